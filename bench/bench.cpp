@@ -0,0 +1,169 @@
+#include <bench.hpp>
+#include <penumbra/config.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <print>
+#include <string>
+#include <thread>
+
+namespace penumbra
+{
+
+u64 bench_now_ns()
+{
+	return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool bench_enabled(const bench_context& ctx, std::string_view name)
+{
+	if(!ctx.options.filter.empty() && name.find(ctx.options.filter) == std::string_view::npos)
+		return false;
+
+	if(ctx.options.list)
+	{
+		std::println("{}", name);
+		return false;
+	}
+
+	return true;
+}
+
+// picks a unit so the printed figure keeps a few significant digits
+static std::string format_time(double ns)
+{
+	if(ns < 1e3)
+		return std::format("{:.2f} ns", ns);
+	if(ns < 1e6)
+		return std::format("{:.2f} us", ns / 1e3);
+	if(ns < 1e9)
+		return std::format("{:.2f} ms", ns / 1e6);
+
+	return std::format("{:.2f} s", ns / 1e9);
+}
+
+void bench_record(bench_context& ctx, std::string_view name, const bench_desc& desc, std::vector<u64>& samples_ns)
+{
+	std::sort(samples_ns.begin(), samples_ns.end());
+
+	const double per_item = 1.0 / static_cast<double>(std::max<u64>(desc.items, 1u));
+	const size_t count = samples_ns.size();
+
+	double mean = 0.0;
+	double m2 = 0.0;
+	for(size_t i = 0; i < count; i++)
+	{
+		const double x = static_cast<double>(samples_ns[i]) * per_item;
+		const double delta = x - mean;
+		mean += delta / static_cast<double>(i + 1);
+		m2 += delta * (x - mean);
+	}
+
+	bench_result result
+	{
+		.name = std::string{name},
+		.samples = count,
+		.items = desc.items,
+		.bytes = desc.bytes,
+		.min_ns = static_cast<double>(samples_ns.front()) * per_item,
+		.median_ns = static_cast<double>(samples_ns[count / 2]) * per_item,
+		.mean_ns = mean,
+		.stddev_ns = count > 1 ? std::sqrt(m2 / static_cast<double>(count - 1)) : 0.0,
+		.p95_ns = static_cast<double>(samples_ns[std::min(count - 1, count * 95 / 100)]) * per_item,
+		.max_ns = static_cast<double>(samples_ns.back()) * per_item
+	};
+
+	std::string line = std::format("{:<44} {:>12} {:>12} +- {:<10} p95 {:>12}", result.name, format_time(result.median_ns), format_time(result.mean_ns), format_time(result.stddev_ns), format_time(result.p95_ns));
+	if(desc.bytes)
+	{
+		// throughput from the median call, bytes per nanosecond is GB/s
+		const double median_call = static_cast<double>(samples_ns[count / 2]);
+		line += std::format(" {:>8.2f} GB/s", static_cast<double>(desc.bytes) / median_call);
+	}
+
+	std::println("{} ({} samples)", line, count);
+	ctx.results.push_back(std::move(result));
+}
+
+void bench_check(bench_context& ctx, std::string_view name, double error, double bound)
+{
+	if(!bench_enabled(ctx, name))
+		return;
+
+	// a nan error never passes
+	const bool passed = error <= bound;
+	std::println("{:<44} max error {:>10.3f} bound {:>10.3f} {}", name, error, bound, passed ? "ok" : "FAILED");
+	ctx.checks.push_back(bench_check_result{.name = std::string{name}, .error = error, .bound = bound, .passed = passed});
+}
+
+bool bench_checks_passed(const bench_context& ctx)
+{
+	return std::all_of(ctx.checks.begin(), ctx.checks.end(), [](const bench_check_result& c){ return c.passed; });
+}
+
+double bench_ulp_error(float value, double reference, double magnitude)
+{
+	const float m = static_cast<float>(std::abs(magnitude));
+	const double ulp = m > 0.0f ? static_cast<double>(std::nextafter(m, std::numeric_limits<float>::infinity()) - m) : static_cast<double>(std::numeric_limits<float>::denorm_min());
+	return std::abs(static_cast<double>(value) - reference) / ulp;
+}
+
+static std::string json_escape(std::string_view str)
+{
+	std::string out;
+	out.reserve(str.size());
+	for(char c : str)
+	{
+		if(c == '"' || c == '\\')
+			out += '\\';
+		out += c;
+	}
+
+	return out;
+}
+
+bool bench_write_json(const bench_context& ctx, const vfs_path& path)
+{
+	std::string json = "{\n";
+	json += std::format("\t\"context\": {{\"git\": \"{}\", \"threads\": {}, \"warmup\": {}, \"min_samples\": {}, \"min_time_ms\": {}}},\n",
+		json_escape(config::git_hash), std::thread::hardware_concurrency(), ctx.options.warmup, ctx.options.min_samples, ctx.options.min_time_ms);
+	json += "\t\"benchmarks\": [\n";
+
+	for(size_t i = 0; i < ctx.results.size(); i++)
+	{
+		const auto& r = ctx.results[i];
+		json += std::format("\t\t{{\"name\": \"{}\", \"samples\": {}, \"items\": {}, \"bytes\": {}, \"min_ns\": {:.3f}, \"median_ns\": {:.3f}, \"mean_ns\": {:.3f}, \"stddev_ns\": {:.3f}, \"p95_ns\": {:.3f}, \"max_ns\": {:.3f}}}{}\n",
+			json_escape(r.name), r.samples, r.items, r.bytes, r.min_ns, r.median_ns, r.mean_ns, r.stddev_ns, r.p95_ns, r.max_ns, i + 1 < ctx.results.size() ? "," : "");
+	}
+
+	json += "\t],\n";
+	json += "\t\"checks\": [\n";
+
+	for(size_t i = 0; i < ctx.checks.size(); i++)
+	{
+		const auto& c = ctx.checks[i];
+		json += std::format("\t\t{{\"name\": \"{}\", \"error\": {:.6f}, \"bound\": {:.6f}, \"passed\": {}}}{}\n",
+			json_escape(c.name), c.error, c.bound, c.passed, i + 1 < ctx.checks.size() ? "," : "");
+	}
+
+	json += "\t]\n}\n";
+
+	vfs_wfd out = vfs_create(path, json.size());
+	if(out < 0)
+		return false;
+
+	if(!vfs_write(out, json.data(), json.size()))
+	{
+		vfs_discard(out);
+		return false;
+	}
+
+	return vfs_commit(out);
+}
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <penumbra/vfs.hpp>
+#include <penumbra/types.hpp>
+
+#include <atomic>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace penumbra
+{
+
+struct bench_options
+{
+	// substring a benchmark name has to contain to run
+	std::string_view filter;
+	bool list{false};
+
+	// untimed runs first, they fault in memory and settle caches and branch predictors
+	u32 warmup{3u};
+	// sampling stops once both minimums are met or max_samples is reached
+	u32 min_samples{10u};
+	u32 max_samples{10000u};
+	double min_time_ms{250.0};
+};
+
+struct bench_desc
+{
+	// operations done by one call, the statistics are reported per operation
+	u64 items{1u};
+	// bytes processed by one call, adds a throughput figure
+	u64 bytes{0u};
+};
+
+// per operation times over all samples
+struct bench_result
+{
+	std::string name;
+	u64 samples;
+	u64 items;
+	u64 bytes;
+
+	double min_ns;
+	double median_ns;
+	double mean_ns;
+	double stddev_ns;
+	double p95_ns;
+	double max_ns;
+};
+
+// an accuracy figure next to the timings, the tree has no test targets so kernels with an error bound are checked here
+struct bench_check_result
+{
+	std::string name;
+	double error;
+	double bound;
+	bool passed;
+};
+
+struct bench_context
+{
+	bench_options options;
+	std::vector<bench_result> results;
+	std::vector<bench_check_result> checks;
+};
+
+u64 bench_now_ns();
+bool bench_enabled(const bench_context& ctx, std::string_view name);
+// reduces the raw sample times and prints the result
+void bench_record(bench_context& ctx, std::string_view name, const bench_desc& desc, std::vector<u64>& samples_ns);
+bool bench_write_json(const bench_context& ctx, const vfs_path& path);
+
+// records and prints the worst error of a check, main exits with an error if any is over its bound
+void bench_check(bench_context& ctx, std::string_view name, double error, double bound);
+bool bench_checks_passed(const bench_context& ctx);
+// distance from a higher precision reference in float ulps at the given magnitude, pass the largest value of
+// the result so cancellation in small elements is not reported as a huge relative error
+double bench_ulp_error(float value, double reference, double magnitude);
+
+// setup runs before every sample outside of the timed region, for work that the measured call consumes
+template <typename Setup, typename F>
+void bench_run(bench_context& ctx, std::string_view name, const bench_desc& desc, Setup&& setup, F&& fn)
+{
+	if(!bench_enabled(ctx, name))
+		return;
+
+	for(u32 i = 0; i < ctx.options.warmup; i++)
+	{
+		setup();
+		fn();
+	}
+
+	std::vector<u64> samples;
+	samples.reserve(ctx.options.min_samples);
+
+	const u64 min_time = static_cast<u64>(ctx.options.min_time_ms * 1e6);
+	const u64 start = bench_now_ns();
+	while(samples.size() < ctx.options.max_samples && (samples.size() < ctx.options.min_samples || bench_now_ns() - start < min_time))
+	{
+		setup();
+
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		const u64 t0 = bench_now_ns();
+		fn();
+		const u64 t1 = bench_now_ns();
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+
+		samples.push_back(t1 - t0);
+	}
+
+	bench_record(ctx, name, desc, samples);
+}
+
+template <typename F>
+void bench_run(bench_context& ctx, std::string_view name, const bench_desc& desc, F&& fn)
+{
+	bench_run(ctx, name, desc, [](){}, fn);
+}
+
+// keeps the compiler from dropping a computation whose result is otherwise unused
+template <typename T>
+inline void bench_keep(const T& value)
+{
+#if defined __GNUC__ || defined __clang__
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	const volatile char sink = *reinterpret_cast<const volatile char*>(&value);
+	(void)sink;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// the suites, in the order main runs them
+void bench_math(bench_context& ctx);
+void bench_culling(bench_context& ctx);
+void bench_fastmath(bench_context& ctx);
+void bench_hash(bench_context& ctx);
+void bench_containers(bench_context& ctx);
+void bench_jobs(bench_context& ctx);
+void bench_vfs(bench_context& ctx);
+void bench_resource(bench_context& ctx);
+void bench_import(bench_context& ctx);
+void bench_world(bench_context& ctx);
+void bench_physics(bench_context& ctx);
+
+// synthetic resource files in the formats the resource manager loads, all relative to the scratch directory
+bool bench_write_geometry(const vfs_path& path, u32 cluster_count);
+bool bench_write_texture(const vfs_path& path, u32 width, u32 height, u32 layers);
+bool bench_write_animation(const vfs_path& path, u32 channel_count, u32 keyframe_count);
+bool bench_write_skeleton(const vfs_path& path, u32 bone_count);
+// an uncompressed pack with one entry per name, entry i holds bench_pack_byte(i, offset) at every offset
+bool bench_write_pack(const vfs_path& path, std::span<const std::string> names, size_t entry_size);
+
+inline u8 bench_pack_byte(u32 entry, size_t offset)
+{
+	return static_cast<u8>(entry * 31u + offset);
+}
+
+}
@@ -0,0 +1,127 @@
+#include <bench.hpp>
+#include <penumbra/flat_map.hpp>
+#include <penumbra/sparse_set.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <format>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace penumbra
+{
+
+// the same operations on flat_map and std::unordered_map, random u64 keys and misses from a disjoint set
+template <typename Map>
+static void bench_map(bench_context& ctx, std::string_view map_name, u32 count)
+{
+	std::mt19937_64 rng{count};
+	std::vector<u64> keys(count);
+	std::vector<u64> misses(count);
+	for(auto& k : keys)
+		k = rng() | 1ull;
+	for(auto& k : misses)
+		k = rng() & ~1ull;
+
+	// lookups in a different order than insertion so they do not walk memory sequentially
+	std::vector<u64> lookups = keys;
+	std::shuffle(lookups.begin(), lookups.end(), rng);
+
+	bench_run(ctx, std::format("containers/{}_insert/{}", map_name, count), {.items = count}, [&]()
+	{
+		Map map;
+		for(u64 k : keys)
+			map.try_emplace(k, k);
+
+		bench_keep(map.size());
+	});
+
+	Map map;
+	for(u64 k : keys)
+		map.try_emplace(k, k);
+
+	bench_run(ctx, std::format("containers/{}_find_hit/{}", map_name, count), {.items = count}, [&]()
+	{
+		u64 acc = 0;
+		for(u64 k : lookups)
+			acc += map.find(k)->second;
+
+		bench_keep(acc);
+	});
+
+	bench_run(ctx, std::format("containers/{}_find_miss/{}", map_name, count), {.items = count}, [&]()
+	{
+		u64 acc = 0;
+		for(u64 k : misses)
+			acc += map.contains(k);
+
+		bench_keep(acc);
+	});
+
+	bench_run(ctx, std::format("containers/{}_iterate/{}", map_name, count), {.items = count}, [&]()
+	{
+		u64 acc = 0;
+		for(const auto& [k, v] : map)
+			acc += v;
+
+		bench_keep(acc);
+	});
+}
+
+static void bench_sparse(bench_context& ctx, u32 count)
+{
+	// ids are dense-ish like entity or object ids, with holes left by erased ones
+	std::mt19937 rng{count};
+	std::vector<u32> ids(count);
+	for(u32 i = 0; i < count; i++)
+		ids[i] = i * 2u + (rng() & 1u);
+
+	std::vector<u32> lookups = ids;
+	std::shuffle(lookups.begin(), lookups.end(), rng);
+
+	bench_run(ctx, std::format("containers/sparse_set_emplace/{}", count), {.items = count}, [&]()
+	{
+		sparse_set<u64> set;
+		for(u32 id : ids)
+			set.emplace(id, u64{id});
+
+		bench_keep(set.size());
+	});
+
+	sparse_set<u64> set;
+	for(u32 id : ids)
+		set.emplace(id, u64{id});
+
+	bench_run(ctx, std::format("containers/sparse_set_find/{}", count), {.items = count}, [&]()
+	{
+		u64 acc = 0;
+		for(u32 id : lookups)
+			acc += *set.find(id);
+
+		bench_keep(acc);
+	});
+
+	bench_run(ctx, std::format("containers/sparse_set_iterate/{}", count), {.items = count}, [&]()
+	{
+		u64 acc = 0;
+		for(u64 v : set)
+			acc += v;
+
+		bench_keep(acc);
+	});
+}
+
+void bench_containers(bench_context& ctx)
+{
+	for(u32 count : {1024u, 65536u, 1048576u})
+	{
+		bench_map<flat_map<u64, u64>>(ctx, "flat_map", count);
+		bench_map<std::unordered_map<u64, u64>>(ctx, "unordered_map", count);
+	}
+
+	for(u32 count : {1024u, 65536u, 1048576u})
+		bench_sparse(ctx, count);
+}
+
+}
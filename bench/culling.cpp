@@ -0,0 +1,136 @@
+#include <bench.hpp>
+#include <penumbra/math.hpp>
+#include <penumbra/resource/geometry.hpp>
+#include <penumbra/types.hpp>
+
+#include <random>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 culling_object_count = 65536u;
+
+// a camera at the origin with the editor's infinite reversed depth projection, objects scattered around it
+static Frustum bench_frustum()
+{
+	const float near = 0.1f;
+	const float x = 1.0f / (16.0f / 9.0f);
+	const mat4 proj
+	{
+		vec4{x, 0.0f, 0.0f, 0.0f},
+		vec4{0.0f, -1.0f, 0.0f, 0.0f},
+		vec4{0.0f, 0.0f, 0.0f, -1.0f},
+		vec4{0.0f, 0.0f, near, 0.0f}
+	};
+
+	const mat4 view = mat4::inverse_affine(Transform{vec3{0.0f}, Quaternion::from_euler(vec3{0.1f, 0.7f, 0.0f}), vec3{1.0f}}.as_matrix());
+	return Frustum::from_matrix(view * proj);
+}
+
+template <typename T, typename F>
+static u32 count_mismatches(const std::vector<T>& objects, const std::vector<u32>& visible, F&& test)
+{
+	u32 mismatches = 0u;
+	for(u32 i = 0; i < objects.size(); i++)
+		mismatches += ((visible[i / 32u] >> (i % 32u)) & 1u) != static_cast<u32>(test(objects[i]));
+
+	return mismatches;
+}
+
+void bench_culling(bench_context& ctx)
+{
+	std::mt19937 rng{culling_object_count};
+	std::uniform_real_distribution<float> pos{-500.0f, 500.0f};
+	std::uniform_real_distribution<float> size{0.5f, 20.0f};
+	std::uniform_real_distribution<float> dir{-1.0f, 1.0f};
+	std::uniform_real_distribution<float> cutoff{-0.2f, 1.0f};
+
+	std::vector<vec4> spheres(culling_object_count);
+	std::vector<AABB> boxes(culling_object_count);
+	std::vector<geom_cluster_format> clusters(culling_object_count);
+	for(u32 i = 0; i < culling_object_count; i++)
+	{
+		const vec3 p{pos(rng), pos(rng), pos(rng)};
+		spheres[i] = vec4{p, size(rng)};
+		boxes[i] = AABB{p, p + vec3{size(rng), size(rng), size(rng)}};
+		clusters[i] = geom_cluster_format{.sphere = spheres[i], .cone = vec4{vec3::normalize(vec3{dir(rng), dir(rng), dir(rng)}), cutoff(rng)}};
+	}
+
+	const Frustum frustum = bench_frustum();
+	const vec3 eye{0.0f};
+	std::vector<u32> visible(visibility_words(culling_object_count));
+	std::vector<u32> indices(culling_object_count);
+
+	bench_run(ctx, "culling/sphere_scalar", {.items = culling_object_count}, [&]()
+	{
+		u32 n = 0u;
+		for(u32 i = 0; i < culling_object_count; i++)
+		{
+			if(frustum_test_sphere(frustum, spheres[i]))
+				indices[n++] = i;
+		}
+
+		bench_keep(n);
+	});
+
+	bench_run(ctx, "culling/sphere_batch", {.items = culling_object_count, .bytes = culling_object_count * sizeof(vec4)}, [&]()
+	{
+		frustum_cull_spheres(frustum, spheres.data(), culling_object_count, visible.data());
+		bench_keep(visible.data());
+	});
+
+	bench_run(ctx, "culling/sphere_batch_indices", {.items = culling_object_count}, [&]()
+	{
+		frustum_cull_spheres(frustum, spheres.data(), culling_object_count, visible.data());
+		bench_keep(visibility_to_indices(visible.data(), culling_object_count, indices.data()));
+	});
+
+	bench_run(ctx, "culling/aabb_scalar", {.items = culling_object_count}, [&]()
+	{
+		u32 n = 0u;
+		for(u32 i = 0; i < culling_object_count; i++)
+		{
+			if(frustum_test_aabb(frustum, boxes[i]))
+				indices[n++] = i;
+		}
+
+		bench_keep(n);
+	});
+
+	bench_run(ctx, "culling/aabb_batch", {.items = culling_object_count, .bytes = culling_object_count * sizeof(AABB)}, [&]()
+	{
+		frustum_cull_aabbs(frustum, boxes.data(), culling_object_count, visible.data());
+		bench_keep(visible.data());
+	});
+
+	bench_run(ctx, "culling/cone_scalar", {.items = culling_object_count}, [&]()
+	{
+		u32 n = 0u;
+		for(u32 i = 0; i < culling_object_count; i++)
+		{
+			if(cone_test(eye, clusters[i].sphere, clusters[i].cone))
+				indices[n++] = i;
+		}
+
+		bench_keep(n);
+	});
+
+	bench_run(ctx, "culling/cone_batch", {.items = culling_object_count, .bytes = culling_object_count * sizeof(geom_cluster_format)}, [&]()
+	{
+		cone_cull(eye, &clusters[0].sphere, &clusters[0].cone, culling_object_count, sizeof(geom_cluster_format), visible.data());
+		bench_keep(visible.data());
+	});
+
+	// the batches have to agree with the scalar tests object for object
+	frustum_cull_spheres(frustum, spheres.data(), culling_object_count, visible.data());
+	bench_check(ctx, "culling/accuracy/sphere_mismatches", count_mismatches(spheres, visible, [&](const vec4& s){ return frustum_test_sphere(frustum, s); }), 0.0);
+
+	frustum_cull_aabbs(frustum, boxes.data(), culling_object_count, visible.data());
+	bench_check(ctx, "culling/accuracy/aabb_mismatches", count_mismatches(boxes, visible, [&](const AABB& b){ return frustum_test_aabb(frustum, b); }), 0.0);
+
+	cone_cull(eye, &clusters[0].sphere, &clusters[0].cone, culling_object_count, sizeof(geom_cluster_format), visible.data());
+	bench_check(ctx, "culling/accuracy/cone_mismatches", count_mismatches(clusters, visible, [&](const geom_cluster_format& c){ return cone_test(eye, c.sphere, c.cone); }), 0.0);
+}
+
+}
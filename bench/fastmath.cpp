@@ -0,0 +1,181 @@
+#include <bench.hpp>
+#include <penumbra/math/fastmath.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 fastmath_batch = 4096u;
+constexpr u32 fastmath_samples = 1u << 18u;
+
+// errors are reported in units of 2^-23, an ulp of one, so the bounds of every tier read as plain numbers
+static void fastmath_check(bench_context& ctx, std::string_view name, double error, double bound)
+{
+	bench_check(ctx, name, std::ldexp(error, 23), std::ldexp(bound, 23));
+}
+
+// worst error of f against reference over evenly spaced samples of [lo, hi], scaled by weight(reference)
+template <typename F, typename R, typename W>
+static double fastmath_error(double lo, double hi, F&& f, R&& reference, W&& weight)
+{
+	double worst = 0.0;
+	for(u32 i = 0; i < fastmath_samples; i++)
+	{
+		const float x = static_cast<float>(lo + (hi - lo) * (i + 0.5) / fastmath_samples);
+		const double expected = reference(static_cast<double>(x));
+		worst = std::max(worst, std::abs(static_cast<double>(f(x)) - expected) / weight(expected));
+	}
+
+	return worst;
+}
+
+template <typename F>
+static void fastmath_time(bench_context& ctx, std::string_view name, const std::vector<float>& in, std::vector<float>& out, F&& f)
+{
+	bench_run(ctx, name, {.items = fastmath_batch}, [&]()
+	{
+		for(u32 i = 0; i < fastmath_batch; i++)
+			out[i] = f(in[i]);
+
+		bench_keep(out.data());
+	});
+}
+
+template <fast_math_accuracy_t A>
+static void fastmath_check_tier(bench_context& ctx, std::string_view tier, const double (&bounds)[8])
+{
+	const auto relative = [](double e){ return std::abs(e); };
+	const auto absolute = [](double){ return 1.0; };
+	const auto name = [&](std::string_view f){ return std::string{"fastmath/accuracy/"} + std::string{f} + "_" + std::string{tier}; };
+
+	// rsqrt and log2 over the binades around one and a few far out
+	double rsqrt = 0.0, log2 = 0.0;
+	for(s32 e : {-60, -30, -3, -2, -1, 0, 1, 2, 30, 59})
+	{
+		const double lo = std::ldexp(1.0, e);
+		rsqrt = std::max(rsqrt, fastmath_error(lo, 2.0 * lo, fast_rsqrt<A>, [](double x){ return 1.0 / std::sqrt(x); }, relative));
+		log2 = std::max(log2, fastmath_error(lo, 2.0 * lo, fast_log2<A>, [](double x){ return std::log2(x); }, [](double l){ return std::max(1.0, std::abs(l)); }));
+	}
+
+	fastmath_check(ctx, name("rsqrt"), rsqrt, bounds[0]);
+	fastmath_check(ctx, name("log2"), log2, bounds[1]);
+	fastmath_check(ctx, name("exp2"), fastmath_error(-125.0, 127.0, fast_exp2<A>, [](double x){ return std::exp2(x); }, relative), bounds[2]);
+	fastmath_check(ctx, name("sin"), fastmath_error(-8192.0, 8192.0, fast_sin<A>, [](double x){ return std::sin(x); }, absolute), bounds[3]);
+	fastmath_check(ctx, name("cos"), fastmath_error(-8192.0, 8192.0, fast_cos<A>, [](double x){ return std::cos(x); }, absolute), bounds[4]);
+	fastmath_check(ctx, name("acos"), fastmath_error(-1.0, 1.0, fast_acos<A>, [](double x){ return std::acos(x); }, absolute), bounds[5]);
+
+	// the two sRGB exponents, the worst case for the texture paths
+	const double pow_decode = fastmath_error(0.0, 1.0, [](float x){ return fast_pow<A>(x, 2.4f); }, [](double x){ return std::pow(x, 2.4); }, relative);
+	const double pow_encode = fastmath_error(0.0, 1.0, [](float x){ return fast_pow<A>(x, 1.0f / 2.4f); }, [](double x){ return std::pow(x, 1.0 / 2.4); }, relative);
+	fastmath_check(ctx, name("pow"), std::max(pow_decode, pow_encode), bounds[6]);
+
+	const double srgb = std::max(
+		fastmath_error(0.0, 1.0, srgb_to_linear<A>, srgb_to_linear_exact, absolute),
+		fastmath_error(0.0, 1.0, linear_to_srgb<A>, linear_to_srgb_exact, absolute));
+	fastmath_check(ctx, name("srgb"), srgb, bounds[7]);
+}
+
+void bench_fastmath(bench_context& ctx)
+{
+	std::vector<float> unit(fastmath_batch);
+	std::vector<float> positive(fastmath_batch);
+	std::vector<float> angle(fastmath_batch);
+	std::vector<float> exponent(fastmath_batch);
+	std::vector<float> out(fastmath_batch);
+	std::vector<u8> bytes(fastmath_batch);
+	for(u32 i = 0; i < fastmath_batch; i++)
+	{
+		const float u = (static_cast<float>(i) + 0.5f) / static_cast<float>(fastmath_batch);
+		unit[i] = u;
+		positive[i] = std::ldexp(1.0f + u, static_cast<int>(i % 40u) - 20);
+		angle[i] = (u - 0.5f) * 100.0f;
+		exponent[i] = (u - 0.5f) * 60.0f;
+		bytes[i] = static_cast<u8>(i * 97u);
+	}
+
+	fastmath_time(ctx, "fastmath/rsqrt_std", positive, out, [](float x){ return 1.0f / std::sqrt(x); });
+	fastmath_time(ctx, "fastmath/rsqrt_low", positive, out, [](float x){ return fast_rsqrt<FAST_MATH_LOW>(x); });
+	fastmath_time(ctx, "fastmath/rsqrt_medium", positive, out, [](float x){ return fast_rsqrt<FAST_MATH_MEDIUM>(x); });
+	fastmath_time(ctx, "fastmath/exp2_std", exponent, out, [](float x){ return std::exp2(x); });
+	fastmath_time(ctx, "fastmath/exp2_medium", exponent, out, [](float x){ return fast_exp2<FAST_MATH_MEDIUM>(x); });
+	fastmath_time(ctx, "fastmath/exp2_high", exponent, out, [](float x){ return fast_exp2<FAST_MATH_HIGH>(x); });
+	fastmath_time(ctx, "fastmath/log2_std", positive, out, [](float x){ return std::log2(x); });
+	fastmath_time(ctx, "fastmath/log2_medium", positive, out, [](float x){ return fast_log2<FAST_MATH_MEDIUM>(x); });
+	fastmath_time(ctx, "fastmath/log2_high", positive, out, [](float x){ return fast_log2<FAST_MATH_HIGH>(x); });
+	fastmath_time(ctx, "fastmath/pow_std", unit, out, [](float x){ return std::pow(x, 2.4f); });
+	fastmath_time(ctx, "fastmath/pow_medium", unit, out, [](float x){ return fast_pow<FAST_MATH_MEDIUM>(x, 2.4f); });
+	fastmath_time(ctx, "fastmath/sin_std", angle, out, [](float x){ return std::sin(x); });
+	fastmath_time(ctx, "fastmath/sin_medium", angle, out, [](float x){ return fast_sin<FAST_MATH_MEDIUM>(x); });
+	fastmath_time(ctx, "fastmath/sin_high", angle, out, [](float x){ return fast_sin<FAST_MATH_HIGH>(x); });
+	fastmath_time(ctx, "fastmath/acos_std", unit, out, [](float x){ return std::acos(x); });
+	fastmath_time(ctx, "fastmath/acos_medium", unit, out, [](float x){ return fast_acos<FAST_MATH_MEDIUM>(x); });
+
+	// the texture importer's sRGB mip step, four texels decoded, averaged and encoded again, against the float pow it used
+	const auto decode_pow = [](u8 v)
+	{
+		const float f = static_cast<float>(v) * (1.0f / 255.0f);
+		return f <= 0.04045f ? f * (1.0f / 12.92f) : std::pow((f + 0.055f) / (1.0f + 0.055f), 2.4f);
+	};
+
+	const auto encode_pow = [](float v)
+	{
+		const float f = v <= 0.0031308f ? 12.92f * v : (1.0f + 0.055f) * std::pow(v, 1.0f / 2.4f) - 0.055f;
+		return static_cast<u8>(std::clamp(std::round(f * 255.0f), 0.0f, 255.0f));
+	};
+
+	std::vector<u8> encoded(fastmath_batch / 4u);
+	bench_run(ctx, "fastmath/srgb8_mip_pow", {.items = fastmath_batch / 4u}, [&]()
+	{
+		for(u32 i = 0; i < fastmath_batch; i += 4u)
+			encoded[i / 4u] = encode_pow((decode_pow(bytes[i]) + decode_pow(bytes[i + 1]) + decode_pow(bytes[i + 2]) + decode_pow(bytes[i + 3])) * 0.25f);
+
+		bench_keep(encoded.data());
+	});
+
+	bench_run(ctx, "fastmath/srgb8_mip_table", {.items = fastmath_batch / 4u}, [&]()
+	{
+		for(u32 i = 0; i < fastmath_batch; i += 4u)
+			encoded[i / 4u] = linear_to_srgb8((srgb8_to_linear(bytes[i]) + srgb8_to_linear(bytes[i + 1]) + srgb8_to_linear(bytes[i + 2]) + srgb8_to_linear(bytes[i + 3])) * 0.25f);
+
+		bench_keep(encoded.data());
+	});
+
+	// the bounds documented in fastmath.hpp, rsqrt, log2, exp2, sin, cos, acos, pow and the sRGB curves
+	fastmath_check_tier<FAST_MATH_LOW>(ctx, "low", {1.8e-3, 1.2e-5, 7.5e-5, 1.1e-5, 1.1e-5, 7e-5, 9.2e-5, 8e-5});
+	fastmath_check_tier<FAST_MATH_MEDIUM>(ctx, "medium", {4.8e-6, 1.7e-7, 2.8e-6, 1.3e-6, 1.3e-6, 1.4e-6, 5.6e-6, 2.6e-6});
+	fastmath_check_tier<FAST_MATH_HIGH>(ctx, "high", {1.2e-7, 1e-7, 1.2e-7, 1e-7, 1e-7, 4.5e-7, 3.7e-6, 2.5e-7});
+
+	double decode8 = 0.0;
+	for(u32 v = 0; v < 256; v++)
+		decode8 = std::max(decode8, std::abs(srgb8_to_linear(static_cast<u8>(v)) - srgb_to_linear_exact(v / 255.0)));
+
+	double decode16 = 0.0;
+	for(u32 v = 0; v < 65536; v++)
+		decode16 = std::max(decode16, std::abs(srgb16_to_linear(static_cast<u16>(v)) - srgb_to_linear_exact(v / 65535.0)));
+
+	fastmath_check(ctx, "fastmath/accuracy/srgb8_decode", decode8, 6e-8);
+	fastmath_check(ctx, "fastmath/accuracy/srgb16_decode", decode16, 8e-8);
+
+	// the table encode in 8 bit steps against correct rounding, and every 8 bit value has to survive a round trip
+	u32 steps = 0u;
+	u32 round_trip = 0u;
+	for(u32 bits = 0; bits <= 0x3f800000u; bits += 251u)
+	{
+		const float v = std::bit_cast<float>(bits);
+		const s32 expected = static_cast<s32>(std::floor(linear_to_srgb_exact(v) * 255.0 + 0.5));
+		steps = std::max(steps, static_cast<u32>(std::abs(static_cast<s32>(linear_to_srgb8(v)) - expected)));
+	}
+
+	for(u32 v = 0; v < 256; v++)
+		round_trip += linear_to_srgb8(srgb8_to_linear(static_cast<u8>(v))) != v;
+
+	bench_check(ctx, "fastmath/accuracy/srgb8_encode_steps", steps, 1.0);
+	bench_check(ctx, "fastmath/accuracy/srgb8_round_trip", round_trip, 0.0);
+}
+
+}
@@ -0,0 +1,73 @@
+#include <bench.hpp>
+#include <penumbra/hash.hpp>
+#include <penumbra/types.hpp>
+
+#include <format>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 hash_batch = 1024u;
+constexpr size_t hash_blob_size = 16ull * 1024ull * 1024ull;
+
+void bench_hash(bench_context& ctx)
+{
+	// resource paths are what gets hashed most, around 50 bytes each
+	std::vector<std::string> paths(hash_batch);
+	u64 path_bytes = 0;
+	for(u32 i = 0; i < hash_batch; i++)
+	{
+		paths[i] = std::format("meshes/props/interior/kitchen_{:04}/lod0_geometry", i);
+		path_bytes += paths[i].size();
+	}
+
+	bench_run(ctx, "hash/fnv32_path", {.items = hash_batch, .bytes = path_bytes}, [&]()
+	{
+		u32 acc = 0;
+		for(const auto& p : paths)
+			acc ^= fnv::hash(std::string_view{p});
+
+		bench_keep(acc);
+	});
+
+	bench_run(ctx, "hash/fnv64_path", {.items = hash_batch, .bytes = path_bytes}, [&]()
+	{
+		u64 acc = 0;
+		for(const auto& p : paths)
+			acc ^= fnv::hash64(p);
+
+		bench_keep(acc);
+	});
+
+	bench_run(ctx, "hash/xxh3_path", {.items = hash_batch, .bytes = path_bytes}, [&]()
+	{
+		u64 acc = 0;
+		for(const auto& p : paths)
+			acc ^= xxh3::hash64(p);
+
+		bench_keep(acc);
+	});
+
+	std::vector<u8> blob(hash_blob_size);
+	std::mt19937_64 rng{42u};
+	for(auto& b : blob)
+		b = static_cast<u8>(rng());
+
+	const std::string_view blob_view{reinterpret_cast<const char*>(blob.data()), blob.size()};
+
+	bench_run(ctx, "hash/fnv64_16mb", {.bytes = hash_blob_size}, [&]()
+	{
+		bench_keep(fnv::hash64(blob_view));
+	});
+
+	bench_run(ctx, "hash/xxh3_16mb", {.bytes = hash_blob_size}, [&]()
+	{
+		bench_keep(xxh3::hash64(blob.data(), blob.size()));
+	});
+}
+
+}
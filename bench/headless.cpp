@@ -0,0 +1,116 @@
+#include <penumbra/gpu.hpp>
+#include <penumbra/renderer.hpp>
+#include <penumbra/math/matrix.hpp>
+#include <penumbra/types.hpp>
+#include <renderer/resource.hpp>
+
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// the resource manager and the editor sources under test are linked against these instead of penumbra_gpu and
+// penumbra_renderer, so the benchmarks run without a device, uploads land in host memory like a staging copy would
+
+namespace penumbra
+{
+
+static u32 next_texture = 1u;
+static u32 geometry_counts[5] = {};
+static std::vector<u8> staging;
+// staged textures are filled after staging returns, batched loads keep several in flight
+static std::unordered_map<GPUTexture, std::vector<u8>> texture_staging;
+static std::vector<mat4> object_transforms;
+
+GPUTexture gpu_create_texture(const GPUTextureDesc& desc)
+{
+	return next_texture++;
+}
+
+void gpu_destroy_texture(GPUTexture tex)
+{
+	texture_staging.erase(tex);
+}
+
+GPUTextureDescriptor gpu_texture_view_descriptor(GPUTexture tex, const GPUViewDesc& desc)
+{
+	return GPUTextureDescriptor{};
+}
+
+u64 renderer_resource_transfer_syncval()
+{
+	return 0ull;
+}
+
+static u32 geometry_write(u32 stream, const void* data, size_t size, u32 count)
+{
+	if(staging.size() < size)
+		staging.resize(size);
+
+	std::memcpy(staging.data(), data, size);
+
+	const u32 offset = geometry_counts[stream];
+	geometry_counts[stream] += count;
+	return offset;
+}
+
+u32 renderer_geometry_write_vertices(const geom_position_format* pos_data, const geom_uv_format* uv_data, const geom_nor_tan_format* nrm_data, u32 count)
+{
+	geometry_write(0, pos_data, count * sizeof(geom_position_format), 0u);
+	geometry_write(0, uv_data, count * sizeof(geom_uv_format), 0u);
+	return geometry_write(0, nrm_data, count * sizeof(geom_nor_tan_format), count);
+}
+
+u32 renderer_geometry_write_skinned(const geom_skinned_format* data, u32 count)
+{
+	return geometry_write(1, data, count * sizeof(geom_skinned_format), count);
+}
+
+u32 renderer_geometry_write_indices(const geom_index_format* data, u32 count)
+{
+	return geometry_write(2, data, count * sizeof(geom_index_format), count);
+}
+
+u32 renderer_geometry_write_clusters(const geom_cluster_format* data, u32 count)
+{
+	return geometry_write(3, data, count * sizeof(geom_cluster_format), count);
+}
+
+u32 renderer_geometry_write_lods(const geom_lod_format* data, u32 count)
+{
+	return geometry_write(4, data, count * sizeof(geom_lod_format), count);
+}
+
+void renderer_write_texture(GPUTexture texture, std::span<const u8> data, u32 num_mips, u32 num_layers)
+{
+	if(staging.size() < data.size())
+		staging.resize(data.size());
+
+	std::memcpy(staging.data(), data.data(), data.size());
+}
+
+std::span<u8> renderer_stage_texture(GPUTexture texture, size_t size, u32 num_mips, u32 num_layers)
+{
+	auto& data = texture_staging[texture];
+	data.resize(size);
+	return {data.data(), size};
+}
+
+void renderer_unstage_texture(GPUTexture texture, size_t size)
+{
+	texture_staging.erase(texture);
+}
+
+void renderer_write_material(u32 offset, const render_material_data& data)
+{
+}
+
+void renderer_world_update_object(renderObjectID object, const mat4& transform)
+{
+	if(object >= object_transforms.size())
+		object_transforms.resize(object + 1u);
+
+	object_transforms[object] = transform;
+}
+
+}
@@ -0,0 +1,136 @@
+#include <bench.hpp>
+#include <import/resource.hpp>
+#include <penumbra/math.hpp>
+#include <penumbra/types.hpp>
+
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 import_texture_size = 1024u;
+
+// a uv sphere, smooth enough that simplification finds a few lods like it would on a real mesh
+static geometry_import_context make_sphere(u32 rings, u32 segments)
+{
+	geometry_import_context ctx;
+	ctx.name = "bench_sphere";
+	ctx.has_normals = true;
+	ctx.has_tangents = true;
+
+	for(u32 r = 0; r <= rings; r++)
+	{
+		const float theta = std::numbers::pi_v<float> * static_cast<float>(r) / static_cast<float>(rings);
+		for(u32 s = 0; s <= segments; s++)
+		{
+			const float phi = 2.0f * std::numbers::pi_v<float> * static_cast<float>(s) / static_cast<float>(segments);
+			const vec3 n{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+
+			geometry_full_vertex v{};
+			v.pos = n;
+			v.nrm = n;
+			v.tan = vec4{-std::sin(phi), 0.0f, std::cos(phi), 1.0f};
+			v.uv = vec2{static_cast<float>(s) / static_cast<float>(segments), static_cast<float>(r) / static_cast<float>(rings)};
+			ctx.vertices.push_back(v);
+		}
+	}
+
+	for(u32 r = 0; r < rings; r++)
+	{
+		for(u32 s = 0; s < segments; s++)
+		{
+			const u32 i0 = r * (segments + 1u) + s;
+			const u32 i1 = i0 + segments + 1u;
+			ctx.indices.insert(ctx.indices.end(), {i0, i1, i0 + 1u, i0 + 1u, i1, i1 + 1u});
+		}
+	}
+
+	return ctx;
+}
+
+// smooth gradients with some noise on top, flat or pure noise images would make the encoder unrealistically fast or slow
+static std::vector<u8> make_image(u32 size, u32 channels)
+{
+	std::mt19937 rng{size * channels};
+	std::vector<u8> pixels(size * size * channels);
+	for(u32 y = 0; y < size; y++)
+	{
+		for(u32 x = 0; x < size; x++)
+		{
+			for(u32 c = 0; c < channels; c++)
+			{
+				const float wave = 0.5f + 0.5f * std::sin(static_cast<float>(x * (c + 1u)) * 0.01f + static_cast<float>(y) * 0.013f);
+				const float value = wave * 224.0f + static_cast<float>(rng() % 32u);
+				pixels[(y * size + x) * channels + c] = static_cast<u8>(value);
+			}
+		}
+	}
+
+	return pixels;
+}
+
+void bench_import(bench_context& ctx)
+{
+	const geometry_import_context sphere = make_sphere(128u, 256u);
+	const u32 triangles = static_cast<u32>(sphere.indices.size() / 3u);
+
+	geometry_import_context geometry;
+	bench_run(ctx, "import/geometry", {.items = triangles}, [&](){ geometry = sphere; }, [&]()
+	{
+		bench_keep(import_geometry(geometry));
+	});
+
+	const std::vector<u8> albedo = make_image(import_texture_size, 4u);
+	const std::vector<u8> normals = make_image(import_texture_size, 2u);
+	const uvec3 albedo_dim{import_texture_size, import_texture_size, 4u};
+	const uvec3 normal_dim{import_texture_size, import_texture_size, 2u};
+	const u64 texels = import_texture_size * import_texture_size;
+
+	texture_encode_context texture;
+	bench_run(ctx, "import/texture_prepare", {.items = texels, .bytes = albedo.size()}, [&]()
+	{
+		texture_encode_begin(texture, IMPORT_TEXTURE_ALBEDO, albedo, albedo_dim);
+	});
+
+	bench_run(ctx, "import/mipgen_rgba8_srgb", {.items = texels}, [&](){ texture_encode_begin(texture, IMPORT_TEXTURE_ALBEDO, albedo, albedo_dim); }, [&]()
+	{
+		texture_generate_mips(texture);
+	});
+
+	bench_run(ctx, "import/mipgen_rgba8_unorm", {.items = texels}, [&](){ texture_encode_begin(texture, IMPORT_TEXTURE_MRO, albedo, albedo_dim); }, [&]()
+	{
+		texture_generate_mips(texture);
+	});
+
+	bench_run(ctx, "import/mipgen_rg8", {.items = texels}, [&](){ texture_encode_begin(texture, IMPORT_TEXTURE_NORMALMAP, normals, normal_dim); }, [&]()
+	{
+		texture_generate_mips(texture);
+	});
+
+	// compression only reads the prepared levels, so they are built once
+	texture_encode_begin(texture, IMPORT_TEXTURE_ALBEDO, albedo, albedo_dim);
+	texture_generate_mips(texture);
+	bench_run(ctx, "import/compress_bc7", {.items = texels, .bytes = texture.pixels.size()}, [&]()
+	{
+		texture_compress(texture);
+		bench_keep(texture.encoded.data());
+	});
+
+	texture_encode_begin(texture, IMPORT_TEXTURE_NORMALMAP, normals, normal_dim);
+	texture_generate_mips(texture);
+	bench_run(ctx, "import/compress_bc5", {.items = texels, .bytes = texture.pixels.size()}, [&]()
+	{
+		texture_compress(texture);
+		bench_keep(texture.encoded.data());
+	});
+
+	bench_run(ctx, "import/texture_albedo", {.items = texels, .bytes = albedo.size()}, [&]()
+	{
+		bench_keep(import_texture("bench_albedo", IMPORT_TEXTURE_ALBEDO, albedo, albedo_dim));
+	});
+}
+
+}
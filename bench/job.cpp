@@ -0,0 +1,72 @@
+#include <bench.hpp>
+#include <penumbra/job.hpp>
+#include <penumbra/types.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 job_batch = 1024u;
+constexpr u32 job_sum_count = 4u * 1024u * 1024u;
+
+void bench_jobs(bench_context& ctx)
+{
+	// empty jobs, what is left is the cost of queueing, stealing and the counter
+	std::vector<job_decl> jobs(job_batch, job_decl{[](void*){}, nullptr});
+	bench_run(ctx, "jobs/run_wait_empty", {.items = job_batch}, [&]()
+	{
+		job_counter counter;
+		job_run(jobs, &counter);
+		job_wait(&counter);
+	});
+
+	bench_run(ctx, "jobs/run_wait_single", {}, [&]()
+	{
+		job_counter counter;
+		job_run(jobs[0], &counter);
+		job_wait(&counter);
+	});
+
+	bench_run(ctx, "jobs/run_after_chain", {.items = job_batch}, [&]()
+	{
+		job_counter first;
+		job_counter second;
+		job_run({jobs.data(), job_batch / 2u}, &first);
+		job_run_after(&first, {jobs.data(), job_batch / 2u}, &second);
+		job_wait(&second);
+	});
+
+	std::atomic<u64> ranges{0};
+	bench_run(ctx, "jobs/parallel_for_empty", {.items = job_batch * 64u}, [&]()
+	{
+		job_parallel_for(job_batch * 64u, 64u, [&ranges](u32 begin, u32 end)
+		{
+			ranges.fetch_add(1u, std::memory_order_relaxed);
+		});
+	});
+
+	std::vector<float> values(job_sum_count);
+	std::iota(values.begin(), values.end(), 0.0f);
+	std::vector<double> partial(job_sum_count / 4096u);
+	bench_run(ctx, "jobs/parallel_for_sum", {.items = job_sum_count, .bytes = job_sum_count * sizeof(float)}, [&]()
+	{
+		job_parallel_for(static_cast<u32>(partial.size()), 1u, [&](u32 begin, u32 end)
+		{
+			for(u32 chunk = begin; chunk < end; chunk++)
+			{
+				double sum = 0.0;
+				for(u32 i = chunk * 4096u; i < (chunk + 1u) * 4096u; i++)
+					sum += values[i];
+
+				partial[chunk] = sum;
+			}
+		});
+
+		bench_keep(partial.data());
+	});
+}
+
+}
@@ -0,0 +1,102 @@
+#include <bench.hpp>
+#include <penumbra/resource.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/types.hpp>
+
+#include <filesystem>
+#include <format>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 resource_file_count = 64u;
+
+static std::vector<vfs_path> write_files(const char* kind, bool (*write)(const vfs_path&, u32), u32 arg)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(std::format("resource/{}", kind), ec);
+
+	std::vector<vfs_path> paths(resource_file_count);
+	for(u32 i = 0; i < resource_file_count; i++)
+	{
+		paths[i] = std::format("resource/{}/{}_{:02}", kind, kind, i);
+		write(paths[i], arg);
+	}
+
+	return paths;
+}
+
+static u64 files_size(const std::vector<vfs_path>& paths)
+{
+	std::error_code ec;
+	u64 size = 0;
+	for(const auto& p : paths)
+		size += std::filesystem::file_size(p, ec);
+
+	return size;
+}
+
+// every sample starts from empty caches so each load parses and uploads again
+static void reset_resources()
+{
+	resource_manager_shutdown();
+	resource_manager_init();
+}
+
+void bench_resource(bench_context& ctx)
+{
+	const auto geometry = write_files("geometry", bench_write_geometry, 32u);
+	const auto textures = write_files("texture", [](const vfs_path& p, u32 size){ return bench_write_texture(p, size, size, 1u); }, 256u);
+	const auto animations = write_files("animation", [](const vfs_path& p, u32 channels){ return bench_write_animation(p, channels, 120u); }, 60u);
+	const auto skeletons = write_files("skeleton", bench_write_skeleton, 64u);
+
+	bench_run(ctx, "resource/load_geometry", {.items = resource_file_count, .bytes = files_size(geometry)}, reset_resources, [&]()
+	{
+		for(const auto& p : geometry)
+			bench_keep(resource_manager_load_geometry(p));
+	});
+
+	bench_run(ctx, "resource/load_batch_geometry", {.items = resource_file_count, .bytes = files_size(geometry)}, reset_resources, [&]()
+	{
+		resource_manager_load_batch(RESOURCE_TYPE_GEOMETRY, geometry);
+	});
+
+	bench_run(ctx, "resource/load_texture", {.items = resource_file_count, .bytes = files_size(textures)}, reset_resources, [&]()
+	{
+		for(const auto& p : textures)
+			bench_keep(resource_manager_load_texture(p));
+	});
+
+	bench_run(ctx, "resource/load_batch_texture", {.items = resource_file_count, .bytes = files_size(textures)}, reset_resources, [&]()
+	{
+		resource_manager_load_batch(RESOURCE_TYPE_TEXTURE, textures);
+	});
+
+	bench_run(ctx, "resource/load_animation", {.items = resource_file_count, .bytes = files_size(animations)}, reset_resources, [&]()
+	{
+		for(const auto& p : animations)
+			bench_keep(resource_manager_load_animation(p));
+	});
+
+	bench_run(ctx, "resource/load_skeleton", {.items = resource_file_count, .bytes = files_size(skeletons)}, reset_resources, [&]()
+	{
+		for(const auto& p : skeletons)
+			bench_keep(resource_manager_load_skeleton(p));
+	});
+
+	// already loaded, only the path hash and the cache lookup
+	reset_resources();
+	for(const auto& p : geometry)
+		resource_manager_load_geometry(p);
+
+	bench_run(ctx, "resource/load_cached", {.items = resource_file_count}, [&]()
+	{
+		for(const auto& p : geometry)
+			bench_keep(resource_manager_load_geometry(p));
+	});
+
+	reset_resources();
+}
+
+}
@@ -0,0 +1,107 @@
+#include <bench.hpp>
+#include <penumbra/job.hpp>
+#include <penumbra/resource.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/types.hpp>
+
+#include <charconv>
+#include <filesystem>
+#include <print>
+#include <string_view>
+
+using namespace penumbra;
+using namespace std::literals::string_view_literals;
+
+template <typename T>
+static bool parse_number(const char* str, T& out)
+{
+	std::string_view s{str};
+	return std::from_chars(s.data(), s.data() + s.size(), out).ec == std::errc{};
+}
+
+static void print_usage()
+{
+	std::println("Usage: penumbra_bench [--filter SUBSTRING] [--json OUTPUT] [--min-time MS] [--samples N] [--list]");
+}
+
+int main(int argc, const char** argv)
+{
+	bench_context ctx;
+	std::filesystem::path json_path;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const std::string_view arg{argv[i]};
+		const bool has_value = i + 1 < argc;
+
+		if(arg == "--list"sv)
+		{
+			ctx.options.list = true;
+		}
+		else if(arg == "--filter"sv && has_value)
+		{
+			ctx.options.filter = argv[++i];
+		}
+		else if(arg == "--json"sv && has_value)
+		{
+			json_path = std::filesystem::absolute(argv[++i]);
+		}
+		else if(arg == "--min-time"sv && has_value && parse_number(argv[i + 1], ctx.options.min_time_ms))
+		{
+			i++;
+		}
+		else if(arg == "--samples"sv && has_value && parse_number(argv[i + 1], ctx.options.min_samples))
+		{
+			i++;
+		}
+		else
+		{
+			print_usage();
+			return arg == "--help"sv ? 0 : 1;
+		}
+	}
+
+	// synthetic assets are written to a scratch directory, which is also the base mount
+	std::error_code ec;
+	const std::filesystem::path scratch = std::filesystem::temp_directory_path(ec) / "penumbra_bench";
+	std::filesystem::remove_all(scratch, ec);
+	std::filesystem::create_directories(scratch, ec);
+	std::filesystem::current_path(scratch, ec);
+	if(ec)
+	{
+		std::println("failed to enter {}: {}", scratch.string(), ec.message());
+		return 1;
+	}
+
+	job_init();
+	vfs_init();
+	resource_manager_init();
+
+	bench_math(ctx);
+	bench_culling(ctx);
+	bench_fastmath(ctx);
+	bench_hash(ctx);
+	bench_containers(ctx);
+	bench_jobs(ctx);
+	bench_vfs(ctx);
+	bench_resource(ctx);
+	bench_import(ctx);
+	bench_world(ctx);
+	bench_physics(ctx);
+
+	int result = bench_checks_passed(ctx) ? 0 : 1;
+	if(!json_path.empty() && !ctx.options.list && !bench_write_json(ctx, json_path))
+	{
+		std::println("failed to write {}", json_path.string());
+		result = 1;
+	}
+
+	resource_manager_shutdown();
+	vfs_shutdown();
+	job_shutdown();
+
+	std::filesystem::current_path(scratch.parent_path(), ec);
+	std::filesystem::remove_all(scratch, ec);
+
+	return result;
+}
@@ -0,0 +1,346 @@
+#include <bench.hpp>
+#include <penumbra/math.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 math_batch = 1024u;
+
+using dmat4 = Matrix<double, 4, 4>;
+
+static dmat4 to_double(const mat4& m)
+{
+	dmat4 out;
+	for(size_t r = 0; r < 4; r++)
+		for(size_t c = 0; c < 4; c++)
+			out[r][c] = m[r][c];
+
+	return out;
+}
+
+// worst element of count results against double precision ones, in ulps of each matrix's largest element
+template <typename F, typename D>
+static double max_mat4_error(u32 count, F&& value, D&& reference)
+{
+	double worst = 0.0;
+	for(u32 i = 0; i < count; i++)
+	{
+		const mat4 v = value(i);
+		const dmat4 expected = reference(i);
+
+		double magnitude = 0.0;
+		for(size_t r = 0; r < 4; r++)
+			for(size_t c = 0; c < 4; c++)
+				magnitude = std::max(magnitude, std::abs(expected[r][c]));
+
+		for(size_t r = 0; r < 4; r++)
+			for(size_t c = 0; c < 4; c++)
+				worst = std::max(worst, bench_ulp_error(v[r][c], expected[r][c], magnitude));
+	}
+
+	return worst;
+}
+
+static std::vector<Transform> random_transforms(u32 count, u32 seed)
+{
+	std::mt19937 rng{seed};
+	std::uniform_real_distribution<float> pos{-100.0f, 100.0f};
+	std::uniform_real_distribution<float> angle{-3.14f, 3.14f};
+	std::uniform_real_distribution<float> scale{0.5f, 2.0f};
+
+	std::vector<Transform> out(count);
+	for(auto& t : out)
+		t = Transform{vec3{pos(rng), pos(rng), pos(rng)}, Quaternion::from_euler(vec3{angle(rng), angle(rng), angle(rng)}), vec3{scale(rng), scale(rng), scale(rng)}};
+
+	return out;
+}
+
+void bench_math(bench_context& ctx)
+{
+	const auto ta = random_transforms(math_batch, 1u);
+	const auto tb = random_transforms(math_batch, 2u);
+
+	std::vector<mat4> a(math_batch);
+	std::vector<mat4> b(math_batch);
+	for(u32 i = 0; i < math_batch; i++)
+	{
+		a[i] = ta[i].as_matrix();
+		b[i] = tb[i].as_matrix();
+	}
+
+	std::vector<mat4> out(math_batch);
+	bench_run(ctx, "math/mat4_mul", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = a[i] * b[i];
+
+		bench_keep(out.data());
+	});
+
+	bench_run(ctx, "math/mat4_mul_reference", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = mul_reference(a[i], b[i]);
+
+		bench_keep(out.data());
+	});
+
+	std::vector<vec4> points(math_batch);
+	bench_run(ctx, "math/vec4_mul_mat4", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			points[i] = vec4{tb[i].translation, 1.0f} * a[i];
+
+		bench_keep(points.data());
+	});
+
+	bench_run(ctx, "math/mat4_transpose", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = mat4::transpose(a[i]);
+
+		bench_keep(out.data());
+	});
+
+	bench_run(ctx, "math/mat4_inverse", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = mat4::inverse(a[i]);
+
+		bench_keep(out.data());
+	});
+
+	bench_run(ctx, "math/mat4_inverse_reference", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = mat4::inverse_reference(a[i]);
+
+		bench_keep(out.data());
+	});
+
+	bench_run(ctx, "math/mat4_inverse_affine", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = mat4::inverse_affine(a[i]);
+
+		bench_keep(out.data());
+	});
+
+	bench_run(ctx, "math/transform_as_matrix", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = ta[i].as_matrix();
+
+		bench_keep(out.data());
+	});
+
+	// the same transforms as separate component arrays, composed under a shared parent
+	std::vector<vec3> translations(math_batch);
+	std::vector<Quaternion> rotations(math_batch);
+	std::vector<vec3> scales(math_batch);
+	for(u32 i = 0; i < math_batch; i++)
+	{
+		translations[i] = ta[i].translation;
+		rotations[i] = ta[i].rotation;
+		scales[i] = ta[i].scale;
+	}
+
+	const transform_batch_t batch{translations.data(), rotations.data(), scales.data(), math_batch};
+	const mat4 parent = tb[0].as_matrix();
+
+	bench_run(ctx, "math/transform_as_matrix_parent", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			out[i] = ta[i].as_matrix() * parent;
+
+		bench_keep(out.data());
+	});
+
+	bench_run(ctx, "math/transform_compose", {.items = math_batch}, [&]()
+	{
+		transform_compose(batch, &parent, out.data());
+		bench_keep(out.data());
+	});
+
+	std::vector<mat3x4> affine(math_batch);
+	bench_run(ctx, "math/transform_compose_3x4", {.items = math_batch}, [&]()
+	{
+		transform_compose(batch, &parent, affine.data());
+		bench_keep(affine.data());
+	});
+
+	// a chain of bones where every parent is a few entries back
+	std::vector<u16> bone_parents(math_batch);
+	for(u32 i = 0; i < math_batch; i++)
+		bone_parents[i] = static_cast<u16>(i % 8u ? i : 0u);
+
+	bench_run(ctx, "math/transform_compose_hierarchy", {.items = math_batch}, [&]()
+	{
+		transform_compose_hierarchy(batch, bone_parents.data(), &parent, out.data());
+		bench_keep(out.data());
+	});
+
+	std::vector<Quaternion> quats(math_batch);
+	bench_run(ctx, "math/quat_slerp", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			quats[i] = Quaternion::slerp(ta[i].rotation, tb[i].rotation, static_cast<float>(i) / static_cast<float>(math_batch));
+
+		bench_keep(quats.data());
+	});
+
+	std::vector<Quaternion> rot_a(math_batch);
+	std::vector<Quaternion> rot_b(math_batch);
+	std::vector<float> rot_t(math_batch);
+	for(u32 i = 0; i < math_batch; i++)
+	{
+		rot_a[i] = ta[i].rotation;
+		rot_b[i] = tb[i].rotation;
+		rot_t[i] = static_cast<float>(i) / static_cast<float>(math_batch);
+	}
+
+	bench_run(ctx, "math/quat_slerp_normalize", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			quats[i] = Quaternion::normalize(Quaternion::slerp(rot_a[i], rot_b[i], rot_t[i]));
+
+		bench_keep(quats.data());
+	});
+
+	bench_run(ctx, "math/quat_slerp_batch", {.items = math_batch}, [&]()
+	{
+		quat_slerp(rot_a.data(), rot_b.data(), rot_t.data(), math_batch, quats.data());
+		bench_keep(quats.data());
+	});
+
+	bench_run(ctx, "math/quat_nlerp_batch", {.items = math_batch}, [&]()
+	{
+		quat_nlerp(rot_a.data(), rot_b.data(), rot_t.data(), math_batch, quats.data());
+		bench_keep(quats.data());
+	});
+
+	bench_run(ctx, "math/quat_normalize_batch", {.items = math_batch}, [&]()
+	{
+		quat_normalize(rot_a.data(), math_batch, quats.data());
+		bench_keep(quats.data());
+	});
+
+	std::vector<mat4> rot_m(math_batch);
+	bench_run(ctx, "math/quat_make_mat4", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+			rot_m[i] = Quaternion::make_mat4(rot_a[i]);
+
+		bench_keep(rot_m.data());
+	});
+
+	std::vector<mat3x4> rot_3x4(math_batch);
+	bench_run(ctx, "math/quat_to_mat3x4_batch", {.items = math_batch}, [&]()
+	{
+		quat_to_mat3x4(rot_a.data(), math_batch, rot_3x4.data());
+		bench_keep(rot_3x4.data());
+	});
+
+	std::vector<Transform> decomposed(math_batch);
+	bench_run(ctx, "math/decompose", {.items = math_batch}, [&]()
+	{
+		for(u32 i = 0; i < math_batch; i++)
+		{
+			auto [t, r, s] = decompose(a[i]);
+			decomposed[i] = Transform{t, r, s};
+		}
+
+		bench_keep(decomposed.data());
+	});
+
+	// the kernels against a double precision evaluation, the scalar reference is checked too so the two can be compared
+	const auto mul_double = [&](u32 i){ return mul_reference(to_double(a[i]), to_double(b[i])); };
+	const auto inverse_double = [&](u32 i){ return dmat4::inverse_reference(to_double(a[i])); };
+
+	bench_check(ctx, "math/accuracy/mat4_mul", max_mat4_error(math_batch, [&](u32 i){ return a[i] * b[i]; }, mul_double), 8.0);
+	bench_check(ctx, "math/accuracy/mat4_mul_reference", max_mat4_error(math_batch, [&](u32 i){ return mul_reference(a[i], b[i]); }, mul_double), 8.0);
+	bench_check(ctx, "math/accuracy/mat4_transpose", max_mat4_error(math_batch, [&](u32 i){ return mat4::transpose(a[i]); }, [&](u32 i){ return dmat4::transpose_reference(to_double(a[i])); }), 0.0);
+	bench_check(ctx, "math/accuracy/mat4_inverse", max_mat4_error(math_batch, [&](u32 i){ return mat4::inverse(a[i]); }, inverse_double), 16.0);
+	bench_check(ctx, "math/accuracy/mat4_inverse_reference", max_mat4_error(math_batch, [&](u32 i){ return mat4::inverse_reference(a[i]); }, inverse_double), 16.0);
+	bench_check(ctx, "math/accuracy/mat4_inverse_affine", max_mat4_error(math_batch, [&](u32 i){ return mat4::inverse_affine(a[i]); }, inverse_double), 16.0);
+
+	// slerp against a double precision one with no lerp fallback, both ends of the arc and near parallel pairs included
+	const auto quat_error = [&](const std::vector<Quaternion>& value, auto&& reference)
+	{
+		double worst = 0.0;
+		for(u32 i = 0; i < math_batch; i++)
+		{
+			const basic_quat<double> expected = reference(i);
+			for(u32 k = 0; k < 4; k++)
+				worst = std::max(worst, bench_ulp_error(value[i][k], expected[k], 1.0));
+		}
+
+		return worst;
+	};
+
+	for(u32 i = 0; i < math_batch; i += 4u)
+	{
+		rot_b[i] = Quaternion::normalize(rot_a[i] + Quaternion{1e-4f, 0.0f, 0.0f, 0.0f});
+		rot_b[i + 1] = -rot_a[i + 1];
+	}
+
+	rot_t[0] = 0.0f;
+	rot_t[math_batch - 1] = 1.0f;
+	quat_slerp(rot_a.data(), rot_b.data(), rot_t.data(), math_batch, quats.data());
+	bench_check(ctx, "math/accuracy/quat_slerp", quat_error(quats, [&](u32 i)
+	{
+		using dquat = basic_quat<double>;
+		const dquat a{Vector<double, 4>{rot_a[i].as_vector()}};
+		dquat b{Vector<double, 4>{rot_b[i].as_vector()}};
+		double d = Vector<double, 4>::dot(a, b);
+		if(d < 0.0)
+		{
+			b = -b;
+			d = -d;
+		}
+
+		const double angle = std::acos(std::min(d, 1.0));
+		const double t = rot_t[i];
+		if(angle < 1e-12)
+			return dquat{a * (1.0 - t) + b * t};
+
+		return dquat{(a * std::sin((1.0 - t) * angle) + b * std::sin(t * angle)) / std::sin(angle)};
+	}), 4.0);
+
+	quat_nlerp(rot_a.data(), rot_b.data(), rot_t.data(), math_batch, quats.data());
+	bench_check(ctx, "math/accuracy/quat_nlerp", quat_error(quats, [&](u32 i)
+	{
+		using dquat = basic_quat<double>;
+		const dquat a{Vector<double, 4>{rot_a[i].as_vector()}};
+		dquat b{Vector<double, 4>{rot_b[i].as_vector()}};
+		if(Vector<double, 4>::dot(a, b) < 0.0)
+			b = -b;
+
+		const double t = rot_t[i];
+		return dquat::normalize(dquat{a * (1.0 - t) + b * t});
+	}), 4.0);
+
+	quat_to_mat3x4(rot_a.data(), math_batch, rot_3x4.data());
+	bench_check(ctx, "math/accuracy/quat_to_mat3x4", max_mat4_error(math_batch, [&](u32 i)
+	{
+		return mat4{rot_3x4[i][0], rot_3x4[i][1], rot_3x4[i][2], vec4{0.0f, 0.0f, 0.0f, 1.0f}};
+	}, [&](u32 i)
+	{
+		return dmat4::transpose_reference(basic_quat<double>::make_mat4(basic_quat<double>{Vector<double, 4>{rot_a[i].as_vector()}}));
+	}), 4.0);
+
+	transform_compose(batch, &parent, out.data());
+	bench_check(ctx, "math/accuracy/transform_compose", max_mat4_error(math_batch, [&](u32 i){ return out[i]; }, [&](u32 i)
+	{
+		const basic_transform<double> t{Vector<double, 3>{translations[i]}, basic_quat<double>{Vector<double, 4>{rotations[i].as_vector()}}, Vector<double, 3>{scales[i]}};
+		return mul_reference(t.as_matrix(), to_double(parent));
+	}), 8.0);
+}
+
+}
@@ -0,0 +1,69 @@
+#include <bench.hpp>
+#include <penumbra/physics.hpp>
+#include <penumbra/sim.hpp>
+#include <penumbra/types.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 physics_body_count = 4096u;
+
+void bench_physics(bench_context& ctx)
+{
+	physics_create_world({});
+
+	// a dynamic body the step moves, a kinematic one placed by hand and a static one that never shows up
+	const Transform placed{vec3{1.0f, 2.0f, 3.0f}, Quaternion::identity(), vec3{1.0f}};
+	physics_create_body({.body_type = PHYSICS_BODY_DYNAMIC, .userdata = 1u});
+	physicsBodyID kinematic = physics_create_body({.body_type = PHYSICS_BODY_KINEMATIC, .userdata = 2u});
+	physics_create_body({.body_type = PHYSICS_BODY_STATIC, .userdata = 3u});
+	physics_body_set_transform(kinematic, placed);
+
+	// one tick through the sim thread, later ones would age the bodies out before the read
+	std::atomic<bool> published{false};
+	sim_init(1000u, [&published](double dt)
+	{
+		if(published.load(std::memory_order_acquire))
+			return;
+
+		physics_world_simulate(static_cast<float>(dt), 1);
+		physics_world_write_transforms(sim_snapshot_begin());
+		sim_snapshot_publish();
+		published.store(true, std::memory_order_release);
+	});
+
+	while(!published.load(std::memory_order_acquire))
+		std::this_thread::yield();
+
+	const sim_interp_state state = sim_snapshot_acquire();
+	u32 mismatches = state.curr.size() != 2u;
+	if(state.curr.size() == 2u)
+	{
+		mismatches += state.curr[0].id != 1u;
+		mismatches += state.curr[1].id != 2u || state.curr[1].transform.translation != placed.translation;
+	}
+
+	sim_shutdown();
+	bench_check(ctx, "physics/accuracy/published_body_mismatches", mismatches, 0.0);
+
+	for(u32 i = 0; i < physics_body_count; i++)
+		physics_create_body({.body_type = PHYSICS_BODY_DYNAMIC, .userdata = 4u + i});
+
+	// the sim tick without the solver, what marking and gathering moved bodies costs
+	std::vector<sim_transform> snapshot;
+	bench_run(ctx, "physics/simulate_write_transforms", {.items = physics_body_count}, [&]()
+	{
+		snapshot.clear();
+		physics_world_simulate(1.0f / 60.0f, 1);
+		physics_world_write_transforms(snapshot);
+		bench_keep(snapshot.data());
+	});
+
+	physics_destroy_world();
+}
+
+}
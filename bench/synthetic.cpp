@@ -0,0 +1,230 @@
+#include <bench.hpp>
+#include <penumbra/resource/anim.hpp>
+#include <penumbra/resource/geometry.hpp>
+#include <penumbra/resource/texture.hpp>
+#include <penumbra/math/transform.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/vfs_pack.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <random>
+#include <vector>
+
+namespace penumbra
+{
+
+// appends count values at a 16 byte aligned offset so the loader can read them in place, returns the offset
+template <typename T>
+static u32 append(std::vector<u8>& buf, const T* data, size_t count)
+{
+	const size_t offset = (buf.size() + 15u) & ~size_t{15u};
+	buf.resize(offset + sizeof(T) * count);
+	if(count)
+		std::memcpy(buf.data() + offset, data, sizeof(T) * count);
+
+	return static_cast<u32>(offset);
+}
+
+template <typename Header>
+static void patch_header(std::vector<u8>& buf, const Header& header)
+{
+	std::memcpy(buf.data(), &header, sizeof(Header));
+}
+
+static bool write_file(const vfs_path& path, const std::vector<u8>& buf)
+{
+	vfs_wfd out = vfs_create(path, buf.size());
+	if(out < 0)
+		return false;
+
+	if(!vfs_write(out, buf.data(), buf.size()))
+	{
+		vfs_discard(out);
+		return false;
+	}
+
+	return vfs_commit(out);
+}
+
+bool bench_write_geometry(const vfs_path& path, u32 cluster_count)
+{
+	constexpr u32 cluster_vertices = 64u;
+	constexpr u32 cluster_indices = 96u * 3u;
+
+	std::mt19937 rng{cluster_count};
+	std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+	const u32 vcount = cluster_count * cluster_vertices;
+	std::vector<geom_position_format> pos(vcount);
+	std::vector<geom_uv_format> uv(vcount);
+	std::vector<geom_nor_tan_format> nor_tan(vcount);
+	for(u32 i = 0; i < vcount; i++)
+	{
+		pos[i] = vec3{dist(rng), dist(rng), dist(rng)};
+		uv[i] = vec2{dist(rng), dist(rng)};
+		nor_tan[i] = uvec2{static_cast<u32>(rng()), static_cast<u32>(rng())};
+	}
+
+	std::vector<geom_index_format> index(cluster_count * cluster_indices);
+	for(auto& i : index)
+		i = static_cast<geom_index_format>(rng() % cluster_vertices);
+
+	std::vector<GeometryFileFormat::Cluster> clusters(cluster_count);
+	for(u32 c = 0; c < cluster_count; c++)
+	{
+		clusters[c].vertex_offset = static_cast<s32>(c * cluster_vertices);
+		clusters[c].vertex_count = cluster_vertices;
+		clusters[c].index_offset = c * cluster_indices;
+		clusters[c].index_count = cluster_indices;
+		clusters[c].sphere = vec4{0.0f, 0.0f, 0.0f, 1.0f};
+		clusters[c].cone = vec4{0.0f, 1.0f, 0.0f, 0.5f};
+	}
+
+	const GeometryFileFormat::LOD lod{0u, cluster_count};
+
+	GeometryFileFormat::Header header{};
+	header.vert_format = VERTEX_FORMAT_STATIC;
+	header.num_lods = 1u;
+	header.sphere = vec4{0.0f, 0.0f, 0.0f, 2.0f};
+
+	std::vector<u8> buf(sizeof(header));
+	header.vpos_offset = append(buf, pos.data(), pos.size());
+	header.vuv_offset = append(buf, uv.data(), uv.size());
+	header.vnorms_offset = append(buf, nor_tan.data(), nor_tan.size());
+	header.index_offset = append(buf, index.data(), index.size());
+	header.lod_offset = append(buf, &lod, 1u);
+	header.cluster_offset = append(buf, clusters.data(), clusters.size());
+	patch_header(buf, header);
+
+	return write_file(path, buf);
+}
+
+bool bench_write_texture(const vfs_path& path, u32 width, u32 height, u32 layers)
+{
+	// BC7, a full chain down to the last 4x4 level
+	std::vector<TextureFileFormat::SubresourceDescription> subres;
+	u32 data_size = 0u;
+	for(u32 level = 0, w = width, h = height; ; level++, w /= 2u, h /= 2u)
+	{
+		for(u32 layer = 0; layer < layers; layer++)
+		{
+			const u32 size = gpu_format_size(GPU_FORMAT_BC7_UNORM, w, h, 1u);
+			subres.push_back({w, h, level, layer, data_size, size});
+			data_size += size;
+		}
+
+		if(w <= 4u && h <= 4u)
+			break;
+	}
+
+	TextureFileFormat::Header header{};
+	header.texformat = TextureFileFormat::TextureFormat::BC7Unorm;
+	header.num_subres = static_cast<u32>(subres.size());
+
+	std::vector<u8> buf(sizeof(header));
+	header.subres_desc_offset = append(buf, subres.data(), subres.size());
+
+	std::vector<u8> blocks(data_size);
+	std::mt19937 rng{width ^ (height << 16u)};
+	for(auto& b : blocks)
+		b = static_cast<u8>(rng());
+
+	const u32 data_offset = append(buf, blocks.data(), blocks.size());
+	for(auto& s : subres)
+		s.data_offset += data_offset;
+
+	std::memcpy(buf.data() + header.subres_desc_offset, subres.data(), subres.size() * sizeof(TextureFileFormat::SubresourceDescription));
+	patch_header(buf, header);
+
+	return write_file(path, buf);
+}
+
+bool bench_write_animation(const vfs_path& path, u32 channel_count, u32 keyframe_count)
+{
+	std::vector<AnimationFileFormat::Channel> channels(channel_count);
+
+	AnimationFileFormat::Header header{};
+	header.channel_count = channel_count;
+	header.ref_skeleton_offset = 0u;
+
+	std::vector<u8> buf(sizeof(header));
+	header.channel_table_offset = append(buf, channels.data(), channels.size());
+
+	std::vector<float> timestamps(keyframe_count);
+	for(u32 k = 0; k < keyframe_count; k++)
+		timestamps[k] = static_cast<float>(k) / 30.0f;
+
+	std::vector<float> values(keyframe_count * 4u, 0.5f);
+	for(u32 c = 0; c < channel_count; c++)
+	{
+		const auto anim_path = static_cast<animation_path_t>(c % 3u);
+		const u32 width = anim_path == ANIM_PATH_ROTATION ? 4u : 3u;
+
+		channels[c].keyframe_count = keyframe_count;
+		channels[c].bone = c / 3u + 1u;
+		channels[c].path = anim_path;
+		channels[c].interp = ANIM_INTERP_LINEAR;
+		channels[c].timestamp_offset = append(buf, timestamps.data(), timestamps.size());
+		channels[c].value_offset = append(buf, values.data(), keyframe_count * width);
+	}
+
+	std::memcpy(buf.data() + header.channel_table_offset, channels.data(), channels.size() * sizeof(AnimationFileFormat::Channel));
+	patch_header(buf, header);
+
+	return write_file(path, buf);
+}
+
+bool bench_write_skeleton(const vfs_path& path, u32 bone_count)
+{
+	std::string names;
+	std::vector<Transform> transforms(bone_count);
+	std::vector<u32> parents(bone_count);
+	std::vector<mat4> matrices(bone_count, mat4::identity());
+	for(u32 b = 0; b < bone_count; b++)
+	{
+		names += std::format("bone_{}", b);
+		names += '\0';
+		parents[b] = b ? (b - 1u) / 2u : 0xFFFFu;
+	}
+
+	SkeletonFileFormat::Header header{};
+	header.bone_count = bone_count;
+
+	std::vector<u8> buf(sizeof(header));
+	header.name_table_offset = append(buf, names.data(), names.size());
+	header.transform_table_offset = append(buf, transforms.data(), transforms.size());
+	header.parent_table_offset = append(buf, parents.data(), parents.size());
+	header.matrix_table_offset = append(buf, matrices.data(), matrices.size());
+	patch_header(buf, header);
+
+	return write_file(path, buf);
+}
+
+bool bench_write_pack(const vfs_path& path, std::span<const std::string> names, size_t entry_size)
+{
+	std::vector<PackFileFormat::Entry> toc(names.size());
+	std::vector<u8> buf(sizeof(PackFileFormat::Header));
+	for(u32 i = 0; i < names.size(); i++)
+	{
+		const u64 offset = (buf.size() + PackFileFormat::entry_alignment - 1) & ~(PackFileFormat::entry_alignment - 1);
+		buf.resize(offset + entry_size);
+		for(size_t b = 0; b < entry_size; b++)
+			buf[offset + b] = bench_pack_byte(i, b);
+
+		toc[i] = {.path_hash = PackFileFormat::hash_path(names[i]), .offset = offset, .size = entry_size, .stored_size = entry_size, .flags = 0u, .num_blocks = 0u};
+	}
+
+	std::sort(toc.begin(), toc.end(), [](const PackFileFormat::Entry& a, const PackFileFormat::Entry& b) { return a.path_hash < b.path_hash; });
+
+	PackFileFormat::Header header{};
+	header.num_entries = static_cast<u32>(toc.size());
+	header.toc_offset = append(buf, toc.data(), toc.size());
+	patch_header(buf, header);
+
+	return write_file(path, buf);
+}
+
+}
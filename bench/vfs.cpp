@@ -0,0 +1,197 @@
+#include <bench.hpp>
+#include <penumbra/job.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 vfs_file_count = 64u;
+constexpr size_t vfs_file_size = 64ull * 1024ull;
+
+void bench_vfs(bench_context& ctx)
+{
+	std::error_code ec;
+	std::filesystem::create_directories("vfs", ec);
+
+	std::vector<vfs_path> paths(vfs_file_count);
+	std::vector<u8> contents(vfs_file_size, 0x5a);
+	for(u32 i = 0; i < vfs_file_count; i++)
+	{
+		paths[i] = std::format("vfs/file_{:02}", i);
+
+		vfs_wfd out = vfs_create(paths[i], contents.size());
+		vfs_write(out, contents.data(), contents.size());
+		vfs_commit(out);
+	}
+
+	// the path cache is warm after the first round, this is the steady state of repeated loads
+	bench_run(ctx, "vfs/open_close", {.items = vfs_file_count}, [&]()
+	{
+		for(const auto& p : paths)
+			vfs_close(vfs_open(p, VFS_ACCESS_READ));
+	});
+
+	bench_run(ctx, "vfs/open_map_close", {.items = vfs_file_count, .bytes = vfs_file_count * vfs_file_size}, [&]()
+	{
+		u64 acc = 0;
+		for(const auto& p : paths)
+		{
+			vfs_fd fd = vfs_open(p, VFS_ACCESS_READ, VFS_HINT_SEQUENTIAL);
+			const u8* data = vfs_map(fd);
+			for(size_t offset = 0; offset < vfs_file_size; offset += 4096u)
+				acc += data[offset];
+
+			vfs_close(fd);
+		}
+
+		bench_keep(acc);
+	});
+
+	// every thread opens and closes the same set of files, contention on the descriptor table and the shared mappings
+	constexpr u32 rounds = 16u;
+	bench_run(ctx, "vfs/open_close_mt", {.items = job_thread_count() * rounds * vfs_file_count}, [&]()
+	{
+		job_parallel_for(job_thread_count(), 1u, [&](u32 begin, u32 end)
+		{
+			for(u32 t = begin; t < end; t++)
+			{
+				for(u32 r = 0; r < rounds; r++)
+				{
+					for(const auto& p : paths)
+						vfs_close(vfs_open(p, VFS_ACCESS_READ));
+				}
+			}
+		});
+	});
+
+	// the full open, map, touch, close cycle on 1 to 32 threads, the mapping is dropped by the close,
+	// shows where the descriptor table and the shared mappings stop scaling
+	const u32 max_threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), job_thread_count());
+	for(u32 threads = 1u; threads <= 32u && threads <= max_threads; threads *= 2u)
+	{
+		const u64 items = u64{threads} * rounds * vfs_file_count;
+		bench_run(ctx, std::format("vfs/open_map_close_mt/{}", threads), {.items = items, .bytes = items * vfs_file_size}, [&]()
+		{
+			job_parallel_for(threads, 1u, [&](u32 begin, u32 end)
+			{
+				u64 acc = 0;
+				for(u32 t = begin; t < end; t++)
+				{
+					for(u32 r = 0; r < rounds; r++)
+					{
+						for(const auto& p : paths)
+						{
+							vfs_fd fd = vfs_open(p, VFS_ACCESS_READ);
+							const u8* data = vfs_map(fd);
+							for(size_t offset = 0; offset < vfs_file_size; offset += 4096u)
+								acc += data[offset];
+
+							vfs_close(fd);
+						}
+					}
+				}
+
+				bench_keep(acc);
+			});
+		});
+	}
+
+	// a pack built the way the pack builder lays it out, every entry has to resolve through the mount and read back intact
+	std::vector<std::string> packed_names(vfs_file_count);
+	std::vector<vfs_path> packed_paths(vfs_file_count);
+	for(u32 i = 0; i < vfs_file_count; i++)
+	{
+		packed_names[i] = std::format("packed/file_{:02}", i);
+		packed_paths[i] = packed_names[i];
+	}
+
+	if(bench_write_pack("bench_vfs.pack", packed_names, vfs_file_size) && vfs_mount("bench_vfs.pack", VFS_MOUNT_PRIORITY_PACK))
+	{
+		u32 failures = 0u;
+		for(u32 i = 0; i < vfs_file_count; i++)
+		{
+			vfs_fd fd = vfs_open(packed_paths[i], VFS_ACCESS_READ);
+			if(fd < 0)
+			{
+				failures++;
+				continue;
+			}
+
+			const u8* data = vfs_map(fd);
+			bool intact = data && vfs_size(fd) == vfs_file_size;
+			for(size_t offset = 0; intact && offset < vfs_file_size; offset++)
+				intact = data[offset] == bench_pack_byte(i, offset);
+
+			failures += !intact;
+			vfs_close(fd);
+		}
+
+		bench_check(ctx, "vfs/accuracy/pack_open_failures", failures, 0.0);
+
+		bench_run(ctx, "vfs/open_close_packed", {.items = vfs_file_count}, [&]()
+		{
+			for(const auto& p : packed_paths)
+				vfs_close(vfs_open(p, VFS_ACCESS_READ));
+		});
+
+		// a write over a packed path has to read back as the new bytes, not the packed copy underneath
+		const std::vector<u8> rewritten(vfs_file_size / 2, 0xa5);
+		vfs_wfd out = vfs_create(packed_paths[0], rewritten.size());
+		vfs_write(out, rewritten.data(), rewritten.size());
+
+		u32 stale = !vfs_commit(out);
+		vfs_fd fd = vfs_open(packed_paths[0], VFS_ACCESS_READ);
+		if(fd >= 0)
+		{
+			const u8* data = vfs_map(fd);
+			stale += !data || vfs_size(fd) != rewritten.size() || !std::equal(rewritten.begin(), rewritten.end(), data);
+			vfs_close(fd);
+		}
+		else
+		{
+			stale++;
+		}
+
+		bench_check(ctx, "vfs/accuracy/packed_overwrite_failures", stale, 0.0);
+
+		vfs_unmount(VFS_WRITE_OVERLAY);
+		std::filesystem::remove_all(VFS_WRITE_OVERLAY, ec);
+		vfs_unmount("bench_vfs.pack");
+	}
+	else
+	{
+		bench_check(ctx, "vfs/accuracy/pack_open_failures", vfs_file_count, 0.0);
+		bench_check(ctx, "vfs/accuracy/packed_overwrite_failures", 1.0, 0.0);
+	}
+
+	std::vector<vfs_read_request> requests(vfs_file_count);
+	for(u32 i = 0; i < vfs_file_count; i++)
+		requests[i] = {.path = paths[i], .user_data = i};
+
+	bench_run(ctx, "vfs/read_batch", {.items = vfs_file_count, .bytes = vfs_file_count * vfs_file_size}, [&]()
+	{
+		vfs_read_submit(requests);
+
+		std::array<vfs_read_completion, 32> completions;
+		size_t remaining = requests.size();
+		while(remaining)
+		{
+			const size_t count = vfs_read_wait(completions);
+			for(size_t i = 0; i < count; i++)
+				vfs_read_free(completions[i].data);
+
+			remaining -= count;
+		}
+	});
+}
+
+}
@@ -0,0 +1,79 @@
+#include <bench.hpp>
+#include <world/state.hpp>
+#include <world/components/render.hpp>
+#include <penumbra/math/transform.hpp>
+#include <penumbra/types.hpp>
+
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 world_group_count = 100u;
+constexpr u32 world_children_per_group = 100u;
+constexpr u32 world_dirty_leaves = 1000u;
+
+static Transform random_transform(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> pos{-10.0f, 10.0f};
+	std::uniform_real_distribution<float> angle{-3.14f, 3.14f};
+	return Transform{vec3{pos(rng), pos(rng), pos(rng)}, Quaternion::from_euler(vec3{angle(rng), angle(rng), angle(rng)}), vec3{1.0f}};
+}
+
+void bench_world(bench_context& ctx)
+{
+	// the constructor loads the environment map, any cube texture does
+	std::error_code ec;
+	std::filesystem::create_directories("hdri/kloppenheim", ec);
+	bench_write_texture("hdri/kloppenheim/env_irradiance", 32u, 32u, 6u);
+	bench_write_texture("hdri/kloppenheim/env_prefiltered", 32u, 32u, 6u);
+
+	WorldState world;
+
+	// a flat scene of prefab-like groups, each a parent with a level of renderable children
+	std::mt19937 rng{world_group_count};
+	std::vector<ecs::entity> groups;
+	std::vector<ecs::entity> leaves;
+	u32 next_object = 1u;
+	for(u32 g = 0; g < world_group_count; g++)
+	{
+		ecs::entity group = world.spawn("group");
+		world.entities.replace<Transform>(group, random_transform(rng));
+		add_entity_as_child(world.entities, world.root, group);
+		groups.push_back(group);
+
+		for(u32 c = 0; c < world_children_per_group; c++)
+		{
+			ecs::entity child = world.spawn("child");
+			world.entities.replace<Transform>(child, random_transform(rng));
+			world.entities.emplace<render_object_component>(child, render_object_component{.renderer_objectID = next_object++});
+			add_entity_as_child(world.entities, group, child);
+			leaves.push_back(child);
+		}
+	}
+
+	// every group moved, the whole scene is rewritten
+	bench_run(ctx, "world/update_transforms_groups", {.items = world_group_count * world_children_per_group}, [&]()
+	{
+		for(ecs::entity group : groups)
+			world.entities.emplace_or_replace<transform_dirty_t>(group);
+	}, [&]()
+	{
+		world.update_transforms();
+	});
+
+	// scattered edits, each one walks up to the root for its parent matrix
+	std::uniform_int_distribution<size_t> pick{0u, leaves.size() - 1u};
+	bench_run(ctx, "world/update_transforms_leaves", {.items = world_dirty_leaves}, [&]()
+	{
+		for(u32 i = 0; i < world_dirty_leaves; i++)
+			world.entities.emplace_or_replace<transform_dirty_t>(leaves[pick(rng)]);
+	}, [&]()
+	{
+		world.update_transforms();
+	});
+}
+
+}
@@ -17,8 +17,12 @@
 
 #include <penumbra/cvar.hpp>
 #include <penumbra/gpu.hpp>
+#include <penumbra/input.hpp>
+#include <penumbra/log.hpp>
 #include <penumbra/physics.hpp>
+#include <penumbra/profile.hpp>
 #include <penumbra/renderer.hpp>
+#include <penumbra/sim.hpp>
 #include <penumbra/window.hpp>
 #include <penumbra/ui.hpp>
 
@@ -27,9 +31,22 @@
 namespace penumbra
 {
 
+static void dump_memory_stats()
+{
+	allocator_dump_stats();
+
+	for(u32 heap = GPU_MEMORY_HOST; heap <= GPU_MEMORY_READBACK; heap++)
+	{
+		const GPUMemoryStats stats = gpu_get_memory_stats(static_cast<GPUMemoryHeap>(heap));
+		PENUMBRA_LOG_INFO("gpu heap {}: {} KB, peak {} KB, {} allocations, {} frees",
+			gpu_memory_heap_names[heap], stats.current / 1024, stats.peak / 1024, stats.allocations, stats.frees);
+	}
+}
+
 Editor::Editor(window_t wnd, WorldState* ws, int argc, const char** argv) : window{wnd}, world{ws}
 {
 	imgui_add_hook([this](){draw_ui();});
+	frame_arena_create(frame_scratch, 1u, 1024ull * 1024ull, "editor_frame", MEMORY_TAG_EDITOR);
 
 	create_rendertarget();
 	widgets.push_back(std::make_unique<Viewport>(&framebuffer, world));
@@ -53,14 +70,34 @@ Editor::Editor(window_t wnd, WorldState* ws, int argc, const char** argv) : wind
 Editor::~Editor()
 {
 	gpu_destroy_texture(framebuffer_tex);
+	frame_arena_destroy(frame_scratch);
 }
 
 void Editor::fixed_update(double dt)
 {
 }
 
+// bodies are keyed by entity, the transforms are world space so they replace the whole parent chain
+void Editor::apply_simulation_state()
+{
+	PROFILE_ZONE;
+
+	const sim_interp_state state = sim_snapshot_acquire();
+	sim_interpolate(state, [this](u64 id, const Transform& xform)
+	{
+		const auto entity = static_cast<ecs::entity>(id);
+		if(!world->entities.valid(entity) || !world->entities.try_get<rigidbody_component>(entity))
+			return;
+
+		world->update_entity_subtree(entity, xform.as_matrix());
+	});
+}
+
 void Editor::variable_update(double dt)
 {
+	frame_arena_next(frame_scratch);
+	arena_t& scratch = frame_arena_current(frame_scratch);
+
 	auto vp_size = widget_viewport->get_size();
 	if(vp_size.x && vp_size.y)
 	{
@@ -82,6 +119,7 @@ void Editor::variable_update(double dt)
 	renderer_set_output_rendertarget(framebuffer_tex);
 
 	world->update_transforms();
+	apply_simulation_state();
 	update_main_camera();
 	update_env();
 
@@ -104,19 +142,26 @@ void Editor::variable_update(double dt)
 		}
 	}
 
-	Transform tmp_bone_ls[64];
-	mat4 tmp_bone_ws[64];
-
 	for(auto [entity, transform, r_obj, r_skel] : world->entities.view<Transform, render_object_component, render_skeleton_component>().each())
 	{
 		if(!resource_get_handle(r_skel.skeleton))
 			continue;
 
 		auto& skeleton = resource_manager_get_skeleton(r_skel.skeleton);
-		assert(skeleton.bone_count < 64);
-		
+
+		// the pose only lives until it is handed to the renderer, give the space back for the next skeleton
+		const arena_marker pose_marker = arena_mark(scratch);
+		vec3* bone_translation = arena_alloc_array<vec3>(scratch, skeleton.bone_count);
+		Quaternion* bone_rotation = arena_alloc_array<Quaternion>(scratch, skeleton.bone_count);
+		vec3* bone_scale = arena_alloc_array<vec3>(scratch, skeleton.bone_count);
+		mat4* tmp_bone_ws = arena_alloc_array<mat4>(scratch, skeleton.bone_count);
+
 		for(u32 i = 0; i < skeleton.bone_count; i++)
-			tmp_bone_ls[i] = skeleton.bone_transforms[i];
+		{
+			bone_translation[i] = skeleton.bone_transforms[i].translation;
+			bone_rotation[i] = skeleton.bone_transforms[i].rotation;
+			bone_scale[i] = skeleton.bone_transforms[i].scale;
+		}
 
 		auto* anim_c = world->entities.try_get<animation_component>(entity);
 		if(!anim_c)
@@ -125,43 +170,62 @@ void Editor::variable_update(double dt)
 		if(anim_c && resource_get_handle(anim_c->animation))
 		{
 			animation_resource& anim = resource_manager_get_animation(anim_c->animation);
-			
+
+			// rotation keys are gathered and interpolated as one batch, the rest are cheap enough one channel at a time
+			const u32 channel_count = static_cast<u32>(anim.channels.size());
+			Quaternion* rot_from = arena_alloc_array<Quaternion>(scratch, channel_count);
+			Quaternion* rot_to = arena_alloc_array<Quaternion>(scratch, channel_count);
+			float* rot_t = arena_alloc_array<float>(scratch, channel_count);
+			u32* rot_bone = arena_alloc_array<u32>(scratch, channel_count);
+			u32 rot_count = 0u;
+
 			for(auto& channel : anim.channels)
 			{
 				for(u32 i = 0u; i < channel.timestamps.size() - 1; i++)
 				{
 					if((anim_c->cur_time >= channel.timestamps[i]) && (anim_c->cur_time <= channel.timestamps[i + 1]))
 					{
-						float a = (anim_c->cur_time - channel.timestamps[i]) / (channel.timestamps[i + 1] / channel.timestamps[i]);
+						// fraction of the way through the key interval, this used to divide the two timestamps and left [0, 1]
+						float a = (anim_c->cur_time - channel.timestamps[i]) / (channel.timestamps[i + 1] - channel.timestamps[i]);
 						switch(channel.path)
 						{
 						case ANIM_PATH_TRANSLATION:
-							tmp_bone_ls[channel.bone].translation = mix(reinterpret_cast<vec3*>(channel.values.data())[i], reinterpret_cast<vec3*>(channel.values.data())[i + 1], a);
+							bone_translation[channel.bone] = mix(reinterpret_cast<vec3*>(channel.values.data())[i], reinterpret_cast<vec3*>(channel.values.data())[i + 1], a);
 							break;
 						case ANIM_PATH_ROTATION:
-							tmp_bone_ls[channel.bone].rotation = Quaternion::normalize(Quaternion::slerp(reinterpret_cast<Quaternion*>(channel.values.data())[i], reinterpret_cast<Quaternion*>(channel.values.data())[i + 1], a));
+							rot_from[rot_count] = reinterpret_cast<Quaternion*>(channel.values.data())[i];
+							rot_to[rot_count] = reinterpret_cast<Quaternion*>(channel.values.data())[i + 1];
+							rot_t[rot_count] = a;
+							rot_bone[rot_count] = channel.bone;
+							rot_count++;
 							break;
 						case ANIM_PATH_SCALE:
-							tmp_bone_ls[channel.bone].scale = mix(reinterpret_cast<vec3*>(channel.values.data())[i], reinterpret_cast<vec3*>(channel.values.data())[i + 1], a);
+							bone_scale[channel.bone] = mix(reinterpret_cast<vec3*>(channel.values.data())[i], reinterpret_cast<vec3*>(channel.values.data())[i + 1], a);
 							break;
 						}
+
+						// one key pair per channel, a time landing on a key matches the interval on either side of it
+						// and would queue the channel twice into the rotation batch sized by channel count
+						break;
 					}
 				}
 			}
-		}
 
-		for(u32 i = 0; i < skeleton.bone_count; i++)
-		{
-			if(skeleton.bone_parents[i] > 0)
-				tmp_bone_ws[i] = tmp_bone_ls[i].as_matrix() * tmp_bone_ws[skeleton.bone_parents[i] - 1];
-			else
-				tmp_bone_ws[i] = tmp_bone_ls[i].as_matrix();
+			quat_slerp(rot_from, rot_to, rot_t, rot_count, rot_from);
+			quat_normalize(rot_from, rot_count, rot_from);
+			for(u32 i = 0; i < rot_count; i++)
+				bone_rotation[rot_bone[i]] = rot_from[i];
 		}
 
+		// bone parents are one based and come before their children, the order the batch walks the hierarchy in
+		const transform_batch_t bones{bone_translation, bone_rotation, bone_scale, skeleton.bone_count};
+		transform_compose_hierarchy(bones, skeleton.bone_parents.data(), nullptr, tmp_bone_ws);
+
 		for(u32 i = 0; i < skeleton.bone_count; i++)
 			tmp_bone_ws[i] = skeleton.bone_inv_bind_matrices[i] * tmp_bone_ws[i];
 
 		renderer_world_update_skin(r_obj.renderer_objectID, &tmp_bone_ws[0], skeleton.bone_count);
+		arena_rewind(scratch, pose_marker);
 	}
 }
 
@@ -267,7 +331,7 @@ void Editor::menubar_draw()
 			{
 				if(ImGui::BeginMenu("Present mode"))
 				{
-					auto* pmode_var = cvar_get("r_present_mode");
+					auto* pmode_var = cvar_get("r_present_mode"_fnv);
 					
 					if(ImGui::MenuItem("FIFO", nullptr, pmode_var->int_v == GPU_PRESENT_MODE_FIFO))
 					{
@@ -289,7 +353,7 @@ void Editor::menubar_draw()
 
 				if(ImGui::BeginMenu("Window mode"))
 				{
-					auto* wmode_var = cvar_get("r_fullscreen");
+					auto* wmode_var = cvar_get("r_fullscreen"_fnv);
 					if(ImGui::MenuItem("Windowed", nullptr, wmode_var->int_v == 0))
 					{
 						cvar_set(wmode_var, 0);
@@ -310,12 +374,69 @@ void Editor::menubar_draw()
 
 		if(ImGui::BeginMenu("Debug"))
 		{
-			auto* vbdebug_cvar = cvar_get("r_visbuffer_debug");
+			auto* vbdebug_cvar = cvar_get("r_visbuffer_debug"_fnv);
 			if(ImGui::MenuItem("Visbuffer", nullptr, vbdebug_cvar->int_v > 0))
 			{
 				cvar_set(vbdebug_cvar, vbdebug_cvar->int_v > 0 ? 0 : 1);
 			}
 
+			if(ImGui::BeginMenu("Profiler"))
+			{
+				auto* prof_cvar = cvar_get("prof_enable"_fnv);
+				if(ImGui::MenuItem("Enabled", nullptr, prof_cvar->int_v > 0))
+				{
+					cvar_set(prof_cvar, prof_cvar->int_v > 0 ? 0 : 1);
+				}
+
+				if(ImGui::MenuItem("Dump trace"))
+				{
+					profile_dump_chrome("profile.json");
+				}
+
+				if(ImGui::MenuItem("Dump binary capture"))
+				{
+					profile_dump_binary("profile.pcap");
+				}
+
+				ImGui::EndMenu();
+			}
+
+			if(ImGui::BeginMenu("Memory"))
+			{
+				if(ImGui::MenuItem("Show in overlay", nullptr, widget_viewport->get_show_memory()))
+				{
+					widget_viewport->set_show_memory(!widget_viewport->get_show_memory());
+				}
+
+				if(ImGui::MenuItem("Dump stats"))
+				{
+					dump_memory_stats();
+				}
+
+				ImGui::EndMenu();
+			}
+
+			if(ImGui::BeginMenu("Input"))
+			{
+				if(ImGui::MenuItem("Record", nullptr, input_recording()))
+				{
+					if(input_recording())
+						input_record_end();
+					else
+						input_record_begin("input.rec");
+				}
+
+				if(ImGui::MenuItem("Replay", nullptr, input_replaying(), !input_recording()))
+				{
+					if(input_replaying())
+						input_replay_end();
+					else
+						input_replay_begin("input.rec");
+				}
+
+				ImGui::EndMenu();
+			}
+
 			ImGui::EndMenu();
 		}
 
@@ -412,7 +533,8 @@ void Editor::try_patch_prefab(std::string_view name)
 		physicsBodyDesc floor_desc
 		{
 			.initial_transform = floor_xform,
-			.body_type = PHYSICS_BODY_STATIC
+			.body_type = PHYSICS_BODY_STATIC,
+			.userdata = static_cast<u64>(floor_ent)
 		};
 
 		static physicsBoxHull floor_hull;
@@ -440,7 +562,8 @@ void Editor::try_patch_prefab(std::string_view name)
 		world->entities.emplace<render_object_component>(test_entity, capsule, def_mat, rd_object);
 		physicsBodyDesc te_rb_desc
 		{
-			.initial_transform = te_xf
+			.initial_transform = te_xf,
+			.userdata = static_cast<u64>(test_entity)
 		};
 
 		auto caps_rb = physics_create_body(te_rb_desc);
@@ -464,7 +587,8 @@ void Editor::try_patch_prefab(std::string_view name)
 
 		physicsBodyDesc box_rb_desc
 		{
-			.initial_transform = bo_xf
+			.initial_transform = bo_xf,
+			.userdata = static_cast<u64>(box)
 		};
 
 		auto box_rb = physics_create_body(box_rb_desc);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <penumbra/allocator.hpp>
 #include <penumbra/gpu.hpp>
 #include <penumbra/window.hpp>
 #include <penumbra/ui.hpp>
@@ -21,11 +22,13 @@ public:
 	Editor(window_t wnd, WorldState* ws, int argc, const char** argv);
 	~Editor();
 
+	// runs on the sim thread while the main thread renders, must not touch the registry or the renderer
 	void fixed_update(double dt);
 	void variable_update(double dt);
 	void draw_ui();
 private:
 	void create_rendertarget();
+	void apply_simulation_state();
 	void update_main_camera();
 	void update_env();
 	void menubar_draw();
@@ -43,6 +46,9 @@ private:
 	GPUTextureDescriptor framebuffer;
 
 	ImGuiID import_popup_id;
+
+	// cpu scratch reset at the start of every variable_update
+	frame_arena_t frame_scratch;
 };
 
 }
@@ -19,7 +19,6 @@
 #include <fastgltf/tools.hpp>
 
 #include <format>
-#include <map>
 #include <string>
 #include <utility>
 #include <variant>
@@ -73,7 +72,7 @@ static ResourceID parse_gltf_skin(gltf_import_context& ctx, fastgltf::Asset& glt
 
 	auto& skin = gltf.skins[index];
 	if(skin.skeleton.has_value())
-		log::debug("skeleton root node {}", gltf.nodes[skin.skeleton.value()].name);
+		PENUMBRA_LOG_DEBUG("skeleton root node {}", gltf.nodes[skin.skeleton.value()].name);
 
 	Skeleton skel;
 	skel.name = std::string{skin.name};
@@ -134,7 +133,7 @@ static ResourceID get_cached_texture(gltf_import_context& ctx, fastgltf::Asset&
 				{
 					int w, h, c;
 					unsigned char* data = stbi_load_from_memory(reinterpret_cast<unsigned char*>(source.bytes.data()) + bufferView.byteOffset, static_cast<int>(bufferView.byteLength), &w, &h, &c, 0);
-					log::debug("get_cached_texture {} {} {}x{} {}bpp", uint32_t(arg.mimeType), texname, w, h, c * 8);
+					PENUMBRA_LOG_DEBUG("get_cached_texture {} {} {}x{} {}bpp", uint32_t(arg.mimeType), texname, w, h, c * 8);
 					if(data)
 					{
 						rid = import_texture(texname, type, {reinterpret_cast<const u8*>(data), size_t(w * h * c)}, uvec3{u32(w), u32(h), u32(c)});
@@ -202,22 +201,22 @@ static ResourceID get_cached_material(gltf_import_context& ctx, fastgltf::Asset&
 
 	if(material.anisotropy.get())
 	{
-		log::info("gltf_import: material {} ANISOTROPIC", material.name);
+		PENUMBRA_LOG_INFO("gltf_import: material {} ANISOTROPIC", material.name);
 	}
 
 	clearcoat_info clearcoat_desc{};
 
 	if(material.clearcoat.get())
 	{
-		log::info("gltf_import: material {} CLEARCOAT", material.name);
+		PENUMBRA_LOG_INFO("gltf_import: material {} CLEARCOAT", material.name);
 		clearcoat_desc.factor = material.clearcoat->clearcoatFactor;
 		clearcoat_desc.roughness_factor = material.clearcoat->clearcoatRoughnessFactor;
 		if(material.clearcoat->clearcoatTexture.has_value())
-			log::debug("has clearcoat texture");
+			PENUMBRA_LOG_DEBUG("has clearcoat texture");
 		if(material.clearcoat->clearcoatRoughnessTexture.has_value())
-			log::debug("has clearcoat roughness texture");
+			PENUMBRA_LOG_DEBUG("has clearcoat roughness texture");
 		if(material.clearcoat->clearcoatNormalTexture.has_value())
-			log::debug("has clearcoat normal texture");
+			PENUMBRA_LOG_DEBUG("has clearcoat normal texture");
 
 		mtl_flags |= MATERIAL_CLEARCOAT;
 	}
@@ -526,7 +525,7 @@ static void parse_gltf(gltf_import_context& ctx, fastgltf::Asset& gltf)
 {
 	for(auto ext : gltf.extensionsUsed)
 	{
-		log::info("parse_gltf: using extension {}", ext);
+		PENUMBRA_LOG_INFO("parse_gltf: using extension {}", ext);
 	}
 
 	size_t default_scene = 0;
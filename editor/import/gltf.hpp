@@ -1,10 +1,10 @@
 #pragma once
 
+#include <penumbra/flat_map.hpp>
 #include <penumbra/resource/rid.hpp>
 #include <penumbra/vfs.hpp>
 #include <penumbra/types.hpp>
 
-#include <map>
 #include <vector>
 
 namespace penumbra
@@ -21,11 +21,11 @@ struct CachedPrimitive
 struct gltf_import_context
 {
 	WorldState* world;
-	std::map<size_t, std::vector<CachedPrimitive>> mesh_map;
-	std::map<size_t, ResourceID> texture_map;
-	std::map<size_t, ResourceID> material_map;
-	std::map<size_t, ResourceID> skeleton_map;
-	std::map<size_t, u16> node_to_bone_map;
+	flat_map<size_t, std::vector<CachedPrimitive>> mesh_map;
+	flat_map<size_t, ResourceID> texture_map;
+	flat_map<size_t, ResourceID> material_map;
+	flat_map<size_t, ResourceID> skeleton_map;
+	flat_map<size_t, u16> node_to_bone_map;
 };
 
 bool import_gltf(gltf_import_context& ctx, const vfs_path& path);
@@ -103,12 +103,12 @@ static void parse_epair(parser_context& ctx)
 	parser_get_token(ctx, false);
 	std::string value{ctx.token};
 
-	log::info("qmap_parse: epair {} : {}", key, value);
+	PENUMBRA_LOG_INFO("qmap_parse: epair {} : {}", key, value);
 }
 
 static void parse_brush(parser_context& ctx)
 {
-	log::info("qmap_parse: brush");
+	PENUMBRA_LOG_INFO("qmap_parse: brush");
 	vec3 planepts[3];
 
 	do
@@ -145,7 +145,7 @@ static void parse_brush(parser_context& ctx)
 		parser_get_token(ctx, false);
 		parser_get_token(ctx, false);
 
-		log::info("qmap_parse: plane {} {} {}", planepts[0], planepts[1], planepts[2]);
+		PENUMBRA_LOG_INFO("qmap_parse: plane {} {} {}", planepts[0], planepts[1], planepts[2]);
 	} while(1);
 }
 
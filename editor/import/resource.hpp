@@ -3,6 +3,8 @@
 #include <penumbra/resource/rid.hpp>
 #include <penumbra/resource/geometry.hpp>
 #include <penumbra/math/vector.hpp>
+#include <penumbra/allocator.hpp>
+#include <penumbra/gpu.hpp>
 #include <penumbra/types.hpp>
 
 #include <string>
@@ -60,6 +62,38 @@ constexpr const char* texture_type_names[] =
 	"CUBE"
 };
 
+struct subresource_info
+{
+	u32 width;
+	u32 height;
+	u32 level;
+	u32 layer;
+	u32 byte_offset;
+	u32 size_bytes;
+};
+
+// the cpu side of a texture import, kept apart from the upload so the stages can also be run on their own
+struct texture_encode_context
+{
+	import_texture_type type;
+	uvec3 dim;
+	u32 num_mips{0u};
+	u32 num_layers{0u};
+	GPUFormat src_fmt;
+	GPUFormat dst_fmt;
+
+	std::vector<subresource_info> src_subres;
+	std::vector<subresource_info> dst_subres;
+	tagged_vector<u8, MEMORY_TAG_EDITOR> pixels;
+	tagged_vector<u8, MEMORY_TAG_EDITOR> encoded;
+};
+
+// lays out every subresource and copies the source into it in the channel order of the intermediate format
+void texture_encode_begin(texture_encode_context& ctx, import_texture_type type, std::span<const u8> data, uvec3 dim);
+// filters each level from the one above, cubemaps arrive with their mips already
+void texture_generate_mips(texture_encode_context& ctx);
+void texture_compress(texture_encode_context& ctx);
+
 ResourceID import_geometry(geometry_import_context& ctx);
 ResourceID import_texture(std::string_view name, import_texture_type type, std::span<const u8> data, uvec3 dim);
 
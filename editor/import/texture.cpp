@@ -1,4 +1,5 @@
 #include <import/resource.hpp>
+#include <penumbra/math/fastmath.hpp>
 #include <penumbra/math/vector.hpp>
 #include <penumbra/math/utility.hpp>
 #include <penumbra/gpu.hpp>
@@ -66,16 +67,6 @@ constexpr const std::array<ImageChannel, 5> type_remaps[] =
 	{ImageChannel::R, ImageChannel::G, ImageChannel::B, ImageChannel::A}
 };
 
-struct subresource_info
-{
-	u32 width;
-	u32 height;
-	u32 level;
-	u32 layer;
-	u32 byte_offset;
-	u32 size_bytes;
-};
-
 struct texture_info
 {
 	std::span<u8> pixels;
@@ -147,55 +138,31 @@ struct InputFormatRGBA8Unorm
 	}
 };
 
+// decodes through the exact 8 bit table and encodes through the bucketed one, no pow per texel
 struct InputFormatRGBA8Srgb : public InputFormatRGBA8Unorm
 {
-	constexpr static float srgb_gamma_to_linear(float v)
-	{
-		if(v <= 0.04045f)
-			return v * (1.0f / 12.92f);
-		else
-			return std::pow((v + 0.055f) / (1.0f + 0.055f), 2.4f);
-	}
-
-	constexpr static float srgb_linear_to_gamma(float v)
-	{
-		if(v <= 0.0031308f)
-			return 12.92f * v;
-		else
-			return (1.0f + 0.055f) * std::pow(v, 1.0f / 2.4f) - 0.055f;
-	}
-
-	constexpr static vec4 srgb_gamma_to_linear(const vec4& v)
+	vec4 sample(const texture_info& tex, const subresource_info& subres, const uvec2& coords) const noexcept
 	{
+		bvec4& val = *access_uv<bvec4>(tex, subres, coords);
 		return vec4
 		{
-			srgb_gamma_to_linear(v.x),
-			srgb_gamma_to_linear(v.y),
-			srgb_gamma_to_linear(v.z),
-			v.w
+			srgb8_to_linear(val.x),
+			srgb8_to_linear(val.y),
+			srgb8_to_linear(val.z),
+			static_cast<float>(val.w) * (1.0f / 255.0f)
 		};
 	}
 
-	constexpr static vec4 srgb_linear_to_gamma(const vec4& v)
+	void write(const texture_info& tex, const subresource_info& subres, const uvec2& coords, const vec4& input) const noexcept
 	{
-		return vec4
+		*access_uv<bvec4>(tex, subres, coords) = bvec4
 		{
-			srgb_linear_to_gamma(v.x),
-			srgb_linear_to_gamma(v.y),
-			srgb_linear_to_gamma(v.z),
-			v.w
+			linear_to_srgb8(input.x),
+			linear_to_srgb8(input.y),
+			linear_to_srgb8(input.z),
+			static_cast<u8>(std::clamp(std::round(input.w * 255.0f), 0.0f, 255.0f))
 		};
 	}
-
-	constexpr vec4 sample(const texture_info& tex, const subresource_info& subres, const uvec2& coords) const noexcept
-	{
-		return srgb_gamma_to_linear(InputFormatRGBA8Unorm::sample(tex, subres, coords));
-	}
-
-	constexpr void write(const texture_info& tex, const subresource_info& subres, const uvec2& coords, const vec4& input) const noexcept
-	{
-		InputFormatRGBA8Unorm::write(tex, subres, coords, srgb_linear_to_gamma(input));
-	}
 };
 
 template <typename Fmt>
@@ -247,18 +214,23 @@ static void mipgen(const texture_info& tex, const Fmt& fmt)
 	}
 }
 
-ResourceID import_texture(std::string_view name, import_texture_type type, std::span<const u8> data, uvec3 dim)
+void texture_encode_begin(texture_encode_context& ctx, import_texture_type type, std::span<const u8> data, uvec3 dim)
 {
-	u32 num_layers = (type == IMPORT_TEXTURE_CUBEMAP) ? 6u : 1u;
-	u32 num_mips = get_mip_levels(dim.x, dim.y);
+	ctx.type = type;
+	ctx.dim = dim;
+	ctx.num_layers = (type == IMPORT_TEXTURE_CUBEMAP) ? 6u : 1u;
+	ctx.num_mips = get_mip_levels(dim.x, dim.y);
 
-	u32 num_subres = num_mips * num_layers;
+	u32 num_layers = ctx.num_layers;
+	u32 num_subres = ctx.num_mips * num_layers;
 
-	std::vector<subresource_info> src_subres(num_subres);
-	std::vector<subresource_info> dst_subres(num_subres);
+	auto& src_subres = ctx.src_subres;
+	auto& dst_subres = ctx.dst_subres;
+	src_subres.resize(num_subres);
+	dst_subres.resize(num_subres);
 
-	auto src_fmt = src_format_from_type[std::to_underlying(type)];
-	auto dst_fmt = dst_format_from_type[std::to_underlying(type)];
+	auto src_fmt = ctx.src_fmt = src_format_from_type[std::to_underlying(type)];
+	auto dst_fmt = ctx.dst_fmt = dst_format_from_type[std::to_underlying(type)];
 
 	u32 s_acc = 0;
 	u32 d_acc = 0;
@@ -293,7 +265,6 @@ ResourceID import_texture(std::string_view name, import_texture_type type, std::
 	}
 
 	u32 source_size = s_acc;
-	u32 dest_size = d_acc;
 
 	auto channel_map = type_remaps[std::to_underlying(type)];
 	u32 required_channels = 0;
@@ -303,7 +274,10 @@ ResourceID import_texture(std::string_view name, import_texture_type type, std::
 			required_channels++;
 	}
 
-	std::vector<u8> pixels(source_size);
+	auto& pixels = ctx.pixels;
+	pixels.resize(source_size);
+	ctx.encoded.resize(d_acc);
+
 	u32 fmt_mul = (src_fmt == GPU_FORMAT_RGBA16_SFLOAT) ? 2u : 1u;
 	u32 w_subres = num_layers > 1 ? num_subres : 1u;
 	u32 data_offset = 0;
@@ -341,13 +315,16 @@ ResourceID import_texture(std::string_view name, import_texture_type type, std::
 		else
 			data_offset += gpu_format_size(GPU_FORMAT_RGBA8_UNORM, src_subres[i].width, src_subres[i].height, 1u);
 	}
+}
 
-	texture_info mg_tex{pixels, src_fmt, dst_fmt, src_subres, dst_subres};
+void texture_generate_mips(texture_encode_context& ctx)
+{
+	if(ctx.num_layers != 1)
+		return;
 
-	if(num_layers == 1)
-	{
-	
-	switch(src_fmt)
+	texture_info mg_tex{ctx.pixels, ctx.src_fmt, ctx.dst_fmt, ctx.src_subres, ctx.dst_subres};
+
+	switch(ctx.src_fmt)
 	{
 	case GPU_FORMAT_R8_UNORM:
 		mipgen(mg_tex, InputFormatR8Unorm());
@@ -364,16 +341,15 @@ ResourceID import_texture(std::string_view name, import_texture_type type, std::
 	default:
 		std::unreachable();
 	}
+}
 
-	}
-
-	std::vector<u8> encode_buffer(dest_size);
-
+void texture_compress(texture_encode_context& ctx)
+{
 	bc7_enc_settings bc7 = {};
-	switch(type)
+	switch(ctx.type)
 	{
 	case IMPORT_TEXTURE_ALBEDO:
-		if(dim.z == 4)
+		if(ctx.dim.z == 4)
 			GetProfile_alpha_fast(&bc7);
 		else
 			GetProfile_fast(&bc7);
@@ -385,20 +361,20 @@ ResourceID import_texture(std::string_view name, import_texture_type type, std::
 	bc6h_enc_settings bc6h = {};
 	GetProfile_bc6h_fast(&bc6h);
 
-	for(u32 l = 0; l < num_subres; l++)
+	for(u32 l = 0; l < ctx.src_subres.size(); l++)
 	{
-		auto& src = src_subres[l];
-		auto& dst = dst_subres[l];
+		auto& src = ctx.src_subres[l];
+		auto& dst = ctx.dst_subres[l];
 
 		rgba_surface padded_surface = {};
 		padded_surface.width = src.width;
 		padded_surface.height = src.height;
-		padded_surface.stride = src.width * gpu_format_blocksize(src_fmt);
-		padded_surface.ptr = reinterpret_cast<u8*>(pixels.data()) + src.byte_offset;
+		padded_surface.stride = src.width * gpu_format_blocksize(ctx.src_fmt);
+		padded_surface.ptr = reinterpret_cast<u8*>(ctx.pixels.data()) + src.byte_offset;
 
-		u8* encode_ptr = encode_buffer.data() + dst.byte_offset;
+		u8* encode_ptr = ctx.encoded.data() + dst.byte_offset;
 		
-		switch(dst_fmt)
+		switch(ctx.dst_fmt)
 		{
 		case GPU_FORMAT_BC7_SRGB:
 		case GPU_FORMAT_BC7_UNORM:
@@ -414,16 +390,24 @@ ResourceID import_texture(std::string_view name, import_texture_type type, std::
 			std::unreachable();
 		}
 	}
+}
+
+ResourceID import_texture(std::string_view name, import_texture_type type, std::span<const u8> data, uvec3 dim)
+{
+	texture_encode_context ctx;
+	texture_encode_begin(ctx, type, data, dim);
+	texture_generate_mips(ctx);
+	texture_compress(ctx);
 
 	return resource_manager_import_texture(name, 
 	{
-		.type = (num_layers) == 6 ? GPU_TEXTURE_CUBE : GPU_TEXTURE_2D,
+		.type = (ctx.num_layers) == 6 ? GPU_TEXTURE_CUBE : GPU_TEXTURE_2D,
 		.dim = {dim.w, dim.h, 1u},
-		.mip_count = num_mips,
-		.layer_count = num_layers,
-		.format = dst_fmt,
+		.mip_count = ctx.num_mips,
+		.layer_count = ctx.num_layers,
+		.format = ctx.dst_fmt,
 		.usage = GPU_TEXTURE_SAMPLED
-	}, {reinterpret_cast<const u8*>(encode_buffer.data()), dest_size});
+	}, {reinterpret_cast<const u8*>(ctx.encoded.data()), ctx.encoded.size()});
 }
 
 }
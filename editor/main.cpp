@@ -3,10 +3,9 @@
 #include <core.hpp>
 #include <world/state.hpp>
 
-#include <tracy/Tracy.hpp>
-
-#include <chrono>
-#include <cmath>
+#include <algorithm>
+#include <string_view>
+#include <vector>
 
 using namespace penumbra;
 
@@ -28,13 +27,38 @@ static cvar_t tickrate
 
 int main(int argc, const char** argv)
 {
-	log_init();
-	log::info("penumbra git-{}", config::git_hash);
+	// --record <path> and --replay <path> are consumed here, everything else goes to the editor
+	const char* record_path = nullptr;
+	const char* replay_path = nullptr;
+	std::vector<const char*> args;
+	for(int i = 0; i < argc; i++)
+	{
+		const std::string_view arg{argv[i]};
+		if(arg == "--record" && i + 1 < argc)
+			record_path = argv[++i];
+		else if(arg == "--replay" && i + 1 < argc)
+			replay_path = argv[++i];
+		else
+			args.push_back(argv[i]);
+	}
+
+	log_init("penumbra.binlog");
+	PENUMBRA_LOG_INFO("penumbra git-{}", config::git_hash);
+
+	profile_init();
+	profile_set_thread_name("main");
 
 	cvar_register(&fps_limit);
 	cvar_register(&tickrate);
 
+	job_init();
 	vfs_init();
+	cvar_load("penumbra.cfg");
+
+	// warm the page cache with what the last run touched during startup and record this run for the next one
+	vfs_readahead_start("startup.vfstrace");
+	vfs_trace_begin();
+
 	wm_init();
 	input_init();
 
@@ -45,77 +69,61 @@ int main(int argc, const char** argv)
 
 	physics_create_world({});
 
-	auto start = std::chrono::steady_clock::now();
 	auto world_state = std::make_unique<WorldState>();
-	auto editor = std::make_unique<Editor>(window, world_state.get(), argc, argv);
+	auto editor = std::make_unique<Editor>(window, world_state.get(), static_cast<int>(args.size()), args.data());
+
+	vfs_trace_end("startup.vfstrace");
+
+	if(replay_path)
+		input_replay_begin(replay_path);
+	if(record_path)
+		input_record_begin(record_path);
 
-	std::chrono::steady_clock::duration accumulator{0};
-	std::chrono::microseconds fixed_timestep{int(1.0 / double(tickrate.int_v) * 1e6)};
+	frame_pacer_t frame_pacer;
+	frame_pacer_init(frame_pacer, static_cast<u32>(std::max(fps_limit.int_v, 0)));
+
+	// the fixed rate simulation ticks on its own thread and overlaps the frame instead of adding to it,
+	// the main thread only sees the published transforms and interpolates between the last two ticks
+	sim_init(static_cast<u32>(std::max(tickrate.int_v, 1)), [&editor](double dt)
+	{
+		editor->fixed_update(dt);
+		physics_world_simulate(static_cast<float>(dt), 4);
+
+		physics_world_write_transforms(sim_snapshot_begin());
+		sim_snapshot_publish();
+	});
 
 	while(!wm_requested_close())
 	{
-		ZoneScopedN("Main Loop");
+		PROFILE_ZONE_N("Main Loop");
 		
-		const auto end = std::chrono::steady_clock::now();
-		const auto frame_time = end - start;
-		start = end;
-		accumulator += frame_time;
-
 		renderer_next_frame();
+		vfs_tick();
 		wm_poll_events();
 		input_poll();
 
-		while(accumulator >= fixed_timestep)
-		{
-			ZoneScopedN("Fixed Update");
-			editor->fixed_update(double(fixed_timestep.count()) / 1e6);
-			physics_world_simulate(double(fixed_timestep.count()) / 1e6, 4);
-			accumulator -= fixed_timestep;
-		}
-		
-		{
-			ZoneScopedN("VRR Update");
-			editor->variable_update(double(frame_time.count()) / 1e9);
-		}
-		renderer_process_frame(double(frame_time.count()) / 1e9);
+		// measured between polls, or taken from the recording so a replay steps the frame identically
+		const double frame_time = input_frame_delta();
+		sim_set_rate(static_cast<u32>(std::max(tickrate.int_v, 1)));
 
-		std::chrono::nanoseconds vrr_timestep{int(1.0 / double(fps_limit.int_v) * 1e9)};
-		auto ft = std::chrono::steady_clock::now() - start;
-		auto sleep_time = vrr_timestep - ft;
-		if(vrr_timestep > ft)
 		{
-			ZoneScopedN("sleep");
-			static double estimate = 5e-3;
-			static double mean = 5e-3;
-			static double m2 = 0;
-			static int64_t count = 1;
-			double seconds = double(sleep_time.count()) / 1e9;
-			while(seconds > estimate)
-			{
-				auto slp_start = std::chrono::steady_clock::now();
-				std::this_thread::sleep_for(std::chrono::milliseconds(1));
-				auto slp_end = std::chrono::steady_clock::now();
-
-				double observed = (slp_end - slp_start).count() / 1e9;
-				seconds -= observed;
-
-				++count;
-				double delta = observed - mean;
-				mean += delta / count;
-				m2 += delta * (observed - mean);
-				double stddev = std::sqrt(m2 / (count - 1));
-				estimate = mean + stddev;
-			}
-
-			auto spin_start = std::chrono::steady_clock::now();
-			auto spinNS = int64_t(seconds * 1e9);
-			auto delay = std::chrono::nanoseconds(spinNS);
-			while(std::chrono::steady_clock::now() - spin_start < delay) {}
+			PROFILE_ZONE_N("VRR Update");
+			editor->variable_update(frame_time);
 		}
+		renderer_process_frame(frame_time);
+
+		frame_pacer_set_rate(frame_pacer, static_cast<u32>(std::max(fps_limit.int_v, 0)));
+		frame_pacer_wait(frame_pacer);
 
-		FrameMark;
+		PROFILE_FRAME;
 	}
 
+	const frame_pacer_stats pacing = frame_pacer_get_stats(frame_pacer);
+	PENUMBRA_LOG_INFO("frame pacing: {} frames, {:.3f} ms mean, {:.3f} ms stddev, {} missed, {:.1f} ms spinning",
+		pacing.frames, pacing.mean_ms, pacing.stddev_ms, pacing.missed, pacing.spin_ms);
+
+	sim_shutdown();
+
 	gpu_wait_idle();
 	editor.reset();
 
@@ -128,4 +136,7 @@ int main(int argc, const char** argv)
 	input_shutdown();
 	wm_shutdown();
 	vfs_shutdown();
+	job_shutdown();
+	profile_shutdown();
+	log_shutdown();
 }
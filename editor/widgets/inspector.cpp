@@ -340,8 +340,14 @@ void Inspector::on_draw()
 */
 		if(!rb && ImGui::Selectable("Rigidbody"))
 		{
-			auto body = physics_create_body({});
-			rb = &graph.emplace<rigidbody_component>(world->selected_entity, physicsBodyDesc{}, body);
+			const physicsBodyDesc desc
+			{
+				.initial_transform = transform,
+				.userdata = static_cast<u64>(world->selected_entity)
+			};
+
+			auto body = physics_create_body(desc);
+			rb = &graph.emplace<rigidbody_component>(world->selected_entity, desc, body);
 		}
 		
 		if(!has_collider && ImGui::Selectable("Sphere collider"))
@@ -149,7 +149,7 @@ void Viewport::on_draw()
 		}	
 	}
 
-	ui::draw_device_overlay({u32(g_root_x), u32(g_root_y)});
+	ui::draw_device_overlay({u32(g_root_x), u32(g_root_y)}, show_memory);
 	ImGui::PopStyleVar(2);
 }
 
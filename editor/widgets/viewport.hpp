@@ -35,6 +35,16 @@ public:
 		return tool;
 	}
 
+	void set_show_memory(bool show)
+	{
+		show_memory = show;
+	}
+
+	bool get_show_memory() const
+	{
+		return show_memory;
+	}
+
 	void on_draw() override;
 private:
 	void transform_gizmo(float root_x, float root_y);
@@ -51,6 +61,7 @@ private:
 	uvec2 picking_pos{0u, 0u};
 
 	ViewportTool tool{ViewportTool::Translate};
+	bool show_memory{false};
 };
 
 }
@@ -42,6 +42,48 @@ void load_prefab(WorldState& world, const vfs_path& path)
 		return reinterpret_cast<const char*>(pdata + header->string_table_offset + offset);
 	};
 	const auto* mtl_table = reinterpret_cast<const PrefabFileFormat::Material*>(pdata + header->material_table_offset);
+	const auto* node_table = reinterpret_cast<const PrefabFileFormat::Node*>(pdata + header->node_table_offset);
+
+	// gather every file the prefab references up front so the reads are issued as one batch
+	// the per-node loads below then resolve from the resource caches
+	{
+		std::vector<vfs_path> texture_paths;
+		for(u32 i = 0; i < header->material_table_count; i++)
+		{
+			for(u32 tex : {mtl_table[i].albedo, mtl_table[i].mro, mtl_table[i].normalmap, mtl_table[i].emissive})
+			{
+				if(tex > 0)
+					texture_paths.push_back(vfs_path{"textures"} / read_string_table(tex));
+			}
+		}
+
+		std::vector<vfs_path> mesh_paths;
+		for(u32 i = 0; i < header->node_table_count; i++)
+		{
+			u32 c_passed = 0;
+			const auto* cptr = pdata + node_table[i].components_offset;
+			while(c_passed < std::min(node_table[i].component_count, 64u))
+			{
+				c_passed++;
+				const auto* cmp = reinterpret_cast<const PrefabFileFormat::Component*>(cptr);
+				if(cmp->type != PrefabFileFormat::ComponentType::STATIC_MESH && cmp->type != PrefabFileFormat::ComponentType::SKINNED_MESH)
+				{
+					cptr += sizeof(PrefabFileFormat::Component);
+					continue;
+				}
+
+				const auto* smc = reinterpret_cast<const PrefabFileFormat::StaticMeshComponent*>(cptr);
+				if(smc->mesh)
+					mesh_paths.push_back(vfs_path{"meshes"} / read_string_table(smc->mesh));
+
+				cptr += (cmp->type == PrefabFileFormat::ComponentType::SKINNED_MESH) ? sizeof(PrefabFileFormat::SkinnedMeshComponent) : sizeof(PrefabFileFormat::StaticMeshComponent);
+			}
+		}
+
+		resource_manager_load_batch(RESOURCE_TYPE_TEXTURE, texture_paths);
+		resource_manager_load_batch(RESOURCE_TYPE_GEOMETRY, mesh_paths);
+	}
+
 	std::map<u32, ResourceID> mtl_map;
 
 	for(u32 i = 0; i < header->material_table_count; i++)
@@ -70,8 +112,6 @@ void load_prefab(WorldState& world, const vfs_path& path)
 		
 	}
 
-	const auto* node_table = reinterpret_cast<const PrefabFileFormat::Node*>(pdata + header->node_table_offset);
-
 	ecs::entity root_entity = world.spawn(path.string());
 	add_entity_as_child(graph, world.root, root_entity);
 
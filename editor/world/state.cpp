@@ -7,8 +7,8 @@
 #include <penumbra/renderer.hpp>
 #include <penumbra/resource.hpp>
 #include <penumbra/math/transform.hpp>
+#include <penumbra/profile.hpp>
 #include <penumbra/types.hpp>
-#include <tracy/Tracy.hpp>
 #include <string>
 #include <cassert>
 
@@ -60,7 +60,7 @@ void unlink_entity(ecs::registry& graph, ecs::entity entity)
 
 mat4 get_entity_world_matrix(ecs::registry& graph, ecs::entity entity)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	entity_relationship& re = graph.get<entity_relationship>(entity);
 	Transform& tx = graph.get<Transform>(entity);
@@ -115,20 +115,60 @@ void WorldState::update_transforms()
 	}
 }
 
+// breadth first, so every parent is before its children, parent indices are one based with zero for the subtree root
+static void flatten_subtree(ecs::registry& graph, ecs::entity entity, transform_propagation_scratch& out)
+{
+	out.entities.clear();
+	out.parents.clear();
+	out.translation.clear();
+	out.rotation.clear();
+	out.scale.clear();
+
+	ecs::entity parent = entity;
+	u32 parent_index = 0u;
+	while(true)
+	{
+		ecs::entity child = graph.get<entity_relationship>(parent).first_child;
+		while(graph.valid(child))
+		{
+			const Transform& tx = graph.get<Transform>(child);
+			out.entities.push_back(child);
+			out.parents.push_back(parent_index);
+			out.translation.push_back(tx.translation);
+			out.rotation.push_back(tx.rotation);
+			out.scale.push_back(tx.scale);
+			child = graph.get<entity_relationship>(child).next_sibling;
+		}
+
+		if(parent_index == out.entities.size())
+			break;
+
+		parent = out.entities[parent_index++];
+	}
+}
+
 void WorldState::update_entity_subtree(ecs::entity entity, mat4 matrix_world)
 {
+	PROFILE_ZONE;
+
 	auto* robj = entities.try_get<render_object_component>(entity);
 	if(robj)
 	{
 		renderer_world_update_object(robj->renderer_objectID, matrix_world);
 	}
 
-	entity_relationship& re = entities.get<entity_relationship>(entity);
-	ecs::entity child = re.first_child;
-	while(entities.valid(child))
+	flatten_subtree(entities, entity, propagation);
+
+	const u32 count = static_cast<u32>(propagation.entities.size());
+	propagation.world.resize(count);
+
+	const transform_batch_t batch{propagation.translation.data(), propagation.rotation.data(), propagation.scale.data(), count};
+	transform_compose_hierarchy(batch, propagation.parents.data(), &matrix_world, propagation.world.data());
+
+	for(u32 i = 0; i < count; i++)
 	{
-		update_entity_subtree(child, entities.get<Transform>(child).as_matrix() * matrix_world);
-		child = entities.get<entity_relationship>(child).next_sibling;
+		if(auto* child_robj = entities.try_get<render_object_component>(propagation.entities[i]))
+			renderer_world_update_object(child_robj->renderer_objectID, propagation.world[i]);
 	}
 }
 
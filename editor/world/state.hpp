@@ -2,6 +2,7 @@
 
 #include <world/envmap.hpp>
 #include <penumbra/math/transform.hpp>
+#include <penumbra/allocator.hpp>
 #include <penumbra/ecs.hpp>
 #include <penumbra/renderer.hpp>
 #include <penumbra/types.hpp>
@@ -26,6 +27,17 @@ void unlink_entity(ecs::registry& graph, ecs::entity entity);
 struct transform_dirty_t{};
 mat4 get_entity_world_matrix(ecs::registry& graph, ecs::entity entity);
 
+// a subtree flattened parents first for batched composition, kept between updates so it only grows to the largest subtree
+struct transform_propagation_scratch
+{
+	tagged_vector<ecs::entity, MEMORY_TAG_EDITOR> entities;
+	tagged_vector<u32, MEMORY_TAG_EDITOR> parents;
+	tagged_vector<vec3, MEMORY_TAG_EDITOR> translation;
+	tagged_vector<Quaternion, MEMORY_TAG_EDITOR> rotation;
+	tagged_vector<vec3, MEMORY_TAG_EDITOR> scale;
+	tagged_vector<mat4, MEMORY_TAG_EDITOR> world;
+};
+
 struct WorldState
 {
 	WorldState();
@@ -41,6 +53,8 @@ struct WorldState
 	ecs::entity main_camera;
 	ecs::entity env;
 	render_environment_map r_envmap;
+
+	transform_propagation_scratch propagation;
 };
 
 }
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <penumbra/types.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace penumbra
+{
+
+// the subsystem memory is accounted to, by what owns the memory and not by which thread allocated it
+enum memory_tag : u32
+{
+	MEMORY_TAG_CORE,
+	MEMORY_TAG_VFS,
+	MEMORY_TAG_RESOURCE,
+	MEMORY_TAG_RENDERER,
+	MEMORY_TAG_PHYSICS,
+	MEMORY_TAG_EDITOR,
+	MEMORY_TAG_COUNT
+};
+
+constexpr const char* memory_tag_names[] =
+{
+	"core",
+	"vfs",
+	"resource",
+	"renderer",
+	"physics",
+	"editor"
+};
+
+struct memory_stats_t
+{
+	u64 current;
+	u64 peak;
+	u64 budget;
+
+	// running totals, rates come from the difference between two samples
+	u64 allocations;
+	u64 frees;
+	u64 allocated_bytes;
+};
+
+void memory_track_alloc(memory_tag tag, size_t size);
+void memory_track_free(memory_tag tag, size_t size);
+memory_stats_t memory_get_stats(memory_tag tag);
+// 0 removes the budget, going over it logs a warning once until usage drops back below
+void memory_set_budget(memory_tag tag, size_t bytes);
+
+// std::allocator that accounts everything it hands out to a tag, for containers owned by one subsystem
+template <typename T, memory_tag Tag>
+struct tagged_allocator
+{
+	using value_type = T;
+
+	template <typename U>
+	struct rebind { using other = tagged_allocator<U, Tag>; };
+
+	constexpr tagged_allocator() noexcept = default;
+
+	template <typename U>
+	constexpr tagged_allocator(const tagged_allocator<U, Tag>&) noexcept {}
+
+	T* allocate(size_t count)
+	{
+		memory_track_alloc(Tag, sizeof(T) * count);
+		return std::allocator<T>{}.allocate(count);
+	}
+
+	void deallocate(T* ptr, size_t count) noexcept
+	{
+		memory_track_free(Tag, sizeof(T) * count);
+		std::allocator<T>{}.deallocate(ptr, count);
+	}
+
+	template <typename U>
+	constexpr bool operator==(const tagged_allocator<U, Tag>&) const noexcept { return true; }
+};
+
+template <typename T, memory_tag Tag>
+using tagged_vector = std::vector<T, tagged_allocator<T, Tag>>;
+
+// linear allocator over one fixed block, individual allocations are never freed, only the whole arena is reset
+// running past the capacity falls back to the heap until the next reset so a too small arena is slow, not fatal
+struct arena_t
+{
+	const char* name{nullptr};
+	memory_tag tag{MEMORY_TAG_CORE};
+	u8* base{nullptr};
+	size_t capacity{0};
+	size_t offset{0};
+
+	// heap blocks handed out after the arena ran full, released on reset
+	struct overflow_block* overflow{nullptr};
+	size_t overflow_size{0};
+
+	size_t high_water{0};
+	u64 resets{0};
+	bool overflow_reported{false};
+
+	arena_t* next{nullptr};
+};
+
+using arena_marker = size_t;
+
+void arena_create(arena_t& arena, size_t capacity, const char* name, memory_tag tag = MEMORY_TAG_CORE);
+void arena_destroy(arena_t& arena);
+void* arena_alloc(arena_t& arena, size_t size, size_t alignment = alignof(std::max_align_t));
+void arena_reset(arena_t& arena);
+
+// rewinding frees everything allocated after the marker, allocations that overflowed to the heap stay until reset
+arena_marker arena_mark(const arena_t& arena);
+void arena_rewind(arena_t& arena, arena_marker marker);
+
+template <typename T>
+T* arena_alloc_array(arena_t& arena, size_t count)
+{
+	return reinterpret_cast<T*>(arena_alloc(arena, sizeof(T) * count, alignof(T)));
+}
+
+constexpr u32 FRAME_ARENA_MAX_SLOTS = 4u;
+
+// one arena per frame slot, memory allocated in a slot stays valid until the same slot comes around again,
+// a single slot resets every frame while config::renderer_frames_in_flight slots outlive the gpu reading them
+struct frame_arena_t
+{
+	arena_t slots[FRAME_ARENA_MAX_SLOTS];
+	u32 num_slots{0};
+	u32 current{0};
+};
+
+void frame_arena_create(frame_arena_t& frame, u32 num_slots, size_t capacity, const char* name, memory_tag tag = MEMORY_TAG_CORE);
+void frame_arena_destroy(frame_arena_t& frame);
+// moves on to the next slot and resets it
+void frame_arena_next(frame_arena_t& frame);
+arena_t& frame_arena_current(frame_arena_t& frame);
+
+// fixed size blocks carved out of chunks that are only returned on destroy
+struct pool_t
+{
+	const char* name{nullptr};
+	memory_tag tag{MEMORY_TAG_CORE};
+	size_t block_size{0};
+	size_t blocks_per_chunk{0};
+
+	struct pool_chunk* chunks{nullptr};
+	void* free_list{nullptr};
+
+	size_t live{0};
+	size_t high_water{0};
+	size_t capacity{0};
+
+	pool_t* next{nullptr};
+};
+
+void pool_create(pool_t& pool, size_t block_size, size_t blocks_per_chunk, const char* name, memory_tag tag = MEMORY_TAG_CORE);
+void pool_destroy(pool_t& pool);
+void* pool_alloc(pool_t& pool);
+void pool_free(pool_t& pool, void* ptr);
+
+// logs the per tag totals, then usage and high water marks of every live arena and pool
+void allocator_dump_stats();
+
+// std::pmr adapters, deallocate is a no-op for arenas
+class arena_resource final : public std::pmr::memory_resource
+{
+public:
+	explicit arena_resource(arena_t* arena) noexcept : arena{arena} {}
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	arena_t* arena;
+};
+
+// always allocates from whichever slot is current, containers built on it must be emptied by rebuilding them
+// before their slot is reused
+class frame_arena_resource final : public std::pmr::memory_resource
+{
+public:
+	explicit frame_arena_resource(frame_arena_t* frame) noexcept : frame{frame} {}
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	frame_arena_t* frame;
+};
+
+// requests that fit a block come from the pool, anything larger goes to upstream
+class pool_resource final : public std::pmr::memory_resource
+{
+public:
+	explicit pool_resource(pool_t* pool, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept : pool{pool}, upstream{upstream} {}
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	pool_t* pool;
+	std::pmr::memory_resource* upstream;
+};
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <penumbra/types.hpp>
+
+namespace penumbra
+{
+
+// LZ4 compatible block codec, every call produces/consumes one self contained block
+size_t lz_compress_bound(size_t size);
+
+// returns the compressed size, 0 if dst_capacity is too small
+size_t lz_compress(const u8* src, size_t src_size, u8* dst, size_t dst_capacity);
+
+// fails on malformed input or if the block does not decode to exactly dst_size bytes
+bool lz_decompress(const u8* src, size_t src_size, u8* dst, size_t dst_size);
+
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <penumbra/hash.hpp>
+#include <penumbra/vfs.hpp>
 #include <penumbra/types.hpp>
 
+#include <string_view>
+
 namespace penumbra
 {
 
@@ -12,6 +16,13 @@ enum cvar_type
 	CVAR_TYPE_STRING
 };
 
+enum cvar_flag_bits : u32
+{
+	CVAR_FLAG_NONE		= 0x0,
+	// the callback is not safe to run from wherever the value changes, it is queued until cvar_flush
+	CVAR_FLAG_DEFERRED	= 0x1,
+};
+
 struct cvar_t
 {
 	const char* name;
@@ -32,13 +43,24 @@ struct cvar_t
 	};
 
 	void (*callback)(cvar_t* cvar){nullptr};
+	u32 flags{CVAR_FLAG_NONE};
 
-	cvar_t* next{nullptr};
+	u32 hash{0u};
+	bool queued{false};
 };
 
-
+// cvars are looked up by the fnv hash of their name, hot code should pass "name"_fnv instead of the string
 void cvar_register(cvar_t* cvar);
-cvar_t* cvar_get(const char* name);
+cvar_t* cvar_get(u32 hash);
+cvar_t* cvar_get(std::string_view name);
 void cvar_set(cvar_t* cvar, u64 value);
+// parses the value from text, string values are copied into storage owned by the registry
+bool cvar_set_string(cvar_t* cvar, std::string_view value);
+
+// applies a config file of "name value" lines in one pass, every changed cvar gets its callback once
+// values for cvars that are not registered yet are kept and applied when they are
+bool cvar_load(const vfs_path& path);
+// runs the queued callbacks of deferred cvars, call at a point in the frame where they are safe
+void cvar_flush();
 
 }
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <penumbra/allocator.hpp>
+
 #include <entt/entity/entity.hpp>
 #include <entt/entity/registry.hpp>
 
 namespace penumbra::ecs
 {
 	using entt::entity;
-	using entt::registry;
+	// component pools are accounted to the editor, the only place a registry lives
+	using registry = entt::basic_registry<entity, tagged_allocator<entity, MEMORY_TAG_EDITOR>>;
 	using entt::null;
 }
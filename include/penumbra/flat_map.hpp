@@ -0,0 +1,621 @@
+#pragma once
+
+#include <penumbra/hash.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if defined __SSE2__ || defined _M_X64
+#include <emmintrin.h>
+#define PENUMBRA_FLAT_MAP_SSE2
+#endif
+
+namespace penumbra
+{
+
+namespace detail
+{
+
+// 15 tags and an overflow byte, a tag of 0 marks an empty slot
+struct alignas(16) flat_group
+{
+	static constexpr u32 size = 15u;
+	static constexpr u32 full_mask = 0x7fffu;
+
+	u8 tags[size];
+	// bit (hash >> 8) % 8 is set when a key with that hash probed past this group because it was full,
+	// a lookup that misses in a group without its bit set can stop there
+	u8 overflow;
+
+	u32 match(u8 tag) const
+	{
+#if defined PENUMBRA_FLAT_MAP_SSE2
+		const __m128i group = _mm_load_si128(reinterpret_cast<const __m128i*>(tags));
+		return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag))))) & full_mask;
+#else
+		u32 mask = 0u;
+		for(u32 i = 0; i < size; i++)
+			mask |= static_cast<u32>(tags[i] == tag) << i;
+
+		return mask;
+#endif
+	}
+
+	u32 match_empty() const
+	{
+		return match(0u);
+	}
+
+	u32 match_occupied() const
+	{
+		return ~match_empty() & full_mask;
+	}
+
+	bool overflowed(u64 hash) const
+	{
+		return overflow & (1u << ((hash >> 8) & 7u));
+	}
+
+	void mark_overflow(u64 hash)
+	{
+		overflow |= static_cast<u8>(1u << ((hash >> 8) & 7u));
+	}
+};
+
+static_assert(sizeof(flat_group) == 16);
+
+// open addressing over groups of 15 slots, a lookup compares 15 tags at once and usually touches a single group,
+// erase only clears the tag so there are no tombstones, a slot freed in an overflowed group counts against
+// the max load instead and the next rehash drops the stale overflow bits
+template <typename Key, typename Value, typename Traits, typename Hash, typename KeyEqual>
+class flat_table
+{
+public:
+	using key_type = Key;
+	using value_type = Value;
+	using size_type = size_t;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+
+	template <bool Const>
+	class table_iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Value;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<Const, const Value*, Value*>;
+		using reference = std::conditional_t<Const, const Value&, Value&>;
+
+		table_iterator() = default;
+
+		template <bool C = Const> requires C
+		table_iterator(const table_iterator<false>& other) : slot{other.slot}, group{other.group}, offset{other.offset}
+		{
+		}
+
+		reference operator*() const
+		{
+			return *slot;
+		}
+
+		pointer operator->() const
+		{
+			return slot;
+		}
+
+		// the sentinel group past the end always has an occupied tag so the scan needs no bounds check
+		table_iterator& operator++()
+		{
+			u32 mask = group->match_occupied() & (~1u << offset);
+			slot -= offset;
+			while(!mask)
+			{
+				group++;
+				slot += flat_group::size;
+				mask = group->match_occupied();
+			}
+
+			offset = static_cast<u32>(std::countr_zero(mask));
+			slot += offset;
+			return *this;
+		}
+
+		table_iterator operator++(int)
+		{
+			table_iterator prev = *this;
+			++*this;
+			return prev;
+		}
+
+		bool operator==(const table_iterator& other) const
+		{
+			return slot == other.slot;
+		}
+
+	private:
+		friend class flat_table;
+		friend class table_iterator<true>;
+
+		table_iterator(pointer slot, const flat_group* group, u32 offset) : slot{slot}, group{group}, offset{offset}
+		{
+		}
+
+		pointer slot{nullptr};
+		const flat_group* group{nullptr};
+		u32 offset{0u};
+	};
+
+	using iterator = std::conditional_t<Traits::is_set, table_iterator<true>, table_iterator<false>>;
+	using const_iterator = table_iterator<true>;
+
+	flat_table() = default;
+
+	explicit flat_table(size_t reserved)
+	{
+		reserve(reserved);
+	}
+
+	flat_table(const flat_table& other)
+	{
+		copy_from(other);
+	}
+
+	flat_table(flat_table&& other) noexcept
+	{
+		steal(other);
+	}
+
+	flat_table& operator=(const flat_table& other)
+	{
+		if(this != &other)
+		{
+			release();
+			copy_from(other);
+		}
+
+		return *this;
+	}
+
+	flat_table& operator=(flat_table&& other) noexcept
+	{
+		if(this != &other)
+		{
+			release();
+			steal(other);
+		}
+
+		return *this;
+	}
+
+	~flat_table()
+	{
+		release();
+	}
+
+	iterator begin()
+	{
+		return make_iterator<iterator>(first_occupied());
+	}
+
+	iterator end()
+	{
+		return make_iterator<iterator>(capacity());
+	}
+
+	const_iterator begin() const
+	{
+		return make_iterator<const_iterator>(first_occupied());
+	}
+
+	const_iterator end() const
+	{
+		return make_iterator<const_iterator>(capacity());
+	}
+
+	const_iterator cbegin() const
+	{
+		return begin();
+	}
+
+	const_iterator cend() const
+	{
+		return end();
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0u;
+	}
+
+	size_t capacity() const
+	{
+		return num_groups * flat_group::size;
+	}
+
+	void reserve(size_t reserved)
+	{
+		if(reserved > max_load)
+			rehash(std::max(groups_for(reserved), num_groups));
+	}
+
+	void clear()
+	{
+		if(!count)
+			return;
+
+		destroy_slots();
+		std::memset(groups, 0, sizeof(flat_group) * num_groups);
+		count = 0u;
+		max_load = load_limit(num_groups);
+	}
+
+	iterator find(const Key& key)
+	{
+		const size_t index = find_index(key, hash_key(key));
+		return make_iterator<iterator>(index == npos ? capacity() : index);
+	}
+
+	const_iterator find(const Key& key) const
+	{
+		const size_t index = find_index(key, hash_key(key));
+		return make_iterator<const_iterator>(index == npos ? capacity() : index);
+	}
+
+	bool contains(const Key& key) const
+	{
+		return find_index(key, hash_key(key)) != npos;
+	}
+
+	size_t erase(const Key& key)
+	{
+		const size_t index = find_index(key, hash_key(key));
+		if(index == npos)
+			return 0u;
+
+		erase_index(index);
+		return 1u;
+	}
+
+	// other iterators stay valid, erasing while iterating is fine as long as the iterator is advanced first
+	void erase(const_iterator pos)
+	{
+		erase_index(static_cast<size_t>(pos.slot - slots));
+	}
+
+protected:
+	static constexpr size_t npos = ~size_t{0};
+
+	static size_t load_limit(size_t groups)
+	{
+		return groups * flat_group::size * 7u / 8u;
+	}
+
+	static size_t groups_for(size_t elements)
+	{
+		const size_t slots = elements + elements / 7u + 1u;
+		return std::bit_ceil((slots + flat_group::size - 1u) / flat_group::size);
+	}
+
+	static u8 hash_tag(u64 hash)
+	{
+		const u8 tag = static_cast<u8>(hash);
+		return tag ? tag : 1u;
+	}
+
+	u64 hash_key(const Key& key) const
+	{
+		// std::hash of an integer is the identity, fold it so the tag and group bits both depend on every input bit
+		return xxh3::detail::mul128_fold64(static_cast<u64>(hasher{}(key)), 0x9e3779b97f4a7c15ull);
+	}
+
+	size_t home_group(u64 hash) const
+	{
+		return static_cast<size_t>(hash >> 16) & (num_groups - 1u);
+	}
+
+	size_t find_index(const Key& key, u64 hash) const
+	{
+		if(!count)
+			return npos;
+
+		const u8 tag = hash_tag(hash);
+		size_t pos = home_group(hash);
+		for(size_t step = 1; step <= num_groups; step++)
+		{
+			const flat_group& group = groups[pos];
+			for(u32 mask = group.match(tag); mask; mask &= mask - 1u)
+			{
+				const size_t index = pos * flat_group::size + static_cast<size_t>(std::countr_zero(mask));
+				if(key_equal{}(Traits::key(slots[index]), key))
+					return index;
+			}
+
+			if(!group.overflowed(hash))
+				break;
+
+			pos = (pos + step) & (num_groups - 1u);
+		}
+
+		return npos;
+	}
+
+	// triangular probing visits every group once, so with the load below 100% this always finds a slot
+	size_t find_free(u64 hash)
+	{
+		size_t pos = home_group(hash);
+		for(size_t step = 1;; step++)
+		{
+			flat_group& group = groups[pos];
+			if(const u32 mask = group.match_empty())
+				return pos * flat_group::size + static_cast<size_t>(std::countr_zero(mask));
+
+			group.mark_overflow(hash);
+			pos = (pos + step) & (num_groups - 1u);
+		}
+	}
+
+	size_t first_occupied() const
+	{
+		for(size_t pos = 0; pos < num_groups; pos++)
+		{
+			if(const u32 mask = groups[pos].match_occupied())
+				return pos * flat_group::size + static_cast<size_t>(std::countr_zero(mask));
+		}
+
+		return capacity();
+	}
+
+	template <typename It>
+	It make_iterator(size_t index) const
+	{
+		const size_t pos = index / flat_group::size;
+		return It{slots + index, groups + pos, static_cast<u32>(index - pos * flat_group::size)};
+	}
+
+	template <typename... Args>
+	std::pair<iterator, bool> emplace_unique(const Key& key, Args&&... args)
+	{
+		const u64 hash = hash_key(key);
+		if(const size_t index = find_index(key, hash); index != npos)
+			return {make_iterator<iterator>(index), false};
+
+		if(count >= max_load)
+			rehash(std::max(groups_for(count + 1u), num_groups));
+
+		const size_t index = find_free(hash);
+		std::construct_at(slots + index, std::forward<Args>(args)...);
+		groups[index / flat_group::size].tags[index % flat_group::size] = hash_tag(hash);
+		count++;
+
+		return {make_iterator<iterator>(index), true};
+	}
+
+	void erase_index(size_t index)
+	{
+		flat_group& group = groups[index / flat_group::size];
+		std::destroy_at(slots + index);
+		group.tags[index % flat_group::size] = 0u;
+		count--;
+
+		if(group.overflow)
+			max_load--;
+	}
+
+	void rehash(size_t new_groups)
+	{
+		flat_group* old_groups = groups;
+		Value* old_slots = slots;
+		const size_t old_num_groups = num_groups;
+
+		allocate(new_groups);
+
+		for(size_t pos = 0; pos < old_num_groups; pos++)
+		{
+			for(u32 mask = old_groups[pos].match_occupied(); mask; mask &= mask - 1u)
+			{
+				Value* old = old_slots + pos * flat_group::size + std::countr_zero(mask);
+				const u64 hash = hash_key(Traits::key(*old));
+				const size_t index = find_free(hash);
+
+				std::construct_at(slots + index, std::move(*old));
+				std::destroy_at(old);
+				groups[index / flat_group::size].tags[index % flat_group::size] = hash_tag(hash);
+			}
+		}
+
+		if(old_groups)
+		{
+			delete[] old_groups;
+			std::allocator<Value>{}.deallocate(old_slots, old_num_groups * flat_group::size);
+		}
+	}
+
+	void allocate(size_t new_groups)
+	{
+		// one extra group as the end sentinel for iteration
+		groups = new flat_group[new_groups + 1u]{};
+		groups[new_groups].tags[0] = 1u;
+		slots = std::allocator<Value>{}.allocate(new_groups * flat_group::size);
+		num_groups = new_groups;
+		max_load = load_limit(new_groups);
+	}
+
+	void destroy_slots()
+	{
+		if constexpr(!std::is_trivially_destructible_v<Value>)
+		{
+			for(size_t pos = 0; pos < num_groups; pos++)
+			{
+				for(u32 mask = groups[pos].match_occupied(); mask; mask &= mask - 1u)
+					std::destroy_at(slots + pos * flat_group::size + std::countr_zero(mask));
+			}
+		}
+	}
+
+	void release()
+	{
+		if(!groups)
+			return;
+
+		destroy_slots();
+		delete[] groups;
+		std::allocator<Value>{}.deallocate(slots, capacity());
+
+		groups = nullptr;
+		slots = nullptr;
+		num_groups = 0u;
+		count = 0u;
+		max_load = 0u;
+	}
+
+	void copy_from(const flat_table& other)
+	{
+		if(!other.groups)
+			return;
+
+		allocate(other.num_groups);
+		std::memcpy(groups, other.groups, sizeof(flat_group) * num_groups);
+		for(size_t pos = 0; pos < num_groups; pos++)
+		{
+			for(u32 mask = groups[pos].match_occupied(); mask; mask &= mask - 1u)
+			{
+				const size_t index = pos * flat_group::size + std::countr_zero(mask);
+				std::construct_at(slots + index, other.slots[index]);
+			}
+		}
+
+		count = other.count;
+		max_load = other.max_load;
+	}
+
+	void steal(flat_table& other)
+	{
+		groups = std::exchange(other.groups, nullptr);
+		slots = std::exchange(other.slots, nullptr);
+		num_groups = std::exchange(other.num_groups, 0u);
+		count = std::exchange(other.count, 0u);
+		max_load = std::exchange(other.max_load, 0u);
+	}
+
+	flat_group* groups{nullptr};
+	Value* slots{nullptr};
+	size_t num_groups{0u};
+	size_t count{0u};
+	size_t max_load{0u};
+};
+
+template <typename Key, typename T>
+struct flat_map_traits
+{
+	static constexpr bool is_set = false;
+
+	static const Key& key(const std::pair<const Key, T>& value)
+	{
+		return value.first;
+	}
+};
+
+template <typename Key>
+struct flat_set_traits
+{
+	static constexpr bool is_set = true;
+
+	static const Key& key(const Key& value)
+	{
+		return value;
+	}
+};
+
+}
+
+// insertion and rehashing invalidate iterators and references, erase only invalidates the erased element
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_map : public detail::flat_table<Key, std::pair<const Key, T>, detail::flat_map_traits<Key, T>, Hash, KeyEqual>
+{
+	using table = detail::flat_table<Key, std::pair<const Key, T>, detail::flat_map_traits<Key, T>, Hash, KeyEqual>;
+
+public:
+	using mapped_type = T;
+	using typename table::value_type;
+	using typename table::iterator;
+
+	using table::table;
+
+	template <typename... Args>
+	std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+	{
+		return this->emplace_unique(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template <typename... Args>
+	std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+	{
+		return this->emplace_unique(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		return this->emplace_unique(value.first, value);
+	}
+
+	std::pair<iterator, bool> insert(value_type&& value)
+	{
+		return this->emplace_unique(value.first, std::move(value));
+	}
+
+	template <typename M>
+	std::pair<iterator, bool> insert_or_assign(const Key& key, M&& value)
+	{
+		auto result = try_emplace(key, std::forward<M>(value));
+		if(!result.second)
+			result.first->second = std::forward<M>(value);
+
+		return result;
+	}
+
+	T& operator[](const Key& key)
+	{
+		return try_emplace(key).first->second;
+	}
+
+	T& operator[](Key&& key)
+	{
+		return try_emplace(std::move(key)).first->second;
+	}
+};
+
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_set : public detail::flat_table<Key, Key, detail::flat_set_traits<Key>, Hash, KeyEqual>
+{
+	using table = detail::flat_table<Key, Key, detail::flat_set_traits<Key>, Hash, KeyEqual>;
+
+public:
+	using typename table::iterator;
+
+	using table::table;
+
+	std::pair<iterator, bool> insert(const Key& key)
+	{
+		return this->emplace_unique(key, key);
+	}
+
+	std::pair<iterator, bool> insert(Key&& key)
+	{
+		return this->emplace_unique(key, std::move(key));
+	}
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <penumbra/types.hpp>
+
+namespace penumbra
+{
+
+// intervals between consecutive frame_pacer_wait returns since the last reset
+struct frame_pacer_stats
+{
+	u64 frames{0};
+	// frames that reached frame_pacer_wait after their deadline
+	u64 missed{0};
+	double mean_ms{0.0};
+	double stddev_ms{0.0};
+	double min_ms{0.0};
+	double max_ms{0.0};
+	// the part of the waits spent spinning, the only part that keeps a core busy
+	double spin_ms{0.0};
+	double spin_window_us{0.0};
+};
+
+constexpr u32 FRAME_PACER_WAKE_SAMPLES = 64u;
+
+// paces a loop against absolute deadlines so errors never accumulate, each wait sleeps until shortly before
+// the deadline and spins the rest, the spin window follows how late the OS has recently been waking the thread
+struct frame_pacer_t
+{
+	u32 rate{0};
+	u64 period_ns{0};
+	u64 deadline_ns{0};
+	u64 last_frame_ns{0};
+
+	// how late the last wakeups were, the window covers a high percentile of them rather than every outlier
+	u32 wake_late_ns[FRAME_PACER_WAKE_SAMPLES]{};
+	u32 wake_count{0};
+	u64 spin_window_ns{0};
+
+	u64 frames{0};
+	u64 missed{0};
+	double interval_mean_ns{0.0};
+	double interval_m2{0.0};
+	u64 interval_min_ns{0};
+	u64 interval_max_ns{0};
+	u64 spin_ns{0};
+};
+
+// rate in frames per second, 0 does not limit
+void frame_pacer_init(frame_pacer_t& pacer, u32 rate);
+// restarts the schedule from now if the rate changed
+void frame_pacer_set_rate(frame_pacer_t& pacer, u32 rate);
+// blocks until the next deadline, a frame that is more than a period late starts a new schedule instead of catching up
+void frame_pacer_wait(frame_pacer_t& pacer);
+
+frame_pacer_stats frame_pacer_get_stats(const frame_pacer_t& pacer);
+void frame_pacer_reset_stats(frame_pacer_t& pacer);
+
+}
@@ -244,6 +244,23 @@ struct GPUProperties
 	std::string device_name;
 };
 
+constexpr const char* gpu_memory_heap_names[] =
+{
+	"HOST",
+	"PRIVATE",
+	"MAPPED",
+	"READBACK"
+};
+
+// bytes of device memory backing buffers allocated from a heap, textures count towards GPU_MEMORY_PRIVATE
+struct GPUMemoryStats
+{
+	u64 current;
+	u64 peak;
+	u64 allocations;
+	u64 frees;
+};
+
 bool gpu_init();
 void gpu_shutdown();
 
@@ -307,6 +324,7 @@ GPUTexture gpu_swapchain_acquire_next(GPUSemaphore sem);
 void gpu_swapchain_present(GPUQueue queue, GPUSemaphore sem);
 bool gpu_swapchain_set_present_mode(GPUPresentMode mode);
 const GPUProperties& gpu_get_properties();
+GPUMemoryStats gpu_get_memory_stats(GPUMemoryHeap heap);
 
 constexpr GPUTextureUsage operator|(GPUTextureUsage lhs, GPUTextureUsage rhs)
 {
@@ -1,7 +1,14 @@
 #pragma once
 
 #include <penumbra/types.hpp>
+
+#include <array>
+#include <bit>
+#include <compare>
+#include <cstring>
+#include <functional>
 #include <string>
+#include <string_view>
 
 namespace penumbra
 {
@@ -42,11 +49,395 @@ constexpr u32 hash(std::string_view str)
 	return out;
 }
 
+constexpr u64 prime64 = 0x100000001b3ull;
+constexpr u64 basis64 = 0xcbf29ce484222325ull;
+
+constexpr u64 hash64(std::string_view str)
+{
+	u64 out = basis64;
+
+	for(auto c : str)
+		out = (out ^ static_cast<u64>(static_cast<u8>(c))) * prime64;
+
+	return out;
+}
+
+}
+
+// XXH3 64-bit, bit exact with the reference implementation
+// usable in constant expressions, at runtime inputs past 240 bytes go to a vectorized loop in penumbra_core
+namespace xxh3
+{
+
+constexpr size_t stripe_len = 64;
+constexpr size_t secret_consume_rate = 8;
+constexpr size_t secret_size = 192;
+constexpr size_t mid_size_max = 240;
+
+constexpr u64 prime32_1 = 0x9e3779b1ull;
+constexpr u64 prime32_2 = 0x85ebca77ull;
+constexpr u64 prime32_3 = 0xc2b2ae3dull;
+constexpr u64 prime64_1 = 0x9e3779b185ebca87ull;
+constexpr u64 prime64_2 = 0xc2b2ae3d27d4eb4full;
+constexpr u64 prime64_3 = 0x165667b19e3779f9ull;
+constexpr u64 prime64_4 = 0x85ebca77c2b2ae63ull;
+constexpr u64 prime64_5 = 0x27d4eb2f165667c5ull;
+
+alignas(64) constexpr std::array<u8, secret_size> default_secret
+{
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+// long input loop over the default secret or one derived from a seed, picks the widest vector unit available
+u64 hash_long(const u8* data, size_t size, const u8* secret);
+
+namespace detail
+{
+
+template <typename ByteT>
+constexpr u32 read32(const ByteT* p)
+{
+	if !consteval
+	{
+		if constexpr(std::endian::native == std::endian::little)
+		{
+			u32 out;
+			std::memcpy(&out, p, sizeof(u32));
+			return out;
+		}
+	}
+
+	return static_cast<u32>(static_cast<u8>(p[0])) | static_cast<u32>(static_cast<u8>(p[1])) << 8 |
+		static_cast<u32>(static_cast<u8>(p[2])) << 16 | static_cast<u32>(static_cast<u8>(p[3])) << 24;
+}
+
+template <typename ByteT>
+constexpr u64 read64(const ByteT* p)
+{
+	return static_cast<u64>(read32(p)) | static_cast<u64>(read32(p + 4)) << 32;
+}
+
+constexpr u64 mul128_fold64(u64 lhs, u64 rhs)
+{
+#if defined __SIZEOF_INT128__
+	const unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+	return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+#else
+	const u64 lo_lo = (lhs & 0xffffffffull) * (rhs & 0xffffffffull);
+	const u64 hi_lo = (lhs >> 32) * (rhs & 0xffffffffull);
+	const u64 lo_hi = (lhs & 0xffffffffull) * (rhs >> 32);
+	const u64 hi_hi = (lhs >> 32) * (rhs >> 32);
+	const u64 cross = (lo_lo >> 32) + (hi_lo & 0xffffffffull) + lo_hi;
+	const u64 upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	const u64 lower = (cross << 32) | (lo_lo & 0xffffffffull);
+	return lower ^ upper;
+#endif
+}
+
+constexpr u64 xxh64_avalanche(u64 h)
+{
+	h ^= h >> 33;
+	h *= prime64_2;
+	h ^= h >> 29;
+	h *= prime64_3;
+	return h ^ (h >> 32);
+}
+
+constexpr u64 avalanche(u64 h)
+{
+	h ^= h >> 37;
+	h *= 0x165667919e3779f9ull;
+	return h ^ (h >> 32);
+}
+
+constexpr u64 rrmxmx(u64 h, u64 len)
+{
+	h ^= std::rotl(h, 49) ^ std::rotl(h, 24);
+	h *= 0x9fb21c651e98df25ull;
+	h ^= (h >> 35) + len;
+	h *= 0x9fb21c651e98df25ull;
+	return h ^ (h >> 28);
+}
+
+template <typename ByteT>
+constexpr u64 mix16(const ByteT* p, const u8* secret, u64 seed)
+{
+	const u64 lo = read64(p) ^ (read64(secret) + seed);
+	const u64 hi = read64(p + 8) ^ (read64(secret + 8) - seed);
+	return mul128_fold64(lo, hi);
+}
+
+template <typename ByteT>
+constexpr u64 hash_0to16(const ByteT* p, size_t len, const u8* secret, u64 seed)
+{
+	if(len > 8)
+	{
+		const u64 lo = read64(p) ^ ((read64(secret + 24) ^ read64(secret + 32)) + seed);
+		const u64 hi = read64(p + len - 8) ^ ((read64(secret + 40) ^ read64(secret + 48)) - seed);
+		return avalanche(len + std::byteswap(lo) + hi + mul128_fold64(lo, hi));
+	}
+
+	if(len >= 4)
+	{
+		seed ^= static_cast<u64>(std::byteswap(static_cast<u32>(seed))) << 32;
+		const u64 input = read32(p + len - 4) + (static_cast<u64>(read32(p)) << 32);
+		return rrmxmx(input ^ ((read64(secret + 8) ^ read64(secret + 16)) - seed), len);
+	}
+
+	if(len > 0)
+	{
+		const u32 combined =
+			static_cast<u32>(static_cast<u8>(p[0])) << 16 |
+			static_cast<u32>(static_cast<u8>(p[len >> 1])) << 24 |
+			static_cast<u32>(static_cast<u8>(p[len - 1])) |
+			static_cast<u32>(len) << 8;
+		return xxh64_avalanche(combined ^ (static_cast<u64>(read32(secret) ^ read32(secret + 4)) + seed));
+	}
+
+	return xxh64_avalanche(seed ^ read64(secret + 56) ^ read64(secret + 64));
+}
+
+template <typename ByteT>
+constexpr u64 hash_17to128(const ByteT* p, size_t len, const u8* secret, u64 seed)
+{
+	u64 acc = len * prime64_1;
+
+	if(len > 32)
+	{
+		if(len > 64)
+		{
+			if(len > 96)
+			{
+				acc += mix16(p + 48, secret + 96, seed);
+				acc += mix16(p + len - 64, secret + 112, seed);
+			}
+
+			acc += mix16(p + 32, secret + 64, seed);
+			acc += mix16(p + len - 48, secret + 80, seed);
+		}
+
+		acc += mix16(p + 16, secret + 32, seed);
+		acc += mix16(p + len - 32, secret + 48, seed);
+	}
+
+	acc += mix16(p, secret, seed);
+	acc += mix16(p + len - 16, secret + 16, seed);
+
+	return avalanche(acc);
+}
+
+template <typename ByteT>
+constexpr u64 hash_129to240(const ByteT* p, size_t len, const u8* secret, u64 seed)
+{
+	u64 acc = len * prime64_1;
+	const size_t rounds = len / 16;
+
+	for(size_t i = 0; i < 8; i++)
+		acc += mix16(p + 16 * i, secret + 16 * i, seed);
+
+	acc = avalanche(acc);
+
+	for(size_t i = 8; i < rounds; i++)
+		acc += mix16(p + 16 * i, secret + 16 * (i - 8) + 3, seed);
+
+	acc += mix16(p + len - 16, secret + 136 - 17, seed);
+	return avalanche(acc);
+}
+
+template <typename ByteT>
+constexpr void accumulate_512(u64* acc, const ByteT* p, const u8* secret)
+{
+	for(size_t i = 0; i < 8; i++)
+	{
+		const u64 value = read64(p + 8 * i);
+		const u64 key = value ^ read64(secret + 8 * i);
+		acc[i ^ 1] += value;
+		acc[i] += (key & 0xffffffffull) * (key >> 32);
+	}
+}
+
+constexpr void scramble(u64* acc, const u8* secret)
+{
+	for(size_t i = 0; i < 8; i++)
+		acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ read64(secret + 8 * i)) * prime32_1;
+}
+
+constexpr u64 merge_accs(const u64* acc, const u8* secret, u64 start)
+{
+	u64 result = start;
+	for(size_t i = 0; i < 4; i++)
+		result += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+
+	return avalanche(result);
+}
+
+constexpr std::array<u64, 8> initial_acc{prime32_3, prime64_1, prime64_2, prime64_3, prime64_4, prime32_2, prime64_5, prime32_1};
+
+template <typename ByteT>
+constexpr u64 hash_long_scalar(const ByteT* p, size_t len, const u8* secret)
+{
+	std::array<u64, 8> acc = initial_acc;
+
+	constexpr size_t stripes_per_block = (secret_size - stripe_len) / secret_consume_rate;
+	constexpr size_t block_len = stripe_len * stripes_per_block;
+	const size_t blocks = (len - 1) / block_len;
+
+	for(size_t b = 0; b < blocks; b++)
+	{
+		for(size_t s = 0; s < stripes_per_block; s++)
+			accumulate_512(acc.data(), p + b * block_len + s * stripe_len, secret + s * secret_consume_rate);
+
+		scramble(acc.data(), secret + secret_size - stripe_len);
+	}
+
+	const size_t stripes = ((len - 1) - block_len * blocks) / stripe_len;
+	for(size_t s = 0; s < stripes; s++)
+		accumulate_512(acc.data(), p + blocks * block_len + s * stripe_len, secret + s * secret_consume_rate);
+
+	accumulate_512(acc.data(), p + len - stripe_len, secret + secret_size - stripe_len - 7);
+
+	return merge_accs(acc.data(), secret + 11, len * prime64_1);
+}
+
+constexpr std::array<u8, secret_size> derive_secret(u64 seed)
+{
+	std::array<u8, secret_size> out{};
+	for(size_t i = 0; i < secret_size / 16; i++)
+	{
+		const u64 lo = read64(default_secret.data() + 16 * i) + seed;
+		const u64 hi = read64(default_secret.data() + 16 * i + 8) - seed;
+		for(size_t b = 0; b < 8; b++)
+		{
+			out[16 * i + b] = static_cast<u8>(lo >> (8 * b));
+			out[16 * i + 8 + b] = static_cast<u8>(hi >> (8 * b));
+		}
+	}
+
+	return out;
+}
+
+template <typename ByteT>
+constexpr u64 hash64(const ByteT* p, size_t len, u64 seed)
+{
+	if(len <= 16)
+		return hash_0to16(p, len, default_secret.data(), seed);
+	if(len <= 128)
+		return hash_17to128(p, len, default_secret.data(), seed);
+	if(len <= mid_size_max)
+		return hash_129to240(p, len, default_secret.data(), seed);
+
+	if consteval
+	{
+		const std::array<u8, secret_size> secret = derive_secret(seed);
+		return hash_long_scalar(p, len, secret.data());
+	}
+	else
+	{
+		if(!seed)
+			return hash_long(reinterpret_cast<const u8*>(p), len, default_secret.data());
+
+		alignas(64) const std::array<u8, secret_size> secret = derive_secret(seed);
+		return hash_long(reinterpret_cast<const u8*>(p), len, secret.data());
+	}
+}
+
 }
 
+constexpr u64 hash64(std::string_view str, u64 seed = 0)
+{
+	return detail::hash64(str.data(), str.size(), seed);
 }
 
-constexpr u32 operator""_fnv(const char* str)
+inline u64 hash64(const void* data, size_t size, u64 seed = 0)
 {
-	return penumbra::fnv::hash(str);
+	return detail::hash64(static_cast<const u8*>(data), size, seed);
 }
+
+}
+
+// a 64-bit string id, debug builds keep the string around and report two strings that hash the same
+class hashed_string
+{
+public:
+	constexpr hashed_string() = default;
+
+	constexpr explicit hashed_string(std::string_view str) : hash{xxh3::hash64(str)}
+	{
+#ifndef NDEBUG
+		if consteval
+		{
+			name = str;
+		}
+		else
+		{
+			name = intern(hash, str);
+		}
+#endif
+	}
+
+	constexpr u64 value() const
+	{
+		return hash;
+	}
+
+	// empty in release builds
+	constexpr std::string_view string() const
+	{
+#ifndef NDEBUG
+		return name;
+#else
+		return {};
+#endif
+	}
+
+	constexpr bool operator==(const hashed_string& other) const
+	{
+		return hash == other.hash;
+	}
+
+	constexpr std::strong_ordering operator<=>(const hashed_string& other) const
+	{
+		return hash <=> other.hash;
+	}
+
+private:
+	u64 hash{0ull};
+
+#ifndef NDEBUG
+	static std::string_view intern(u64 hash, std::string_view str);
+
+	std::string_view name;
+#endif
+};
+
+}
+
+consteval u32 operator""_fnv(const char* str, size_t len)
+{
+	return penumbra::fnv::hash(std::string_view{str, len});
+}
+
+consteval penumbra::hashed_string operator""_hs(const char* str, size_t len)
+{
+	return penumbra::hashed_string{std::string_view{str, len}};
+}
+
+template <>
+struct std::hash<penumbra::hashed_string>
+{
+	size_t operator()(const penumbra::hashed_string& str) const noexcept
+	{
+		return static_cast<size_t>(str.value());
+	}
+};
@@ -2,6 +2,7 @@
 
 #include <penumbra/input_keys.hpp>
 #include <penumbra/types.hpp>
+#include <penumbra/vfs.hpp>
 #include <penumbra/window.hpp>
 
 #include <functional>
@@ -13,9 +14,22 @@ namespace penumbra
 
 void input_init();
 void input_shutdown();
+// dispatches everything queued since the last poll to the listeners in one batch and samples the mouse
 void input_poll();
+// seconds between the last two polls, while replaying the recorded frame time
+double input_frame_delta();
 
-void input_dispatch_event(const SDL_Event& event);
+// only copies the event into a lock-free queue, safe to call from one thread other than the polling one
+void input_queue_event(const SDL_Event& event);
+
+// a recording holds every dispatched event and the sampled mouse state of each poll,
+// replaying feeds them back in place of live input so the same session runs identically across builds
+bool input_record_begin(const vfs_path& path);
+bool input_record_end();
+bool input_recording();
+bool input_replay_begin(const vfs_path& path);
+void input_replay_end();
+bool input_replaying();
 
 enum input_event_type
 {
@@ -31,6 +45,8 @@ enum input_event_type
 struct input_event_t
 {
 	input_event_type type;
+	// nanoseconds, same clock as SDL_GetTicksNS
+	u64 timestamp;
 
 	union
 	{
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <penumbra/array_proxy.hpp>
+#include <penumbra/types.hpp>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+namespace penumbra
+{
+
+// number of jobs still outstanding, jobs run with a counter decrement it when they finish
+struct job_counter
+{
+	std::atomic<u32> value{0};
+};
+
+struct job_decl
+{
+	void (*entry)(void* data);
+	void* data;
+};
+
+// worker_count 0 picks one worker per hardware thread besides the calling thread,
+// the thread calling job_init becomes the main thread and takes part in job_wait
+void job_init(u32 worker_count = 0);
+void job_shutdown();
+
+// workers plus the main thread
+u32 job_thread_count();
+// 0 for the main thread, 1..n for workers, -1 for threads not owned by the job system
+s32 job_thread_index();
+
+// without job_init jobs run inline on the calling thread
+void job_run(array_proxy<job_decl> jobs, job_counter* counter = nullptr);
+// jobs are queued once dependency reaches zero, counter covers them from the moment this is called
+void job_run_after(job_counter* dependency, array_proxy<job_decl> jobs, job_counter* counter = nullptr);
+// runs queued jobs on the calling thread until counter reaches zero
+void job_wait(job_counter* counter);
+
+using job_range_fn = void (*)(void* data, u32 begin, u32 end);
+
+// ranges are split lazily, only while the splitting thread has nothing queued for others to steal,
+// so the grain adapts to how busy the workers are and never drops below min_grain
+void job_parallel_for(u32 count, u32 min_grain, job_range_fn fn, void* data);
+
+template <typename F>
+requires std::is_invocable_v<F&, u32, u32>
+void job_parallel_for(u32 count, u32 min_grain, F&& fn)
+{
+	using fn_type = std::remove_cvref_t<F>;
+	job_parallel_for(count, min_grain, [](void* data, u32 begin, u32 end)
+	{
+		(*reinterpret_cast<fn_type*>(data))(begin, end);
+	}, const_cast<fn_type*>(std::addressof(fn)));
+}
+
+}
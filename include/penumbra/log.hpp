@@ -1,28 +1,216 @@
 #pragma once
 
-#include <spdlog/spdlog.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <concepts>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// calls below this level compile to nothing, 0 debug, 1 info, 2 warn, 3 error, 4 critical
+// the log:: functions still evaluate their arguments, the PENUMBRA_LOG_* macros below skip those too
+#ifndef PENUMBRA_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define PENUMBRA_LOG_MIN_LEVEL 1
+#else
+#define PENUMBRA_LOG_MIN_LEVEL 0
+#endif
+#endif
 
 namespace penumbra
 {
 
-inline void log_init()
+enum log_level : u8
+{
+	LOG_LEVEL_DEBUG,
+	LOG_LEVEL_INFO,
+	LOG_LEVEL_WARN,
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_CRITICAL
+};
+
+// records are formatted and written by a background thread, to the console and to binary_path if given
+// before log_init and after log_shutdown messages are formatted and printed on the calling thread
+void log_init(const char* binary_path = nullptr);
+void log_shutdown();
+// blocks until every message logged so far is written
+void log_flush();
+
+// decodes a binary log to text, output goes to stdout if no path is given
+bool log_decode_binary(const char* input, const char* output = nullptr);
+
+namespace detail
+{
+
+enum log_arg_type : u8
 {
-        auto console = spdlog::stdout_color_mt("penumbra");
+	LOG_ARG_BOOL,
+	LOG_ARG_CHAR,
+	LOG_ARG_S64,
+	LOG_ARG_U64,
+	LOG_ARG_F32,
+	LOG_ARG_F64,
+	LOG_ARG_PTR,
+	LOG_ARG_STRING
+};
+
+// a record with this many args carries the already formatted message as its only string
+constexpr u8 LOG_PREFORMATTED = 0xffu;
+constexpr u32 LOG_MAX_STRING = 4096u;
+constexpr u32 LOG_MAX_MESSAGE = 16384u;
 
-        console->set_pattern("[%^%l%$] %v");
-        console->set_level(spdlog::level::debug);
+// reserves room for the arguments in the calling thread's ring, log_record_end publishes them
+u8* log_record_begin(log_level level, std::string_view fmt, u8 num_args, u32 args_size);
+void log_record_end();
+
+template <typename T>
+concept log_string_arg =
+	std::same_as<std::decay_t<T>, const char*> ||
+	std::same_as<std::decay_t<T>, char*> ||
+	std::same_as<std::remove_cvref_t<T>, std::string_view> ||
+	std::same_as<std::remove_cvref_t<T>, std::basic_string<char, typename std::remove_cvref_t<T>::traits_type, typename std::remove_cvref_t<T>::allocator_type>>;
+
+// arguments that format the same after being copied into the ring, anything else formats the message on the calling thread
+template <typename T>
+concept log_lazy_arg =
+	std::same_as<std::remove_cvref_t<T>, bool> ||
+	std::same_as<std::remove_cvref_t<T>, char> ||
+	(std::integral<std::remove_cvref_t<T>> && sizeof(std::remove_cvref_t<T>) <= sizeof(u64)) ||
+	std::same_as<std::remove_cvref_t<T>, float> ||
+	std::same_as<std::remove_cvref_t<T>, double> ||
+	std::same_as<std::decay_t<T>, const void*> ||
+	std::same_as<std::decay_t<T>, void*> ||
+	log_string_arg<T>;
+
+template <typename T>
+std::string_view log_string(const T& arg)
+{
+	std::string_view str;
+	if constexpr(std::is_pointer_v<std::decay_t<T>>)
+		str = arg ? std::string_view{arg} : std::string_view{"(null)"};
+	else
+		str = std::string_view{arg};
+
+	return str.substr(0, LOG_MAX_STRING);
+}
+
+template <typename T>
+u32 log_arg_size(const T& arg)
+{
+	if constexpr(log_string_arg<T>)
+		return 1u + sizeof(u32) + static_cast<u32>(log_string(arg).size());
+	else if constexpr(std::same_as<T, bool> || std::same_as<T, char>)
+		return 1u + 1u;
+	else if constexpr(std::same_as<T, float>)
+		return 1u + sizeof(float);
+	else
+		return 1u + sizeof(u64);
+}
+
+template <typename T>
+void log_arg_write(u8*& out, log_arg_type type, const T& value)
+{
+	*out++ = type;
+	std::memcpy(out, &value, sizeof(T));
+	out += sizeof(T);
+}
+
+template <typename T>
+void log_arg_write(u8*& out, const T& arg)
+{
+	if constexpr(log_string_arg<T>)
+	{
+		const std::string_view str = log_string(arg);
+		log_arg_write(out, LOG_ARG_STRING, static_cast<u32>(str.size()));
+		std::memcpy(out, str.data(), str.size());
+		out += str.size();
+	}
+	else if constexpr(std::same_as<T, bool>)
+		log_arg_write(out, LOG_ARG_BOOL, arg);
+	else if constexpr(std::same_as<T, char>)
+		log_arg_write(out, LOG_ARG_CHAR, arg);
+	else if constexpr(std::same_as<T, float>)
+		log_arg_write(out, LOG_ARG_F32, arg);
+	else if constexpr(std::same_as<T, double>)
+		log_arg_write(out, LOG_ARG_F64, arg);
+	else if constexpr(std::is_pointer_v<T>)
+		log_arg_write(out, LOG_ARG_PTR, reinterpret_cast<u64>(arg));
+	else if constexpr(std::is_signed_v<T>)
+		log_arg_write(out, LOG_ARG_S64, static_cast<s64>(arg));
+	else
+		log_arg_write(out, LOG_ARG_U64, static_cast<u64>(arg));
+}
+
+template <log_level Level, typename... Args>
+void log_write(std::format_string<Args...> fmt, Args&&... args)
+{
+	if constexpr(Level < PENUMBRA_LOG_MIN_LEVEL)
+		return;
+	else if constexpr((log_lazy_arg<Args> && ...))
+	{
+		const u32 size = (0u + ... + log_arg_size(static_cast<const std::remove_cvref_t<Args>&>(args)));
+		u8* out = log_record_begin(Level, fmt.get(), static_cast<u8>(sizeof...(Args)), size);
+		(log_arg_write(out, static_cast<const std::remove_cvref_t<Args>&>(args)), ...);
+		log_record_end();
+	}
+	else
+	{
+		const std::string message = std::vformat(fmt.get(), std::make_format_args(args...));
+		const u32 size = std::min(static_cast<u32>(message.size()), LOG_MAX_MESSAGE);
+		u8* out = log_record_begin(Level, fmt.get(), LOG_PREFORMATTED, size);
+		std::memcpy(out, message.data(), size);
+		log_record_end();
+	}
+}
 
-        spdlog::set_default_logger(console);
 }
 
 namespace log
 {
-	using spdlog::debug;
-	using spdlog::info;
-	using spdlog::warn;
-	using spdlog::error;
-	using spdlog::critical;
+
+template <typename... Args>
+void debug(std::format_string<Args...> fmt, Args&&... args)
+{
+	detail::log_write<LOG_LEVEL_DEBUG>(fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void info(std::format_string<Args...> fmt, Args&&... args)
+{
+	detail::log_write<LOG_LEVEL_INFO>(fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void warn(std::format_string<Args...> fmt, Args&&... args)
+{
+	detail::log_write<LOG_LEVEL_WARN>(fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void error(std::format_string<Args...> fmt, Args&&... args)
+{
+	detail::log_write<LOG_LEVEL_ERROR>(fmt, std::forward<Args>(args)...);
 }
 
+template <typename... Args>
+void critical(std::format_string<Args...> fmt, Args&&... args)
+{
+	detail::log_write<LOG_LEVEL_CRITICAL>(fmt, std::forward<Args>(args)...);
 }
+
+}
+
+}
+
+// the level test sits in front of the call, a filtered call doesn't evaluate or format its arguments
+#define PENUMBRA_LOG(level, fn, ...) \
+	do { if constexpr((level) >= PENUMBRA_LOG_MIN_LEVEL) ::penumbra::log::fn(__VA_ARGS__); } while(0)
+
+#define PENUMBRA_LOG_DEBUG(...) PENUMBRA_LOG(::penumbra::LOG_LEVEL_DEBUG, debug, __VA_ARGS__)
+#define PENUMBRA_LOG_INFO(...) PENUMBRA_LOG(::penumbra::LOG_LEVEL_INFO, info, __VA_ARGS__)
+#define PENUMBRA_LOG_WARN(...) PENUMBRA_LOG(::penumbra::LOG_LEVEL_WARN, warn, __VA_ARGS__)
+#define PENUMBRA_LOG_ERROR(...) PENUMBRA_LOG(::penumbra::LOG_LEVEL_ERROR, error, __VA_ARGS__)
+#define PENUMBRA_LOG_CRITICAL(...) PENUMBRA_LOG(::penumbra::LOG_LEVEL_CRITICAL, critical, __VA_ARGS__)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <penumbra/math/aabb.hpp>
+#include <penumbra/math/fastmath.hpp>
+#include <penumbra/math/frustum.hpp>
 #include <penumbra/math/matrix.hpp>
 #include <penumbra/math/plane.hpp>
 #include <penumbra/math/quaternion.hpp>
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <penumbra/types.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <numbers>
+
+namespace penumbra
+{
+
+// approximations for hot loops, branch free on floats and integers so loops over them vectorize, the ones that take a
+// sqrt only do with gcc under -fno-math-errno
+// every function takes an accuracy tier, the bounds next to each one are the worst seen over its valid inputs
+enum fast_math_accuracy_t
+{
+	FAST_MATH_LOW,		// around 1e-4, for anything that ends up in 8 bits
+	FAST_MATH_MEDIUM,	// around 1e-6
+	FAST_MATH_HIGH		// within a few ulps of the libm result
+};
+
+template <size_t N>
+inline float fast_horner(float x, const float (&c)[N]) noexcept
+{
+	float p = c[N - 1];
+	for(size_t i = N - 1; i-- > 0;)
+		p = p * x + c[i];
+
+	return p;
+}
+
+// a when c holds and b otherwise through a bit mask, a ternary lets the optimizer sink a and b into branches
+// and it will not turn a division back into a select when fp traps are on
+inline float fast_select(bool c, float a, float b) noexcept
+{
+	const u32 mask = 0u - static_cast<u32>(c);
+	return std::bit_cast<float>((std::bit_cast<u32>(a) & mask) | (std::bit_cast<u32>(b) & ~mask));
+}
+
+// adding 1.5 * 2^23 rounds to the nearest integer and leaves it in the low mantissa bits, for |x| below 2^22
+constexpr float fast_round_magic = 12582912.0f;
+
+// x > 0, relative error 1.8e-3 low, 4.8e-6 medium, 1.2e-7 high
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float fast_rsqrt(float x) noexcept
+{
+	if constexpr(A == FAST_MATH_HIGH)
+		return 1.0f / std::sqrt(x);
+
+	float y = std::bit_cast<float>(0x5f375a86u - (std::bit_cast<u32>(x) >> 1u));
+	const float hx = 0.5f * x;
+	y = y * (1.5f - hx * y * y);
+	if constexpr(A == FAST_MATH_MEDIUM)
+		y = y * (1.5f - hx * y * y);
+
+	return y;
+}
+
+// x is clamped to [-125, 127] so the result stays a normal float, relative error 7.5e-5 low, 2.8e-6 medium, 1.2e-7 high
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float fast_exp2(float x) noexcept
+{
+	x = std::min(std::max(x, -125.0f), 127.0f);
+	const float t = x + fast_round_magic;
+	const s32 k = std::bit_cast<s32>(t) - std::bit_cast<s32>(fast_round_magic);
+	const float f = x - (t - fast_round_magic);
+
+	// 2^f on [-0.5, 0.5]
+	float p;
+	if constexpr(A == FAST_MATH_LOW)
+	{
+		constexpr float c[]{9.999280740e-01f, 6.932609938e-01f, 2.426111187e-01f, 5.517162372e-02f};
+		p = fast_horner(f, c);
+	}
+	else if constexpr(A == FAST_MATH_MEDIUM)
+	{
+		constexpr float c[]{9.999992614e-01f, 6.931218148e-01f, 2.402474496e-01f, 5.591785991e-02f, 9.570096670e-03f};
+		p = fast_horner(f, c);
+	}
+	else
+	{
+		constexpr float c[]{1.0f, 6.931472057e-01f, 2.402264689e-01f, 5.550328777e-02f, 9.618488974e-03f, 1.339993118e-03f, 1.534580753e-04f};
+		p = fast_horner(f, c);
+	}
+
+	return std::bit_cast<float>(std::bit_cast<s32>(p) + k * (1 << 23));
+}
+
+// x a positive normal float, error over max(1, |log2(x)|) 1.2e-5 low, 1.7e-7 medium, 1e-7 high
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float fast_log2(float x) noexcept
+{
+	// split off the exponent so the mantissa lands in [sqrt(0.5), sqrt(2))
+	const s32 e = (std::bit_cast<s32>(x) - 0x3f3504f3) >> 23;
+	const float m = std::bit_cast<float>(std::bit_cast<s32>(x) - e * (1 << 23));
+
+	// log2(m) = z * p(z * z) with z = (m - 1) / (m + 1)
+	const float z = (m - 1.0f) / (m + 1.0f);
+	const float w = z * z;
+	float p;
+	if constexpr(A == FAST_MATH_LOW)
+	{
+		constexpr float c[]{2.885325546e+00f, 9.791498434e-01f};
+		p = fast_horner(w, c);
+	}
+	else if constexpr(A == FAST_MATH_MEDIUM)
+	{
+		constexpr float c[]{2.885390426e+00f, 9.615878614e-01f, 5.957965047e-01f};
+		p = fast_horner(w, c);
+	}
+	else
+	{
+		constexpr float c[]{2.885390080e+00f, 9.617988537e-01f, 5.767138354e-01f, 4.317483066e-01f};
+		p = fast_horner(w, c);
+	}
+
+	return static_cast<float>(e) + z * p;
+}
+
+// x >= 0 with zero giving zero, the error grows with |y * log2(x)|, relative error for the sRGB exponents on (0, 1]
+// is 9.2e-5 low, 5.6e-6 medium, 3.7e-6 high
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float fast_pow(float x, float y) noexcept
+{
+	// whatever log2 makes of zero is masked off
+	const float r = fast_exp2<A>(y * fast_log2<A>(x));
+	return fast_select(x > 0.0f, r, 0.0f);
+}
+
+// sin on [-pi / 4, pi / 4] is r * s(r * r) and cos is c(r * r), the quadrant picks one and its sign
+template <fast_math_accuracy_t A>
+inline float fast_sin_quadrant(float x, u32 offset) noexcept
+{
+	const float t = x * (2.0f / std::numbers::pi_v<float>) + fast_round_magic;
+	const float k = t - fast_round_magic;
+	const u32 q = std::bit_cast<u32>(t) + offset;
+
+	// pi / 2 in three parts with few enough bits that k times each is exact, the cephes split
+	const float r = ((x - k * 1.5703125f) - k * 4.837512969970703125e-4f) - k * 7.54978995489188216e-8f;
+	const float w = r * r;
+
+	float s, c;
+	if constexpr(A == FAST_MATH_LOW)
+	{
+		constexpr float sc[]{9.999985694e-01f, -1.666248017e-01f, 8.151635543e-03f};
+		constexpr float cc[]{9.999900349e-01f, -4.997081402e-01f, 4.039853565e-02f};
+		s = r * fast_horner(w, sc);
+		c = fast_horner(w, cc);
+	}
+	else if constexpr(A == FAST_MATH_MEDIUM)
+	{
+		constexpr float sc[]{9.999985694e-01f, -1.666248017e-01f, 8.151635543e-03f};
+		constexpr float cc[]{9.999999724e-01f, -4.999985670e-01f, 4.165502688e-02f, -1.358590847e-03f};
+		s = r * fast_horner(w, sc);
+		c = fast_horner(w, cc);
+	}
+	else
+	{
+		constexpr float sc[]{1.0f, -1.666665070e-01f, 8.332036875e-03f, -1.950402196e-04f};
+		constexpr float cc[]{1.0f, -4.999999962e-01f, 4.166661674e-02f, -1.388661921e-03f, 2.437992972e-05f};
+		s = r * fast_horner(w, sc);
+		c = fast_horner(w, cc);
+	}
+
+	const float v = (q & 1u) ? c : s;
+	return (q & 2u) ? -v : v;
+}
+
+// |x| up to 8192, absolute error 1.1e-5 low, 1.3e-6 medium, 1e-7 high
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float fast_sin(float x) noexcept
+{
+	return fast_sin_quadrant<A>(x, 0u);
+}
+
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float fast_cos(float x) noexcept
+{
+	return fast_sin_quadrant<A>(x, 1u);
+}
+
+// x in [-1, 1], acos(|x|) = sqrt(1 - |x|) * p(|x|) after abramowitz and stegun 4.4.45 and 4.4.46,
+// absolute error 7e-5 low, 1.4e-6 medium, 4.5e-7 high
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float fast_acos(float x) noexcept
+{
+	const float a = std::abs(x);
+	float p;
+	if constexpr(A == FAST_MATH_LOW)
+	{
+		constexpr float c[]{1.570728815e+00f, -2.121151607e-01f, 7.426212476e-02f, -1.872971910e-02f};
+		p = fast_horner(a, c);
+	}
+	else if constexpr(A == FAST_MATH_MEDIUM)
+	{
+		constexpr float c[]{1.570795206e+00f, -2.145122679e-01f, 8.787561954e-02f, -4.495714836e-02f, 1.934816005e-02f, -4.337127610e-03f};
+		p = fast_horner(a, c);
+	}
+	else
+	{
+		constexpr float c[]{1.570796305e+00f, -2.145988037e-01f, 8.897904737e-02f, -5.017469969e-02f, 3.089300803e-02f, -1.708974359e-02f, 6.671243787e-03f, -1.262816640e-03f};
+		p = fast_horner(a, c);
+	}
+
+	const float r = std::sqrt(1.0f - a) * p;
+	return x < 0.0f ? std::numbers::pi_v<float> - r : r;
+}
+
+// sRGB transfer functions on [0, 1], the exact curve in double for the tables and the pow tiers for everything else
+inline double srgb_to_linear_exact(double v)
+{
+	return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+inline double linear_to_srgb_exact(double v)
+{
+	return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+}
+
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float srgb_to_linear(float v) noexcept
+{
+	const float p = fast_pow<A>((v + 0.055f) * (1.0f / 1.055f), 2.4f);
+	return fast_select(v <= 0.04045f, v * (1.0f / 12.92f), p);
+}
+
+template <fast_math_accuracy_t A = FAST_MATH_MEDIUM>
+inline float linear_to_srgb(float v) noexcept
+{
+	const float p = 1.055f * fast_pow<A>(v, 1.0f / 2.4f) - 0.055f;
+	return fast_select(v <= 0.0031308f, v * 12.92f, p);
+}
+
+// every 8 bit value decoded exactly
+inline const std::array<float, 256> srgb8_decode_table = []()
+{
+	std::array<float, 256> table;
+	for(u32 i = 0; i < 256; i++)
+		table[i] = static_cast<float>(srgb_to_linear_exact(i / 255.0));
+
+	return table;
+}();
+
+// every 16th 16 bit value, the ones between are interpolated to within 8e-8
+inline const std::array<float, 4097> srgb16_decode_table = []()
+{
+	std::array<float, 4097> table;
+	for(u32 i = 0; i < 4097; i++)
+		table[i] = static_cast<float>(srgb_to_linear_exact(i * 16.0 / 65535.0));
+
+	return table;
+}();
+
+inline float srgb8_to_linear(u8 v) noexcept
+{
+	return srgb8_decode_table[v];
+}
+
+inline float srgb16_to_linear(u16 v) noexcept
+{
+	const float a = srgb16_decode_table[v >> 4u];
+	const float b = srgb16_decode_table[(v >> 4u) + 1u];
+	return a + (b - a) * (static_cast<float>(v & 15u) * (1.0f / 16.0f));
+}
+
+// linear [0, 1] to 8 bit sRGB without a pow, the float is split into 104 buckets by its exponent and top three
+// mantissa bits and the curve is a line over each, in 16.16 fixed point on the next eight mantissa bits, everything
+// below 2^-13 rounds to zero anyway, the result is at most one step off the correctly rounded one and that for
+// about 0.05% of inputs, every decoded 8 bit value encodes back to itself
+struct srgb8_encode_bucket
+{
+	u32 bias;
+	u32 scale;
+};
+
+constexpr u32 srgb8_encode_min_bits = 0x39000000u;	// 2^-13
+constexpr u32 srgb8_encode_max_bits = 0x3f7fffffu;	// the float below one
+
+inline const std::array<srgb8_encode_bucket, 104> srgb8_encode_table = []()
+{
+	std::array<srgb8_encode_bucket, 104> table;
+	for(u32 b = 0; b < 104; b++)
+	{
+		// least squares line through the rounding target at the start, middle and end of every step of t
+		double st = 0.0, sy = 0.0, stt = 0.0, sty = 0.0, n = 0.0;
+		for(u32 t = 0; t < 256; t++)
+		{
+			for(u32 low : {0u, 0x800u, 0xfffu})
+			{
+				const double x = std::bit_cast<float>(srgb8_encode_min_bits + (b << 20u) + (t << 12u) + low);
+				const double y = linear_to_srgb_exact(x) * 255.0 + 0.5;
+				st += t;
+				sy += y;
+				stt += double(t) * t;
+				sty += t * y;
+				n += 1.0;
+			}
+		}
+
+		const double scale = (n * sty - st * sy) / (n * stt - st * st);
+		const double bias = (sy - scale * st) / n;
+		table[b] = srgb8_encode_bucket{static_cast<u32>(std::lround(bias * 65536.0)), static_cast<u32>(std::lround(scale * 65536.0))};
+	}
+
+	return table;
+}();
+
+inline u8 linear_to_srgb8(float v) noexcept
+{
+	// the comparisons also send nan to zero
+	const float lo = std::bit_cast<float>(srgb8_encode_min_bits);
+	const float hi = std::bit_cast<float>(srgb8_encode_max_bits);
+	v = v > lo ? v : lo;
+	v = v < hi ? v : hi;
+
+	const u32 bits = std::bit_cast<u32>(v);
+	const srgb8_encode_bucket& bucket = srgb8_encode_table[(bits - srgb8_encode_min_bits) >> 20u];
+	const u32 t = (bits >> 12u) & 0xffu;
+	return static_cast<u8>((bucket.bias + bucket.scale * t) >> 16u);
+}
+
+}
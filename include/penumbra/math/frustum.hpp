@@ -0,0 +1,274 @@
+#pragma once
+
+#include <penumbra/math/aabb.hpp>
+#include <penumbra/math/matrix.hpp>
+#include <penumbra/math/simd.hpp>
+#include <penumbra/math/vector.hpp>
+#include <penumbra/types.hpp>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace penumbra
+{
+
+// inward facing planes, xyz the unit normal and w the offset, a point p is inside when dot(xyz, p) + w >= 0
+struct Frustum
+{
+	// from a view projection matrix with a [0, 1] depth range, with reversed depth the two depth planes swap roles
+	// and the far plane of an infinite projection has a zero normal and a positive offset, so it passes everything
+	static Frustum from_matrix(const mat4& view_proj) noexcept
+	{
+		const mat4 t = mat4::transpose(view_proj);
+
+		Frustum f;
+		f.planes[0] = t[3] + t[0];
+		f.planes[1] = t[3] - t[0];
+		f.planes[2] = t[3] + t[1];
+		f.planes[3] = t[3] - t[1];
+		f.planes[4] = t[2];
+		f.planes[5] = t[3] - t[2];
+
+		for(auto& p : f.planes)
+		{
+			const float mag = p.demote<3>().magnitude();
+			if(mag > 0.0f)
+				p = p / mag;
+		}
+
+		return f;
+	}
+
+	vec4 planes[6];
+};
+
+static_assert(sizeof(AABB) == 6 * sizeof(float), "the aabb kernel reads mins and maxs as one block");
+
+// the sums are written out so the scalar tests and the batch kernels associate the same way
+inline float frustum_plane_distance(const vec4& p, float x, float y, float z) noexcept
+{
+	return ((p.x * x + p.y * y) + p.z * z) + p.w;
+}
+
+// touching counts as visible, the same comparison the culling shaders make
+inline bool frustum_test_sphere(const Frustum& f, const vec4& sphere) noexcept
+{
+	for(const vec4& p : f.planes)
+	{
+		if(!(frustum_plane_distance(p, sphere.x, sphere.y, sphere.z) > -sphere.w))
+			return false;
+	}
+
+	return true;
+}
+
+inline bool frustum_test_aabb(const Frustum& f, const AABB& box) noexcept
+{
+	const vec3 c = (box.mins + box.maxs) * 0.5f;
+	const vec3 e = (box.maxs - box.mins) * 0.5f;
+
+	for(const vec4& p : f.planes)
+	{
+		const float reach = (std::abs(p.x) * e.x + std::abs(p.y) * e.y) + std::abs(p.z) * e.z;
+		if(!(frustum_plane_distance(p, c.x, c.y, c.z) > -reach))
+			return false;
+	}
+
+	return true;
+}
+
+// the cluster cone from meshoptimizer, axis in xyz and cutoff in w, a cluster is culled when all of its triangles face
+// away from the eye, which has to be in the same space as the sphere and cone
+inline bool cone_test(const vec3& eye, const vec4& sphere, const vec4& cone) noexcept
+{
+	const float dx = sphere.x - eye.x;
+	const float dy = sphere.y - eye.y;
+	const float dz = sphere.z - eye.z;
+	const float dist = std::sqrt((dx * dx + dy * dy) + dz * dz);
+	return ((dx * cone.x + dy * cone.y) + dz * cone.z) < cone.w * dist + sphere.w;
+}
+
+// batches write one bit per object into visible, bit i of word i / 32 for object i, which needs (count + 31) / 32 words
+inline u32 visibility_words(u32 count) noexcept
+{
+	return (count + 31u) / 32u;
+}
+
+// the set bits of a mask as ascending indices, returns how many were written
+inline u32 visibility_to_indices(const u32* visible, u32 count, u32* indices) noexcept
+{
+	u32 n = 0u;
+	for(u32 w = 0; w < visibility_words(count); w++)
+	{
+		u32 bits = visible[w];
+		while(bits)
+		{
+			indices[n++] = w * 32u + static_cast<u32>(std::countr_zero(bits));
+			bits &= bits - 1u;
+		}
+	}
+
+	return n;
+}
+
+// spheres are center xyz and radius w, like render_object_data::sphere once it is in world space and scaled by cull_scale
+inline void frustum_cull_spheres(const Frustum& f, const vec4* spheres, u32 count, u32* visible) noexcept
+{
+	std::memset(visible, 0, visibility_words(count) * sizeof(u32));
+
+	u32 i = 0;
+#if PENUMBRA_SIMD
+	f32x8 px[6], py[6], pz[6], pw[6];
+	for(u32 p = 0; p < 6; p++)
+	{
+		px[p] = f32x8_splat(f.planes[p].x);
+		py[p] = f32x8_splat(f.planes[p].y);
+		pz[p] = f32x8_splat(f.planes[p].z);
+		pw[p] = f32x8_splat(f.planes[p].w);
+	}
+
+	const f32x8 zero = f32x8_splat(0.0f);
+	for(; i + 8u <= count; i += 8u)
+	{
+		const float* rows[8];
+		for(u32 k = 0; k < 8; k++)
+			rows[k] = spheres[i + k].data;
+
+		f32x8 x, y, z, r;
+		f32x8_load_transposed(rows, x, y, z, r);
+		const f32x8 neg_r = f32x8_sub(zero, r);
+
+		const auto plane_in = [&](u32 p)
+		{
+			const f32x8 d = f32x8_add(f32x8_add(f32x8_add(f32x8_mul(px[p], x), f32x8_mul(py[p], y)), f32x8_mul(pz[p], z)), pw[p]);
+			return f32x8_cmpgt(d, neg_r);
+		};
+
+		f32x8 inside = plane_in(0);
+		for(u32 p = 1; p < 6; p++)
+			inside = f32x8_and(inside, plane_in(p));
+
+		visible[i / 32u] |= f32x8_movemask(inside) << (i % 32u);
+	}
+#endif
+
+	for(; i < count; i++)
+	{
+		if(frustum_test_sphere(f, spheres[i]))
+			visible[i / 32u] |= 1u << (i % 32u);
+	}
+}
+
+// boxes go through their center and half extents, the reach of a box towards a plane is dot(abs(normal), extents)
+inline void frustum_cull_aabbs(const Frustum& f, const AABB* boxes, u32 count, u32* visible) noexcept
+{
+	std::memset(visible, 0, visibility_words(count) * sizeof(u32));
+
+	u32 i = 0;
+#if PENUMBRA_SIMD
+	f32x8 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+	for(u32 p = 0; p < 6; p++)
+	{
+		px[p] = f32x8_splat(f.planes[p].x);
+		py[p] = f32x8_splat(f.planes[p].y);
+		pz[p] = f32x8_splat(f.planes[p].z);
+		pw[p] = f32x8_splat(f.planes[p].w);
+		ax[p] = f32x8_abs(px[p]);
+		ay[p] = f32x8_abs(py[p]);
+		az[p] = f32x8_abs(pz[p]);
+	}
+
+	const f32x8 zero = f32x8_splat(0.0f);
+	const f32x8 half = f32x8_splat(0.5f);
+	for(; i + 8u <= count; i += 8u)
+	{
+		// mins.x to maxs.x and mins.z to maxs.z, both stay inside the box
+		const float* lo_rows[8];
+		const float* hi_rows[8];
+		for(u32 k = 0; k < 8; k++)
+		{
+			lo_rows[k] = &boxes[i + k].mins.x;
+			hi_rows[k] = &boxes[i + k].mins.z;
+		}
+
+		f32x8 min_x, min_y, min_z, max_x, unused_z, unused_x, max_y, max_z;
+		f32x8_load_transposed(lo_rows, min_x, min_y, min_z, max_x);
+		f32x8_load_transposed(hi_rows, unused_z, unused_x, max_y, max_z);
+
+		const f32x8 cx = f32x8_mul(f32x8_add(min_x, max_x), half);
+		const f32x8 cy = f32x8_mul(f32x8_add(min_y, max_y), half);
+		const f32x8 cz = f32x8_mul(f32x8_add(min_z, max_z), half);
+		const f32x8 ex = f32x8_mul(f32x8_sub(max_x, min_x), half);
+		const f32x8 ey = f32x8_mul(f32x8_sub(max_y, min_y), half);
+		const f32x8 ez = f32x8_mul(f32x8_sub(max_z, min_z), half);
+
+		const auto plane_in = [&](u32 p)
+		{
+			const f32x8 d = f32x8_add(f32x8_add(f32x8_add(f32x8_mul(px[p], cx), f32x8_mul(py[p], cy)), f32x8_mul(pz[p], cz)), pw[p]);
+			const f32x8 reach = f32x8_add(f32x8_add(f32x8_mul(ax[p], ex), f32x8_mul(ay[p], ey)), f32x8_mul(az[p], ez));
+			return f32x8_cmpgt(d, f32x8_sub(zero, reach));
+		};
+
+		f32x8 inside = plane_in(0);
+		for(u32 p = 1; p < 6; p++)
+			inside = f32x8_and(inside, plane_in(p));
+
+		visible[i / 32u] |= f32x8_movemask(inside) << (i % 32u);
+	}
+#endif
+
+	for(; i < count; i++)
+	{
+		if(frustum_test_aabb(f, boxes[i]))
+			visible[i / 32u] |= 1u << (i % 32u);
+	}
+}
+
+// spheres and cones are read stride bytes apart, so with sizeof(geom_cluster_format) they point straight into the clusters
+inline void cone_cull(const vec3& eye, const vec4* spheres, const vec4* cones, u32 count, u32 stride, u32* visible) noexcept
+{
+	std::memset(visible, 0, visibility_words(count) * sizeof(u32));
+
+	const auto at = [stride](const vec4* base, u32 i)
+	{
+		return reinterpret_cast<const vec4*>(reinterpret_cast<const u8*>(base) + static_cast<size_t>(i) * stride);
+	};
+
+	u32 i = 0;
+#if PENUMBRA_SIMD
+	const f32x8 eye_x = f32x8_splat(eye.x);
+	const f32x8 eye_y = f32x8_splat(eye.y);
+	const f32x8 eye_z = f32x8_splat(eye.z);
+	for(; i + 8u <= count; i += 8u)
+	{
+		const float* sphere_rows[8];
+		const float* cone_rows[8];
+		for(u32 k = 0; k < 8; k++)
+		{
+			sphere_rows[k] = at(spheres, i + k)->data;
+			cone_rows[k] = at(cones, i + k)->data;
+		}
+
+		f32x8 sx, sy, sz, sr, axis_x, axis_y, axis_z, cutoff;
+		f32x8_load_transposed(sphere_rows, sx, sy, sz, sr);
+		f32x8_load_transposed(cone_rows, axis_x, axis_y, axis_z, cutoff);
+
+		const f32x8 dx = f32x8_sub(sx, eye_x);
+		const f32x8 dy = f32x8_sub(sy, eye_y);
+		const f32x8 dz = f32x8_sub(sz, eye_z);
+		const f32x8 dist = f32x8_sqrt(f32x8_add(f32x8_add(f32x8_mul(dx, dx), f32x8_mul(dy, dy)), f32x8_mul(dz, dz)));
+		const f32x8 facing = f32x8_add(f32x8_add(f32x8_mul(dx, axis_x), f32x8_mul(dy, axis_y)), f32x8_mul(dz, axis_z));
+		const f32x8 in = f32x8_cmplt(facing, f32x8_add(f32x8_mul(cutoff, dist), sr));
+
+		visible[i / 32u] |= f32x8_movemask(in) << (i % 32u);
+	}
+#endif
+
+	for(; i < count; i++)
+	{
+		if(cone_test(eye, *at(spheres, i), *at(cones, i)))
+			visible[i / 32u] |= 1u << (i % 32u);
+	}
+}
+
+}
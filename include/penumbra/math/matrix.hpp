@@ -1,5 +1,6 @@
 #pragma once
 
+#include <penumbra/math/simd.hpp>
 #include <penumbra/math/vector.hpp>
 #include <penumbra/types.hpp>
 #include <cmath>
@@ -65,6 +66,21 @@ public:
 	}
 
 	static constexpr auto transpose(const Matrix<T, M, N>& m) noexcept
+	{
+		if constexpr(simd_mat4)
+		{
+			if !consteval
+			{
+				Matrix<T, 4, 4> result;
+				simd_mat4_transpose(m.floats(), result.floats());
+				return result;
+			}
+		}
+
+		return transpose_reference(m);
+	}
+
+	static constexpr auto transpose_reference(const Matrix<T, M, N>& m) noexcept
 	{
 		return transpose(m, std::make_index_sequence<N>{});
 	}
@@ -146,6 +162,62 @@ public:
 	}
 
 	static constexpr auto inverse(const Matrix<T, 4, 4>& m) noexcept
+	{
+		if constexpr(simd_mat4)
+		{
+			if !consteval
+			{
+				Matrix<T, 4, 4> result;
+				simd_mat4_inverse(m.floats(), result.floats());
+				return result;
+			}
+		}
+
+		return inverse_reference(m);
+	}
+
+	// for transforms with no projection, rows 0-2 the linear part and row 3 the translation
+	static constexpr auto inverse_affine(const Matrix<T, 4, 4>& m) noexcept
+	{
+		if constexpr(simd_mat4)
+		{
+			if !consteval
+			{
+				Matrix<T, 4, 4> result;
+				simd_mat4_inverse_affine(m.floats(), result.floats());
+				return result;
+			}
+		}
+
+		return inverse_affine_reference(m);
+	}
+
+	static constexpr auto inverse_affine_reference(const Matrix<T, 4, 4>& m) noexcept
+	{
+		const Vector<T, 3> r0 = m[0].template demote<3>();
+		const Vector<T, 3> r1 = m[1].template demote<3>();
+		const Vector<T, 3> r2 = m[2].template demote<3>();
+		const Vector<T, 3> t = m[3].template demote<3>();
+
+		const Vector<T, 3> c0 = Vector<T, 3>::cross(r1, r2);
+		const Vector<T, 3> c1 = Vector<T, 3>::cross(r2, r0);
+		const Vector<T, 3> c2 = Vector<T, 3>::cross(r0, r1);
+		const T invdet = T(1.0) / Vector<T, 3>::dot(r0, c0);
+
+		const Vector<T, 3> i0 = Vector<T, 3>{c0.x, c1.x, c2.x} * invdet;
+		const Vector<T, 3> i1 = Vector<T, 3>{c0.y, c1.y, c2.y} * invdet;
+		const Vector<T, 3> i2 = Vector<T, 3>{c0.z, c1.z, c2.z} * invdet;
+
+		return Matrix<T, 4, 4>
+		{
+			Vector<T, 4>{i0, T(0)},
+			Vector<T, 4>{i1, T(0)},
+			Vector<T, 4>{i2, T(0)},
+			Vector<T, 4>{-(i0 * t.x + (i1 * t.y + i2 * t.z)), T(1)}
+		};
+	}
+
+	static constexpr auto inverse_reference(const Matrix<T, 4, 4>& m) noexcept
 	{
 		Matrix<T, 4, 4> result;
 
@@ -248,7 +320,7 @@ public:
 		Vector<T, 3> r2_xzy{r2.x, r2.z, r2.y};
 		Vector<T, 3> r3_yxz{r3.y, r3.x, r3.z};
 		Vector<T, 3> r2_yxw{r2.y, r2.x, r2.w};
-		Vector<T, 3> r1_zyx{r2.z, r2.y, r2.x};
+		Vector<T, 3> r1_zyx{r1.z, r1.y, r1.x};
 		Vector<T, 3> r3_yxw{r3.y, r3.x, r3.w};
 		Vector<T, 3> r2_xwy{r2.x, r2.w, r2.y};
 		Vector<T, 3> r3_xwy{r3.x, r3.w, r3.y};
@@ -315,7 +387,13 @@ public:
 			};
 		}(std::make_index_sequence<Num>{});
 	}
+
+	// the contiguous row major floats the simd kernels work on
+	const float* floats() const noexcept { return &this->data[0][0]; }
+	float* floats() noexcept { return &this->data[0][0]; }
 private:
+	static constexpr bool simd_mat4 = PENUMBRA_SIMD && std::is_same_v<T, float> && M == 4 && N == 4;
+
 	template <size_t... Is>
 	constexpr auto get_column_vector(size_t i, std::index_sequence<Is...>) const noexcept
 	{
@@ -378,23 +456,59 @@ constexpr auto operator*(T s, const Matrix<T, M, N>& m) noexcept
 }
 
 template <typename T, size_t M, size_t N, size_t... Is>
-constexpr auto operator*(const Vector<T, M, std::index_sequence<Is...>>& v, const Matrix<T, M, N>& m) noexcept
+constexpr auto mul_reference(const Vector<T, M, std::index_sequence<Is...>>& v, const Matrix<T, M, N>& m) noexcept
 {
 	return Vector<T, N>{(Vector<T, M>::dot(v, m.column(Is)))...};
 }
 
 template <typename T, typename U, size_t M, size_t N, size_t P>
-constexpr auto operator*(const Matrix<T, M, N>& lhs, const Matrix<U, N, P>& rhs) noexcept
+constexpr auto mul_reference(const Matrix<T, M, N>& lhs, const Matrix<U, N, P>& rhs) noexcept
 {
 	Matrix<T, M, P> res;
 	for(size_t r = 0; r < M; r++)
-		res[r] = lhs[r] * rhs;
+		res[r] = mul_reference(lhs[r], rhs);
 
 	return res;
 }
 
+template <typename T, size_t M, size_t N, size_t... Is>
+constexpr auto operator*(const Vector<T, M, std::index_sequence<Is...>>& v, const Matrix<T, M, N>& m) noexcept
+{
+	if constexpr(PENUMBRA_SIMD && std::is_same_v<T, float> && M == 4 && N == 4)
+	{
+		if !consteval
+		{
+			Vector<T, N> res;
+			simd_vec4_mul_mat4(v.data, m.floats(), res.data);
+			return res;
+		}
+	}
+
+	return mul_reference(v, m);
+}
+
+template <typename T, typename U, size_t M, size_t N, size_t P>
+constexpr auto operator*(const Matrix<T, M, N>& lhs, const Matrix<U, N, P>& rhs) noexcept
+{
+	if constexpr(PENUMBRA_SIMD && std::is_same_v<T, float> && std::is_same_v<U, float> && M == 4 && N == 4 && P == 4)
+	{
+		if !consteval
+		{
+			Matrix<T, M, P> res;
+			simd_mat4_mul(lhs.floats(), rhs.floats(), res.floats());
+			return res;
+		}
+	}
+
+	return mul_reference(lhs, rhs);
+}
+
 using mat3 = Matrix<float, 3, 3>;
 using mat4 = Matrix<float, 4, 4>;
+// an affine mat4 transposed with the last row dropped, the translation is in the w column
+using mat3x4 = Matrix<float, 3, 4>;
+
+static_assert(sizeof(mat4) == 16 * sizeof(float), "the simd kernels expect tightly packed rows");
 
 }
 
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <penumbra/math/matrix.hpp>
+#include <penumbra/math/simd.hpp>
 #include <penumbra/math/vector.hpp>
 #include <penumbra/math/utility.hpp>
 #include <penumbra/types.hpp>
+#include <algorithm>
 #include <cmath>
 #include <format>
 
@@ -174,6 +176,242 @@ constexpr auto operator*(const basic_quat<T>& lhs, const basic_quat<U>& rhs) noe
 
 using Quaternion = basic_quat<float>;
 
+// batch kernels over arrays of quaternions, eight at a time as lanes of x, y, z and w and the scalar code below for the
+// rest, which associates the same way, out may alias the inputs
+
+inline float quat_dot(const Quaternion& a, const Quaternion& b) noexcept
+{
+	return ((a.x * b.x + a.y * b.y) + a.z * b.z) + a.w * b.w;
+}
+
+// acos on [0, 1], abramowitz and stegun 4.4.46, absolute error below 2e-8
+inline float quat_acos_poly(float x) noexcept
+{
+	const float p = ((((((-0.0012624911f * x + 0.0066700901f) * x - 0.0170881256f) * x + 0.0308918810f) * x - 0.0501743046f) * x + 0.0889789874f) * x - 0.2145988016f) * x + 1.5707963050f;
+	return std::sqrt(1.0f - x) * p;
+}
+
+// sin(x) / x from x * x, the taylor series up to x^10 is good to 4e-8 for the angles slerp sees, [0, pi / 2]
+inline float quat_sinc_poly(float x2) noexcept
+{
+	return ((((-2.5052108e-8f * x2 + 2.7557319e-6f) * x2 - 1.9841270e-4f) * x2 + 8.3333333e-3f) * x2 - 1.6666667e-1f) * x2 + 1.0f;
+}
+
+inline Quaternion quat_blend(const Quaternion& a, const Quaternion& b, float wa, float wb) noexcept
+{
+	return Quaternion{a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb};
+}
+
+inline Quaternion quat_normalize_one(const Quaternion& q) noexcept
+{
+	const float len = std::sqrt(quat_dot(q, q));
+	return Quaternion{q.x / len, q.y / len, q.z / len, q.w / len};
+}
+
+// the weights of both ends written as t * sin(t * angle) / (t * angle) over sin(angle) / angle, which stays finite as the
+// angle goes to zero, so there is no lerp fallback to branch to
+inline Quaternion quat_slerp_one(const Quaternion& a, const Quaternion& b, float t) noexcept
+{
+	const float d = quat_dot(a, b);
+	const float sign = d < 0.0f ? -1.0f : 1.0f;
+	const float angle = quat_acos_poly(std::min(std::abs(d), 1.0f));
+	const float u = 1.0f - t;
+	const float sinc = quat_sinc_poly(angle * angle);
+	const float wa = (u * quat_sinc_poly((u * angle) * (u * angle))) / sinc;
+	const float wb = (t * quat_sinc_poly((t * angle) * (t * angle))) / sinc;
+	return quat_blend(a, b, wa, wb * sign);
+}
+
+#if PENUMBRA_SIMD
+struct simd_quat8
+{
+	f32x8 x, y, z, w;
+};
+
+inline simd_quat8 simd_quat8_load(const Quaternion* q)
+{
+	const float* rows[8];
+	for(u32 k = 0; k < 8; k++)
+		rows[k] = q[k].data;
+
+	simd_quat8 r;
+	f32x8_load_transposed(rows, r.x, r.y, r.z, r.w);
+	return r;
+}
+
+inline void simd_quat8_store(Quaternion* q, const simd_quat8& v)
+{
+	float* rows[8];
+	for(u32 k = 0; k < 8; k++)
+		rows[k] = q[k].data;
+
+	f32x8_store_transposed(rows, v.x, v.y, v.z, v.w);
+}
+
+inline f32x8 simd_quat8_dot(const simd_quat8& a, const simd_quat8& b)
+{
+	return f32x8_add(f32x8_add(f32x8_add(f32x8_mul(a.x, b.x), f32x8_mul(a.y, b.y)), f32x8_mul(a.z, b.z)), f32x8_mul(a.w, b.w));
+}
+
+inline simd_quat8 simd_quat8_blend(const simd_quat8& a, const simd_quat8& b, f32x8 wa, f32x8 wb)
+{
+	return
+	{
+		f32x8_add(f32x8_mul(a.x, wa), f32x8_mul(b.x, wb)),
+		f32x8_add(f32x8_mul(a.y, wa), f32x8_mul(b.y, wb)),
+		f32x8_add(f32x8_mul(a.z, wa), f32x8_mul(b.z, wb)),
+		f32x8_add(f32x8_mul(a.w, wa), f32x8_mul(b.w, wb))
+	};
+}
+
+inline simd_quat8 simd_quat8_normalize(const simd_quat8& q)
+{
+	const f32x8 len = f32x8_sqrt(simd_quat8_dot(q, q));
+	return {f32x8_div(q.x, len), f32x8_div(q.y, len), f32x8_div(q.z, len), f32x8_div(q.w, len)};
+}
+
+// minus one where the dot is negative and one otherwise, the flip to the shorter arc
+inline f32x8 simd_quat8_sign(f32x8 d)
+{
+	return f32x8_add(f32x8_splat(1.0f), f32x8_and(f32x8_cmplt(d, f32x8_splat(0.0f)), f32x8_splat(-2.0f)));
+}
+
+inline f32x8 simd_poly_step(f32x8 p, f32x8 x, float c)
+{
+	return f32x8_add(f32x8_mul(p, x), f32x8_splat(c));
+}
+
+inline f32x8 simd_quat_acos_poly(f32x8 x)
+{
+	f32x8 p = simd_poly_step(f32x8_splat(-0.0012624911f), x, 0.0066700901f);
+	p = simd_poly_step(p, x, -0.0170881256f);
+	p = simd_poly_step(p, x, 0.0308918810f);
+	p = simd_poly_step(p, x, -0.0501743046f);
+	p = simd_poly_step(p, x, 0.0889789874f);
+	p = simd_poly_step(p, x, -0.2145988016f);
+	p = simd_poly_step(p, x, 1.5707963050f);
+	return f32x8_mul(f32x8_sqrt(f32x8_sub(f32x8_splat(1.0f), x)), p);
+}
+
+inline f32x8 simd_quat_sinc_poly(f32x8 x2)
+{
+	f32x8 p = simd_poly_step(f32x8_splat(-2.5052108e-8f), x2, 2.7557319e-6f);
+	p = simd_poly_step(p, x2, -1.9841270e-4f);
+	p = simd_poly_step(p, x2, 8.3333333e-3f);
+	p = simd_poly_step(p, x2, -1.6666667e-1f);
+	return simd_poly_step(p, x2, 1.0f);
+}
+#endif
+
+inline void quat_normalize(const Quaternion* in, u32 count, Quaternion* out) noexcept
+{
+	u32 i = 0;
+#if PENUMBRA_SIMD
+	for(; i + 8u <= count; i += 8u)
+		simd_quat8_store(out + i, simd_quat8_normalize(simd_quat8_load(in + i)));
+#endif
+
+	for(; i < count; i++)
+		out[i] = quat_normalize_one(in[i]);
+}
+
+// normalized lerp along the shorter arc, what blending and sampling want when keys are close together
+inline void quat_nlerp(const Quaternion* a, const Quaternion* b, const float* t, u32 count, Quaternion* out) noexcept
+{
+	u32 i = 0;
+#if PENUMBRA_SIMD
+	for(; i + 8u <= count; i += 8u)
+	{
+		const simd_quat8 qa = simd_quat8_load(a + i);
+		const simd_quat8 qb = simd_quat8_load(b + i);
+		const f32x8 tt = f32x8_load(t + i);
+		const f32x8 wb = f32x8_mul(tt, simd_quat8_sign(simd_quat8_dot(qa, qb)));
+		simd_quat8_store(out + i, simd_quat8_normalize(simd_quat8_blend(qa, qb, f32x8_sub(f32x8_splat(1.0f), tt), wb)));
+	}
+#endif
+
+	for(; i < count; i++)
+	{
+		const float sign = quat_dot(a[i], b[i]) < 0.0f ? -1.0f : 1.0f;
+		out[i] = quat_normalize_one(quat_blend(a[i], b[i], 1.0f - t[i], t[i] * sign));
+	}
+}
+
+// slerp along the shorter arc for unit quaternions and t in [0, 1], within a few ulps of a double precision slerp
+inline void quat_slerp(const Quaternion* a, const Quaternion* b, const float* t, u32 count, Quaternion* out) noexcept
+{
+	u32 i = 0;
+#if PENUMBRA_SIMD
+	const f32x8 one = f32x8_splat(1.0f);
+	for(; i + 8u <= count; i += 8u)
+	{
+		const simd_quat8 qa = simd_quat8_load(a + i);
+		const simd_quat8 qb = simd_quat8_load(b + i);
+		const f32x8 tt = f32x8_load(t + i);
+		const f32x8 d = simd_quat8_dot(qa, qb);
+		const f32x8 angle = simd_quat_acos_poly(f32x8_min(f32x8_abs(d), one));
+		const f32x8 u = f32x8_sub(one, tt);
+		const f32x8 ua = f32x8_mul(u, angle);
+		const f32x8 ta = f32x8_mul(tt, angle);
+		const f32x8 sinc = simd_quat_sinc_poly(f32x8_mul(angle, angle));
+		const f32x8 wa = f32x8_div(f32x8_mul(u, simd_quat_sinc_poly(f32x8_mul(ua, ua))), sinc);
+		const f32x8 wb = f32x8_div(f32x8_mul(tt, simd_quat_sinc_poly(f32x8_mul(ta, ta))), sinc);
+		simd_quat8_store(out + i, simd_quat8_blend(qa, qb, wa, f32x8_mul(wb, simd_quat8_sign(d))));
+	}
+#endif
+
+	for(; i < count; i++)
+		out[i] = quat_slerp_one(a[i], b[i], t[i]);
+}
+
+// rotation matrices in the layout of transform_compose's 3x4 output, each row a column of make_mat4 and w zero
+inline void quat_to_mat3x4(const Quaternion* in, u32 count, mat3x4* out) noexcept
+{
+	u32 i = 0;
+#if PENUMBRA_SIMD
+	const f32x8 one = f32x8_splat(1.0f);
+	const f32x8 zero = f32x8_splat(0.0f);
+	for(; i + 8u <= count; i += 8u)
+	{
+		const simd_quat8 q = simd_quat8_load(in + i);
+		const f32x8 x2 = f32x8_add(q.x, q.x);
+		const f32x8 y2 = f32x8_add(q.y, q.y);
+		const f32x8 z2 = f32x8_add(q.z, q.z);
+		const f32x8 xx = f32x8_mul(q.x, x2), yy = f32x8_mul(q.y, y2), zz = f32x8_mul(q.z, z2);
+		const f32x8 xy = f32x8_mul(q.x, y2), xz = f32x8_mul(q.x, z2), yz = f32x8_mul(q.y, z2);
+		const f32x8 xw = f32x8_mul(q.w, x2), yw = f32x8_mul(q.w, y2), zw = f32x8_mul(q.w, z2);
+
+		float* rows[8];
+		for(u32 k = 0; k < 8; k++)
+			rows[k] = out[i + k].floats();
+		f32x8_store_transposed(rows, f32x8_sub(f32x8_sub(one, yy), zz), f32x8_sub(xy, zw), f32x8_add(xz, yw), zero);
+
+		for(u32 k = 0; k < 8; k++)
+			rows[k] += 4;
+		f32x8_store_transposed(rows, f32x8_add(xy, zw), f32x8_sub(f32x8_sub(one, xx), zz), f32x8_sub(yz, xw), zero);
+
+		for(u32 k = 0; k < 8; k++)
+			rows[k] += 4;
+		f32x8_store_transposed(rows, f32x8_sub(xz, yw), f32x8_add(yz, xw), f32x8_sub(f32x8_sub(one, xx), yy), zero);
+	}
+#endif
+
+	for(; i < count; i++)
+	{
+		const Quaternion& q = in[i];
+		const float x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+		const float xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+		const float xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+		const float xw = q.w * x2, yw = q.w * y2, zw = q.w * z2;
+		out[i] = mat3x4
+		{
+			vec4{(1.0f - yy) - zz, xy - zw, xz + yw, 0.0f},
+			vec4{xy + zw, (1.0f - xx) - zz, yz - xw, 0.0f},
+			vec4{xz - yw, yz + xw, (1.0f - xx) - yy, 0.0f}
+		};
+	}
+}
+
 }
 
 template <typename T>
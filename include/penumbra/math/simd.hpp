@@ -0,0 +1,369 @@
+#pragma once
+
+#include <penumbra/types.hpp>
+
+// the instruction set is picked at compile time from what the compiler targets, the build uses -march=native
+// define PENUMBRA_SIMD_DISABLE to force the scalar reference paths everywhere
+#if !defined PENUMBRA_SIMD_DISABLE
+#if defined __SSE4_1__
+#define PENUMBRA_SIMD_SSE4 1
+#if defined __AVX2__
+#define PENUMBRA_SIMD_AVX2 1
+#endif
+#elif defined __ARM_NEON && defined __aarch64__
+#define PENUMBRA_SIMD_NEON 1
+#endif
+#endif
+
+#if defined PENUMBRA_SIMD_SSE4 || defined PENUMBRA_SIMD_NEON
+#define PENUMBRA_SIMD 1
+#else
+#define PENUMBRA_SIMD 0
+#endif
+
+#if defined PENUMBRA_SIMD_SSE4
+#include <immintrin.h>
+#elif defined PENUMBRA_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace penumbra
+{
+
+#if PENUMBRA_SIMD
+
+// thin wrappers over four float lanes so kernels are written once for sse and neon, every one maps to a single
+// instruction or a short fixed sequence, multiplies and adds are never fused so results match the scalar code
+#if defined PENUMBRA_SIMD_SSE4
+using f32x4 = __m128;
+
+inline f32x4 f32x4_load(const float* p) { return _mm_loadu_ps(p); }
+inline void f32x4_store(float* p, f32x4 v) { _mm_storeu_ps(p, v); }
+inline f32x4 f32x4_set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline f32x4 f32x4_splat(float s) { return _mm_set1_ps(s); }
+inline f32x4 f32x4_zero() { return _mm_setzero_ps(); }
+inline f32x4 f32x4_add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+inline f32x4 f32x4_sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+inline f32x4 f32x4_mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+inline f32x4 f32x4_div(f32x4 a, f32x4 b) { return _mm_div_ps(a, b); }
+inline float f32x4_x(f32x4 v) { return _mm_cvtss_f32(v); }
+inline f32x4 f32x4_min(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+inline f32x4 f32x4_max(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+inline f32x4 f32x4_abs(f32x4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+inline f32x4 f32x4_sqrt(f32x4 v) { return _mm_sqrt_ps(v); }
+
+// comparisons give all ones lanes where they hold, movemask packs the lanes into the low bits
+inline f32x4 f32x4_cmpgt(f32x4 a, f32x4 b) { return _mm_cmpgt_ps(a, b); }
+inline f32x4 f32x4_cmplt(f32x4 a, f32x4 b) { return _mm_cmplt_ps(a, b); }
+inline f32x4 f32x4_and(f32x4 a, f32x4 b) { return _mm_and_ps(a, b); }
+inline u32 f32x4_movemask(f32x4 v) { return static_cast<u32>(_mm_movemask_ps(v)); }
+
+// lanes x and y come from a, z and w from b
+template <int X, int Y, int Z, int W>
+inline f32x4 f32x4_shuffle(f32x4 a, f32x4 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X)); }
+
+template <int X, int Y, int Z, int W>
+inline f32x4 f32x4_swizzle(f32x4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X)); }
+
+// xyz from a, w from b
+inline f32x4 f32x4_blend_w(f32x4 a, f32x4 b) { return _mm_blend_ps(a, b, 0x8); }
+
+inline void f32x4_transpose(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) { _MM_TRANSPOSE4_PS(r0, r1, r2, r3); }
+#elif defined PENUMBRA_SIMD_NEON
+using f32x4 = float32x4_t;
+
+inline f32x4 f32x4_load(const float* p) { return vld1q_f32(p); }
+inline void f32x4_store(float* p, f32x4 v) { vst1q_f32(p, v); }
+inline f32x4 f32x4_set(float x, float y, float z, float w) { const float v[4]{x, y, z, w}; return vld1q_f32(v); }
+inline f32x4 f32x4_splat(float s) { return vdupq_n_f32(s); }
+inline f32x4 f32x4_zero() { return vdupq_n_f32(0.0f); }
+inline f32x4 f32x4_add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+inline f32x4 f32x4_sub(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+inline f32x4 f32x4_mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+inline f32x4 f32x4_div(f32x4 a, f32x4 b) { return vdivq_f32(a, b); }
+inline float f32x4_x(f32x4 v) { return vgetq_lane_f32(v, 0); }
+inline f32x4 f32x4_min(f32x4 a, f32x4 b) { return vminq_f32(a, b); }
+inline f32x4 f32x4_max(f32x4 a, f32x4 b) { return vmaxq_f32(a, b); }
+inline f32x4 f32x4_abs(f32x4 v) { return vabsq_f32(v); }
+inline f32x4 f32x4_sqrt(f32x4 v) { return vsqrtq_f32(v); }
+
+inline f32x4 f32x4_cmpgt(f32x4 a, f32x4 b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+inline f32x4 f32x4_cmplt(f32x4 a, f32x4 b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+inline f32x4 f32x4_and(f32x4 a, f32x4 b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+inline u32 f32x4_movemask(f32x4 v)
+{
+	const int32x4_t shift{0, 1, 2, 3};
+	return vaddvq_u32(vshlq_u32(vshrq_n_u32(vreinterpretq_u32_f32(v), 31), shift));
+}
+
+template <int X, int Y, int Z, int W>
+inline f32x4 f32x4_shuffle(f32x4 a, f32x4 b) { return __builtin_shufflevector(a, b, X, Y, Z + 4, W + 4); }
+
+template <int X, int Y, int Z, int W>
+inline f32x4 f32x4_swizzle(f32x4 v) { return __builtin_shufflevector(v, v, X, Y, Z, W); }
+
+inline f32x4 f32x4_blend_w(f32x4 a, f32x4 b) { return vcopyq_laneq_f32(a, 3, b, 3); }
+
+inline void f32x4_transpose(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3)
+{
+	const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+	const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+	r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+	r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+	r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+	r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+#endif
+
+template <int I>
+inline f32x4 f32x4_splat_lane(f32x4 v) { return f32x4_swizzle<I, I, I, I>(v); }
+
+// eight lanes for batch kernels, one register with avx2 and a pair of four lane halves otherwise
+#if defined PENUMBRA_SIMD_AVX2
+using f32x8 = __m256;
+
+inline f32x8 f32x8_combine(f32x4 lo, f32x4 hi) { return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1); }
+inline f32x4 f32x8_lo(f32x8 v) { return _mm256_castps256_ps128(v); }
+inline f32x4 f32x8_hi(f32x8 v) { return _mm256_extractf128_ps(v, 1); }
+inline f32x8 f32x8_load(const float* p) { return _mm256_loadu_ps(p); }
+inline f32x8 f32x8_splat(float s) { return _mm256_set1_ps(s); }
+inline f32x8 f32x8_add(f32x8 a, f32x8 b) { return _mm256_add_ps(a, b); }
+inline f32x8 f32x8_sub(f32x8 a, f32x8 b) { return _mm256_sub_ps(a, b); }
+inline f32x8 f32x8_mul(f32x8 a, f32x8 b) { return _mm256_mul_ps(a, b); }
+inline f32x8 f32x8_div(f32x8 a, f32x8 b) { return _mm256_div_ps(a, b); }
+inline f32x8 f32x8_min(f32x8 a, f32x8 b) { return _mm256_min_ps(a, b); }
+inline f32x8 f32x8_abs(f32x8 v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+inline f32x8 f32x8_sqrt(f32x8 v) { return _mm256_sqrt_ps(v); }
+inline f32x8 f32x8_cmpgt(f32x8 a, f32x8 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline f32x8 f32x8_cmplt(f32x8 a, f32x8 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline f32x8 f32x8_and(f32x8 a, f32x8 b) { return _mm256_and_ps(a, b); }
+inline u32 f32x8_movemask(f32x8 v) { return static_cast<u32>(_mm256_movemask_ps(v)); }
+#else
+struct f32x8
+{
+	f32x4 lo;
+	f32x4 hi;
+};
+
+inline f32x8 f32x8_combine(f32x4 lo, f32x4 hi) { return {lo, hi}; }
+inline f32x4 f32x8_lo(f32x8 v) { return v.lo; }
+inline f32x4 f32x8_hi(f32x8 v) { return v.hi; }
+inline f32x8 f32x8_load(const float* p) { return {f32x4_load(p), f32x4_load(p + 4)}; }
+inline f32x8 f32x8_splat(float s) { return {f32x4_splat(s), f32x4_splat(s)}; }
+inline f32x8 f32x8_add(f32x8 a, f32x8 b) { return {f32x4_add(a.lo, b.lo), f32x4_add(a.hi, b.hi)}; }
+inline f32x8 f32x8_sub(f32x8 a, f32x8 b) { return {f32x4_sub(a.lo, b.lo), f32x4_sub(a.hi, b.hi)}; }
+inline f32x8 f32x8_mul(f32x8 a, f32x8 b) { return {f32x4_mul(a.lo, b.lo), f32x4_mul(a.hi, b.hi)}; }
+inline f32x8 f32x8_div(f32x8 a, f32x8 b) { return {f32x4_div(a.lo, b.lo), f32x4_div(a.hi, b.hi)}; }
+inline f32x8 f32x8_min(f32x8 a, f32x8 b) { return {f32x4_min(a.lo, b.lo), f32x4_min(a.hi, b.hi)}; }
+inline f32x8 f32x8_abs(f32x8 v) { return {f32x4_abs(v.lo), f32x4_abs(v.hi)}; }
+inline f32x8 f32x8_cmpgt(f32x8 a, f32x8 b) { return {f32x4_cmpgt(a.lo, b.lo), f32x4_cmpgt(a.hi, b.hi)}; }
+inline f32x8 f32x8_cmplt(f32x8 a, f32x8 b) { return {f32x4_cmplt(a.lo, b.lo), f32x4_cmplt(a.hi, b.hi)}; }
+inline f32x8 f32x8_and(f32x8 a, f32x8 b) { return {f32x4_and(a.lo, b.lo), f32x4_and(a.hi, b.hi)}; }
+inline u32 f32x8_movemask(f32x8 v) { return f32x4_movemask(v.lo) | (f32x4_movemask(v.hi) << 4u); }
+inline f32x8 f32x8_sqrt(f32x8 v) { return {f32x4_sqrt(v.lo), f32x4_sqrt(v.hi)}; }
+#endif
+
+// eight vec4 rows into eight lanes each of x, y, z and w, how array of structure inputs get into the batch kernels
+inline void f32x8_load_transposed(const float* const rows[8], f32x8& x, f32x8& y, f32x8& z, f32x8& w)
+{
+	f32x4 a0 = f32x4_load(rows[0]), a1 = f32x4_load(rows[1]), a2 = f32x4_load(rows[2]), a3 = f32x4_load(rows[3]);
+	f32x4 b0 = f32x4_load(rows[4]), b1 = f32x4_load(rows[5]), b2 = f32x4_load(rows[6]), b3 = f32x4_load(rows[7]);
+	f32x4_transpose(a0, a1, a2, a3);
+	f32x4_transpose(b0, b1, b2, b3);
+	x = f32x8_combine(a0, b0);
+	y = f32x8_combine(a1, b1);
+	z = f32x8_combine(a2, b2);
+	w = f32x8_combine(a3, b3);
+}
+
+// the way back, eight lanes each of x, y, z and w out as eight vec4 rows
+inline void f32x8_store_transposed(float* const rows[8], f32x8 x, f32x8 y, f32x8 z, f32x8 w)
+{
+	f32x4 a0 = f32x8_lo(x), a1 = f32x8_lo(y), a2 = f32x8_lo(z), a3 = f32x8_lo(w);
+	f32x4 b0 = f32x8_hi(x), b1 = f32x8_hi(y), b2 = f32x8_hi(z), b3 = f32x8_hi(w);
+	f32x4_transpose(a0, a1, a2, a3);
+	f32x4_transpose(b0, b1, b2, b3);
+	f32x4_store(rows[0], a0);
+	f32x4_store(rows[1], a1);
+	f32x4_store(rows[2], a2);
+	f32x4_store(rows[3], a3);
+	f32x4_store(rows[4], b0);
+	f32x4_store(rows[5], b1);
+	f32x4_store(rows[6], b2);
+	f32x4_store(rows[7], b3);
+}
+
+// mat4 kernels on 16 row major floats, Matrix dispatches to these and keeps the scalar code as the reference
+// a row times a matrix associates like Vector::dot, x * b0 + (y * b1 + (z * b2 + w * b3)), so products match it bit for bit
+inline f32x4 simd_row_mul(f32x4 row, f32x4 b0, f32x4 b1, f32x4 b2, f32x4 b3)
+{
+	const f32x4 zw = f32x4_add(f32x4_mul(f32x4_splat_lane<2>(row), b2), f32x4_mul(f32x4_splat_lane<3>(row), b3));
+	const f32x4 yzw = f32x4_add(f32x4_mul(f32x4_splat_lane<1>(row), b1), zw);
+	return f32x4_add(f32x4_mul(f32x4_splat_lane<0>(row), b0), yzw);
+}
+
+inline void simd_mat4_mul(const float* a, const float* b, float* out)
+{
+#if defined PENUMBRA_SIMD_AVX2
+	// two rows per register, the rows of b are broadcast to both halves
+	const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 0));
+	const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 4));
+	const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 8));
+	const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 12));
+
+	for(int i = 0; i < 16; i += 8)
+	{
+		const __m256 rows = _mm256_loadu_ps(a + i);
+		const __m256 zw = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(rows, 0xaa), b2), _mm256_mul_ps(_mm256_permute_ps(rows, 0xff), b3));
+		const __m256 yzw = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(rows, 0x55), b1), zw);
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b0), yzw));
+	}
+#else
+	const f32x4 b0 = f32x4_load(b + 0);
+	const f32x4 b1 = f32x4_load(b + 4);
+	const f32x4 b2 = f32x4_load(b + 8);
+	const f32x4 b3 = f32x4_load(b + 12);
+
+	for(int i = 0; i < 16; i += 4)
+		f32x4_store(out + i, simd_row_mul(f32x4_load(a + i), b0, b1, b2, b3));
+#endif
+}
+
+inline void simd_vec4_mul_mat4(const float* v, const float* m, float* out)
+{
+	f32x4_store(out, simd_row_mul(f32x4_load(v), f32x4_load(m), f32x4_load(m + 4), f32x4_load(m + 8), f32x4_load(m + 12)));
+}
+
+inline void simd_mat4_transpose(const float* m, float* out)
+{
+#if defined PENUMBRA_SIMD_NEON
+	// the interleaving load is the transpose
+	const float32x4x4_t cols = vld4q_f32(m);
+	for(int i = 0; i < 4; i++)
+		vst1q_f32(out + i * 4, cols.val[i]);
+#else
+	f32x4 r0 = f32x4_load(m + 0);
+	f32x4 r1 = f32x4_load(m + 4);
+	f32x4 r2 = f32x4_load(m + 8);
+	f32x4 r3 = f32x4_load(m + 12);
+	f32x4_transpose(r0, r1, r2, r3);
+	f32x4_store(out + 0, r0);
+	f32x4_store(out + 4, r1);
+	f32x4_store(out + 8, r2);
+	f32x4_store(out + 12, r3);
+#endif
+}
+
+// 2x2 blocks stored as one register (x y / z w), with A# the adjugate
+inline f32x4 simd_mat2_mul(f32x4 a, f32x4 b)
+{
+	return f32x4_add(f32x4_mul(a, f32x4_swizzle<0, 3, 0, 3>(b)), f32x4_mul(f32x4_swizzle<1, 0, 3, 2>(a), f32x4_swizzle<2, 1, 2, 1>(b)));
+}
+
+// A# * B
+inline f32x4 simd_mat2_adj_mul(f32x4 a, f32x4 b)
+{
+	return f32x4_sub(f32x4_mul(f32x4_swizzle<3, 3, 0, 0>(a), b), f32x4_mul(f32x4_swizzle<1, 1, 2, 2>(a), f32x4_swizzle<2, 3, 0, 1>(b)));
+}
+
+// A * B#
+inline f32x4 simd_mat2_mul_adj(f32x4 a, f32x4 b)
+{
+	return f32x4_sub(f32x4_mul(a, f32x4_swizzle<3, 0, 3, 0>(b)), f32x4_mul(f32x4_swizzle<1, 0, 3, 2>(a), f32x4_swizzle<2, 1, 2, 1>(b)));
+}
+
+// general inverse through the 2x2 block decomposition, no pivoting, a singular matrix gives infinities like the reference
+inline void simd_mat4_inverse(const float* m, float* out)
+{
+	const f32x4 r0 = f32x4_load(m + 0);
+	const f32x4 r1 = f32x4_load(m + 4);
+	const f32x4 r2 = f32x4_load(m + 8);
+	const f32x4 r3 = f32x4_load(m + 12);
+
+	// M = | A B |
+	//     | C D |
+	const f32x4 a = f32x4_shuffle<0, 1, 0, 1>(r0, r1);
+	const f32x4 b = f32x4_shuffle<2, 3, 2, 3>(r0, r1);
+	const f32x4 c = f32x4_shuffle<0, 1, 0, 1>(r2, r3);
+	const f32x4 d = f32x4_shuffle<2, 3, 2, 3>(r2, r3);
+
+	// |A| |B| |C| |D|
+	const f32x4 det_sub = f32x4_sub(
+		f32x4_mul(f32x4_shuffle<0, 2, 0, 2>(r0, r2), f32x4_shuffle<1, 3, 1, 3>(r1, r3)),
+		f32x4_mul(f32x4_shuffle<1, 3, 1, 3>(r0, r2), f32x4_shuffle<0, 2, 0, 2>(r1, r3)));
+	const f32x4 det_a = f32x4_splat_lane<0>(det_sub);
+	const f32x4 det_b = f32x4_splat_lane<1>(det_sub);
+	const f32x4 det_c = f32x4_splat_lane<2>(det_sub);
+	const f32x4 det_d = f32x4_splat_lane<3>(det_sub);
+
+	const f32x4 d_c = simd_mat2_adj_mul(d, c);
+	const f32x4 a_b = simd_mat2_adj_mul(a, b);
+
+	// the blocks of the adjugate, M^-1 = 1/|M| * | X Y |
+	//                                             | Z W |
+	f32x4 x = f32x4_sub(f32x4_mul(det_d, a), simd_mat2_mul(b, d_c));
+	f32x4 w = f32x4_sub(f32x4_mul(det_a, d), simd_mat2_mul(c, a_b));
+	f32x4 y = f32x4_sub(f32x4_mul(det_b, c), simd_mat2_mul_adj(d, a_b));
+	f32x4 z = f32x4_sub(f32x4_mul(det_c, b), simd_mat2_mul_adj(a, d_c));
+
+	// |M| = |A||D| + |B||C| - tr(A#B D#C), the trace summed across lanes without horizontal adds
+	f32x4 tr = f32x4_mul(a_b, f32x4_swizzle<0, 2, 1, 3>(d_c));
+	tr = f32x4_add(tr, f32x4_swizzle<1, 0, 3, 2>(tr));
+	tr = f32x4_add(tr, f32x4_swizzle<2, 3, 0, 1>(tr));
+	const f32x4 det = f32x4_sub(f32x4_add(f32x4_mul(det_a, det_d), f32x4_mul(det_b, det_c)), tr);
+
+	const f32x4 rdet = f32x4_div(f32x4_set(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = f32x4_mul(x, rdet);
+	y = f32x4_mul(y, rdet);
+	z = f32x4_mul(z, rdet);
+	w = f32x4_mul(w, rdet);
+
+	// the adjugate of each block folded into the store shuffle
+	f32x4_store(out + 0, f32x4_shuffle<3, 1, 3, 1>(x, y));
+	f32x4_store(out + 4, f32x4_shuffle<2, 0, 2, 0>(x, y));
+	f32x4_store(out + 8, f32x4_shuffle<3, 1, 3, 1>(z, w));
+	f32x4_store(out + 12, f32x4_shuffle<2, 0, 2, 0>(z, w));
+}
+
+// a b.zxy - a.zxy b, the same order as cross() so the w lane stays zero
+inline f32x4 simd_cross3(f32x4 a, f32x4 b)
+{
+	return f32x4_sub(
+		f32x4_mul(f32x4_swizzle<1, 2, 0, 3>(a), f32x4_swizzle<2, 0, 1, 3>(b)),
+		f32x4_mul(f32x4_swizzle<2, 0, 1, 3>(a), f32x4_swizzle<1, 2, 0, 3>(b)));
+}
+
+// rows 0-2 are the linear part with a zero w, row 3 the translation, the inverse of the 3x3 block through cross products
+inline void simd_mat4_inverse_affine(const float* m, float* out)
+{
+	const f32x4 r0 = f32x4_load(m + 0);
+	const f32x4 r1 = f32x4_load(m + 4);
+	const f32x4 r2 = f32x4_load(m + 8);
+	const f32x4 t = f32x4_load(m + 12);
+
+	f32x4 c0 = simd_cross3(r1, r2);
+	f32x4 c1 = simd_cross3(r2, r0);
+	f32x4 c2 = simd_cross3(r0, r1);
+	f32x4 c3 = f32x4_zero();
+
+	// x + (y + z) like a 3 wide dot
+	const f32x4 p = f32x4_mul(r0, c0);
+	const f32x4 det = f32x4_add(p, f32x4_add(f32x4_splat_lane<1>(p), f32x4_splat_lane<2>(p)));
+	const f32x4 rdet = f32x4_div(f32x4_splat(1.0f), f32x4_splat_lane<0>(det));
+
+	f32x4_transpose(c0, c1, c2, c3);
+	c0 = f32x4_mul(c0, rdet);
+	c1 = f32x4_mul(c1, rdet);
+	c2 = f32x4_mul(c2, rdet);
+
+	const f32x4 tl = simd_row_mul(f32x4_blend_w(t, f32x4_zero()), c0, c1, c2, f32x4_zero());
+	f32x4_store(out + 0, c0);
+	f32x4_store(out + 4, c1);
+	f32x4_store(out + 8, c2);
+	f32x4_store(out + 12, f32x4_blend_w(f32x4_sub(f32x4_zero(), tl), f32x4_splat(1.0f)));
+}
+
+#endif
+
+}
@@ -32,9 +32,16 @@ struct basic_transform
 		return {-t.translation, ~t.rotation, T(1.0) / t.scale};
 	}	
 
+	static constexpr basic_transform<T> interpolate(const basic_transform<T>& a, const basic_transform<T>& b, T t)
+	{
+		return {mix(a.translation, b.translation, t), basic_quat<T>::slerp(a.rotation, b.rotation, t), mix(a.scale, b.scale, t)};
+	}
+
+	// scale * rotation * translation, written out since the scale only scales the rotation rows and the translation is the last row
 	Matrix<T, 4, 4> as_matrix() const noexcept
 	{
-		return Matrix<T, 4, 4>::make_scale(scale) * basic_quat<T>::make_mat4(rotation) * Matrix<T, 4, 4>::make_translation(translation);
+		const Matrix<T, 4, 4> r = basic_quat<T>::make_mat4(rotation);
+		return Matrix<T, 4, 4>{r[0] * scale.x, r[1] * scale.y, r[2] * scale.z, Vector<T, 4>{translation, T(1.0)}};
 	}
 
 	Matrix<T, 4, 4> as_inverse_translation_rotation() const noexcept
@@ -127,6 +134,118 @@ constexpr std::tuple<Vector<T, 3>, basic_quat<T>, Vector<T, 3>> decompose(Matrix
 
 using Transform = basic_transform<float>;
 
+// local transforms as one array per component, count entries each
+struct transform_batch_t
+{
+	const vec3* translation;
+	const Quaternion* rotation;
+	const vec3* scale;
+	u32 count;
+};
+
+#if PENUMBRA_SIMD
+// the rows of Transform::as_matrix, the rotation comes straight from the quaternion and the zero w lanes of the signs keep w at zero
+inline void simd_transform_rows(const vec3& t, const Quaternion& q, const vec3& s, f32x4 rows[4])
+{
+	const f32x4 v = f32x4_load(q.data);
+	const f32x4 v2 = f32x4_add(v, v);
+
+	// 2yy 2xy 2xz, 2zz 2zw 2yw
+	const f32x4 a0 = f32x4_mul(f32x4_swizzle<1, 0, 0, 3>(v2), f32x4_swizzle<1, 1, 2, 3>(v));
+	const f32x4 b0 = f32x4_mul(f32x4_swizzle<2, 2, 1, 3>(v2), f32x4_swizzle<2, 3, 3, 3>(v));
+	// 2xy 2xx 2yz, 2zw 2zz 2xw
+	const f32x4 a1 = f32x4_mul(f32x4_swizzle<0, 0, 1, 3>(v2), f32x4_swizzle<1, 0, 2, 3>(v));
+	const f32x4 b1 = f32x4_mul(f32x4_swizzle<2, 2, 0, 3>(v2), f32x4_swizzle<3, 2, 3, 3>(v));
+	// 2xz 2yz 2xx, 2yw 2xw 2yy
+	const f32x4 a2 = f32x4_mul(f32x4_swizzle<0, 1, 0, 3>(v2), f32x4_swizzle<2, 2, 0, 3>(v));
+	const f32x4 b2 = f32x4_mul(f32x4_swizzle<1, 0, 1, 3>(v2), f32x4_swizzle<3, 3, 1, 3>(v));
+
+	const f32x4 r0 = f32x4_add(f32x4_add(f32x4_set(1.0f, 0.0f, 0.0f, 0.0f), f32x4_mul(f32x4_set(-1.0f, 1.0f, 1.0f, 0.0f), a0)), f32x4_mul(f32x4_set(-1.0f, 1.0f, -1.0f, 0.0f), b0));
+	const f32x4 r1 = f32x4_add(f32x4_add(f32x4_set(0.0f, 1.0f, 0.0f, 0.0f), f32x4_mul(f32x4_set(1.0f, -1.0f, 1.0f, 0.0f), a1)), f32x4_mul(f32x4_set(-1.0f, -1.0f, 1.0f, 0.0f), b1));
+	const f32x4 r2 = f32x4_add(f32x4_add(f32x4_set(0.0f, 0.0f, 1.0f, 0.0f), f32x4_mul(f32x4_set(1.0f, 1.0f, -1.0f, 0.0f), a2)), f32x4_mul(f32x4_set(1.0f, -1.0f, -1.0f, 0.0f), b2));
+
+	rows[0] = f32x4_mul(r0, f32x4_splat(s.x));
+	rows[1] = f32x4_mul(r1, f32x4_splat(s.y));
+	rows[2] = f32x4_mul(r2, f32x4_splat(s.z));
+	rows[3] = f32x4_set(t.x, t.y, t.z, 1.0f);
+}
+
+inline void simd_transform_rows_parent(const float* parent, f32x4 rows[4])
+{
+	const f32x4 p0 = f32x4_load(parent + 0);
+	const f32x4 p1 = f32x4_load(parent + 4);
+	const f32x4 p2 = f32x4_load(parent + 8);
+	const f32x4 p3 = f32x4_load(parent + 12);
+	for(int r = 0; r < 4; r++)
+		rows[r] = simd_row_mul(rows[r], p0, p1, p2, p3);
+}
+#endif
+
+// out[i] = local[i] * parent, the same as as_matrix() * parent, a null parent gives the local matrices
+inline void transform_compose(const transform_batch_t& batch, const mat4* parent, mat4* out)
+{
+	for(u32 i = 0; i < batch.count; i++)
+	{
+#if PENUMBRA_SIMD
+		f32x4 rows[4];
+		simd_transform_rows(batch.translation[i], batch.rotation[i], batch.scale[i], rows);
+		if(parent)
+			simd_transform_rows_parent(parent->floats(), rows);
+
+		for(int r = 0; r < 4; r++)
+			f32x4_store(out[i].floats() + r * 4, rows[r]);
+#else
+		const mat4 local = Transform{batch.translation[i], batch.rotation[i], batch.scale[i]}.as_matrix();
+		out[i] = parent ? local * *parent : local;
+#endif
+	}
+}
+
+// the same as transposed 3x4 affine matrices, each row is a column of the 4x4 with the translation in w
+inline void transform_compose(const transform_batch_t& batch, const mat4* parent, mat3x4* out)
+{
+	for(u32 i = 0; i < batch.count; i++)
+	{
+#if PENUMBRA_SIMD
+		f32x4 rows[4];
+		simd_transform_rows(batch.translation[i], batch.rotation[i], batch.scale[i], rows);
+		if(parent)
+			simd_transform_rows_parent(parent->floats(), rows);
+
+		f32x4_transpose(rows[0], rows[1], rows[2], rows[3]);
+		for(int r = 0; r < 3; r++)
+			f32x4_store(out[i].floats() + r * 4, rows[r]);
+#else
+		const mat4 local = Transform{batch.translation[i], batch.rotation[i], batch.scale[i]}.as_matrix();
+		const mat4 world = mat4::transpose(parent ? local * *parent : local);
+		out[i] = mat3x4{world[0], world[1], world[2]};
+#endif
+	}
+}
+
+// parents have to come before their children, parents[i] is one based into out and zero makes it a child of parent,
+// the convention of skeleton bone parents and prefab nodes
+template <typename Index>
+inline void transform_compose_hierarchy(const transform_batch_t& batch, const Index* parents, const mat4* parent, mat4* out)
+{
+	for(u32 i = 0; i < batch.count; i++)
+	{
+		const mat4* p = parents[i] > 0 ? &out[parents[i] - 1] : parent;
+#if PENUMBRA_SIMD
+		f32x4 rows[4];
+		simd_transform_rows(batch.translation[i], batch.rotation[i], batch.scale[i], rows);
+		if(p)
+			simd_transform_rows_parent(p->floats(), rows);
+
+		for(int r = 0; r < 4; r++)
+			f32x4_store(out[i].floats() + r * 4, rows[r]);
+#else
+		const mat4 local = Transform{batch.translation[i], batch.rotation[i], batch.scale[i]}.as_matrix();
+		out[i] = p ? local * *p : local;
+#endif
+	}
+}
+
 }
 
 template <typename T>
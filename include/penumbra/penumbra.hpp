@@ -1,20 +1,27 @@
 #pragma once
 
+#include <penumbra/allocator.hpp>
 #include <penumbra/array_proxy.hpp>
 #include <penumbra/config.hpp>
 #include <penumbra/cvar.hpp>
 #include <penumbra/ecs.hpp>
+#include <penumbra/flat_map.hpp>
+#include <penumbra/frame_pacer.hpp>
 #include <penumbra/gpu.hpp>
 #include <penumbra/hash.hpp>
 #include <penumbra/input.hpp>
 #include <penumbra/input_keys.hpp>
+#include <penumbra/job.hpp>
 #include <penumbra/log.hpp>
 #include <penumbra/math.hpp>
 #include <penumbra/panic.hpp>
 #include <penumbra/physics.hpp>
+#include <penumbra/profile.hpp>
 #include <penumbra/renderer.hpp>
 #include <penumbra/resource.hpp>
 #include <penumbra/shader.hpp>
+#include <penumbra/sim.hpp>
+#include <penumbra/sparse_set.hpp>
 #include <penumbra/types.hpp>
 #include <penumbra/ui.hpp>
 #include <penumbra/vfs.hpp>
@@ -2,6 +2,7 @@
 
 #include <penumbra/math/plane.hpp>
 #include <penumbra/math/transform.hpp>
+#include <penumbra/sim.hpp>
 #include <penumbra/types.hpp>
 
 namespace penumbra
@@ -85,9 +86,15 @@ struct physicsBoxHull
 void physics_create_world(const physicsWorldDesc& desc);
 void physics_destroy_world();
 void physics_world_simulate(float dt, int substeps);
+// appends the transforms of bodies that moved in the last two ticks keyed by userdata, dynamic bodies move every step
+// and kinematic ones when physics_body_set_transform places them, static bodies and bodies at rest are left out
+// so whatever else positions them (the editor gizmo, animation) is not overwritten every frame
+void physics_world_write_transforms(std::vector<sim_transform>& out);
 
 physicsBodyID physics_create_body(const physicsBodyDesc& desc);
 void physics_destroy_body(physicsBodyID body);
+// places a body outside the step, it goes into the next two snapshots like one the step moved
+void physics_body_set_transform(physicsBodyID body, const Transform& transform);
 
 physicsShapeID physics_create_sphere(physicsBodyID body, const physicsShapeDesc& desc, const physicsSphere& sphere);
 physicsShapeID physics_create_capsule(physicsBodyID body, const physicsShapeDesc& desc, const physicsCapsule& capsule);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <penumbra/vfs.hpp>
+#include <penumbra/types.hpp>
+
+#include <tracy/Tracy.hpp>
+
+namespace penumbra
+{
+
+// one per instrumented scope, lives in static storage so events only carry a pointer to it
+struct alignas(8) profile_zone_desc
+{
+	const char* name;
+	const char* function;
+	const char* file;
+	u32 line;
+};
+
+// zones are recorded into a fixed size ring per thread that keeps overwriting the oldest events,
+// a dump captures whatever the rings hold at that moment so hitches can be grabbed after the fact
+void profile_init();
+void profile_shutdown();
+
+void profile_set_enabled(bool enabled);
+bool profile_enabled();
+void profile_set_thread_name(const char* name);
+
+void profile_zone_begin(const profile_zone_desc* zone);
+void profile_zone_end();
+void profile_frame_mark();
+
+bool profile_dump_chrome(const vfs_path& path);
+bool profile_dump_binary(const vfs_path& path);
+// converts a binary dump to chrome trace json
+bool profile_convert_binary(const vfs_path& input, const vfs_path& output);
+
+struct profile_scope
+{
+	explicit profile_scope(const profile_zone_desc* zone) noexcept
+	{
+		profile_zone_begin(zone);
+	}
+
+	~profile_scope() noexcept
+	{
+		profile_zone_end();
+	}
+
+	profile_scope(const profile_scope&) = delete;
+	profile_scope& operator=(const profile_scope&) = delete;
+};
+
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_ZONE_IMPL(zone_name) \
+	static constexpr ::penumbra::profile_zone_desc PROFILE_CONCAT(profile_zone_, __LINE__){zone_name, __func__, __FILE__, static_cast<u32>(__LINE__)}; \
+	::penumbra::profile_scope PROFILE_CONCAT(profile_scope_, __LINE__){&PROFILE_CONCAT(profile_zone_, __LINE__)}
+
+// drop-in replacements for ZoneScoped, ZoneScopedN and FrameMark that feed both tracy and the built-in profiler
+#define PROFILE_ZONE ZoneScoped; PROFILE_ZONE_IMPL(__func__)
+#define PROFILE_ZONE_N(name) ZoneScopedN(name); PROFILE_ZONE_IMPL(name)
+#define PROFILE_FRAME FrameMark; ::penumbra::profile_frame_mark()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <penumbra/allocator.hpp>
 #include <penumbra/array_proxy.hpp>
 #include <penumbra/math/matrix.hpp>
 #include <penumbra/math/vector.hpp>
@@ -84,6 +85,10 @@ void renderer_next_frame();
 void renderer_process_frame(double dt);
 u32 renderer_gfx_frame_index();
 
+// cpu scratch for the current frame, it stays valid until this frame slot's gpu work has finished
+arena_t& renderer_frame_arena();
+std::pmr::memory_resource* renderer_frame_resource();
+
 uvec2 renderer_get_render_resolution();
 void renderer_update_render_resolution(uvec2 res);
 void renderer_set_output_rendertarget(GPUTexture rt);
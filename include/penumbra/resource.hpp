@@ -1,5 +1,6 @@
 #pragma once
 
+#include <penumbra/array_proxy.hpp>
 #include <penumbra/resource/rid.hpp>
 #include <penumbra/resource/anim.hpp>
 #include <penumbra/resource/geometry.hpp>
@@ -29,6 +30,7 @@ ResourceID resource_manager_load_geometry(const vfs_path& path);
 ResourceID resource_manager_load_texture(const vfs_path& path);
 ResourceID resource_manager_load_animation(const vfs_path& path);
 ResourceID resource_manager_load_skeleton(const vfs_path& path);
+void resource_manager_load_batch(resource_type type, array_proxy<vfs_path> paths);
 
 geometry_resource& resource_manager_get_geometry(ResourceID rid);
 texture_resource& resource_manager_get_texture(ResourceID rid);
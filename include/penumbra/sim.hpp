@@ -0,0 +1,61 @@
+#pragma once
+
+#include <penumbra/math/transform.hpp>
+#include <penumbra/types.hpp>
+
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace penumbra
+{
+
+// one transform written by a simulation tick, id is whatever the writer uses to find the owner again
+struct sim_transform
+{
+	u64 id;
+	Transform transform;
+};
+
+// the two newest ticks as seen by the render thread, alpha is how far the present has moved from prev towards curr
+struct sim_interp_state
+{
+	std::span<const sim_transform> prev;
+	std::span<const sim_transform> curr;
+	float alpha{1.0f};
+	u64 tick{0};
+};
+
+using sim_tick_fn = std::function<void(double)>;
+
+// runs tick rate times per second on a dedicated thread until sim_shutdown, rate must not be 0
+void sim_init(u32 rate, sim_tick_fn tick);
+void sim_shutdown();
+// takes effect from the next tick
+void sim_set_rate(u32 rate);
+
+// sim thread only, the tick writes its transforms sorted by id into the returned buffer and publishes it as the newest snapshot
+std::vector<sim_transform>& sim_snapshot_begin();
+void sim_snapshot_publish();
+
+// render thread only, the spans stay valid until the next call
+sim_interp_state sim_snapshot_acquire();
+
+// calls fn(id, transform) for every transform of the newest tick, blended with the previous tick where that has one too
+template <typename F>
+void sim_interpolate(const sim_interp_state& state, F&& fn)
+{
+	size_t j = 0;
+	for(const sim_transform& cur : state.curr)
+	{
+		while(j < state.prev.size() && state.prev[j].id < cur.id)
+			j++;
+
+		if(j < state.prev.size() && state.prev[j].id == cur.id)
+			fn(cur.id, Transform::interpolate(state.prev[j].transform, cur.transform, state.alpha));
+		else
+			fn(cur.id, cur.transform);
+	}
+}
+
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace penumbra
+{
+
+// values are packed in a dense array so iterating only touches live entries, ids find their dense index
+// through a paged sparse array, erase moves the last value into the hole so the order is not stable
+template <typename T, std::unsigned_integral ID = u32>
+class sparse_set
+{
+public:
+	static constexpr u32 page_size = 4096u;
+
+	using value_type = T;
+	using iterator = typename std::vector<T>::iterator;
+	using const_iterator = typename std::vector<T>::const_iterator;
+
+	iterator begin()
+	{
+		return values.begin();
+	}
+
+	iterator end()
+	{
+		return values.end();
+	}
+
+	const_iterator begin() const
+	{
+		return values.begin();
+	}
+
+	const_iterator end() const
+	{
+		return values.end();
+	}
+
+	size_t size() const
+	{
+		return values.size();
+	}
+
+	bool empty() const
+	{
+		return values.empty();
+	}
+
+	// the id of each value, in the same order as iteration
+	std::span<const ID> ids() const
+	{
+		return dense;
+	}
+
+	void reserve(size_t count)
+	{
+		values.reserve(count);
+		dense.reserve(count);
+	}
+
+	bool contains(ID id) const
+	{
+		return index_of(id) != invalid;
+	}
+
+	T* find(ID id)
+	{
+		const u32 index = index_of(id);
+		return index == invalid ? nullptr : &values[index];
+	}
+
+	const T* find(ID id) const
+	{
+		const u32 index = index_of(id);
+		return index == invalid ? nullptr : &values[index];
+	}
+
+	T& operator[](ID id)
+	{
+		assert(contains(id));
+		return values[index_of(id)];
+	}
+
+	const T& operator[](ID id) const
+	{
+		assert(contains(id));
+		return values[index_of(id)];
+	}
+
+	// replaces the value if the id is already present
+	template <typename... Args>
+	T& emplace(ID id, Args&&... args)
+	{
+		u32& index = sparse_slot(id);
+		if(index != invalid)
+		{
+			values[index] = T{std::forward<Args>(args)...};
+			return values[index];
+		}
+
+		index = static_cast<u32>(values.size());
+		dense.push_back(id);
+		return values.emplace_back(std::forward<Args>(args)...);
+	}
+
+	bool erase(ID id)
+	{
+		const u32 index = index_of(id);
+		if(index == invalid)
+			return false;
+
+		const u32 last = static_cast<u32>(values.size() - 1u);
+		if(index != last)
+		{
+			values[index] = std::move(values[last]);
+			dense[index] = dense[last];
+			sparse_slot(dense[index]) = index;
+		}
+
+		values.pop_back();
+		dense.pop_back();
+		sparse_slot(id) = invalid;
+		return true;
+	}
+
+	// keeps the pages so the same ids can be inserted again without allocating
+	void clear()
+	{
+		for(ID id : dense)
+			sparse_slot(id) = invalid;
+
+		values.clear();
+		dense.clear();
+	}
+
+private:
+	static constexpr u32 invalid = ~0u;
+
+	u32 index_of(ID id) const
+	{
+		const size_t page = id / page_size;
+		if(page >= pages.size() || !pages[page])
+			return invalid;
+
+		return pages[page][id % page_size];
+	}
+
+	u32& sparse_slot(ID id)
+	{
+		const size_t page = id / page_size;
+		if(page >= pages.size())
+			pages.resize(page + 1u);
+
+		if(!pages[page])
+		{
+			pages[page] = std::make_unique_for_overwrite<u32[]>(page_size);
+			std::fill_n(pages[page].get(), page_size, invalid);
+		}
+
+		return pages[page][id % page_size];
+	}
+
+	std::vector<T> values;
+	std::vector<ID> dense;
+	std::vector<std::unique_ptr<u32[]>> pages;
+};
+
+}
@@ -24,7 +24,8 @@ void imgui_add_hook(std::function<void()>&& hook);
 namespace ui
 {
 
-void draw_device_overlay(uvec2 root = {0u, 0u});
+// show_memory adds the per tag and per gpu heap usage below the frame rate
+void draw_device_overlay(uvec2 root = {0u, 0u}, bool show_memory = false);
 
 }
 
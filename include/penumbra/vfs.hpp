@@ -1,14 +1,18 @@
 #pragma once
 
+#include <penumbra/array_proxy.hpp>
 #include <penumbra/types.hpp>
 #include <expected>
 #include <filesystem>
+#include <span>
 
 namespace penumbra
 {
 
 void vfs_init();
 void vfs_shutdown();
+// releases mappings whose grace period ran out, call once per frame
+void vfs_tick();
 
 using vfs_path = std::filesystem::path;
 using vfs_fd = s32;
@@ -19,10 +23,100 @@ enum vfs_access_t
 	VFS_ACCESS_RW	= 0x2,
 };
 
-vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode);
+// access pattern hints, applied to the mapping and the page cache
+// populate prefaults the whole file when it is first mapped
+enum vfs_access_hint_t
+{
+	VFS_HINT_NONE		= 0x0,
+	VFS_HINT_SEQUENTIAL	= 0x1,
+	VFS_HINT_RANDOM		= 0x2,
+	VFS_HINT_WILLNEED	= 0x4,
+	VFS_HINT_POPULATE	= 0x8,
+};
+
+// read only opens of the same file share one refcounted mapping, which outlives the last close by a short grace period
+vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode, u32 hints = VFS_HINT_NONE);
 void vfs_close(vfs_fd fd);
 
+// compressed pack entries are decoded on the first vfs_map, which returns null if decoding fails
 const u8* vfs_map(vfs_fd fd);
 u8* vfs_map_rw(vfs_fd fd);
+size_t vfs_size(vfs_fd fd);
+
+// copies a byte range of the file into dst, compressed pack entries are decoded in parallel without an intermediate copy
+bool vfs_read(vfs_fd fd, u8* dst, size_t offset, size_t size);
+
+enum vfs_mount_priority : s32
+{
+	VFS_MOUNT_PRIORITY_BASE		= 0,
+	VFS_MOUNT_PRIORITY_PACK		= 100,
+	VFS_MOUNT_PRIORITY_OVERLAY	= 200,
+};
+
+// writes over packed files land in this directory under the highest priority mounted directory, mounted above every pack
+constexpr const char* VFS_WRITE_OVERLAY = "overlay";
+
+// mounts a directory or a pack file, relative paths resolve against the highest priority mount that has them
+// resolutions are cached by path hash until the mount table changes or vfs_flush_path_cache is called
+bool vfs_mount(const vfs_path& p, s32 priority);
+void vfs_unmount(const vfs_path& p);
+void vfs_flush_path_cache();
+
+// streaming writer, data goes through large aligned buffers into a temporary file next to the target
+// vfs_commit flushes it to disk and atomically renames it over the target, vfs_discard drops it
+// relative paths are created in the highest priority mounted directory, or in the write overlay if a pack above it has the path
+using vfs_wfd = s32;
+
+enum vfs_create_flags_t
+{
+	VFS_CREATE_DEFAULT	= 0x0,
+	VFS_CREATE_DIRECT	= 0x1,
+};
+
+vfs_wfd vfs_create(const vfs_path& p, u64 size_hint = 0, u32 flags = VFS_CREATE_DEFAULT);
+bool vfs_write(vfs_wfd fd, const void* data, size_t size);
+bool vfs_commit(vfs_wfd fd);
+void vfs_discard(vfs_wfd fd);
+
+// access tracing, records opens and async reads in order until vfs_trace_end writes them to a manifest
+// vfs_readahead_start replays a manifest on a background thread so the page cache is warm before the files are opened
+void vfs_trace_begin();
+bool vfs_trace_end(const vfs_path& manifest);
+void vfs_readahead_start(const vfs_path& manifest);
+
+// asynchronous reads, serviced by io_uring where available and a worker pool otherwise
+// if dst is null the buffer is allocated by the vfs and must be released with vfs_read_free
+// size 0 reads from offset to the end of the file, a read that ends before its size completes with an error
+struct vfs_read_request
+{
+	vfs_path path;
+	u8* dst{nullptr};
+	size_t offset{0};
+	size_t size{0};
+	u64 user_data{0};
+};
+
+struct vfs_read_completion
+{
+	u64 user_data;
+	u8* data;
+	size_t size;
+	s32 result;
+};
+
+// a read completes on the queue it was submitted to, submitters that wait for their own reads
+// create a private queue so they never drain completions that belong to someone else
+using vfs_read_queue = u32;
+constexpr vfs_read_queue VFS_READ_QUEUE_SHARED = 0u;
+
+vfs_read_queue vfs_read_queue_create();
+// waits for the reads still in flight on the queue, uncollected completions are dropped
+void vfs_read_queue_destroy(vfs_read_queue queue);
+
+size_t vfs_read_submit(array_proxy<vfs_read_request> requests, vfs_read_queue queue = VFS_READ_QUEUE_SHARED);
+size_t vfs_read_poll(std::span<vfs_read_completion> completions, vfs_read_queue queue = VFS_READ_QUEUE_SHARED);
+size_t vfs_read_wait(std::span<vfs_read_completion> completions, size_t min_count = 1, vfs_read_queue queue = VFS_READ_QUEUE_SHARED);
+size_t vfs_read_pending(vfs_read_queue queue = VFS_READ_QUEUE_SHARED);
+void vfs_read_free(u8* data);
 
 }
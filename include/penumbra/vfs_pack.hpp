@@ -0,0 +1,56 @@
+#pragma once
+
+#include <penumbra/hash.hpp>
+#include <penumbra/types.hpp>
+#include <string_view>
+
+namespace penumbra
+{
+
+// single file archive, entry data is stored first and the table of contents last
+// the toc is sorted by path hash so lookups are a binary search over the mapped file
+// compressed entries start with num_blocks + 1 offsets relative to the entry followed by the lz blocks,
+// a block whose stored size equals its raw size is stored uncompressed
+struct PackFileFormat
+{
+	constexpr static u32 fmt_magic = 0x4b43504c;
+	constexpr static u32 fmt_major = 2u;
+	constexpr static u32 fmt_minor = 0u;
+
+	constexpr static u64 entry_alignment = 64ull;
+	constexpr static u64 block_size = 256ull * 1024ull;
+
+	constexpr static u32 entry_compressed = 0x1u;
+
+	struct Header
+	{
+		u32 magic{fmt_magic};
+		u32 vmajor{fmt_major};
+		u32 vminor{fmt_minor};
+		u32 num_entries;
+		u64 toc_offset;
+	};
+
+	struct Entry
+	{
+		u64 path_hash;
+		u64 offset;
+		u64 size;
+		u64 stored_size;
+		u32 flags;
+		u32 num_blocks;
+	};
+
+	constexpr static u32 block_count(u64 size)
+	{
+		return static_cast<u32>((size + block_size - 1) / block_size);
+	}
+
+	// entries are keyed by their path relative to the pack root, '/' separated
+	constexpr static u64 hash_path(std::string_view path)
+	{
+		return fnv::hash64(path);
+	}
+};
+
+}
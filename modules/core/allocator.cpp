@@ -0,0 +1,435 @@
+#include <penumbra/allocator.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/panic.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <new>
+#include <string>
+
+#if defined __SANITIZE_ADDRESS__
+#define PENUMBRA_ASAN 1
+#elif defined __has_feature
+#if __has_feature(address_sanitizer)
+#define PENUMBRA_ASAN 1
+#endif
+#endif
+
+#if defined PENUMBRA_ASAN
+#include <sanitizer/asan_interface.h>
+#endif
+
+namespace penumbra
+{
+
+constexpr size_t ARENA_ALIGNMENT = 64ull;
+constexpr size_t POOL_ALIGNMENT = alignof(std::max_align_t);
+
+// debug builds fill fresh memory with 0xcd and released memory with 0xdd so stale reads stand out
+constexpr u8 POISON_FRESH = 0xcd;
+constexpr u8 POISON_FREED = 0xdd;
+
+struct overflow_block
+{
+	overflow_block* next;
+};
+
+struct pool_chunk
+{
+	pool_chunk* next;
+};
+
+// counters of different tags are touched by different threads, keep them on separate lines
+struct alignas(64) memory_tag_counters
+{
+	std::atomic<u64> current{0};
+	std::atomic<u64> peak{0};
+	std::atomic<u64> budget{0};
+	std::atomic<u64> allocations{0};
+	std::atomic<u64> frees{0};
+	std::atomic<u64> allocated_bytes{0};
+	std::atomic<bool> over_budget{false};
+};
+
+static memory_tag_counters tag_counters[MEMORY_TAG_COUNT];
+
+static std::mutex registry_lock;
+static arena_t* arena_list = nullptr;
+static pool_t* pool_list = nullptr;
+
+static void memory_poison(void* ptr, size_t size)
+{
+	#if !defined NDEBUG
+	std::memset(ptr, POISON_FREED, size);
+	#endif
+
+	#if defined PENUMBRA_ASAN
+	ASAN_POISON_MEMORY_REGION(ptr, size);
+	#endif
+}
+
+static void memory_unpoison(void* ptr, size_t size)
+{
+	#if defined PENUMBRA_ASAN
+	ASAN_UNPOISON_MEMORY_REGION(ptr, size);
+	#endif
+
+	#if !defined NDEBUG
+	std::memset(ptr, POISON_FRESH, size);
+	#endif
+}
+
+void memory_track_alloc(memory_tag tag, size_t size)
+{
+	memory_tag_counters& c = tag_counters[tag];
+	const u64 current = c.current.fetch_add(size, std::memory_order_relaxed) + size;
+	c.allocations.fetch_add(1u, std::memory_order_relaxed);
+	c.allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	u64 peak = c.peak.load(std::memory_order_relaxed);
+	while(current > peak && !c.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+
+	const u64 budget = c.budget.load(std::memory_order_relaxed);
+	if(budget && current > budget && !c.over_budget.exchange(true, std::memory_order_relaxed))
+		log::warn("memory: {} over budget, {} / {} KB", memory_tag_names[tag], current / 1024, budget / 1024);
+}
+
+void memory_track_free(memory_tag tag, size_t size)
+{
+	memory_tag_counters& c = tag_counters[tag];
+	const u64 current = c.current.fetch_sub(size, std::memory_order_relaxed) - size;
+	c.frees.fetch_add(1u, std::memory_order_relaxed);
+
+	if(c.over_budget.load(std::memory_order_relaxed) && current <= c.budget.load(std::memory_order_relaxed))
+		c.over_budget.store(false, std::memory_order_relaxed);
+}
+
+memory_stats_t memory_get_stats(memory_tag tag)
+{
+	const memory_tag_counters& c = tag_counters[tag];
+	return memory_stats_t
+	{
+		.current = c.current.load(std::memory_order_relaxed),
+		.peak = c.peak.load(std::memory_order_relaxed),
+		.budget = c.budget.load(std::memory_order_relaxed),
+		.allocations = c.allocations.load(std::memory_order_relaxed),
+		.frees = c.frees.load(std::memory_order_relaxed),
+		.allocated_bytes = c.allocated_bytes.load(std::memory_order_relaxed)
+	};
+}
+
+void memory_set_budget(memory_tag tag, size_t bytes)
+{
+	tag_counters[tag].budget.store(bytes, std::memory_order_relaxed);
+	tag_counters[tag].over_budget.store(false, std::memory_order_relaxed);
+}
+
+template <typename T>
+static void registry_link(T*& list, T* elem)
+{
+	std::scoped_lock<std::mutex> lock{registry_lock};
+	elem->next = list;
+	list = elem;
+}
+
+template <typename T>
+static void registry_unlink(T*& list, T* elem)
+{
+	std::scoped_lock<std::mutex> lock{registry_lock};
+	for(T** cur = &list; *cur; cur = &(*cur)->next)
+	{
+		if(*cur == elem)
+		{
+			*cur = elem->next;
+			break;
+		}
+	}
+}
+
+void arena_create(arena_t& arena, size_t capacity, const char* name, memory_tag tag)
+{
+	arena = {};
+	arena.name = name;
+	arena.tag = tag;
+	arena.capacity = (capacity + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+	arena.base = reinterpret_cast<u8*>(::operator new(arena.capacity, std::align_val_t{ARENA_ALIGNMENT}));
+	memory_track_alloc(tag, arena.capacity);
+
+	#if defined PENUMBRA_ASAN
+	ASAN_POISON_MEMORY_REGION(arena.base, arena.capacity);
+	#endif
+
+	registry_link(arena_list, &arena);
+}
+
+static void arena_release_overflow(arena_t& arena)
+{
+	if(arena.overflow_size)
+		memory_track_free(arena.tag, arena.overflow_size);
+
+	while(arena.overflow)
+	{
+		overflow_block* next = arena.overflow->next;
+		::operator delete(arena.overflow);
+		arena.overflow = next;
+	}
+
+	arena.overflow_size = 0;
+}
+
+void arena_destroy(arena_t& arena)
+{
+	registry_unlink(arena_list, &arena);
+	arena_release_overflow(arena);
+
+	#if defined PENUMBRA_ASAN
+	ASAN_UNPOISON_MEMORY_REGION(arena.base, arena.capacity);
+	#endif
+
+	::operator delete(arena.base, std::align_val_t{ARENA_ALIGNMENT});
+	memory_track_free(arena.tag, arena.capacity);
+	arena.base = nullptr;
+	arena.capacity = 0;
+	arena.offset = 0;
+}
+
+static void* arena_alloc_overflow(arena_t& arena, size_t size, size_t alignment)
+{
+	if(!arena.overflow_reported)
+	{
+		log::warn("arena {}: capacity of {} KB exceeded, falling back to the heap until the next reset", arena.name, arena.capacity / 1024);
+		arena.overflow_reported = true;
+	}
+
+	const size_t header = (sizeof(overflow_block) + alignment - 1) & ~(alignment - 1);
+	auto* block = reinterpret_cast<overflow_block*>(::operator new(header + size + alignment));
+	block->next = arena.overflow;
+	arena.overflow = block;
+	arena.overflow_size += size;
+	memory_track_alloc(arena.tag, size);
+
+	const auto addr = reinterpret_cast<uintptr_t>(block) + header;
+	return reinterpret_cast<void*>((addr + alignment - 1) & ~(uintptr_t{alignment} - 1));
+}
+
+void* arena_alloc(arena_t& arena, size_t size, size_t alignment)
+{
+	const uintptr_t base = reinterpret_cast<uintptr_t>(arena.base);
+	const uintptr_t aligned = (base + arena.offset + alignment - 1) & ~(uintptr_t{alignment} - 1);
+	const size_t end = static_cast<size_t>(aligned - base) + size;
+
+	void* ptr = nullptr;
+	if(end <= arena.capacity)
+	{
+		ptr = reinterpret_cast<void*>(aligned);
+		arena.offset = end;
+		memory_unpoison(ptr, size);
+	}
+	else
+	{
+		ptr = arena_alloc_overflow(arena, size, alignment);
+	}
+
+	arena.high_water = std::max(arena.high_water, arena.offset + arena.overflow_size);
+	return ptr;
+}
+
+void arena_reset(arena_t& arena)
+{
+	memory_poison(arena.base, arena.offset);
+	arena.offset = 0;
+	arena.resets++;
+
+	arena_release_overflow(arena);
+}
+
+arena_marker arena_mark(const arena_t& arena)
+{
+	return arena.offset;
+}
+
+void arena_rewind(arena_t& arena, arena_marker marker)
+{
+	if(marker > arena.offset)
+		return;
+
+	memory_poison(arena.base + marker, arena.offset - marker);
+	arena.offset = marker;
+}
+
+void frame_arena_create(frame_arena_t& frame, u32 num_slots, size_t capacity, const char* name, memory_tag tag)
+{
+	if(!num_slots || num_slots > FRAME_ARENA_MAX_SLOTS)
+		panic("frame_arena_create: invalid slot count");
+
+	frame.num_slots = num_slots;
+	frame.current = 0;
+	for(u32 i = 0; i < num_slots; i++)
+		arena_create(frame.slots[i], capacity, name, tag);
+}
+
+void frame_arena_destroy(frame_arena_t& frame)
+{
+	for(u32 i = 0; i < frame.num_slots; i++)
+		arena_destroy(frame.slots[i]);
+
+	frame.num_slots = 0;
+}
+
+void frame_arena_next(frame_arena_t& frame)
+{
+	frame.current = (frame.current + 1) % frame.num_slots;
+	arena_reset(frame.slots[frame.current]);
+}
+
+arena_t& frame_arena_current(frame_arena_t& frame)
+{
+	return frame.slots[frame.current];
+}
+
+void pool_create(pool_t& pool, size_t block_size, size_t blocks_per_chunk, const char* name, memory_tag tag)
+{
+	pool = {};
+	pool.name = name;
+	pool.tag = tag;
+	pool.block_size = (std::max(block_size, sizeof(void*)) + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1);
+	pool.blocks_per_chunk = std::max(blocks_per_chunk, size_t{1});
+
+	registry_link(pool_list, &pool);
+}
+
+void pool_destroy(pool_t& pool)
+{
+	registry_unlink(pool_list, &pool);
+
+	if(pool.live)
+		log::warn("pool {}: destroyed with {} blocks still allocated", pool.name, pool.live);
+
+	while(pool.chunks)
+	{
+		pool_chunk* next = pool.chunks->next;
+
+		#if defined PENUMBRA_ASAN
+		ASAN_UNPOISON_MEMORY_REGION(pool.chunks, POOL_ALIGNMENT + pool.block_size * pool.blocks_per_chunk);
+		#endif
+
+		::operator delete(pool.chunks, std::align_val_t{POOL_ALIGNMENT});
+		memory_track_free(pool.tag, POOL_ALIGNMENT + pool.block_size * pool.blocks_per_chunk);
+		pool.chunks = next;
+	}
+
+	pool.free_list = nullptr;
+	pool.capacity = 0;
+}
+
+// the first pointer of a free block links to the next one, everything past it stays poisoned
+static void pool_push_free(pool_t& pool, void* block)
+{
+	memory_poison(block, pool.block_size);
+
+	#if defined PENUMBRA_ASAN
+	ASAN_UNPOISON_MEMORY_REGION(block, sizeof(void*));
+	#endif
+
+	*reinterpret_cast<void**>(block) = pool.free_list;
+	pool.free_list = block;
+}
+
+static void pool_grow(pool_t& pool)
+{
+	const size_t chunk_size = POOL_ALIGNMENT + pool.block_size * pool.blocks_per_chunk;
+	auto* chunk = reinterpret_cast<pool_chunk*>(::operator new(chunk_size, std::align_val_t{POOL_ALIGNMENT}));
+	memory_track_alloc(pool.tag, chunk_size);
+	chunk->next = pool.chunks;
+	pool.chunks = chunk;
+
+	u8* blocks = reinterpret_cast<u8*>(chunk) + POOL_ALIGNMENT;
+	for(size_t i = pool.blocks_per_chunk; i > 0; i--)
+		pool_push_free(pool, blocks + (i - 1) * pool.block_size);
+
+	pool.capacity += pool.blocks_per_chunk;
+}
+
+void* pool_alloc(pool_t& pool)
+{
+	if(!pool.free_list)
+		pool_grow(pool);
+
+	void* block = pool.free_list;
+	pool.free_list = *reinterpret_cast<void**>(block);
+	memory_unpoison(block, pool.block_size);
+
+	pool.live++;
+	pool.high_water = std::max(pool.high_water, pool.live);
+	return block;
+}
+
+void pool_free(pool_t& pool, void* ptr)
+{
+	if(!ptr)
+		return;
+
+	pool_push_free(pool, ptr);
+	pool.live--;
+}
+
+void allocator_dump_stats()
+{
+	for(u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+	{
+		const memory_stats_t stats = memory_get_stats(static_cast<memory_tag>(tag));
+		PENUMBRA_LOG_INFO("memory {}: {} KB, peak {} KB, {} allocations, {} frees, {} KB allocated in total{}",
+			memory_tag_names[tag], stats.current / 1024, stats.peak / 1024, stats.allocations, stats.frees, stats.allocated_bytes / 1024,
+			stats.budget ? std::format(", budget {} KB", stats.budget / 1024) : std::string{});
+	}
+
+	std::scoped_lock<std::mutex> lock{registry_lock};
+
+	for(const arena_t* arena = arena_list; arena; arena = arena->next)
+	{
+		PENUMBRA_LOG_INFO("arena {}: {} / {} KB used, high water {} KB, {} resets{}",
+			arena->name, arena->offset / 1024, arena->capacity / 1024, arena->high_water / 1024, arena->resets,
+			arena->overflow_reported ? ", overflowed" : "");
+	}
+
+	for(const pool_t* pool = pool_list; pool; pool = pool->next)
+	{
+		PENUMBRA_LOG_INFO("pool {}: {} / {} blocks of {} bytes live, high water {}",
+			pool->name, pool->live, pool->capacity, pool->block_size, pool->high_water);
+	}
+}
+
+void* arena_resource::do_allocate(size_t bytes, size_t alignment)
+{
+	return arena_alloc(*arena, bytes, alignment);
+}
+
+void* frame_arena_resource::do_allocate(size_t bytes, size_t alignment)
+{
+	return arena_alloc(frame_arena_current(*frame), bytes, alignment);
+}
+
+void* pool_resource::do_allocate(size_t bytes, size_t alignment)
+{
+	if(bytes > pool->block_size || alignment > POOL_ALIGNMENT)
+		return upstream->allocate(bytes, alignment);
+
+	return pool_alloc(*pool);
+}
+
+void pool_resource::do_deallocate(void* ptr, size_t bytes, size_t alignment)
+{
+	if(bytes > pool->block_size || alignment > POOL_ALIGNMENT)
+	{
+		upstream->deallocate(ptr, bytes, alignment);
+		return;
+	}
+
+	pool_free(*pool, ptr);
+}
+
+}
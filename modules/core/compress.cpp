@@ -0,0 +1,243 @@
+#include <penumbra/compress.hpp>
+#include <penumbra/types.hpp>
+
+#include <array>
+#include <cstring>
+
+namespace penumbra
+{
+
+constexpr size_t LZ_MIN_MATCH = 4;
+constexpr size_t LZ_LAST_LITERALS = 5;
+constexpr size_t LZ_MATCH_FIND_LIMIT = 12;
+constexpr size_t LZ_MAX_OFFSET = 65535;
+constexpr u32 LZ_HASH_BITS = 14;
+constexpr size_t LZ_MAX_INPUT = 0x7E000000;
+
+static u32 read32(const u8* p)
+{
+	u32 v;
+	std::memcpy(&v, p, sizeof(u32));
+	return v;
+}
+
+static u32 lz_hash(u32 v)
+{
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static u8* write_length(u8* op, const u8* oend, size_t len)
+{
+	for(; len >= 255; len -= 255)
+	{
+		if(op >= oend)
+			return nullptr;
+
+		*op++ = 255;
+	}
+
+	if(op >= oend)
+		return nullptr;
+
+	*op++ = static_cast<u8>(len);
+	return op;
+}
+
+static u8* write_sequence(u8* op, const u8* oend, const u8* literals, size_t literal_len, size_t offset, size_t match_len)
+{
+	if(op >= oend)
+		return nullptr;
+
+	u8* token = op++;
+	*token = 0;
+
+	if(literal_len >= 15)
+	{
+		*token = 15 << 4;
+		if(!(op = write_length(op, oend, literal_len - 15)))
+			return nullptr;
+	}
+	else
+	{
+		*token = static_cast<u8>(literal_len << 4);
+	}
+
+	if(literal_len > static_cast<size_t>(oend - op))
+		return nullptr;
+
+	if(literal_len)
+		std::memcpy(op, literals, literal_len);
+	op += literal_len;
+
+	// the last sequence has literals only
+	if(!offset)
+		return op;
+
+	if(oend - op < 2)
+		return nullptr;
+
+	*op++ = static_cast<u8>(offset & 0xFF);
+	*op++ = static_cast<u8>(offset >> 8);
+
+	match_len -= LZ_MIN_MATCH;
+	if(match_len >= 15)
+	{
+		*token |= 15;
+		if(!(op = write_length(op, oend, match_len - 15)))
+			return nullptr;
+	}
+	else
+	{
+		*token |= static_cast<u8>(match_len);
+	}
+
+	return op;
+}
+
+size_t lz_compress_bound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+size_t lz_compress(const u8* src, size_t src_size, u8* dst, size_t dst_capacity)
+{
+	if(src_size > LZ_MAX_INPUT)
+		return 0;
+
+	const u8* ip = src;
+	const u8* anchor = src;
+	const u8* iend = src + src_size;
+
+	u8* op = dst;
+	const u8* oend = dst + dst_capacity;
+
+	if(src_size >= LZ_MATCH_FIND_LIMIT)
+	{
+		const u8* mflimit = iend - LZ_MATCH_FIND_LIMIT;
+		const u8* matchlimit = iend - LZ_LAST_LITERALS;
+
+		std::array<u32, 1u << LZ_HASH_BITS> table{};
+		ip++;
+
+		while(ip <= mflimit)
+		{
+			const u32 h = lz_hash(read32(ip));
+			const u8* ref = src + table[h];
+			table[h] = static_cast<u32>(ip - src);
+
+			if(ref >= ip || static_cast<size_t>(ip - ref) > LZ_MAX_OFFSET || read32(ref) != read32(ip))
+			{
+				ip++;
+				continue;
+			}
+
+			while(ip > anchor && ref > src && ip[-1] == ref[-1])
+			{
+				ip--;
+				ref--;
+			}
+
+			const u8* mp = ip + LZ_MIN_MATCH;
+			const u8* rp = ref + LZ_MIN_MATCH;
+			while(mp < matchlimit && *mp == *rp)
+			{
+				mp++;
+				rp++;
+			}
+
+			op = write_sequence(op, oend, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - ref), static_cast<size_t>(mp - ip));
+			if(!op)
+				return 0;
+
+			ip = mp;
+			anchor = ip;
+
+			if(ip <= mflimit)
+				table[lz_hash(read32(ip - 2))] = static_cast<u32>(ip - 2 - src);
+		}
+	}
+
+	op = write_sequence(op, oend, anchor, static_cast<size_t>(iend - anchor), 0, 0);
+	if(!op)
+		return 0;
+
+	return static_cast<size_t>(op - dst);
+}
+
+bool lz_decompress(const u8* src, size_t src_size, u8* dst, size_t dst_size)
+{
+	const u8* ip = src;
+	const u8* iend = src + src_size;
+
+	u8* op = dst;
+	u8* oend = dst + dst_size;
+
+	auto read_length = [&ip, iend](size_t& len) -> bool
+	{
+		u8 b;
+		do
+		{
+			if(ip >= iend)
+				return false;
+
+			b = *ip++;
+			len += b;
+		}
+		while(b == 255);
+
+		return true;
+	};
+
+	while(ip < iend)
+	{
+		const u8 token = *ip++;
+
+		size_t literal_len = token >> 4;
+		if(literal_len == 15 && !read_length(literal_len))
+			return false;
+
+		if(literal_len > static_cast<size_t>(iend - ip) || literal_len > static_cast<size_t>(oend - op))
+			return false;
+
+		if(literal_len)
+			std::memcpy(op, ip, literal_len);
+		op += literal_len;
+		ip += literal_len;
+
+		if(ip >= iend)
+			break;
+
+		if(iend - ip < 2)
+			return false;
+
+		const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+		ip += 2;
+
+		if(!offset || offset > static_cast<size_t>(op - dst))
+			return false;
+
+		size_t match_len = token & 15;
+		if(match_len == 15 && !read_length(match_len))
+			return false;
+
+		match_len += LZ_MIN_MATCH;
+		if(match_len > static_cast<size_t>(oend - op))
+			return false;
+
+		const u8* ref = op - offset;
+		if(offset >= match_len)
+		{
+			std::memcpy(op, ref, match_len);
+			op += match_len;
+		}
+		else
+		{
+			for(size_t i = 0; i < match_len; i++)
+				*op++ = ref[i];
+		}
+	}
+
+	return op == oend;
+}
+
+}
@@ -1,51 +1,164 @@
 #include <penumbra/cvar.hpp>
+#include <penumbra/hash.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/vfs.hpp>
 #include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace penumbra
 {
 
-static cvar_t* cvarlist = nullptr;
+constexpr u32 CVAR_TABLE_MIN_SIZE = 64u;
 
-void cvar_register(cvar_t* cvar)
+// open addressing with linear probing, names are unique by hash so a lookup never compares strings
+struct cvar_registry
 {
-	cvar->next = nullptr;
+	std::unique_ptr<cvar_t*[]> slots;
+	u32 capacity{0u};
+	u32 count{0u};
 
-	if(cvar_get(cvar->name))
-		return;
+	// values loaded before their cvar was registered
+	std::unordered_map<u32, std::string> unresolved;
+	std::unordered_map<u32, std::string> strings;
+	std::vector<cvar_t*> deferred;
+};
+
+static cvar_registry registry;
+
+static cvar_t** table_find(cvar_t** slots, u32 capacity, u32 hash)
+{
+	for(u32 i = hash & (capacity - 1u);; i = (i + 1u) & (capacity - 1u))
+	{
+		if(!slots[i] || slots[i]->hash == hash)
+			return &slots[i];
+	}
+}
 
-	if(!cvarlist || std::strcmp(cvar->name, cvarlist->name) < 0)
+static void table_grow()
+{
+	const u32 capacity = registry.capacity ? registry.capacity * 2u : CVAR_TABLE_MIN_SIZE;
+	auto slots = std::make_unique<cvar_t*[]>(capacity);
+
+	for(u32 i = 0; i < registry.capacity; i++)
 	{
-		cvar->next = cvarlist;
-		cvarlist = cvar;
+		if(registry.slots[i])
+			*table_find(slots.get(), capacity, registry.slots[i]->hash) = registry.slots[i];
 	}
+
+	registry.slots = std::move(slots);
+	registry.capacity = capacity;
+}
+
+static void queue_callback(cvar_t* cvar)
+{
+	if(!cvar->callback || cvar->queued)
+		return;
+
+	cvar->queued = true;
+	registry.deferred.push_back(cvar);
+}
+
+static void run_callback(cvar_t* cvar)
+{
+	if(!cvar->callback)
+		return;
+
+	if(cvar->flags & CVAR_FLAG_DEFERRED)
+		queue_callback(cvar);
 	else
+		cvar->callback(cvar);
+}
+
+static bool parse_value(cvar_t* cvar, std::string_view value)
+{
+	switch(cvar->type)
 	{
-		cvar_t* prev = cvarlist;
-		cvar_t* cur = cvarlist->next;
-		while(cur && (std::strcmp(cvar->name, cur->name) > 0))
-		{
-			prev = cur;
-			cur = cur->next;
-		}
+	case CVAR_TYPE_INT:
+	{
+		int v;
+		const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), v);
+		if(ec != std::errc{} || ptr != value.data() + value.size())
+			return false;
+
+		cvar->int_v = v;
+		return true;
+	}
+	case CVAR_TYPE_FLOAT:
+	{
+		float v;
+		const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), v);
+		if(ec != std::errc{} || ptr != value.data() + value.size())
+			return false;
+
+		cvar->float_v = v;
+		return true;
+	}
+	case CVAR_TYPE_STRING:
+	{
+		if(value.size() >= 2 && value.front() == '"' && value.back() == '"')
+			value = value.substr(1, value.size() - 2);
 
-		cvar->next = prev->next;
-		prev->next = cvar;
+		std::string& storage = registry.strings[cvar->hash];
+		storage = value;
+		cvar->string_v = storage.data();
+		return true;
 	}
+	}
+
+	return false;
 }
 
-cvar_t* cvar_get(const char* name)
+void cvar_register(cvar_t* cvar)
 {
-	cvar_t* cur = cvarlist;
-	while(cur)
+	cvar->hash = fnv::hash(std::string_view{cvar->name});
+	cvar->queued = false;
+
+	if((registry.count + 1u) * 4u > registry.capacity * 3u)
+		table_grow();
+
+	cvar_t** slot = table_find(registry.slots.get(), registry.capacity, cvar->hash);
+	if(*slot)
 	{
-		if(!std::strcmp(cur->name, name))
-			return cur;
+		if(std::strcmp((*slot)->name, cvar->name))
+			log::error("cvar: {} collides with {}, not registered", cvar->name, (*slot)->name);
 
-		cur = cur->next;
+		return;
 	}
 
-	return nullptr;
+	*slot = cvar;
+	registry.count++;
+
+	// whoever registers is still initializing, the callback waits for the next flush
+	if(auto it = registry.unresolved.find(cvar->hash); it != registry.unresolved.end())
+	{
+		if(parse_value(cvar, it->second))
+			queue_callback(cvar);
+		else
+			log::warn("cvar: invalid value \"{}\" for {}", it->second, cvar->name);
+
+		registry.unresolved.erase(it);
+	}
+}
+
+cvar_t* cvar_get(u32 hash)
+{
+	if(!registry.count)
+		return nullptr;
+
+	return *table_find(registry.slots.get(), registry.capacity, hash);
+}
+
+cvar_t* cvar_get(std::string_view name)
+{
+	return cvar_get(fnv::hash(name));
 }
 
 void cvar_set(cvar_t* cvar, u64 value)
@@ -64,8 +177,102 @@ void cvar_set(cvar_t* cvar, u64 value)
 		break;
 	}
 
-	if(cvar->callback)
+	run_callback(cvar);
+}
+
+bool cvar_set_string(cvar_t* cvar, std::string_view value)
+{
+	if(!parse_value(cvar, value))
+		return false;
+
+	run_callback(cvar);
+	return true;
+}
+
+static std::string_view trim(std::string_view str)
+{
+	const size_t start = str.find_first_not_of(" \t\r");
+	if(start == std::string_view::npos)
+		return {};
+
+	return str.substr(start, str.find_last_not_of(" \t\r") - start + 1);
+}
+
+bool cvar_load(const vfs_path& path)
+{
+	vfs_fd file = vfs_open(path, VFS_ACCESS_READ, VFS_HINT_SEQUENTIAL);
+	if(file < 0)
+		return false;
+
+	const u8* data = vfs_map(file);
+	if(!data)
+	{
+		vfs_close(file);
+		return false;
+	}
+
+	std::string_view text{reinterpret_cast<const char*>(data), vfs_size(file)};
+	std::vector<cvar_t*> changed;
+	u32 line_num = 0;
+
+	while(!text.empty())
+	{
+		const size_t eol = text.find('\n');
+		std::string_view line = text.substr(0, eol);
+		text = eol == std::string_view::npos ? std::string_view{} : text.substr(eol + 1);
+		line_num++;
+
+		if(const size_t comment = line.find("//"); comment != std::string_view::npos)
+			line = line.substr(0, comment);
+
+		line = trim(line);
+		if(line.empty())
+			continue;
+
+		const size_t split = line.find_first_of(" \t");
+		const std::string_view name = line.substr(0, split);
+		const std::string_view value = split == std::string_view::npos ? std::string_view{} : trim(line.substr(split));
+
+		cvar_t* cvar = cvar_get(name);
+		if(!cvar)
+		{
+			registry.unresolved[fnv::hash(name)] = value;
+			continue;
+		}
+
+		if(!parse_value(cvar, value))
+		{
+			log::warn("cvar: {}:{}: invalid value \"{}\" for {}", path.string(), line_num, value, cvar->name);
+			continue;
+		}
+
+		if(std::find(changed.begin(), changed.end(), cvar) == changed.end())
+			changed.push_back(cvar);
+	}
+
+	vfs_close(file);
+
+	for(cvar_t* cvar : changed)
+		run_callback(cvar);
+
+	PENUMBRA_LOG_INFO("cvar: loaded {} values from {}", changed.size(), path.string());
+	return true;
+}
+
+void cvar_flush()
+{
+	if(registry.deferred.empty())
+		return;
+
+	// callbacks may set other cvars, those land in a fresh list and wait for the next flush
+	std::vector<cvar_t*> deferred = std::move(registry.deferred);
+	registry.deferred.clear();
+
+	for(cvar_t* cvar : deferred)
+	{
+		cvar->queued = false;
 		cvar->callback(cvar);
+	}
 }
 
 }
@@ -0,0 +1,186 @@
+#include <penumbra/frame_pacer.hpp>
+#include <penumbra/profile.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <thread>
+
+#if defined __linux__
+#include <cerrno>
+#include <sys/prctl.h>
+#include <time.h>
+#endif
+
+#if defined __x86_64__ || defined _M_X64
+#include <immintrin.h>
+#endif
+
+namespace penumbra
+{
+
+constexpr u64 FRAME_PACER_MIN_SPIN_NS = 20'000ull;
+constexpr u64 FRAME_PACER_MAX_SPIN_NS = 2'000'000ull;
+// the window is recomputed this often from the recent wakeups
+constexpr u32 FRAME_PACER_UPDATE_INTERVAL = 16u;
+
+// steady_clock is CLOCK_MONOTONIC on linux, which is what the absolute sleeps are measured against
+static u64 now_ns()
+{
+	return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void sleep_until_ns(u64 target)
+{
+#if defined __linux__
+	const timespec ts
+	{
+		.tv_sec = static_cast<time_t>(target / 1'000'000'000ull),
+		.tv_nsec = static_cast<long>(target % 1'000'000'000ull)
+	};
+
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+		;
+#else
+	std::this_thread::sleep_until(std::chrono::steady_clock::time_point{std::chrono::nanoseconds{target}});
+#endif
+}
+
+static void cpu_relax()
+{
+#if defined __x86_64__ || defined _M_X64
+	_mm_pause();
+#endif
+}
+
+void frame_pacer_init(frame_pacer_t& pacer, u32 rate)
+{
+	pacer = frame_pacer_t{};
+
+	// initial guess until enough wakeups were measured
+	pacer.spin_window_ns = 500'000ull;
+
+#if defined __linux__
+	// the default 50us slack is added to every timed sleep of this thread and would have to be spun away
+	prctl(PR_SET_TIMERSLACK, 1ul);
+#endif
+
+	frame_pacer_set_rate(pacer, rate);
+}
+
+void frame_pacer_set_rate(frame_pacer_t& pacer, u32 rate)
+{
+	if(pacer.rate == rate && pacer.deadline_ns)
+		return;
+
+	pacer.rate = rate;
+	pacer.period_ns = rate ? 1'000'000'000ull / rate : 0ull;
+	pacer.deadline_ns = now_ns() + pacer.period_ns;
+}
+
+static void track_wakeup(frame_pacer_t& pacer, u64 late)
+{
+	pacer.wake_late_ns[pacer.wake_count % FRAME_PACER_WAKE_SAMPLES] = static_cast<u32>(std::min<u64>(late, FRAME_PACER_MAX_SPIN_NS));
+	pacer.wake_count++;
+
+	if(pacer.wake_count < FRAME_PACER_WAKE_SAMPLES || pacer.wake_count % FRAME_PACER_UPDATE_INTERVAL)
+		return;
+
+	// 95th percentile plus a quarter, a rare later wakeup costs one late frame instead of spinning on every frame
+	u32 samples[FRAME_PACER_WAKE_SAMPLES];
+	std::copy(std::begin(pacer.wake_late_ns), std::end(pacer.wake_late_ns), samples);
+	u32* percentile = samples + FRAME_PACER_WAKE_SAMPLES * 95u / 100u;
+	std::nth_element(samples, percentile, samples + FRAME_PACER_WAKE_SAMPLES);
+
+	pacer.spin_window_ns = std::clamp<u64>(*percentile + *percentile / 4u, FRAME_PACER_MIN_SPIN_NS, FRAME_PACER_MAX_SPIN_NS);
+}
+
+static void track_frame(frame_pacer_t& pacer, u64 now)
+{
+	if(pacer.last_frame_ns)
+	{
+		const u64 interval = now - pacer.last_frame_ns;
+
+		pacer.frames++;
+		const double delta = static_cast<double>(interval) - pacer.interval_mean_ns;
+		pacer.interval_mean_ns += delta / static_cast<double>(pacer.frames);
+		pacer.interval_m2 += delta * (static_cast<double>(interval) - pacer.interval_mean_ns);
+
+		pacer.interval_min_ns = pacer.frames == 1 ? interval : std::min(pacer.interval_min_ns, interval);
+		pacer.interval_max_ns = std::max(pacer.interval_max_ns, interval);
+	}
+
+	pacer.last_frame_ns = now;
+}
+
+void frame_pacer_wait(frame_pacer_t& pacer)
+{
+	PROFILE_ZONE;
+
+	u64 now = now_ns();
+	if(!pacer.period_ns)
+	{
+		track_frame(pacer, now);
+		return;
+	}
+
+	if(now >= pacer.deadline_ns)
+	{
+		pacer.missed++;
+		if(now - pacer.deadline_ns > pacer.period_ns)
+			pacer.deadline_ns = now;
+	}
+	else
+	{
+		if(pacer.deadline_ns - now > pacer.spin_window_ns)
+		{
+			const u64 wake_target = pacer.deadline_ns - pacer.spin_window_ns;
+			sleep_until_ns(wake_target);
+
+			now = now_ns();
+			track_wakeup(pacer, now > wake_target ? now - wake_target : 0ull);
+		}
+
+		const u64 spin_start = now;
+		while(now < pacer.deadline_ns)
+		{
+			cpu_relax();
+			now = now_ns();
+		}
+
+		pacer.spin_ns += now - spin_start;
+	}
+
+	track_frame(pacer, now);
+	pacer.deadline_ns += pacer.period_ns;
+}
+
+frame_pacer_stats frame_pacer_get_stats(const frame_pacer_t& pacer)
+{
+	frame_pacer_stats stats;
+	stats.frames = pacer.frames;
+	stats.missed = pacer.missed;
+	stats.mean_ms = pacer.interval_mean_ns / 1e6;
+	stats.stddev_ms = pacer.frames > 1 ? std::sqrt(pacer.interval_m2 / static_cast<double>(pacer.frames - 1)) / 1e6 : 0.0;
+	stats.min_ms = static_cast<double>(pacer.interval_min_ns) / 1e6;
+	stats.max_ms = static_cast<double>(pacer.interval_max_ns) / 1e6;
+	stats.spin_ms = static_cast<double>(pacer.spin_ns) / 1e6;
+	stats.spin_window_us = static_cast<double>(pacer.spin_window_ns) / 1e3;
+	return stats;
+}
+
+void frame_pacer_reset_stats(frame_pacer_t& pacer)
+{
+	pacer.frames = 0;
+	pacer.missed = 0;
+	pacer.interval_mean_ns = 0.0;
+	pacer.interval_m2 = 0.0;
+	pacer.interval_min_ns = 0;
+	pacer.interval_max_ns = 0;
+	pacer.spin_ns = 0;
+	pacer.last_frame_ns = 0;
+}
+
+}
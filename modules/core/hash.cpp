@@ -0,0 +1,186 @@
+#include <penumbra/hash.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/types.hpp>
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#if defined __x86_64__ || defined _M_X64
+#include <immintrin.h>
+#define PENUMBRA_HASH_SSE2
+#if defined __GNUC__
+#define PENUMBRA_HASH_AVX2
+#endif
+#endif
+
+namespace penumbra
+{
+
+namespace xxh3
+{
+
+using accumulate_fn = void (*)(u64* acc, const u8* p, const u8* secret, size_t stripes);
+using scramble_fn = void (*)(u64* acc, const u8* secret);
+
+static void accumulate_scalar(u64* acc, const u8* p, const u8* secret, size_t stripes)
+{
+	for(size_t s = 0; s < stripes; s++)
+		detail::accumulate_512(acc, p + s * stripe_len, secret + s * secret_consume_rate);
+}
+
+static void scramble_scalar(u64* acc, const u8* secret)
+{
+	detail::scramble(acc, secret);
+}
+
+#if defined PENUMBRA_HASH_SSE2
+static void accumulate_sse2(u64* acc, const u8* p, const u8* secret, size_t stripes)
+{
+	auto* xacc = reinterpret_cast<__m128i*>(acc);
+	for(size_t s = 0; s < stripes; s++)
+	{
+		const auto* data = reinterpret_cast<const __m128i*>(p + s * stripe_len);
+		const auto* key = reinterpret_cast<const __m128i*>(secret + s * secret_consume_rate);
+
+		for(size_t i = 0; i < 4; i++)
+		{
+			const __m128i value = _mm_loadu_si128(data + i);
+			const __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128(key + i));
+			const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+			const __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+			xacc[i] = _mm_add_epi64(product, _mm_add_epi64(xacc[i], swapped));
+		}
+	}
+}
+
+static void scramble_sse2(u64* acc, const u8* secret)
+{
+	auto* xacc = reinterpret_cast<__m128i*>(acc);
+	const auto* key = reinterpret_cast<const __m128i*>(secret);
+	const __m128i prime = _mm_set1_epi32(static_cast<int>(prime32_1));
+
+	for(size_t i = 0; i < 4; i++)
+	{
+		const __m128i shifted = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+		const __m128i keyed = _mm_xor_si128(shifted, _mm_loadu_si128(key + i));
+		const __m128i lo = _mm_mul_epu32(keyed, prime);
+		const __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		xacc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+	}
+}
+#endif
+
+#if defined PENUMBRA_HASH_AVX2
+__attribute__((target("avx2")))
+static void accumulate_avx2(u64* acc, const u8* p, const u8* secret, size_t stripes)
+{
+	auto* xacc = reinterpret_cast<__m256i*>(acc);
+	__m256i acc0 = _mm256_load_si256(xacc);
+	__m256i acc1 = _mm256_load_si256(xacc + 1);
+
+	for(size_t s = 0; s < stripes; s++)
+	{
+		const auto* data = reinterpret_cast<const __m256i*>(p + s * stripe_len);
+		const auto* key = reinterpret_cast<const __m256i*>(secret + s * secret_consume_rate);
+
+		const __m256i value0 = _mm256_loadu_si256(data);
+		const __m256i value1 = _mm256_loadu_si256(data + 1);
+		const __m256i keyed0 = _mm256_xor_si256(value0, _mm256_loadu_si256(key));
+		const __m256i keyed1 = _mm256_xor_si256(value1, _mm256_loadu_si256(key + 1));
+
+		acc0 = _mm256_add_epi64(acc0, _mm256_shuffle_epi32(value0, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc1 = _mm256_add_epi64(acc1, _mm256_shuffle_epi32(value1, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(keyed0, _mm256_shuffle_epi32(keyed0, _MM_SHUFFLE(0, 3, 0, 1))));
+		acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(keyed1, _mm256_shuffle_epi32(keyed1, _MM_SHUFFLE(0, 3, 0, 1))));
+	}
+
+	_mm256_store_si256(xacc, acc0);
+	_mm256_store_si256(xacc + 1, acc1);
+}
+
+__attribute__((target("avx2")))
+static void scramble_avx2(u64* acc, const u8* secret)
+{
+	auto* xacc = reinterpret_cast<__m256i*>(acc);
+	const auto* key = reinterpret_cast<const __m256i*>(secret);
+	const __m256i prime = _mm256_set1_epi32(static_cast<int>(prime32_1));
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		const __m256i shifted = _mm256_xor_si256(xacc[i], _mm256_srli_epi64(xacc[i], 47));
+		const __m256i keyed = _mm256_xor_si256(shifted, _mm256_loadu_si256(key + i));
+		const __m256i lo = _mm256_mul_epu32(keyed, prime);
+		const __m256i hi = _mm256_mul_epu32(_mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		xacc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+	}
+}
+#endif
+
+struct long_kernels
+{
+	accumulate_fn accumulate;
+	scramble_fn scramble;
+};
+
+static long_kernels select_kernels()
+{
+#if defined PENUMBRA_HASH_AVX2
+	if(__builtin_cpu_supports("avx2"))
+		return {accumulate_avx2, scramble_avx2};
+#endif
+#if defined PENUMBRA_HASH_SSE2
+	return {accumulate_sse2, scramble_sse2};
+#else
+	return {accumulate_scalar, scramble_scalar};
+#endif
+}
+
+static const long_kernels kernels = select_kernels();
+
+u64 hash_long(const u8* data, size_t size, const u8* secret)
+{
+	alignas(64) std::array<u64, 8> acc = detail::initial_acc;
+
+	constexpr size_t stripes_per_block = (secret_size - stripe_len) / secret_consume_rate;
+	constexpr size_t block_len = stripe_len * stripes_per_block;
+	const size_t blocks = (size - 1) / block_len;
+
+	for(size_t b = 0; b < blocks; b++)
+	{
+		kernels.accumulate(acc.data(), data + b * block_len, secret, stripes_per_block);
+		kernels.scramble(acc.data(), secret + secret_size - stripe_len);
+	}
+
+	const size_t stripes = ((size - 1) - block_len * blocks) / stripe_len;
+	kernels.accumulate(acc.data(), data + blocks * block_len, secret, stripes);
+	kernels.accumulate(acc.data(), data + size - stripe_len, secret + secret_size - stripe_len - 7, 1);
+
+	return detail::merge_accs(acc.data(), secret + 11, size * prime64_1);
+}
+
+}
+
+#ifndef NDEBUG
+struct hashed_string_registry
+{
+	std::mutex lock;
+	std::unordered_map<u64, std::string> strings;
+};
+
+std::string_view hashed_string::intern(u64 hash, std::string_view str)
+{
+	static hashed_string_registry registry;
+	std::scoped_lock<std::mutex> lock{registry.lock};
+
+	auto [it, inserted] = registry.strings.try_emplace(hash, str);
+	if(!inserted && it->second != str)
+		log::error("hashed_string: \"{}\" and \"{}\" share the hash {:#018x}", it->second, str, hash);
+
+	return it->second;
+}
+#endif
+
+}
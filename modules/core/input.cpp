@@ -1,5 +1,7 @@
 #include <penumbra/input.hpp>
 #include <penumbra/window.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/vfs.hpp>
 #include <penumbra/types.hpp>
 #include <penumbra/math/vector.hpp>
 
@@ -7,24 +9,113 @@
 #include <SDL3/SDL_events.h>
 #include <SDL3/SDL_keyboard.h>
 #include <SDL3/SDL_mouse.h>
+#include <SDL3/SDL_timer.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace penumbra
 {
 
+constexpr u32 INPUT_QUEUE_SIZE = 1024u;
+constexpr u32 INPUT_TEXT_SIZE = 32u;
+
+// fixed size so the queue and recordings can copy it as is, text input is stored inline
+struct input_queued_event
+{
+	u64 timestamp;
+	input_event_type type;
+
+	union
+	{
+		kbd_scancode scancode;
+		char text[INPUT_TEXT_SIZE];
+		u8 button;
+		vec2 wheel_delta;
+
+		struct
+		{
+			vec2 pos;
+			vec2 delta;
+		} mouse_motion;
+	};
+};
+
+static_assert(std::is_trivially_copyable_v<input_queued_event>);
+
+// one Frame per input_poll followed by the events it dispatched, frames run until the end of the file
+struct InputFileFormat
+{
+	constexpr static u32 fmt_magic = 0x504e494c;
+	constexpr static u32 fmt_major = 1u;
+	constexpr static u32 fmt_minor = 0u;
+
+	struct Header
+	{
+		u32 magic{fmt_magic};
+		u32 vmajor{fmt_major};
+		u32 vminor{fmt_minor};
+		u32 event_size{sizeof(input_queued_event)};
+	};
+
+	struct Frame
+	{
+		u64 delta_ns;
+		vec2 mouse_pos;
+		vec2 mouse_delta;
+		u32 num_events;
+		u32 pad;
+	};
+};
+
+// single producer, single consumer, the producer drops events instead of waiting when the consumer falls behind
+struct input_event_queue
+{
+	std::array<input_queued_event, INPUT_QUEUE_SIZE> events;
+
+	alignas(64) std::atomic<u32> head{0u};
+	alignas(64) std::atomic<u32> tail{0u};
+	std::atomic<u32> dropped{0u};
+};
+
 struct input_state_t
 {
-	SDL_Window* window;
+	std::atomic<SDL_Window*> window{nullptr};
 
 	vec2 mouse_pos{0.0f};
 	vec2 mouse_delta{0.0f};
-	const bool* key_states{nullptr};
+	std::bitset<SCANCODE_COUNT> keys;
 
 	std::vector<input_listener_t> listeners;
 
 	bool capture_mouse{false};
+
+	input_event_queue queue;
+	std::vector<input_queued_event> batch;
+
+	std::chrono::steady_clock::time_point last_poll;
+	u64 frame_delta_ns{0ull};
+	bool polled{false};
+
+	vfs_wfd record{-1};
+	std::string record_path;
+	u64 record_frames{0ull};
+
+	vfs_fd replay{-1};
+	const u8* replay_data{nullptr};
+	size_t replay_size{0};
+	size_t replay_offset{0};
+	u64 replay_frames{0ull};
+	std::chrono::steady_clock::time_point replay_start;
 };
 
 static input_state_t* input_state = nullptr;
@@ -32,21 +123,99 @@ static input_state_t* input_state = nullptr;
 void input_init()
 {
 	input_state = new input_state_t();
-	input_state->key_states = SDL_GetKeyboardState(nullptr);
+	input_state->batch.reserve(INPUT_QUEUE_SIZE);
 }
 
 void input_shutdown()
 {
 	assert(input_state);
 
+	input_replay_end();
+	input_record_end();
+
 	delete input_state;
 	input_state = nullptr;
 }
 
-void input_poll()
+static bool queue_push(input_event_queue& queue, const input_queued_event& event)
+{
+	const u32 head = queue.head.load(std::memory_order_relaxed);
+	if(head - queue.tail.load(std::memory_order_acquire) == INPUT_QUEUE_SIZE)
+	{
+		queue.dropped.fetch_add(1u, std::memory_order_relaxed);
+		return false;
+	}
+
+	queue.events[head & (INPUT_QUEUE_SIZE - 1u)] = event;
+	queue.head.store(head + 1u, std::memory_order_release);
+	return true;
+}
+
+static void queue_drain(input_event_queue& queue, std::vector<input_queued_event>& out)
+{
+	const u32 tail = queue.tail.load(std::memory_order_relaxed);
+	const u32 head = queue.head.load(std::memory_order_acquire);
+
+	for(u32 i = tail; i != head; i++)
+		out.push_back(queue.events[i & (INPUT_QUEUE_SIZE - 1u)]);
+
+	queue.tail.store(head, std::memory_order_release);
+}
+
+static void listener_dispatch(const input_event_t& event)
 {
 	assert(input_state);
+	for(auto& callback : input_state->listeners)
+		callback(event);
+}
+
+static void dispatch_queued(const input_queued_event& queued)
+{
+	input_event_t event{.type = queued.type, .timestamp = queued.timestamp};
 
+	switch(queued.type)
+	{
+	case INPUT_EVENT_KEY_DOWN:
+	case INPUT_EVENT_KEY_UP:
+		event.key.scancode = queued.scancode;
+		if(queued.scancode < SCANCODE_COUNT)
+			input_state->keys.set(queued.scancode, queued.type == INPUT_EVENT_KEY_DOWN);
+		break;
+	case INPUT_EVENT_TEXT_INPUT:
+		event.text.data = queued.text;
+		break;
+	case INPUT_EVENT_MOUSE_MOTION:
+		event.mouse_motion.pos = queued.mouse_motion.pos;
+		event.mouse_motion.delta = queued.mouse_motion.delta;
+		break;
+	case INPUT_EVENT_MOUSE_BUTTON_DOWN:
+	case INPUT_EVENT_MOUSE_BUTTON_UP:
+		event.mouse_button.button = queued.button;
+		break;
+	case INPUT_EVENT_MOUSE_WHEEL:
+		event.mouse_wheel.delta = queued.wheel_delta;
+		break;
+	}
+
+	listener_dispatch(event);
+}
+
+// keys held when live input and a replay hand over to each other would otherwise stay down
+static void release_keys()
+{
+	for(u32 key = 0; key < SCANCODE_COUNT; key++)
+	{
+		if(!input_state->keys.test(key))
+			continue;
+
+		input_queued_event event{.timestamp = SDL_GetTicksNS(), .type = INPUT_EVENT_KEY_UP};
+		event.scancode = static_cast<kbd_scancode>(key);
+		dispatch_queued(event);
+	}
+}
+
+static void sample_mouse()
+{
 	if(input_state->capture_mouse)
 	{
 		float dx, dy;
@@ -66,78 +235,292 @@ void input_poll()
 	}
 }
 
-static void listener_dispatch(const input_event_t& event)
+static bool replay_frame(std::vector<input_queued_event>& batch)
+{
+	auto& state = *input_state;
+	if(state.replay_offset + sizeof(InputFileFormat::Frame) > state.replay_size)
+		return false;
+
+	InputFileFormat::Frame frame;
+	std::memcpy(&frame, state.replay_data + state.replay_offset, sizeof(InputFileFormat::Frame));
+	state.replay_offset += sizeof(InputFileFormat::Frame);
+
+	const size_t events_size = size_t{frame.num_events} * sizeof(input_queued_event);
+	if(state.replay_offset + events_size > state.replay_size)
+	{
+		log::warn("input: recording is truncated after {} frames", state.replay_frames);
+		return false;
+	}
+
+	batch.resize(frame.num_events);
+	std::memcpy(batch.data(), state.replay_data + state.replay_offset, events_size);
+	state.replay_offset += events_size;
+
+	state.mouse_pos = frame.mouse_pos;
+	state.mouse_delta = frame.mouse_delta;
+	state.frame_delta_ns = frame.delta_ns;
+	state.replay_frames++;
+	return true;
+}
+
+static void record_frame(const std::vector<input_queued_event>& batch)
+{
+	auto& state = *input_state;
+
+	const InputFileFormat::Frame frame
+	{
+		.delta_ns = state.frame_delta_ns,
+		.mouse_pos = state.mouse_pos,
+		.mouse_delta = state.mouse_delta,
+		.num_events = static_cast<u32>(batch.size()),
+		.pad = 0u
+	};
+
+	bool ok = vfs_write(state.record, &frame, sizeof(InputFileFormat::Frame));
+	ok = ok && vfs_write(state.record, batch.data(), batch.size() * sizeof(input_queued_event));
+	if(!ok)
+	{
+		log::error("input: failed to write {}, recording stopped", state.record_path);
+		vfs_discard(state.record);
+		state.record = -1;
+		return;
+	}
+
+	state.record_frames++;
+}
+
+void input_poll()
 {
 	assert(input_state);
-	for(auto& callback : input_state->listeners)
-		callback(event);
+	auto& state = *input_state;
+
+	const auto now = std::chrono::steady_clock::now();
+	state.frame_delta_ns = state.polled ? static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - state.last_poll).count()) : 0ull;
+	state.last_poll = now;
+	state.polled = true;
+
+	if(const u32 dropped = state.queue.dropped.exchange(0u, std::memory_order_relaxed))
+		log::warn("input: event queue full, dropped {} events", dropped);
+
+	// drained while replaying as well so the queue does not fill up, live events are discarded then
+	state.batch.clear();
+	queue_drain(state.queue, state.batch);
+
+	if(state.replay >= 0)
+	{
+		state.batch.clear();
+		if(!replay_frame(state.batch))
+		{
+			input_replay_end();
+			sample_mouse();
+		}
+	}
+	else
+		sample_mouse();
+
+	for(const auto& event : state.batch)
+		dispatch_queued(event);
+
+	if(state.record >= 0)
+		record_frame(state.batch);
+}
+
+double input_frame_delta()
+{
+	assert(input_state);
+	return static_cast<double>(input_state->frame_delta_ns) / 1e9;
 }
 
-void input_dispatch_event(const SDL_Event& event)
+static void queue_text(u64 timestamp, std::string_view text)
+{
+	// split on code point boundaries, SDL hands out text of any length
+	while(!text.empty())
+	{
+		size_t len = std::min<size_t>(text.size(), INPUT_TEXT_SIZE - 1u);
+		while(len > 0 && len < text.size() && (static_cast<u8>(text[len]) & 0xc0u) == 0x80u)
+			len--;
+
+		if(!len)
+			len = std::min<size_t>(text.size(), INPUT_TEXT_SIZE - 1u);
+
+		input_queued_event event{.timestamp = timestamp, .type = INPUT_EVENT_TEXT_INPUT};
+		std::memcpy(event.text, text.data(), len);
+		event.text[len] = '\0';
+		queue_push(input_state->queue, event);
+
+		text.remove_prefix(len);
+	}
+}
+
+void input_queue_event(const SDL_Event& event)
 {
 	assert(input_state);
 
+	input_queued_event queued{.timestamp = event.common.timestamp};
+
 	switch(event.type)
 	{
 	case SDL_EVENT_WINDOW_FOCUS_GAINED:
-		input_state->window = SDL_GetWindowFromID(event.window.windowID);
-		break;
+		input_state->window.store(SDL_GetWindowFromID(event.window.windowID), std::memory_order_relaxed);
+		return;
 	case SDL_EVENT_KEY_DOWN:
 	case SDL_EVENT_KEY_UP:
-		listener_dispatch
-		({
-			.type = (event.type == SDL_EVENT_KEY_DOWN) ? INPUT_EVENT_KEY_DOWN : INPUT_EVENT_KEY_UP,
-			.key =
-			{
-				.scancode = sdl_scancode_parse(event.key.scancode)
-			}
-		});
+		queued.type = (event.type == SDL_EVENT_KEY_DOWN) ? INPUT_EVENT_KEY_DOWN : INPUT_EVENT_KEY_UP;
+		queued.scancode = sdl_scancode_parse(event.key.scancode);
 		break;
 	case SDL_EVENT_TEXT_INPUT:
-		listener_dispatch
-		({
-			.type = INPUT_EVENT_TEXT_INPUT,
-			.text =
-			{
-				.data = event.text.text
-			}
-		});
-		break;
+		if(event.text.text)
+			queue_text(event.common.timestamp, event.text.text);
+		return;
 	case SDL_EVENT_MOUSE_MOTION:
-		listener_dispatch
-		({
-			.type = INPUT_EVENT_MOUSE_MOTION,
-			.mouse_motion =
-			{
-				.pos = vec2{event.motion.x, event.motion.y},
-				.delta = vec2{event.motion.xrel, event.motion.yrel}
-			}
-		});
+		queued.type = INPUT_EVENT_MOUSE_MOTION;
+		queued.mouse_motion.pos = vec2{event.motion.x, event.motion.y};
+		queued.mouse_motion.delta = vec2{event.motion.xrel, event.motion.yrel};
 		break;
 	case SDL_EVENT_MOUSE_BUTTON_DOWN:
 	case SDL_EVENT_MOUSE_BUTTON_UP:
-		listener_dispatch
-		({
-			.type = (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN) ? INPUT_EVENT_MOUSE_BUTTON_DOWN : INPUT_EVENT_MOUSE_BUTTON_UP,
-			.mouse_button =
-			{
-				.button = sdl_mouse_parse(event.button.button)
-			}
-		});
+		queued.type = (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN) ? INPUT_EVENT_MOUSE_BUTTON_DOWN : INPUT_EVENT_MOUSE_BUTTON_UP;
+		queued.button = sdl_mouse_parse(event.button.button);
 		break;
 	case SDL_EVENT_MOUSE_WHEEL:
-		listener_dispatch
-		({
-			.type = INPUT_EVENT_MOUSE_WHEEL,
-			.mouse_wheel =
-			{
-				.delta = vec2{event.wheel.x, event.wheel.y}
-			}
-		});
+		queued.type = INPUT_EVENT_MOUSE_WHEEL;
+		queued.wheel_delta = vec2{event.wheel.x, event.wheel.y};
 		break;
 	default:
-		break;
+		return;
+	}
+
+	queue_push(input_state->queue, queued);
+}
+
+bool input_record_begin(const vfs_path& path)
+{
+	assert(input_state);
+	auto& state = *input_state;
+
+	if(state.record >= 0)
+		return false;
+
+	state.record = vfs_create(path);
+	if(state.record < 0)
+	{
+		log::error("input: failed to create recording {}", path.string());
+		return false;
+	}
+
+	const InputFileFormat::Header header;
+	if(!vfs_write(state.record, &header, sizeof(InputFileFormat::Header)))
+	{
+		vfs_discard(state.record);
+		state.record = -1;
+		return false;
+	}
+
+	state.record_path = path.string();
+	state.record_frames = 0ull;
+	PENUMBRA_LOG_INFO("input: recording to {}", state.record_path);
+	return true;
+}
+
+bool input_record_end()
+{
+	assert(input_state);
+	auto& state = *input_state;
+
+	if(state.record < 0)
+		return false;
+
+	const bool ok = vfs_commit(state.record);
+	state.record = -1;
+
+	if(ok)
+		PENUMBRA_LOG_INFO("input: recorded {} frames to {}", state.record_frames, state.record_path);
+	else
+		log::error("input: failed to write {}", state.record_path);
+
+	return ok;
+}
+
+bool input_recording()
+{
+	assert(input_state);
+	return input_state->record >= 0;
+}
+
+bool input_replay_begin(const vfs_path& path)
+{
+	assert(input_state);
+	auto& state = *input_state;
+
+	input_replay_end();
+
+	vfs_fd file = vfs_open(path, VFS_ACCESS_READ, VFS_HINT_SEQUENTIAL);
+	if(file < 0)
+	{
+		log::error("input: failed to open recording {}", path.string());
+		return false;
 	}
+
+	const u8* data = vfs_map(file);
+	const size_t size = vfs_size(file);
+
+	InputFileFormat::Header header;
+	bool valid = data && size >= sizeof(InputFileFormat::Header);
+	if(valid)
+	{
+		std::memcpy(&header, data, sizeof(InputFileFormat::Header));
+		valid = header.magic == InputFileFormat::fmt_magic &&
+			header.vmajor == InputFileFormat::fmt_major &&
+			header.event_size == sizeof(input_queued_event);
+	}
+
+	if(!valid)
+	{
+		log::error("input: {} is not a compatible recording", path.string());
+		vfs_close(file);
+		return false;
+	}
+
+	release_keys();
+
+	state.replay = file;
+	state.replay_data = data;
+	state.replay_size = size;
+	state.replay_offset = sizeof(InputFileFormat::Header);
+	state.replay_frames = 0ull;
+	state.replay_start = std::chrono::steady_clock::now();
+
+	PENUMBRA_LOG_INFO("input: replaying {}", path.string());
+	return true;
+}
+
+void input_replay_end()
+{
+	assert(input_state);
+	auto& state = *input_state;
+
+	if(state.replay < 0)
+		return;
+
+	const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - state.replay_start).count();
+	PENUMBRA_LOG_INFO("input: replay finished, {} frames in {:.1f} ms, {:.3f} ms per frame", state.replay_frames, elapsed, state.replay_frames ? elapsed / static_cast<double>(state.replay_frames) : 0.0);
+
+	vfs_close(state.replay);
+	state.replay = -1;
+	state.replay_data = nullptr;
+	state.replay_size = 0;
+	state.replay_offset = 0;
+
+	release_keys();
+
+	// the live mouse position has moved on while the recording drove it
+	state.mouse_delta = vec2{0.0f};
+}
+
+bool input_replaying()
+{
+	assert(input_state);
+	return input_state->replay >= 0;
 }
 
 void input_register_listener(const input_listener_t& listener)
@@ -153,32 +536,32 @@ bool input_is_key_down(kbd_scancode key)
 	if(key >= SCANCODE_COUNT)
 		return false;
 
-	return input_state->key_states[scancode_to_sdl(key)];
+	return input_state->keys.test(key);
 }
 
 bool input_text_input_active()
 {
 	assert(input_state);
-	return SDL_TextInputActive(input_state->window);
+	return SDL_TextInputActive(input_state->window.load(std::memory_order_relaxed));
 }
 
 bool input_start_text_input()
 {
 	assert(input_state);
-	return SDL_StartTextInput(input_state->window);
+	return SDL_StartTextInput(input_state->window.load(std::memory_order_relaxed));
 }
 
 bool input_stop_text_input()
 {
 	assert(input_state);
-	return SDL_StopTextInput(input_state->window);
+	return SDL_StopTextInput(input_state->window.load(std::memory_order_relaxed));
 }
 
 void input_set_mouse_capture(bool state)
 {
 	assert(input_state);
 	input_state->capture_mouse = state;
-	SDL_SetWindowRelativeMouseMode(input_state->window, state);
+	SDL_SetWindowRelativeMouseMode(input_state->window.load(std::memory_order_relaxed), state);
 	if(state)
 		SDL_GetRelativeMouseState(nullptr, nullptr);
 }
@@ -0,0 +1,531 @@
+#include <penumbra/job.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/profile.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace penumbra
+{
+
+constexpr u32 JOB_QUEUE_SIZE = 4096u;
+constexpr u32 JOB_POOL_SIZE = 4096u;
+constexpr u32 JOB_SPIN_COUNT = 64u;
+// parallel_for chunks per thread, enough to balance uneven ranges without paying a split check per element
+constexpr u32 JOB_RANGE_CHUNKS = 32u;
+
+struct range_task
+{
+	job_range_fn fn;
+	void* data;
+	u32 grain;
+	job_counter counter;
+};
+
+struct job_t
+{
+	void (*entry)(void*){nullptr};
+	void* data{nullptr};
+	job_counter* counter{nullptr};
+
+	// parallel_for subranges carry their task instead of an entry point
+	range_task* range{nullptr};
+	u32 begin{0};
+	u32 end{0};
+
+	bool heap{false};
+	std::atomic<bool> busy{false};
+};
+
+// Chase-Lev deque, the owning thread pushes and pops at the bottom while thieves take from the top
+struct job_queue
+{
+	alignas(64) std::atomic<s64> top{0};
+	alignas(64) std::atomic<s64> bottom{0};
+	std::array<std::atomic<job_t*>, JOB_QUEUE_SIZE> jobs;
+};
+
+struct alignas(64) job_worker
+{
+	job_queue queue;
+	std::thread thread;
+};
+
+struct deferred_jobs
+{
+	job_counter* dependency;
+	std::vector<job_decl> jobs;
+	job_counter* counter;
+};
+
+struct job_context
+{
+	// index 0 is the main thread, it owns a queue but no std::thread
+	std::vector<std::unique_ptr<job_worker>> workers;
+
+	// jobs submitted from threads the job system doesn't own
+	std::mutex inject_lock;
+	std::deque<job_t*> inject;
+	std::atomic<u32> inject_size{0};
+
+	// a counter only reaches zero while this is held, see counter_decrement
+	std::mutex deferred_lock;
+	std::vector<deferred_jobs> deferred;
+
+	std::atomic<u32> signal{0};
+	std::atomic<u32> sleepers{0};
+	std::atomic<bool> shutdown{false};
+};
+static job_context* context = nullptr;
+
+struct job_pool
+{
+	std::unique_ptr<job_t[]> jobs;
+	u32 next{0};
+};
+
+static thread_local s32 thread_index = -1;
+static thread_local job_pool pool;
+static thread_local u32 steal_seed = 0x9e3779b9u;
+
+static bool queue_push(job_queue& q, job_t* job)
+{
+	const s64 b = q.bottom.load(std::memory_order_relaxed);
+	const s64 t = q.top.load(std::memory_order_acquire);
+	if(b - t >= static_cast<s64>(JOB_QUEUE_SIZE))
+		return false;
+
+	q.jobs[static_cast<u64>(b) & (JOB_QUEUE_SIZE - 1u)].store(job, std::memory_order_relaxed);
+	q.bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+static job_t* queue_pop(job_queue& q)
+{
+	// the seq_cst store/load pair keeps a thief from reading the old bottom after we read top
+	const s64 b = q.bottom.load(std::memory_order_relaxed) - 1;
+	q.bottom.store(b, std::memory_order_seq_cst);
+	s64 t = q.top.load(std::memory_order_seq_cst);
+
+	if(t > b)
+	{
+		q.bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	job_t* job = q.jobs[static_cast<u64>(b) & (JOB_QUEUE_SIZE - 1u)].load(std::memory_order_relaxed);
+
+	// last job left, race the thieves for it
+	if(t == b)
+	{
+		if(!q.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+
+		q.bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+static job_t* queue_steal(job_queue& q)
+{
+	s64 t = q.top.load(std::memory_order_seq_cst);
+	const s64 b = q.bottom.load(std::memory_order_seq_cst);
+
+	if(t >= b)
+		return nullptr;
+
+	job_t* job = q.jobs[static_cast<u64>(t) & (JOB_QUEUE_SIZE - 1u)].load(std::memory_order_relaxed);
+	if(!q.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+
+	return job;
+}
+
+static bool queue_empty(const job_queue& q)
+{
+	return q.bottom.load(std::memory_order_relaxed) <= q.top.load(std::memory_order_relaxed);
+}
+
+// jobs come from a per thread ring, a slot that is still in flight when the ring wraps falls back to the heap
+static job_t* job_alloc()
+{
+	if(!pool.jobs)
+		pool.jobs = std::make_unique<job_t[]>(JOB_POOL_SIZE);
+
+	job_t* job = &pool.jobs[pool.next++ & (JOB_POOL_SIZE - 1u)];
+	if(job->busy.load(std::memory_order_acquire))
+	{
+		job = new job_t();
+		job->heap = true;
+	}
+
+	job->busy.store(true, std::memory_order_relaxed);
+	job->range = nullptr;
+	return job;
+}
+
+static void job_free(job_t* job)
+{
+	if(job->heap)
+		delete job;
+	else
+		job->busy.store(false, std::memory_order_release);
+}
+
+static void wake_workers(size_t count)
+{
+	context->signal.fetch_add(1u);
+	if(!context->sleepers.load())
+		return;
+
+	if(count > 1)
+		context->signal.notify_all();
+	else
+		context->signal.notify_one();
+}
+
+static void job_push(job_t* job)
+{
+	if(thread_index >= 0 && queue_push(context->workers[thread_index]->queue, job))
+		return;
+
+	std::scoped_lock<std::mutex> lock{context->inject_lock};
+	context->inject.push_back(job);
+	context->inject_size.fetch_add(1u, std::memory_order_relaxed);
+}
+
+static job_t* find_job()
+{
+	if(thread_index >= 0)
+	{
+		if(job_t* job = queue_pop(context->workers[thread_index]->queue))
+			return job;
+	}
+
+	if(context->inject_size.load(std::memory_order_relaxed))
+	{
+		std::scoped_lock<std::mutex> lock{context->inject_lock};
+		if(!context->inject.empty())
+		{
+			job_t* job = context->inject.front();
+			context->inject.pop_front();
+			context->inject_size.fetch_sub(1u, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	// start at a random victim so thieves don't all pile onto the same queue
+	steal_seed ^= steal_seed << 13;
+	steal_seed ^= steal_seed >> 17;
+	steal_seed ^= steal_seed << 5;
+
+	const auto count = static_cast<u32>(context->workers.size());
+	for(u32 i = 0; i < count; i++)
+	{
+		const u32 victim = (steal_seed + i) % count;
+		if(static_cast<s32>(victim) == thread_index)
+			continue;
+
+		if(job_t* job = queue_steal(context->workers[victim]->queue))
+			return job;
+	}
+
+	return nullptr;
+}
+
+static void queue_jobs(array_proxy<job_decl> jobs, job_counter* counter)
+{
+	for(const auto& decl : jobs)
+	{
+		job_t* job = job_alloc();
+		job->entry = decl.entry;
+		job->data = decl.data;
+		job->counter = counter;
+		job_push(job);
+	}
+
+	wake_workers(jobs.size());
+}
+
+// a waiter may destroy the counter as soon as it reads zero, so the last decrement happens under deferred_lock and
+// unhooks the batches waiting on it by pointer, job_run_after checks the dependency under the same lock
+static void counter_decrement(job_counter* counter)
+{
+	u32 value = counter->value.load(std::memory_order_relaxed);
+	while(value > 1u)
+	{
+		if(counter->value.compare_exchange_weak(value, value - 1u))
+			return;
+	}
+
+	if(!context)
+	{
+		counter->value.fetch_sub(1u);
+		return;
+	}
+
+	std::vector<deferred_jobs> ready;
+	{
+		std::scoped_lock<std::mutex> lock{context->deferred_lock};
+		if(counter->value.fetch_sub(1u) == 1u && !context->deferred.empty())
+		{
+			// the counter is never read again, a new one at the same address can't defer anything until the lock is dropped
+			auto it = std::ranges::partition(context->deferred, [counter](const deferred_jobs& d)
+			{
+				return d.dependency != counter;
+			}).begin();
+
+			std::move(it, context->deferred.end(), std::back_inserter(ready));
+			context->deferred.erase(it, context->deferred.end());
+		}
+	}
+
+	for(const auto& d : ready)
+		queue_jobs(d.jobs, d.counter);
+}
+
+static bool local_queue_empty()
+{
+	if(thread_index >= 0)
+		return queue_empty(context->workers[thread_index]->queue);
+
+	return !context->inject_size.load(std::memory_order_relaxed);
+}
+
+static void run_range(range_task* task, u32 begin, u32 end)
+{
+	while(begin < end)
+	{
+		// hand the back half to thieves, but only once whatever was split off before has been taken
+		if(end - begin > task->grain && local_queue_empty())
+		{
+			const u32 mid = begin + (end - begin) / 2u;
+
+			job_t* job = job_alloc();
+			job->range = task;
+			job->begin = mid;
+			job->end = end;
+			job->counter = &task->counter;
+			task->counter.value.fetch_add(1u);
+
+			job_push(job);
+			wake_workers(1);
+
+			end = mid;
+			continue;
+		}
+
+		const u32 chunk_end = end - begin > task->grain ? begin + task->grain : end;
+		task->fn(task->data, begin, chunk_end);
+		begin = chunk_end;
+	}
+}
+
+static void job_execute(job_t* job)
+{
+	job_counter* counter = job->counter;
+
+	if(job->range)
+		run_range(job->range, job->begin, job->end);
+	else
+		job->entry(job->data);
+
+	job_free(job);
+
+	if(counter)
+		counter_decrement(counter);
+}
+
+static void worker_main(s32 index)
+{
+	thread_index = index;
+	profile_set_thread_name(std::format("job worker {}", index).c_str());
+
+	while(!context->shutdown.load(std::memory_order_relaxed))
+	{
+		if(job_t* job = find_job())
+		{
+			job_execute(job);
+			continue;
+		}
+
+		// jobs tend to arrive in bursts, spin for a bit before going to sleep
+		job_t* job = nullptr;
+		for(u32 i = 0; i < JOB_SPIN_COUNT && !job; i++)
+		{
+			std::this_thread::yield();
+			job = find_job();
+		}
+
+		if(job)
+		{
+			job_execute(job);
+			continue;
+		}
+
+		const u32 seen = context->signal.load();
+		if((job = find_job()))
+		{
+			job_execute(job);
+			continue;
+		}
+
+		if(context->shutdown.load(std::memory_order_relaxed))
+			break;
+
+		context->sleepers.fetch_add(1u);
+		context->signal.wait(seen);
+		context->sleepers.fetch_sub(1u);
+	}
+}
+
+static void submit(array_proxy<job_decl> jobs, job_counter* counter)
+{
+	if(!context)
+	{
+		for(const auto& decl : jobs)
+		{
+			decl.entry(decl.data);
+			if(counter)
+				counter_decrement(counter);
+		}
+
+		return;
+	}
+
+	queue_jobs(jobs, counter);
+}
+
+void job_init(u32 worker_count)
+{
+	if(!worker_count)
+		worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+
+	context = new job_context();
+	thread_index = 0;
+
+	for(u32 i = 0; i <= worker_count; i++)
+		context->workers.push_back(std::make_unique<job_worker>());
+
+	for(u32 i = 1; i <= worker_count; i++)
+		context->workers[i]->thread = std::thread{worker_main, static_cast<s32>(i)};
+
+	PENUMBRA_LOG_INFO("job: started {} worker threads", worker_count);
+}
+
+void job_shutdown()
+{
+	// anything still queued would reference memory its submitter has long released, run it now
+	while(job_t* job = find_job())
+		job_execute(job);
+
+	context->shutdown.store(true);
+	context->signal.fetch_add(1u);
+	context->signal.notify_all();
+
+	for(auto& worker : context->workers)
+	{
+		if(worker->thread.joinable())
+			worker->thread.join();
+	}
+
+	if(!context->deferred.empty())
+		log::warn("job: {} job batches were still waiting on a dependency at shutdown", context->deferred.size());
+
+	delete context;
+	context = nullptr;
+	thread_index = -1;
+}
+
+u32 job_thread_count()
+{
+	return context ? static_cast<u32>(context->workers.size()) : 1u;
+}
+
+s32 job_thread_index()
+{
+	return thread_index;
+}
+
+void job_run(array_proxy<job_decl> jobs, job_counter* counter)
+{
+	if(jobs.empty())
+		return;
+
+	if(counter)
+		counter->value.fetch_add(static_cast<u32>(jobs.size()));
+
+	submit(jobs, counter);
+}
+
+void job_run_after(job_counter* dependency, array_proxy<job_decl> jobs, job_counter* counter)
+{
+	if(jobs.empty())
+		return;
+
+	if(counter)
+		counter->value.fetch_add(static_cast<u32>(jobs.size()));
+
+	if(context && dependency->value.load())
+	{
+		// still nonzero under the lock means the last decrement hasn't happened and will find this batch
+		std::unique_lock<std::mutex> lock{context->deferred_lock};
+		if(dependency->value.load())
+		{
+			context->deferred.push_back({dependency, {jobs.begin(), jobs.end()}, counter});
+			return;
+		}
+	}
+
+	submit(jobs, counter);
+}
+
+void job_wait(job_counter* counter)
+{
+	u32 idle = 0;
+	while(counter->value.load(std::memory_order_acquire))
+	{
+		job_t* job = context ? find_job() : nullptr;
+		if(job)
+		{
+			job_execute(job);
+			idle = 0;
+			continue;
+		}
+
+		// whatever is left is running on other threads
+		if(++idle > JOB_SPIN_COUNT)
+			std::this_thread::yield();
+	}
+}
+
+void job_parallel_for(u32 count, u32 min_grain, job_range_fn fn, void* data)
+{
+	if(!count)
+		return;
+
+	const u32 threads = job_thread_count();
+	const u32 grain = std::max({min_grain, 1u, count / (threads * JOB_RANGE_CHUNKS)});
+
+	if(threads == 1 || count <= grain)
+	{
+		fn(data, 0, count);
+		return;
+	}
+
+	range_task task{fn, data, grain, {}};
+	run_range(&task, 0, count);
+	job_wait(&task.counter);
+}
+
+}
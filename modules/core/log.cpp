@@ -0,0 +1,693 @@
+#include <penumbra/log.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined __linux__
+#include <unistd.h>
+#elif defined _WIN32
+#include <io.h>
+#endif
+
+namespace penumbra
+{
+
+// a header followed by a stream of blocks, format strings are written once before the first message that uses them
+struct LogFileFormat
+{
+	constexpr static u32 fmt_magic = 0x474f4c50;
+	constexpr static u32 fmt_major = 1u;
+	constexpr static u32 fmt_minor = 0u;
+
+	struct Header
+	{
+		u32 magic{fmt_magic};
+		u32 vmajor{fmt_major};
+		u32 vminor{fmt_minor};
+		u32 reserved{0u};
+		u64 base_time_ns;
+		s64 wall_time_ns;
+	};
+
+	enum BlockKind : u8
+	{
+		BLOCK_FORMAT = 0,
+		BLOCK_MESSAGE = 1
+	};
+
+	// format blocks carry the string in the payload, message blocks the encoded arguments
+	struct Block
+	{
+		u8 kind;
+		u8 level;
+		u8 num_args;
+		u8 reserved;
+		u32 format;
+		u32 thread;
+		u32 size;
+		u64 time_ns;
+	};
+};
+
+constexpr u64 LOG_RING_SIZE = 256ull * 1024ull;
+constexpr u8 LOG_RECORD_PAD = 0xffu;
+
+struct log_record
+{
+	u64 time;
+	const char* fmt;
+	u32 fmt_size;
+	u32 args_size;
+	u32 size;
+	log_level level;
+	u8 num_args;
+	u8 flags;
+};
+
+// single producer, the owning thread, and a single consumer, whoever holds the drain lock
+struct log_ring
+{
+	std::unique_ptr<u8[]> data;
+	alignas(64) std::atomic<u64> head{0};
+	alignas(64) std::atomic<u64> tail{0};
+	std::atomic<bool> retired{false};
+	const void* owner;
+	u32 id;
+};
+
+struct log_thread_state
+{
+	std::shared_ptr<log_ring> ring;
+	std::vector<u8> scratch;
+	log_record* record{nullptr};
+	bool sync{false};
+
+	~log_thread_state()
+	{
+		if(ring)
+			ring->retired.store(true, std::memory_order_release);
+	}
+};
+
+struct log_backend
+{
+	std::mutex rings_lock;
+	std::vector<std::shared_ptr<log_ring>> rings;
+	u32 next_ring_id{0u};
+
+	std::mutex drain_lock;
+	std::string console;
+	std::string message;
+
+	std::FILE* binary{nullptr};
+	std::vector<u8> binary_buffer;
+	std::unordered_map<const char*, u32> formats;
+
+	std::atomic<bool> shutdown{false};
+	std::thread thread;
+};
+
+static std::atomic<log_backend*> backend{nullptr};
+static std::mutex console_lock;
+static bool console_color = false;
+
+static thread_local log_thread_state thread_state;
+
+constexpr std::array<std::string_view, 5> level_names{"debug", "info", "warning", "error", "critical"};
+constexpr std::array<std::string_view, 5> level_colors{"\033[36m", "\033[32m", "\033[33m\033[1m", "\033[31m\033[1m", "\033[1m\033[41m"};
+
+static u64 log_now()
+{
+	return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct log_arg
+{
+	detail::log_arg_type type;
+	union
+	{
+		bool b;
+		char c;
+		s64 i;
+		u64 u;
+		float f;
+		double d;
+	};
+	std::string_view str;
+};
+
+template <typename T>
+static bool read_arg(const u8*& in, const u8* end, T& out)
+{
+	if(static_cast<size_t>(end - in) < sizeof(T))
+		return false;
+
+	std::memcpy(&out, in, sizeof(T));
+	in += sizeof(T);
+	return true;
+}
+
+static bool decode_args(const u8* in, u32 size, u8 num_args, std::array<log_arg, 255>& args)
+{
+	const u8* end = in + size;
+	for(u32 i = 0; i < num_args; i++)
+	{
+		log_arg& arg = args[i];
+		if(in == end)
+			return false;
+
+		arg.type = static_cast<detail::log_arg_type>(*in++);
+		switch(arg.type)
+		{
+		case detail::LOG_ARG_BOOL:
+			if(!read_arg(in, end, arg.b))
+				return false;
+			break;
+		case detail::LOG_ARG_CHAR:
+			if(!read_arg(in, end, arg.c))
+				return false;
+			break;
+		case detail::LOG_ARG_S64:
+			if(!read_arg(in, end, arg.i))
+				return false;
+			break;
+		case detail::LOG_ARG_U64:
+		case detail::LOG_ARG_PTR:
+			if(!read_arg(in, end, arg.u))
+				return false;
+			break;
+		case detail::LOG_ARG_F32:
+			if(!read_arg(in, end, arg.f))
+				return false;
+			break;
+		case detail::LOG_ARG_F64:
+			if(!read_arg(in, end, arg.d))
+				return false;
+			break;
+		case detail::LOG_ARG_STRING:
+		{
+			u32 length;
+			if(!read_arg(in, end, length) || length > static_cast<size_t>(end - in))
+				return false;
+
+			arg.str = std::string_view{reinterpret_cast<const char*>(in), length};
+			in += length;
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void format_arg(std::string& out, const log_arg& arg, std::string_view spec)
+{
+	std::array<char, 64> fmt_buf;
+	std::string_view fmt = "{}";
+	if(!spec.empty() && spec.size() + 3u <= fmt_buf.size())
+	{
+		fmt_buf[0] = '{';
+		fmt_buf[1] = ':';
+		std::memcpy(fmt_buf.data() + 2, spec.data(), spec.size());
+		fmt_buf[spec.size() + 2] = '}';
+		fmt = std::string_view{fmt_buf.data(), spec.size() + 3u};
+	}
+
+	auto it = std::back_inserter(out);
+	switch(arg.type)
+	{
+	case detail::LOG_ARG_BOOL:
+		std::vformat_to(it, fmt, std::make_format_args(arg.b));
+		break;
+	case detail::LOG_ARG_CHAR:
+		std::vformat_to(it, fmt, std::make_format_args(arg.c));
+		break;
+	case detail::LOG_ARG_S64:
+		std::vformat_to(it, fmt, std::make_format_args(arg.i));
+		break;
+	case detail::LOG_ARG_U64:
+		std::vformat_to(it, fmt, std::make_format_args(arg.u));
+		break;
+	case detail::LOG_ARG_F32:
+		std::vformat_to(it, fmt, std::make_format_args(arg.f));
+		break;
+	case detail::LOG_ARG_F64:
+		std::vformat_to(it, fmt, std::make_format_args(arg.d));
+		break;
+	case detail::LOG_ARG_PTR:
+	{
+		const void* ptr = reinterpret_cast<const void*>(arg.u);
+		std::vformat_to(it, fmt, std::make_format_args(ptr));
+		break;
+	}
+	case detail::LOG_ARG_STRING:
+		std::vformat_to(it, fmt, std::make_format_args(arg.str));
+		break;
+	}
+}
+
+// std::format has no runtime sized argument list, so replacement fields are parsed here and every argument is formatted on its own
+static void render_message(std::string& out, std::string_view fmt, u8 num_args, const u8* data, u32 size)
+{
+	if(num_args == detail::LOG_PREFORMATTED)
+	{
+		out.append(reinterpret_cast<const char*>(data), size);
+		return;
+	}
+
+	std::array<log_arg, 255> args;
+	if(!decode_args(data, size, num_args, args))
+	{
+		out += fmt;
+		out += " <invalid arguments>";
+		return;
+	}
+
+	u32 next_arg = 0;
+	for(size_t i = 0; i < fmt.size(); i++)
+	{
+		const char c = fmt[i];
+		if((c == '{' || c == '}') && i + 1 < fmt.size() && fmt[i + 1] == c)
+		{
+			out += c;
+			i++;
+			continue;
+		}
+
+		if(c != '{')
+		{
+			out += c;
+			continue;
+		}
+
+		const size_t close = fmt.find('}', i);
+		if(close == std::string_view::npos)
+		{
+			out += fmt.substr(i);
+			return;
+		}
+
+		const std::string_view field = fmt.substr(i + 1, close - i - 1);
+		const size_t colon = field.find(':');
+		const std::string_view id = field.substr(0, colon);
+		const std::string_view spec = colon == std::string_view::npos ? std::string_view{} : field.substr(colon + 1);
+
+		u32 index = next_arg++;
+		if(!id.empty())
+		{
+			index = 0;
+			for(char d : id)
+				index = index * 10u + static_cast<u32>(d - '0');
+		}
+
+		// nested replacement fields would consume arguments of their own, they are not worth supporting here
+		if(index >= num_args || spec.find('{') != std::string_view::npos)
+			out += fmt.substr(i, close - i + 1);
+		else
+			format_arg(out, args[index], spec);
+
+		i = close;
+	}
+}
+
+static void append_line(std::string& out, log_level level, std::string_view message, bool color)
+{
+	const u32 lvl = std::min<u32>(level, LOG_LEVEL_CRITICAL);
+
+	out += '[';
+	if(color)
+		out += level_colors[lvl];
+	out += level_names[lvl];
+	if(color)
+		out += "\033[m";
+	out += "] ";
+	out += message;
+	out += '\n';
+}
+
+static void write_console(std::string_view text)
+{
+	std::scoped_lock<std::mutex> lock{console_lock};
+	std::fwrite(text.data(), 1, text.size(), stdout);
+	std::fflush(stdout);
+}
+
+template <typename T>
+static void buffer_append(std::vector<u8>& buffer, const T& value)
+{
+	const auto* bytes = reinterpret_cast<const u8*>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+static void binary_append(log_backend& be, const log_record& record, u32 thread, const u8* args)
+{
+	auto [it, inserted] = be.formats.try_emplace(record.fmt, static_cast<u32>(be.formats.size()));
+	if(inserted)
+	{
+		buffer_append(be.binary_buffer, LogFileFormat::Block{LogFileFormat::BLOCK_FORMAT, record.level, 0u, 0u, it->second, 0u, record.fmt_size, 0ull});
+		be.binary_buffer.insert(be.binary_buffer.end(), record.fmt, record.fmt + record.fmt_size);
+	}
+
+	buffer_append(be.binary_buffer, LogFileFormat::Block{LogFileFormat::BLOCK_MESSAGE, record.level, record.num_args, 0u, it->second, thread, record.args_size, record.time});
+	be.binary_buffer.insert(be.binary_buffer.end(), args, args + record.args_size);
+}
+
+struct drain_cursor
+{
+	log_ring* ring;
+	u64 pos;
+	u64 end;
+};
+
+static const log_record* cursor_peek(drain_cursor& cursor)
+{
+	while(cursor.pos < cursor.end)
+	{
+		const auto* record = reinterpret_cast<const log_record*>(cursor.ring->data.get() + (cursor.pos & (LOG_RING_SIZE - 1ull)));
+		if(record->flags != LOG_RECORD_PAD)
+			return record;
+
+		cursor.pos += record->size;
+	}
+
+	return nullptr;
+}
+
+// merges whatever the rings hold by timestamp, so messages from different threads come out in order
+static void drain(log_backend& be)
+{
+	std::scoped_lock<std::mutex> lock{be.drain_lock};
+
+	std::vector<std::shared_ptr<log_ring>> rings;
+	{
+		std::scoped_lock<std::mutex> rings_lock{be.rings_lock};
+		rings = be.rings;
+	}
+
+	std::vector<drain_cursor> cursors;
+	cursors.reserve(rings.size());
+	for(const auto& ring : rings)
+		cursors.push_back({ring.get(), ring->tail.load(std::memory_order_relaxed), ring->head.load(std::memory_order_acquire)});
+
+	be.console.clear();
+	be.binary_buffer.clear();
+
+	while(true)
+	{
+		drain_cursor* next = nullptr;
+		const log_record* next_record = nullptr;
+		for(auto& cursor : cursors)
+		{
+			const log_record* record = cursor_peek(cursor);
+			if(record && (!next_record || record->time < next_record->time))
+			{
+				next = &cursor;
+				next_record = record;
+			}
+		}
+
+		if(!next)
+			break;
+
+		const u8* args = reinterpret_cast<const u8*>(next_record + 1);
+
+		be.message.clear();
+		render_message(be.message, std::string_view{next_record->fmt, next_record->fmt_size}, next_record->num_args, args, next_record->args_size);
+		append_line(be.console, next_record->level, be.message, console_color);
+
+		if(be.binary)
+			binary_append(be, *next_record, next->ring->id, args);
+
+		next->pos += next_record->size;
+	}
+
+	for(const auto& cursor : cursors)
+		cursor.ring->tail.store(cursor.pos, std::memory_order_release);
+
+	if(!be.console.empty())
+		write_console(be.console);
+
+	if(be.binary && !be.binary_buffer.empty())
+	{
+		std::fwrite(be.binary_buffer.data(), 1, be.binary_buffer.size(), be.binary);
+		std::fflush(be.binary);
+	}
+
+	// a retired ring's thread is gone, once it is empty nobody will write to it again
+	std::scoped_lock<std::mutex> rings_lock{be.rings_lock};
+	std::erase_if(be.rings, [](const std::shared_ptr<log_ring>& ring)
+	{
+		return ring->retired.load(std::memory_order_acquire) && ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+	});
+}
+
+static void backend_main(log_backend* be)
+{
+	while(!be->shutdown.load(std::memory_order_relaxed))
+	{
+		drain(*be);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+static log_ring* ring_acquire(log_backend& be)
+{
+	if(thread_state.ring && thread_state.ring->owner == &be)
+		return thread_state.ring.get();
+
+	// a pad record header may stick out past the end of the ring
+	auto ring = std::make_shared<log_ring>();
+	ring->data = std::make_unique<u8[]>(LOG_RING_SIZE + sizeof(log_record));
+	ring->owner = &be;
+
+	std::scoped_lock<std::mutex> lock{be.rings_lock};
+	ring->id = be.next_ring_id++;
+	be.rings.push_back(ring);
+	thread_state.ring = std::move(ring);
+
+	return thread_state.ring.get();
+}
+
+namespace detail
+{
+
+u8* log_record_begin(log_level level, std::string_view fmt, u8 num_args, u32 args_size)
+{
+	const u32 size = static_cast<u32>((sizeof(log_record) + args_size + 7ull) & ~7ull);
+	log_backend* be = backend.load(std::memory_order_acquire);
+
+	u8* out;
+	if(!be || size > LOG_RING_SIZE / 2ull)
+	{
+		thread_state.scratch.resize(size);
+		out = thread_state.scratch.data();
+		thread_state.sync = true;
+	}
+	else
+	{
+		log_ring* ring = ring_acquire(*be);
+		u64 head = ring->head.load(std::memory_order_relaxed);
+
+		// records never wrap, the rest of the ring is skipped with a pad record if this one doesn't fit
+		const u64 offset = head & (LOG_RING_SIZE - 1ull);
+		const u64 pad = offset + size > LOG_RING_SIZE ? LOG_RING_SIZE - offset : 0ull;
+
+		// the ring is full, drain it on this thread instead of waiting for the backend to come around
+		while(head + pad + size - ring->tail.load(std::memory_order_acquire) > LOG_RING_SIZE)
+			drain(*be);
+
+		if(pad)
+		{
+			auto* record = reinterpret_cast<log_record*>(ring->data.get() + offset);
+			record->size = static_cast<u32>(pad);
+			record->flags = LOG_RECORD_PAD;
+			head += pad;
+			ring->head.store(head, std::memory_order_release);
+		}
+
+		out = ring->data.get() + (head & (LOG_RING_SIZE - 1ull));
+		thread_state.sync = false;
+	}
+
+	auto* record = reinterpret_cast<log_record*>(out);
+	record->time = log_now();
+	record->fmt = fmt.data();
+	record->fmt_size = static_cast<u32>(fmt.size());
+	record->args_size = args_size;
+	record->size = size;
+	record->level = level;
+	record->num_args = num_args;
+	record->flags = 0u;
+	thread_state.record = record;
+
+	return out + sizeof(log_record);
+}
+
+void log_record_end()
+{
+	const log_record* record = thread_state.record;
+	if(thread_state.sync)
+	{
+		std::string message;
+		render_message(message, std::string_view{record->fmt, record->fmt_size}, record->num_args, reinterpret_cast<const u8*>(record + 1), record->args_size);
+
+		std::string line;
+		append_line(line, record->level, message, console_color);
+		write_console(line);
+		return;
+	}
+
+	log_ring* ring = thread_state.ring.get();
+	ring->head.store(ring->head.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+}
+
+}
+
+void log_init(const char* binary_path)
+{
+#if defined __linux__
+	console_color = isatty(fileno(stdout));
+#elif defined _WIN32
+	console_color = _isatty(_fileno(stdout));
+#endif
+
+	auto* be = new log_backend();
+
+	if(binary_path)
+	{
+		be->binary = std::fopen(binary_path, "wb");
+		if(be->binary)
+		{
+			LogFileFormat::Header header;
+			header.base_time_ns = log_now();
+			header.wall_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+			std::fwrite(&header, sizeof(LogFileFormat::Header), 1, be->binary);
+		}
+	}
+
+	be->thread = std::thread{backend_main, be};
+	backend.store(be, std::memory_order_release);
+
+	if(binary_path && !be->binary)
+		log::warn("log: failed to open {}, binary log disabled", binary_path);
+}
+
+void log_shutdown()
+{
+	log_backend* be = backend.exchange(nullptr, std::memory_order_acq_rel);
+	if(!be)
+		return;
+
+	be->shutdown.store(true, std::memory_order_relaxed);
+	be->thread.join();
+	drain(*be);
+
+	if(be->binary)
+		std::fclose(be->binary);
+
+	delete be;
+	thread_state.ring.reset();
+}
+
+void log_flush()
+{
+	if(log_backend* be = backend.load(std::memory_order_acquire))
+		drain(*be);
+}
+
+bool log_decode_binary(const char* input, const char* output)
+{
+	std::FILE* in = std::fopen(input, "rb");
+	if(!in)
+	{
+		log::error("log: failed to open {}", input);
+		return false;
+	}
+
+	std::FILE* out = output ? std::fopen(output, "wb") : stdout;
+	if(!out)
+	{
+		log::error("log: failed to open {}", output);
+		std::fclose(in);
+		return false;
+	}
+
+	LogFileFormat::Header header;
+	bool valid =
+		std::fread(&header, sizeof(LogFileFormat::Header), 1, in) == 1 &&
+		header.magic == LogFileFormat::fmt_magic &&
+		header.vmajor == LogFileFormat::fmt_major;
+
+	std::vector<std::string> formats;
+	std::vector<u8> payload;
+	std::string message;
+	std::string line;
+
+	LogFileFormat::Block block;
+	while(valid && std::fread(&block, sizeof(LogFileFormat::Block), 1, in) == 1)
+	{
+		payload.resize(block.size);
+		if(block.size && std::fread(payload.data(), 1, block.size, in) != block.size)
+		{
+			valid = false;
+			break;
+		}
+
+		if(block.kind == LogFileFormat::BLOCK_FORMAT)
+		{
+			if(block.format != formats.size())
+			{
+				valid = false;
+				break;
+			}
+
+			formats.emplace_back(reinterpret_cast<const char*>(payload.data()), payload.size());
+			continue;
+		}
+
+		if(block.kind != LogFileFormat::BLOCK_MESSAGE || block.format >= formats.size())
+		{
+			valid = false;
+			break;
+		}
+
+		message.clear();
+		render_message(message, formats[block.format], block.num_args, payload.data(), block.size);
+
+		line.clear();
+		const double seconds = static_cast<double>(block.time_ns - header.base_time_ns) / 1e9;
+		std::format_to(std::back_inserter(line), "[{:12.6f}] [t{}] ", seconds, block.thread);
+		append_line(line, static_cast<log_level>(block.level), message, false);
+		std::fwrite(line.data(), 1, line.size(), out);
+	}
+
+	std::fclose(in);
+	if(output)
+		std::fclose(out);
+
+	if(!valid)
+	{
+		log::error("log: {} is not a valid binary log", input);
+		return false;
+	}
+
+	return true;
+}
+
+}
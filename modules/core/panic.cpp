@@ -8,7 +8,8 @@ namespace penumbra
 
 [[noreturn]] void panic(const char* message)
 {
-	log::critical(message);
+	log::critical("{}", message);
+	log_flush();
 	wm_message_box("Fatal error", message, WM_MESSAGE_BOX_ERROR);
 	std::terminate();		
 }
@@ -0,0 +1,563 @@
+#include <penumbra/profile.hpp>
+#include <penumbra/allocator.hpp>
+#include <penumbra/cvar.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace penumbra
+{
+
+// zone, thread and event tables followed by a string table of null terminated strings
+struct ProfileFileFormat
+{
+	constexpr static u32 fmt_magic = 0x46525050;
+	constexpr static u32 fmt_major = 1u;
+	constexpr static u32 fmt_minor = 0u;
+
+	struct Header
+	{
+		u32 magic{fmt_magic};
+		u32 vmajor{fmt_major};
+		u32 vminor{fmt_minor};
+		u32 num_zones;
+		u32 num_threads;
+		u32 reserved{0u};
+		u64 num_events;
+		u64 base_time_ns;
+		u64 string_table_offset;
+	};
+
+	struct Zone
+	{
+		u32 name;
+		u32 function;
+		u32 file;
+		u32 line;
+	};
+
+	struct Thread
+	{
+		u32 name;
+		u32 tid;
+		u64 first_event;
+		u64 num_events;
+	};
+
+	struct Event
+	{
+		u64 time_ns;
+		u32 zone;
+		u32 type;
+	};
+};
+
+constexpr u64 PROFILE_RING_SIZE = 65536ull;
+constexpr u32 PROFILE_NO_ZONE = ~0u;
+
+enum profile_event_type : u32
+{
+	PROFILE_EVENT_BEGIN = 0,
+	PROFILE_EVENT_END = 1,
+	PROFILE_EVENT_FRAME = 2
+};
+
+// both words are written with relaxed stores so a dump racing the owning thread reads stale values, never torn ones
+struct profile_event
+{
+	std::atomic<u64> time;
+	std::atomic<u64> data;
+};
+
+struct profile_ring
+{
+	std::unique_ptr<profile_event[]> events;
+	std::atomic<u64> head{0};
+	std::string name;
+	u32 tid;
+};
+
+struct profile_context
+{
+	std::mutex lock;
+	std::vector<std::unique_ptr<profile_ring>> rings;
+	std::atomic<bool> enabled{true};
+};
+static profile_context* context = nullptr;
+
+static thread_local profile_ring* thread_ring = nullptr;
+
+static void prof_enable_changed(cvar_t* cvar)
+{
+	profile_set_enabled(cvar->int_v != 0);
+}
+
+static cvar_t prof_enable
+{
+	.name = "prof_enable",
+	.type = CVAR_TYPE_INT,
+	.int_defv = 1,
+	.int_v = 1,
+	.callback = prof_enable_changed
+};
+
+static u64 profile_now()
+{
+	return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static profile_ring* ring_acquire()
+{
+	if(thread_ring)
+		return thread_ring;
+
+	auto ring = std::make_unique<profile_ring>();
+	ring->events = std::make_unique<profile_event[]>(PROFILE_RING_SIZE);
+	memory_track_alloc(MEMORY_TAG_CORE, sizeof(profile_event) * PROFILE_RING_SIZE);
+
+	std::scoped_lock<std::mutex> lock{context->lock};
+	ring->tid = static_cast<u32>(context->rings.size());
+	ring->name = std::format("thread {}", ring->tid);
+	thread_ring = ring.get();
+	context->rings.push_back(std::move(ring));
+
+	return thread_ring;
+}
+
+static void record(u32 type, const profile_zone_desc* zone)
+{
+	if(!context || !context->enabled.load(std::memory_order_relaxed))
+		return;
+
+	profile_ring* ring = ring_acquire();
+	const u64 head = ring->head.load(std::memory_order_relaxed);
+
+	profile_event& event = ring->events[head & (PROFILE_RING_SIZE - 1ull)];
+	event.time.store(profile_now(), std::memory_order_relaxed);
+	event.data.store(reinterpret_cast<u64>(zone) | type, std::memory_order_relaxed);
+
+	ring->head.store(head + 1ull, std::memory_order_release);
+}
+
+void profile_init()
+{
+	context = new profile_context();
+	cvar_register(&prof_enable);
+	context->enabled.store(prof_enable.int_v != 0, std::memory_order_relaxed);
+}
+
+void profile_shutdown()
+{
+	memory_track_free(MEMORY_TAG_CORE, sizeof(profile_event) * PROFILE_RING_SIZE * context->rings.size());
+	delete context;
+	context = nullptr;
+	thread_ring = nullptr;
+}
+
+void profile_set_enabled(bool enabled)
+{
+	if(context)
+		context->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool profile_enabled()
+{
+	return context && context->enabled.load(std::memory_order_relaxed);
+}
+
+void profile_set_thread_name(const char* name)
+{
+	if(!context)
+		return;
+
+	profile_ring* ring = ring_acquire();
+
+	std::scoped_lock<std::mutex> lock{context->lock};
+	ring->name = name;
+}
+
+void profile_zone_begin(const profile_zone_desc* zone)
+{
+	record(PROFILE_EVENT_BEGIN, zone);
+}
+
+void profile_zone_end()
+{
+	record(PROFILE_EVENT_END, nullptr);
+}
+
+void profile_frame_mark()
+{
+	record(PROFILE_EVENT_FRAME, nullptr);
+}
+
+struct capture_zone
+{
+	std::string name;
+	std::string function;
+	std::string file;
+	u32 line;
+};
+
+struct capture_event
+{
+	u64 time;
+	u32 zone;
+	u32 type;
+};
+
+struct capture_thread
+{
+	std::string name;
+	u32 tid;
+	std::vector<capture_event> events;
+};
+
+struct profile_capture
+{
+	std::vector<capture_zone> zones;
+	std::vector<capture_thread> threads;
+	u64 base_time{~0ull};
+};
+
+static void capture_ring(profile_capture& capture, std::unordered_map<const profile_zone_desc*, u32>& zone_map, const profile_ring& ring)
+{
+	const u64 head = ring.head.load(std::memory_order_acquire);
+	const u64 start = head > PROFILE_RING_SIZE ? head - PROFILE_RING_SIZE : 0ull;
+
+	std::vector<std::pair<u64, u64>> raw;
+	raw.reserve(head - start);
+	for(u64 i = start; i < head; i++)
+	{
+		const profile_event& event = ring.events[i & (PROFILE_RING_SIZE - 1ull)];
+		raw.emplace_back(event.time.load(std::memory_order_relaxed), event.data.load(std::memory_order_relaxed));
+	}
+
+	// the owning thread kept recording while we copied, whatever it may have lapped is unreliable
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const u64 head_after = ring.head.load(std::memory_order_relaxed);
+	const u64 valid_start = head_after >= PROFILE_RING_SIZE ? head_after - PROFILE_RING_SIZE + 1ull : 0ull;
+	const size_t skip = static_cast<size_t>(std::min<u64>(std::max(valid_start, start) - start, raw.size()));
+
+	capture_thread& thread = capture.threads.emplace_back();
+	thread.name = ring.name;
+	thread.tid = ring.tid;
+	thread.events.reserve(raw.size() - skip);
+
+	for(size_t i = skip; i < raw.size(); i++)
+	{
+		const auto [time, data] = raw[i];
+		const auto type = static_cast<u32>(data & 0x7ull);
+		const auto* desc = reinterpret_cast<const profile_zone_desc*>(data & ~0x7ull);
+
+		u32 zone = PROFILE_NO_ZONE;
+		if(desc)
+		{
+			auto [it, inserted] = zone_map.try_emplace(desc, static_cast<u32>(capture.zones.size()));
+			if(inserted)
+				capture.zones.push_back({desc->name, desc->function, desc->file, desc->line});
+
+			zone = it->second;
+		}
+
+		capture.base_time = std::min(capture.base_time, time);
+		thread.events.push_back({time, zone, type});
+	}
+}
+
+static profile_capture capture_rings()
+{
+	profile_capture capture;
+	std::unordered_map<const profile_zone_desc*, u32> zone_map;
+
+	std::scoped_lock<std::mutex> lock{context->lock};
+	for(const auto& ring : context->rings)
+		capture_ring(capture, zone_map, *ring);
+
+	if(capture.base_time == ~0ull)
+		capture.base_time = 0ull;
+
+	return capture;
+}
+
+static void json_escape(std::string& out, std::string_view str)
+{
+	for(char c : str)
+	{
+		if(c == '"' || c == '\\')
+			out += '\\';
+
+		if(static_cast<unsigned char>(c) < 0x20)
+			continue;
+
+		out += c;
+	}
+}
+
+static bool write_file(const vfs_path& path, std::string_view data)
+{
+	vfs_wfd out = vfs_create(path, data.size());
+	if(out < 0)
+		return false;
+
+	if(!vfs_write(out, data.data(), data.size()))
+	{
+		vfs_discard(out);
+		return false;
+	}
+
+	return vfs_commit(out);
+}
+
+// begin/end pairs become complete events, ends whose begin was already overwritten and zones still open are dropped
+static bool write_chrome_trace(const profile_capture& capture, const vfs_path& path)
+{
+	std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	bool first = true;
+
+	auto separator = [&out, &first]()
+	{
+		if(!first)
+			out += ",\n";
+		first = false;
+	};
+
+	size_t num_events = 0;
+	std::vector<const capture_event*> stack;
+
+	for(const auto& thread : capture.threads)
+	{
+		separator();
+		out += std::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"", thread.tid);
+		json_escape(out, thread.name);
+		out += "\"}}";
+
+		stack.clear();
+		for(const auto& event : thread.events)
+		{
+			const double ts = static_cast<double>(event.time - capture.base_time) / 1000.0;
+
+			switch(event.type)
+			{
+			case PROFILE_EVENT_BEGIN:
+				stack.push_back(&event);
+				break;
+			case PROFILE_EVENT_END:
+			{
+				if(stack.empty())
+					break;
+
+				const capture_event& begin = *stack.back();
+				stack.pop_back();
+
+				const capture_zone& zone = capture.zones[begin.zone];
+				const double begin_ts = static_cast<double>(begin.time - capture.base_time) / 1000.0;
+
+				separator();
+				out += "{\"name\":\"";
+				json_escape(out, zone.name);
+				out += std::format("\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":{},\"args\":{{\"function\":\"", begin_ts, ts - begin_ts, thread.tid);
+				json_escape(out, zone.function);
+				out += "\",\"source\":\"";
+				json_escape(out, zone.file);
+				out += std::format(":{}\"}}}}", zone.line);
+				num_events++;
+				break;
+			}
+			case PROFILE_EVENT_FRAME:
+				separator();
+				out += std::format("{{\"name\":\"frame\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":{:.3f},\"pid\":0,\"tid\":{}}}", ts, thread.tid);
+				num_events++;
+				break;
+			}
+		}
+	}
+
+	out += "\n]}\n";
+
+	if(!write_file(path, out))
+	{
+		log::error("profile: failed to write {}", path.string());
+		return false;
+	}
+
+	PENUMBRA_LOG_INFO("profile: wrote {} events from {} threads to {}", num_events, capture.threads.size(), path.string());
+	return true;
+}
+
+bool profile_dump_chrome(const vfs_path& path)
+{
+	if(!context)
+		return false;
+
+	return write_chrome_trace(capture_rings(), path);
+}
+
+bool profile_dump_binary(const vfs_path& path)
+{
+	if(!context)
+		return false;
+
+	const profile_capture capture = capture_rings();
+
+	std::string strings;
+	auto add_string = [&strings](std::string_view str)
+	{
+		const auto offset = static_cast<u32>(strings.size());
+		strings += str;
+		strings += '\0';
+		return offset;
+	};
+
+	std::vector<ProfileFileFormat::Zone> zones;
+	zones.reserve(capture.zones.size());
+	for(const auto& zone : capture.zones)
+		zones.push_back({add_string(zone.name), add_string(zone.function), add_string(zone.file), zone.line});
+
+	std::vector<ProfileFileFormat::Thread> threads;
+	std::vector<ProfileFileFormat::Event> events;
+	for(const auto& thread : capture.threads)
+	{
+		threads.push_back({add_string(thread.name), thread.tid, events.size(), thread.events.size()});
+		for(const auto& event : thread.events)
+			events.push_back({event.time - capture.base_time, event.zone, event.type});
+	}
+
+	ProfileFileFormat::Header header;
+	header.num_zones = static_cast<u32>(zones.size());
+	header.num_threads = static_cast<u32>(threads.size());
+	header.num_events = events.size();
+	header.base_time_ns = capture.base_time;
+	header.string_table_offset = sizeof(ProfileFileFormat::Header) +
+		zones.size() * sizeof(ProfileFileFormat::Zone) +
+		threads.size() * sizeof(ProfileFileFormat::Thread) +
+		events.size() * sizeof(ProfileFileFormat::Event);
+
+	vfs_wfd out = vfs_create(path, header.string_table_offset + strings.size());
+	if(out < 0)
+		return false;
+
+	bool ok = vfs_write(out, &header, sizeof(ProfileFileFormat::Header));
+	ok = ok && vfs_write(out, zones.data(), zones.size() * sizeof(ProfileFileFormat::Zone));
+	ok = ok && vfs_write(out, threads.data(), threads.size() * sizeof(ProfileFileFormat::Thread));
+	ok = ok && vfs_write(out, events.data(), events.size() * sizeof(ProfileFileFormat::Event));
+	ok = ok && vfs_write(out, strings.data(), strings.size());
+
+	if(!ok)
+	{
+		vfs_discard(out);
+		log::error("profile: failed to write {}", path.string());
+		return false;
+	}
+
+	if(!vfs_commit(out))
+		return false;
+
+	PENUMBRA_LOG_INFO("profile: wrote {} events from {} threads to {}", events.size(), threads.size(), path.string());
+	return true;
+}
+
+bool profile_convert_binary(const vfs_path& input, const vfs_path& output)
+{
+	vfs_fd file = vfs_open(input, VFS_ACCESS_READ, VFS_HINT_SEQUENTIAL);
+	if(file < 0)
+	{
+		log::error("profile: failed to open {}", input.string());
+		return false;
+	}
+
+	const u8* data = vfs_map(file);
+	const size_t size = vfs_size(file);
+	const auto* header = reinterpret_cast<const ProfileFileFormat::Header*>(data);
+
+	const u64 tables_size =
+		sizeof(ProfileFileFormat::Header) +
+		u64{size >= sizeof(ProfileFileFormat::Header) ? header->num_zones : 0u} * sizeof(ProfileFileFormat::Zone) +
+		u64{size >= sizeof(ProfileFileFormat::Header) ? header->num_threads : 0u} * sizeof(ProfileFileFormat::Thread);
+
+	if
+	(
+		!data ||
+		size < sizeof(ProfileFileFormat::Header) ||
+		header->magic != ProfileFileFormat::fmt_magic ||
+		header->vmajor != ProfileFileFormat::fmt_major ||
+		header->string_table_offset > size ||
+		header->string_table_offset < tables_size ||
+		(header->string_table_offset - tables_size) / sizeof(ProfileFileFormat::Event) < header->num_events
+	)
+	{
+		log::error("profile: {} is not a valid profile capture", input.string());
+		vfs_close(file);
+		return false;
+	}
+
+	const auto* zones = reinterpret_cast<const ProfileFileFormat::Zone*>(data + sizeof(ProfileFileFormat::Header));
+	const auto* threads = reinterpret_cast<const ProfileFileFormat::Thread*>(zones + header->num_zones);
+	const auto* events = reinterpret_cast<const ProfileFileFormat::Event*>(threads + header->num_threads);
+
+	const std::string_view strings{reinterpret_cast<const char*>(data + header->string_table_offset), size - header->string_table_offset};
+	auto get_string = [&strings](u32 offset) -> std::string
+	{
+		if(offset >= strings.size())
+			return {};
+
+		return std::string{strings.substr(offset, strings.find('\0', offset) - offset)};
+	};
+
+	profile_capture capture;
+	capture.base_time = 0ull;
+
+	for(u32 i = 0; i < header->num_zones; i++)
+		capture.zones.push_back({get_string(zones[i].name), get_string(zones[i].function), get_string(zones[i].file), zones[i].line});
+
+	bool valid = true;
+	for(u32 i = 0; i < header->num_threads && valid; i++)
+	{
+		const auto& thread = threads[i];
+		if(thread.first_event > header->num_events || thread.num_events > header->num_events - thread.first_event)
+		{
+			valid = false;
+			break;
+		}
+
+		capture_thread& out = capture.threads.emplace_back();
+		out.name = get_string(thread.name);
+		out.tid = thread.tid;
+
+		for(u64 e = thread.first_event; e < thread.first_event + thread.num_events; e++)
+		{
+			const auto& event = events[e];
+			if(event.type == PROFILE_EVENT_BEGIN && event.zone >= header->num_zones)
+			{
+				valid = false;
+				break;
+			}
+
+			out.events.push_back({event.time_ns, event.zone, event.type});
+		}
+	}
+
+	vfs_close(file);
+
+	if(!valid)
+	{
+		log::error("profile: {} references events or zones out of range", input.string());
+		return false;
+	}
+
+	return write_chrome_trace(capture, output);
+}
+
+}
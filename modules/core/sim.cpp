@@ -0,0 +1,148 @@
+#include <penumbra/sim.hpp>
+#include <penumbra/frame_pacer.hpp>
+#include <penumbra/profile.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace penumbra
+{
+
+struct sim_snapshot
+{
+	std::vector<sim_transform> transforms;
+	u64 tick{0};
+	u64 time_ns{0};
+};
+
+struct sim_context
+{
+	std::thread thread;
+	std::atomic<bool> shutdown{false};
+	std::atomic<u32> rate{0};
+	sim_tick_fn tick;
+
+	// owned by the sim thread, the tick being written
+	sim_snapshot work;
+	u64 ticks{0};
+	u64 tick_start_ns{0};
+
+	// the two newest published ticks, a publish shifts them and only holds the lock for the swaps
+	std::mutex publish_lock;
+	sim_snapshot prev;
+	sim_snapshot curr;
+
+	// owned by the render thread, copied out of the published pair whenever a newer tick is there
+	sim_snapshot read_prev;
+	sim_snapshot read_curr;
+};
+
+static sim_context* context = nullptr;
+
+static u64 now_ns()
+{
+	return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void sim_thread_main()
+{
+	profile_set_thread_name("sim");
+
+	frame_pacer_t pacer;
+	frame_pacer_init(pacer, context->rate.load(std::memory_order_relaxed));
+
+	while(!context->shutdown.load(std::memory_order_acquire))
+	{
+		const u32 rate = context->rate.load(std::memory_order_relaxed);
+		frame_pacer_set_rate(pacer, rate);
+		frame_pacer_wait(pacer);
+
+		// stamped before it runs, so how long the tick takes does not shift the interpolation
+		context->tick_start_ns = now_ns();
+
+		PROFILE_ZONE_N("Sim Tick");
+		context->tick(1.0 / static_cast<double>(rate));
+	}
+}
+
+void sim_init(u32 rate, sim_tick_fn tick)
+{
+	assert(!context);
+	assert(rate);
+
+	context = new sim_context();
+	context->rate.store(rate, std::memory_order_relaxed);
+	context->tick = std::move(tick);
+	context->thread = std::thread{sim_thread_main};
+}
+
+void sim_shutdown()
+{
+	context->shutdown.store(true, std::memory_order_release);
+	context->thread.join();
+
+	delete context;
+	context = nullptr;
+}
+
+void sim_set_rate(u32 rate)
+{
+	assert(rate);
+	context->rate.store(rate, std::memory_order_relaxed);
+}
+
+std::vector<sim_transform>& sim_snapshot_begin()
+{
+	context->work.transforms.clear();
+	return context->work.transforms;
+}
+
+void sim_snapshot_publish()
+{
+	sim_snapshot& work = context->work;
+	assert(std::is_sorted(work.transforms.begin(), work.transforms.end(), [](const sim_transform& a, const sim_transform& b){ return a.id < b.id; }));
+
+	work.tick = ++context->ticks;
+	work.time_ns = context->tick_start_ns;
+
+	// work ends up with the storage of the oldest tick, which the next tick overwrites
+	std::scoped_lock<std::mutex> lock{context->publish_lock};
+	std::swap(context->prev, context->curr);
+	std::swap(context->curr, work);
+}
+
+sim_interp_state sim_snapshot_acquire()
+{
+	PROFILE_ZONE;
+
+	{
+		std::scoped_lock<std::mutex> lock{context->publish_lock};
+		if(context->curr.tick != context->read_curr.tick)
+		{
+			// copy assignment keeps the capacity of the read side, so this does not allocate once warmed up
+			context->read_prev = context->prev;
+			context->read_curr = context->curr;
+		}
+	}
+
+	sim_interp_state state;
+	state.prev = context->read_prev.transforms;
+	state.curr = context->read_curr.transforms;
+	state.tick = context->read_curr.tick;
+
+	// rendering runs one tick behind the simulation, so the present always lies between two published ticks
+	const u64 period = 1'000'000'000ull / context->rate.load(std::memory_order_relaxed);
+	const u64 now = now_ns();
+	const u64 elapsed = now > context->read_curr.time_ns ? now - context->read_curr.time_ns : 0ull;
+	state.alpha = std::min(static_cast<float>(static_cast<double>(elapsed) / static_cast<double>(period)), 1.0f);
+
+	return state;
+}
+
+}
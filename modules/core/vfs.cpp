@@ -1,13 +1,25 @@
+#include <core/vfs.hpp>
 #include <penumbra/vfs.hpp>
+#include <penumbra/vfs_pack.hpp>
+#include <penumbra/allocator.hpp>
 #include <penumbra/panic.hpp>
 #include <penumbra/log.hpp>
 #include <penumbra/types.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <bit>
+#include <chrono>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <expected>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #if defined __linux__
@@ -25,6 +37,60 @@
 namespace penumbra
 {
 
+constexpr u32 VFS_MAX_FILES = 65536u;
+constexpr u32 VFS_FD_INDEX_BITS = 16u;
+constexpr u32 VFS_FD_INDEX_MASK = (1u << VFS_FD_INDEX_BITS) - 1u;
+constexpr u32 VFS_FD_GENERATION_MASK = 0x7FFFu;
+
+// unreferenced read only mappings are kept this long in case the file is opened again
+constexpr std::chrono::seconds VFS_MAPPING_GRACE_PERIOD{2};
+
+struct pack_t
+{
+	vfs_path path;
+
+	#if defined __linux__
+	int fd;
+	#elif defined _WIN32
+	HANDLE fd;
+	HANDLE map;
+	#endif
+	size_t size;
+	u8* mapped;
+
+	const PackFileFormat::Entry* toc;
+	u32 num_entries;
+
+	std::atomic<u32> open_entries{0};
+};
+
+// read only mappings are shared between every open of the same file version
+struct mapping_key
+{
+	u64 device;
+	u64 inode;
+	u64 mtime;
+	u64 size;
+
+	bool operator==(const mapping_key&) const = default;
+};
+
+struct mapping_key_hash
+{
+	size_t operator()(const mapping_key& k) const
+	{
+		return std::hash<u64>{}(k.inode ^ (k.device << 48) ^ (k.mtime * 0x9e3779b97f4a7c15ull) ^ k.size);
+	}
+};
+
+struct mapping_t
+{
+	u8* mapped;
+	size_t size;
+	u32 refcount;
+	std::chrono::steady_clock::time_point expire;
+};
+
 struct file_t
 {
 	#if defined __linux__
@@ -36,16 +102,60 @@ struct file_t
 	size_t size;
 	u8* mapped;
 	bool rw;
+
+	// set for entries that live inside a mounted pack, these share the pack mapping
+	// unless compressed, in which case mapped is decoded on first use and owned by the file
+	pack_t* pack;
+	const PackFileFormat::Entry* entry;
+	bool owned;
+
+	// read only native files point into the shared mapping cache and hold no native handle
+	mapping_t* mapping;
+
+	// bumped on every close so stale handles to a recycled slot can be detected
+	std::atomic<u32> generation{0};
+};
+
+struct mount_t
+{
+	vfs_path root;
+	s32 priority;
+	std::unique_ptr<pack_t> pack;
+};
+
+struct resolved_path
+{
+	u64 generation;
+	pack_t* pack;
+	const PackFileFormat::Entry* entry;
+	vfs_path native;
 };
 
 struct vfs_context_t
 {
-	std::vector<file_t> table;
-	std::vector<u64> bitmap;
-	std::shared_mutex lock;
+	std::unique_ptr<file_t[]> table;
+	std::unique_ptr<std::atomic<u64>[]> bitmap;
+	std::atomic<u32> next_start_word{0};
+
+	// sorted by descending priority, equal priorities resolve to the most recently mounted first
+	std::vector<mount_t> mounts;
+
+	// virtual path hash -> resolved location, entries from an older generation are stale
+	std::unordered_map<u64, resolved_path, std::hash<u64>, std::equal_to<u64>, tagged_allocator<std::pair<const u64, resolved_path>, MEMORY_TAG_VFS>> path_cache;
+	std::atomic<u64> generation{1};
+
+	std::shared_mutex mount_lock;
+	// held while the write overlay is created so concurrent writers mount it once
+	std::mutex overlay_lock;
+
+	std::unordered_map<mapping_key, std::unique_ptr<mapping_t>, mapping_key_hash> mappings;
+	std::mutex mapping_lock;
 };
 static vfs_context_t* context = nullptr;
 
+constexpr u32 bitmap_words = VFS_MAX_FILES / 64u;
+constexpr size_t table_size = sizeof(file_t) * VFS_MAX_FILES + sizeof(std::atomic<u64>) * bitmap_words;
+
 void vfs_init()
 {
 	context = new vfs_context_t();
@@ -53,54 +163,620 @@ void vfs_init()
 	#if defined __linux__
 	struct rlimit lim;
 	getrlimit(RLIMIT_NOFILE, &lim);
-	lim.rlim_cur = 65536;
+	lim.rlim_cur = VFS_MAX_FILES;
 	setrlimit(RLIMIT_NOFILE, &lim);
 	#endif
 
-	context->table.resize(65536);
-	context->bitmap.resize(65536 / 64);
+	context->table = std::make_unique<file_t[]>(VFS_MAX_FILES);
+	context->bitmap = std::make_unique<std::atomic<u64>[]>(bitmap_words);
+	memory_track_alloc(MEMORY_TAG_VFS, table_size);
+
+	for(u32 i = 0; i < bitmap_words; i++)
+		context->bitmap[i].store(~(0ull), std::memory_order_relaxed);
+
+	// the working directory is the base data dir, every *.pack in it is mounted on top in name order so pak1 overrides pak0
+	std::error_code ec;
+	const vfs_path base_dir = std::filesystem::current_path(ec);
+	vfs_mount(base_dir, VFS_MOUNT_PRIORITY_BASE);
+
+	std::vector<vfs_path> pack_files;
+	for(const auto& entry : std::filesystem::directory_iterator{base_dir, ec})
+	{
+		if(entry.is_regular_file(ec) && entry.path().extension() == ".pack")
+			pack_files.push_back(entry.path());
+	}
+
+	std::sort(pack_files.begin(), pack_files.end());
+	for(const auto& pack : pack_files)
+		vfs_mount(pack, VFS_MOUNT_PRIORITY_PACK);
+
+	// files written over packed ones in earlier runs keep shadowing the packs
+	if(std::filesystem::is_directory(base_dir / VFS_WRITE_OVERLAY, ec))
+		vfs_mount(base_dir / VFS_WRITE_OVERLAY, VFS_MOUNT_PRIORITY_OVERLAY);
+
+	vfs_async_init();
+	vfs_write_init();
+	vfs_trace_init();
+}
 
-	for(size_t i = 0; i < context->bitmap.size(); i++)
-		context->bitmap[i] = ~(0ull);
+static void pack_unmap(pack_t& pack)
+{
+	#if defined __linux__
+	munmap(pack.mapped, pack.size);
+	close(pack.fd);
+	#elif defined _WIN32
+	UnmapViewOfFile(pack.mapped);
+	CloseHandle(pack.map);
+	CloseHandle(pack.fd);
+	#endif
+}
+
+static void mapping_unmap(u8* mapped, size_t size)
+{
+	#if defined __linux__
+	munmap(mapped, size);
+	#elif defined _WIN32
+	(void)size;
+	UnmapViewOfFile(mapped);
+	#endif
 }
 
 void vfs_shutdown()
 {
+	vfs_trace_shutdown();
+	vfs_write_shutdown();
+	vfs_async_shutdown();
+
+	for(auto& [key, mapping] : context->mappings)
+	{
+		if(mapping->refcount)
+			log::warn("vfs: mapping of {} bytes still has {} references", mapping->size, mapping->refcount);
+
+		mapping_unmap(mapping->mapped, mapping->size);
+	}
+
+	for(auto& mount : context->mounts)
+	{
+		if(!mount.pack)
+			continue;
+
+		if(mount.pack->open_entries.load(std::memory_order_relaxed))
+			log::warn("vfs: pack {} still has {} open entries", mount.root.string(), mount.pack->open_entries.load(std::memory_order_relaxed));
+
+		pack_unmap(*mount.pack);
+	}
+
 	delete context;
+	memory_track_free(MEMORY_TAG_VFS, table_size);
 }
 
-static vfs_fd get_free_fd()
+static std::unique_ptr<pack_t> pack_open(const vfs_path& p)
 {
-	std::unique_lock<std::shared_mutex> r_lock{context->lock};
+	auto pack = std::make_unique<pack_t>();
+	pack->path = p;
+
+	#if defined __linux__
+	pack->fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+	if(pack->fd < 0)
+	{
+		log::error("vfs: failed to open pack {}", p.string());
+		return nullptr;
+	}
 
-	for(size_t i = 0; i < context->bitmap.size(); i++)
+	struct stat file_info;
+	if(fstat(pack->fd, &file_info) < 0)
 	{
-		u64 cur_word = context->bitmap[i];
-		if(cur_word == 0)
+		close(pack->fd);
+		log::error("vfs: failed to stat pack {}", p.string());
+		return nullptr;
+	}
+	pack->size = static_cast<size_t>(file_info.st_size);
+
+	pack->mapped = reinterpret_cast<u8*>(mmap(nullptr, pack->size, PROT_READ, MAP_SHARED, pack->fd, 0));
+	if(pack->mapped == MAP_FAILED)
+	{
+		close(pack->fd);
+		log::error("vfs: failed to map pack {}", p.string());
+		return nullptr;
+	}
+	#elif defined _WIN32
+	pack->fd = CreateFileW(p.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if(pack->fd == INVALID_HANDLE_VALUE)
+	{
+		log::error("vfs: failed to open pack {}: {}", p.string(), GetLastError());
+		return nullptr;
+	}
+
+	LARGE_INTEGER fsize;
+	if(!GetFileSizeEx(pack->fd, &fsize))
+	{
+		CloseHandle(pack->fd);
+		log::error("vfs: failed to stat pack {}: {}", p.string(), GetLastError());
+		return nullptr;
+	}
+	pack->size = static_cast<size_t>(fsize.QuadPart);
+
+	pack->map = CreateFileMapping(pack->fd, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	pack->mapped = pack->map ? reinterpret_cast<u8*>(MapViewOfFile(pack->map, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	if(!pack->mapped)
+	{
+		if(pack->map)
+			CloseHandle(pack->map);
+		CloseHandle(pack->fd);
+		log::error("vfs: failed to map pack {}: {}", p.string(), GetLastError());
+		return nullptr;
+	}
+	#else
+	static_assert(false, "vfs_mount_pack not implemented");
+	#endif
+
+	const auto* header = reinterpret_cast<const PackFileFormat::Header*>(pack->mapped);
+	if
+	(
+		pack->size < sizeof(PackFileFormat::Header) ||
+		header->magic != PackFileFormat::fmt_magic ||
+		header->vmajor != PackFileFormat::fmt_major ||
+		header->toc_offset > pack->size ||
+		(pack->size - header->toc_offset) / sizeof(PackFileFormat::Entry) < header->num_entries
+	)
+	{
+		log::error("vfs: {} is not a valid pack", p.string());
+		pack_unmap(*pack);
+		return nullptr;
+	}
+
+	pack->toc = reinterpret_cast<const PackFileFormat::Entry*>(pack->mapped + header->toc_offset);
+	pack->num_entries = header->num_entries;
+
+	for(u32 i = 0; i < pack->num_entries; i++)
+	{
+		const auto& entry = pack->toc[i];
+		const bool compressed = entry.flags & PackFileFormat::entry_compressed;
+		if
+		(
+			entry.offset > header->toc_offset ||
+			entry.stored_size > header->toc_offset - entry.offset ||
+			(!compressed && entry.stored_size != entry.size) ||
+			(compressed && entry.num_blocks != PackFileFormat::block_count(entry.size))
+		)
+		{
+			log::error("vfs: pack {} entry {} is out of bounds", p.string(), i);
+			pack_unmap(*pack);
+			return nullptr;
+		}
+	}
+
+	return pack;
+}
+
+// mount changes invalidate every cached resolution, callers must hold mount_lock exclusively
+static void path_cache_invalidate()
+{
+	context->generation.fetch_add(1u, std::memory_order_release);
+	context->path_cache.clear();
+}
+
+bool vfs_mount(const vfs_path& p, s32 priority)
+{
+	std::error_code ec;
+	mount_t mount{std::filesystem::absolute(p, ec).lexically_normal(), priority, nullptr};
+
+	if(std::filesystem::is_regular_file(mount.root, ec))
+	{
+		mount.pack = pack_open(mount.root);
+		if(!mount.pack)
+			return false;
+
+		PENUMBRA_LOG_INFO("vfs: mounted pack {} ({} entries) priority {}", mount.root.string(), mount.pack->num_entries, priority);
+	}
+	else if(std::filesystem::is_directory(mount.root, ec))
+	{
+		PENUMBRA_LOG_INFO("vfs: mounted {} priority {}", mount.root.string(), priority);
+	}
+	else
+	{
+		log::error("vfs: cannot mount {}: not a directory or pack", p.string());
+		return false;
+	}
+
+	std::unique_lock<std::shared_mutex> lock{context->mount_lock};
+
+	auto pos = std::find_if(context->mounts.begin(), context->mounts.end(), [priority](const mount_t& m) { return m.priority <= priority; });
+	context->mounts.insert(pos, std::move(mount));
+	path_cache_invalidate();
+	return true;
+}
+
+
+void vfs_unmount(const vfs_path& p)
+{
+	std::error_code ec;
+	const vfs_path root = std::filesystem::absolute(p, ec).lexically_normal();
+
+	std::unique_lock<std::shared_mutex> lock{context->mount_lock};
+
+	auto it = std::find_if(context->mounts.begin(), context->mounts.end(), [&root](const mount_t& m) { return m.root == root; });
+	if(it == context->mounts.end())
+		return;
+
+	if(it->pack)
+	{
+		if(it->pack->open_entries.load(std::memory_order_acquire))
+		{
+			log::error("vfs: cannot unmount pack {} while entries are open", p.string());
+			return;
+		}
+
+		pack_unmap(*it->pack);
+	}
+
+	context->mounts.erase(it);
+	path_cache_invalidate();
+}
+
+void vfs_flush_path_cache()
+{
+	context->generation.fetch_add(1u, std::memory_order_release);
+}
+
+static const PackFileFormat::Entry* pack_find(const pack_t& pack, u64 hash)
+{
+	const auto* end = pack.toc + pack.num_entries;
+	const auto* it = std::lower_bound(pack.toc, end, hash, [](const PackFileFormat::Entry& e, u64 h) { return e.path_hash < h; });
+	if(it == end || it->path_hash != hash)
+		return nullptr;
+
+	return it;
+}
+
+static u64 path_cache_key(std::string_view normalized)
+{
+	return xxh3::hash64(normalized);
+}
+
+// drops a single stale resolution, the rest of the cache stays warm
+static void path_cache_evict(const vfs_path& p)
+{
+	std::unique_lock<std::shared_mutex> lock{context->mount_lock};
+	context->path_cache.erase(path_cache_key(p.lexically_normal().generic_string()));
+}
+
+// walks the mount table and caches the result, pins the pack when the path resolves into one so it can't be unmounted under the caller
+static bool resolve_path(const vfs_path& p, resolved_path& out, bool pin_pack)
+{
+	// the path cache is keyed by xxh3, pack tables of contents by the fnv hash the pack builder wrote
+	const std::string normalized = p.lexically_normal().generic_string();
+	const u64 key = path_cache_key(normalized);
+
+	{
+		std::shared_lock<std::shared_mutex> lock{context->mount_lock};
+
+		auto it = context->path_cache.find(key);
+		if(it != context->path_cache.end() && it->second.generation == context->generation.load(std::memory_order_acquire))
+		{
+			out = it->second;
+			if(pin_pack && out.pack)
+				out.pack->open_entries.fetch_add(1u, std::memory_order_relaxed);
+
+			return true;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock{context->mount_lock};
+
+	const u64 generation = context->generation.load(std::memory_order_acquire);
+	bool found = false;
+
+	for(const auto& mount : context->mounts)
+	{
+		if(mount.pack)
+		{
+			if(const auto* entry = pack_find(*mount.pack, PackFileFormat::hash_path(normalized)); entry)
+			{
+				out = {generation, mount.pack.get(), entry, {}};
+				found = true;
+				break;
+			}
+
 			continue;
+		}
 
-		int index = __builtin_ctzll(cur_word);
-		context->bitmap[i] &= ~(1ull << index);
-		return (i * 64 + index);
+		std::error_code ec;
+		vfs_path native = mount.root / p;
+		if(std::filesystem::is_regular_file(native, ec))
+		{
+			out = {generation, nullptr, nullptr, std::move(native)};
+			found = true;
+			break;
+		}
+	}
+
+	if(!found)
+		return false;
+
+	context->path_cache.insert_or_assign(key, out);
+	if(pin_pack && out.pack)
+		out.pack->open_entries.fetch_add(1u, std::memory_order_relaxed);
+
+	return true;
+}
+
+bool vfs_resolve(const vfs_path& p, vfs_location& out)
+{
+	if(p.is_absolute())
+		return false;
+
+	resolved_path resolved;
+	if(!resolve_path(p, resolved, false))
+		return false;
+
+	if(resolved.pack)
+	{
+		out.native_path = resolved.pack->path;
+		out.offset = resolved.entry->offset;
+		out.size = resolved.entry->size;
+		out.packed = true;
+		out.compressed = resolved.entry->flags & PackFileFormat::entry_compressed;
+	}
+	else
+	{
+		out.native_path = std::move(resolved.native);
+		out.offset = 0;
+		out.size = 0;
+		out.packed = false;
+		out.compressed = false;
+	}
+
+	return true;
+}
+
+// the highest priority directory takes the write unless a pack above it has the path, then overlay is set to where it should go
+static bool find_write_path(u64 hash, const vfs_path& p, vfs_path& out, vfs_path& overlay)
+{
+	std::shared_lock<std::shared_mutex> lock{context->mount_lock};
+
+	bool shadowed = false;
+	for(const auto& mount : context->mounts)
+	{
+		if(mount.pack)
+		{
+			shadowed = shadowed || pack_find(*mount.pack, hash);
+			continue;
+		}
+
+		if(shadowed)
+		{
+			overlay = mount.root / VFS_WRITE_OVERLAY;
+			return false;
+		}
+
+		out = mount.root / p;
+		return true;
+	}
+
+	out = p;
+	return true;
+}
+
+vfs_path vfs_resolve_write_path(const vfs_path& p)
+{
+	if(p.is_absolute())
+		return p;
+
+	const u64 hash = PackFileFormat::hash_path(p.lexically_normal().generic_string());
+
+	vfs_path target;
+	vfs_path overlay;
+	if(find_write_path(hash, p, target, overlay))
+		return target;
+
+	// a file written below the pack would never be read back, mount a directory above every pack to hold it
+	std::scoped_lock<std::mutex> lock{context->overlay_lock};
+	if(find_write_path(hash, p, target, overlay))
+		return target;
+
+	std::error_code ec;
+	std::filesystem::create_directories(overlay, ec);
+	if(!vfs_mount(overlay, VFS_MOUNT_PRIORITY_OVERLAY))
+		return overlay / p;
+
+	target = overlay / p;
+	std::filesystem::create_directories(target.parent_path(), ec);
+	return target;
+}
+
+static constexpr u32 fd_index(vfs_fd fd)
+{
+	return static_cast<u32>(fd) & VFS_FD_INDEX_MASK;
+}
+
+static constexpr u32 fd_generation(vfs_fd fd)
+{
+	return static_cast<u32>(fd) >> VFS_FD_INDEX_BITS;
+}
+
+static file_t& get_file(vfs_fd fd)
+{
+	file_t& f = context->table[fd_index(fd)];
+	assert(fd >= 0 && "vfs: invalid file descriptor");
+	assert(fd_generation(fd) == f.generation.load(std::memory_order_relaxed) && "vfs: stale file descriptor");
+	return f;
+}
+
+static vfs_fd get_free_fd()
+{
+	// every thread starts scanning at a different word so concurrent opens rarely race on the same CAS
+	thread_local u32 start_word = context->next_start_word.fetch_add(7u, std::memory_order_relaxed) % bitmap_words;
+
+	for(u32 n = 0; n < bitmap_words; n++)
+	{
+		u32 word = (start_word + n) % bitmap_words;
+		u64 cur_word = context->bitmap[word].load(std::memory_order_relaxed);
+
+		while(cur_word)
+		{
+			u64 bit = 1ull << std::countr_zero(cur_word);
+			if(context->bitmap[word].compare_exchange_weak(cur_word, cur_word & ~bit, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				start_word = word;
+
+				u32 index = word * 64u + static_cast<u32>(std::countr_zero(bit));
+				u32 generation = context->table[index].generation.load(std::memory_order_relaxed);
+				return static_cast<vfs_fd>((generation << VFS_FD_INDEX_BITS) | index);
+			}
+		}
 	}
 
 	log::error("vfs: out of file descriptors");
 	return -1;
 }
 
-vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode)
+static void release_fd(vfs_fd fd)
+{
+	u32 index = fd_index(fd);
+	file_t& f = context->table[index];
+	f.generation.store((f.generation.load(std::memory_order_relaxed) + 1u) & VFS_FD_GENERATION_MASK, std::memory_order_relaxed);
+
+	context->bitmap[index / 64u].fetch_or(1ull << (index % 64u), std::memory_order_release);
+}
+
+// the pack must already be pinned by resolve_path
+static vfs_fd open_pack_entry(pack_t* pack, const PackFileFormat::Entry* entry)
 {
 	vfs_fd handle = get_free_fd();
 	if(handle < 0)
+	{
+		pack->open_entries.fetch_sub(1u, std::memory_order_release);
 		return handle;
+	}
 
-	if(!std::filesystem::exists(p))
-		return -1;
+	file_t& f = context->table[fd_index(handle)];
+	f.pack = pack;
+	f.entry = entry;
+	f.mapping = nullptr;
+	f.size = entry->size;
+	f.rw = false;
 
-	if(std::filesystem::is_directory(p))
-		return -1;
+	if(entry->flags & PackFileFormat::entry_compressed)
+	{
+		f.mapped = nullptr;
+		f.owned = true;
+	}
+	else
+	{
+		f.mapped = pack->mapped + entry->offset;
+		f.owned = false;
+	}
+
+	return handle;
+}
+
+template <typename MapFn>
+static mapping_t* mapping_acquire(const mapping_key& key, MapFn&& map_file)
+{
+	{
+		std::scoped_lock<std::mutex> lock{context->mapping_lock};
+		if(auto it = context->mappings.find(key); it != context->mappings.end())
+		{
+			it->second->refcount++;
+			return it->second.get();
+		}
+	}
+
+	// map outside the lock, MAP_POPULATE can take a while
+	u8* mapped = map_file();
+	if(!mapped)
+		return nullptr;
+
+	std::scoped_lock<std::mutex> lock{context->mapping_lock};
+	auto [it, inserted] = context->mappings.try_emplace(key);
+	if(inserted)
+		it->second = std::make_unique<mapping_t>(mapped, static_cast<size_t>(key.size), 0u);
+	else
+		mapping_unmap(mapped, static_cast<size_t>(key.size));
+
+	it->second->refcount++;
+	return it->second.get();
+}
+
+static void mapping_release(mapping_t* mapping)
+{
+	std::scoped_lock<std::mutex> lock{context->mapping_lock};
+	if(--mapping->refcount == 0)
+		mapping->expire = std::chrono::steady_clock::now() + VFS_MAPPING_GRACE_PERIOD;
+}
+
+void vfs_tick()
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	std::scoped_lock<std::mutex> lock{context->mapping_lock};
+	std::erase_if(context->mappings, [now](const auto& it)
+	{
+		const auto& mapping = it.second;
+		if(mapping->refcount || mapping->expire > now)
+			return false;
+
+		mapping_unmap(mapping->mapped, mapping->size);
+		return true;
+	});
+}
+
+#if defined __linux__
+static void apply_hints(const u8* data, size_t size, int fd, size_t file_offset, u32 hints)
+{
+	if(!hints || !size)
+		return;
+
+	static const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	const uintptr_t start = std::bit_cast<uintptr_t>(data) & ~(page_size - 1);
+	const size_t length = std::bit_cast<uintptr_t>(data) + size - start;
+	void* addr = std::bit_cast<void*>(start);
+
+	if(hints & VFS_HINT_SEQUENTIAL)
+	{
+		madvise(addr, length, MADV_SEQUENTIAL);
+		if(fd >= 0)
+			posix_fadvise(fd, static_cast<off_t>(file_offset), static_cast<off_t>(size), POSIX_FADV_SEQUENTIAL);
+	}
+
+	if(hints & VFS_HINT_RANDOM)
+	{
+		madvise(addr, length, MADV_RANDOM);
+		if(fd >= 0)
+			posix_fadvise(fd, static_cast<off_t>(file_offset), static_cast<off_t>(size), POSIX_FADV_RANDOM);
+	}
 
-	file_t& f = context->table[handle];
+	// populate only takes effect when the file is first mapped, fall back to willneed when sharing a mapping
+	if(hints & (VFS_HINT_WILLNEED | VFS_HINT_POPULATE))
+	{
+		madvise(addr, length, MADV_WILLNEED);
+		if(fd >= 0)
+			posix_fadvise(fd, static_cast<off_t>(file_offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+	}
+}
+#elif defined _WIN32
+static void apply_hints(const u8* data, size_t size, HANDLE, size_t, u32 hints)
+{
+	if(!size || !(hints & (VFS_HINT_WILLNEED | VFS_HINT_POPULATE)))
+		return;
+
+	WIN32_MEMORY_RANGE_ENTRY range{const_cast<u8*>(data), size};
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#endif
+
+static vfs_fd open_native(const vfs_path& p, vfs_access_t mode, u32 hints)
+{
+	vfs_fd handle = get_free_fd();
+	if(handle < 0)
+		return handle;
+
+	file_t& f = context->table[fd_index(handle)];
+	f.pack = nullptr;
+	f.entry = nullptr;
+	f.owned = false;
+	f.mapping = nullptr;
 
 	#if defined __linux__
 
@@ -123,6 +799,7 @@ vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode)
 	if(f.fd < 0)
 	{
 		std::perror("vfs_open: open() failed");
+		release_fd(handle);
 		return -1;
 	}
 
@@ -130,14 +807,64 @@ vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode)
 	if(fstat(f.fd, &file_info) < 0)
 	{
 		std::perror("vfs_open: stat() failed");
+		close(f.fd);
+		release_fd(handle);
+		return -1;
+	}
+
+	if(!S_ISREG(file_info.st_mode))
+	{
+		close(f.fd);
+		release_fd(handle);
 		return -1;
 	}
 	f.size = static_cast<size_t>(file_info.st_size);
 
-	f.mapped = reinterpret_cast<u8*>(mmap(nullptr, f.size, prot, MAP_PRIVATE, f.fd, 0));
+	if(!f.rw)
+	{
+		const mapping_key key
+		{
+			static_cast<u64>(file_info.st_dev),
+			static_cast<u64>(file_info.st_ino),
+			static_cast<u64>(file_info.st_mtim.tv_sec) * 1000000000ull + static_cast<u64>(file_info.st_mtim.tv_nsec),
+			f.size
+		};
+
+		f.mapping = mapping_acquire(key, [&f, hints]() -> u8*
+		{
+			const int flags = MAP_PRIVATE | ((hints & VFS_HINT_POPULATE) ? MAP_POPULATE : 0);
+			void* mapped = mmap(nullptr, f.size, PROT_READ, flags, f.fd, 0);
+			if(mapped == MAP_FAILED)
+			{
+				std::perror("vfs_open: mmap() failed");
+				return nullptr;
+			}
+
+			return reinterpret_cast<u8*>(mapped);
+		});
+
+		if(f.mapping)
+			apply_hints(f.mapping->mapped, f.size, f.fd, 0, hints);
+
+		close(f.fd);
+		f.fd = -1;
+
+		if(!f.mapping)
+		{
+			release_fd(handle);
+			return -1;
+		}
+
+		f.mapped = f.mapping->mapped;
+		return handle;
+	}
+
+	f.mapped = reinterpret_cast<u8*>(mmap(nullptr, f.size, prot, MAP_SHARED, f.fd, 0));
 	if(f.mapped == MAP_FAILED)
 	{
 		std::perror("vfs_open: mmap() failed");
+		close(f.fd);
+		release_fd(handle);
 		return -1;
 	}
 	#elif defined _WIN32
@@ -151,60 +878,68 @@ vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode)
 	(
 		p.c_str(),
 		GENERIC_READ,
-		0,
+		FILE_SHARE_READ,
 		nullptr,
 		OPEN_EXISTING,
-		FILE_ATTRIBUTE_NORMAL,
+		FILE_ATTRIBUTE_NORMAL | ((hints & VFS_HINT_SEQUENTIAL) ? FILE_FLAG_SEQUENTIAL_SCAN : 0) | ((hints & VFS_HINT_RANDOM) ? FILE_FLAG_RANDOM_ACCESS : 0),
 		0
 	);
 
 	if(f.fd == INVALID_HANDLE_VALUE)
 	{
 		log::error("vfs_open: CreateFileW failed: {}", GetLastError());
+		release_fd(handle);
 		return -1;
 	}
 
-	LARGE_INTEGER fsize;
-	if(!GetFileSizeEx(f.fd, &fsize))
+	BY_HANDLE_FILE_INFORMATION file_info;
+	if(!GetFileInformationByHandle(f.fd, &file_info))
 	{
-		log::error("vfs_open: GetFileSizeEx failed: {}", GetLastError());
+		log::error("vfs_open: GetFileInformationByHandle failed: {}", GetLastError());
 		CloseHandle(f.fd);
+		release_fd(handle);
 		return -1;
 	}
 
-	f.size = static_cast<size_t>(fsize.QuadPart);
+	f.size = (static_cast<size_t>(file_info.nFileSizeHigh) << 32) | file_info.nFileSizeLow;
 
-	f.map = CreateFileMapping
-	(
-		f.fd,
-		nullptr,
-		PAGE_READONLY,
-		0,
-		0,
-		nullptr
-	);
+	const mapping_key key
+	{
+		file_info.dwVolumeSerialNumber,
+		(static_cast<u64>(file_info.nFileIndexHigh) << 32) | file_info.nFileIndexLow,
+		(static_cast<u64>(file_info.ftLastWriteTime.dwHighDateTime) << 32) | file_info.ftLastWriteTime.dwLowDateTime,
+		f.size
+	};
 
-	if(f.map == 0)
+	// views stay valid after the file and mapping handles are closed
+	f.mapping = mapping_acquire(key, [&f]() -> u8*
 	{
-		log::error("vfs_open: CreateFileMapping failed: {}", GetLastError());
-		CloseHandle(f.fd);
-		return -1;
-	}
+		HANDLE map = CreateFileMapping(f.fd, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(map == 0)
+		{
+			log::error("vfs_open: CreateFileMapping failed: {}", GetLastError());
+			return nullptr;
+		}
 
-	f.mapped = reinterpret_cast<u8*>(MapViewOfFile
-	(
-		f.map,
-		FILE_MAP_READ,
-		0, 0, 0
-	));
+		u8* mapped = reinterpret_cast<u8*>(MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0));
+		if(mapped == nullptr)
+			log::error("vfs_open: MapViewOfFile failed: {}", GetLastError());
 
-	if(f.mapped == nullptr)
+		CloseHandle(map);
+		return mapped;
+	});
+
+	CloseHandle(f.fd);
+	f.fd = INVALID_HANDLE_VALUE;
+
+	if(!f.mapping)
 	{
-		log::error("vfs_open: MapViewOfFile failed: {}", GetLastError());
-		CloseHandle(f.map);
-		CloseHandle(f.fd);
+		release_fd(handle);
 		return -1;
 	}
+
+	f.mapped = f.mapping->mapped;
+	apply_hints(f.mapped, f.size, f.fd, 0, hints);
 	#else
 	static_assert(false, "vfs_open not implemented");
 	#endif
@@ -212,11 +947,80 @@ vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode)
 	return handle;
 }
 
+static vfs_fd open_file(const vfs_path& p, vfs_access_t mode, u32 hints)
+{
+	if(p.is_absolute())
+		return open_native(p, mode, hints);
+
+	for(u32 attempt = 0; attempt < 2; attempt++)
+	{
+		resolved_path resolved;
+		if(!resolve_path(p, resolved, true))
+			return -1;
+
+		if(resolved.pack)
+		{
+			if(mode != VFS_ACCESS_READ)
+			{
+				resolved.pack->open_entries.fetch_sub(1u, std::memory_order_release);
+				log::error("vfs_open: {} is inside a pack and can only be opened for reading", p.string());
+				return -1;
+			}
+
+			vfs_fd handle = open_pack_entry(resolved.pack, resolved.entry);
+			if(handle >= 0)
+				apply_hints(resolved.pack->mapped + resolved.entry->offset, resolved.entry->stored_size, resolved.pack->fd, resolved.entry->offset, hints);
+
+			return handle;
+		}
+
+		vfs_fd handle = open_native(resolved.native, mode, hints);
+		if(handle >= 0)
+			return handle;
+
+		// the file went away since it was cached, resolve it again once in case a lower priority mount still has it
+		path_cache_evict(p);
+	}
+
+	return -1;
+}
+
+vfs_fd vfs_open(const vfs_path& p, vfs_access_t mode, u32 hints)
+{
+	vfs_fd handle = open_file(p, mode, hints);
+	if(handle >= 0)
+		vfs_trace_record(p, 0, context->table[fd_index(handle)].size);
+
+	return handle;
+}
+
+vfs_fd vfs_open_untraced(const vfs_path& p, vfs_access_t mode)
+{
+	return open_file(p, mode, VFS_HINT_NONE);
+}
+
 void vfs_close(vfs_fd fd)
 {
-	std::unique_lock<std::shared_mutex> w_lock{context->lock};
+	file_t& f = get_file(fd);
+	if(f.pack)
+	{
+		if(f.owned)
+			std::free(f.mapped);
+
+		f.pack->open_entries.fetch_sub(1u, std::memory_order_release);
+		f.pack = nullptr;
+		release_fd(fd);
+		return;
+	}
+
+	if(f.mapping)
+	{
+		mapping_release(f.mapping);
+		f.mapping = nullptr;
+		release_fd(fd);
+		return;
+	}
 
-	file_t& f = context->table[fd];
 	#if defined __linux__
 	munmap(f.mapped, f.size);
 	close(f.fd);
@@ -228,22 +1032,55 @@ void vfs_close(vfs_fd fd)
 	static_assert(false, "vfs_close not implemented");
 	#endif
 
-	auto bmp_offset = fd / 64;
-	auto bit_offset = fd % 64;
+	release_fd(fd);
+}
+
+static bool decode_entry(file_t& f)
+{
+	f.mapped = reinterpret_cast<u8*>(std::malloc(std::max<size_t>(f.size, 1)));
+	if(!vfs_decode_range(f.pack->mapped + f.entry->offset, *f.entry, f.mapped, 0, f.size))
+	{
+		std::free(f.mapped);
+		f.mapped = nullptr;
+		return false;
+	}
 
-	context->bitmap[bmp_offset] |= (1ull << bit_offset);
+	return true;
 }
 
 const u8* vfs_map(vfs_fd fd)
 {
-	std::scoped_lock<std::shared_mutex> r_lock{context->lock};
-	return std::bit_cast<const u8*>(context->table[fd].mapped);
+	file_t& f = get_file(fd);
+	if(!f.mapped && f.owned && !decode_entry(f))
+		return nullptr;
+
+	return std::bit_cast<const u8*>(f.mapped);
 }
 
 u8* vfs_map_rw(vfs_fd fd)
 {
-	std::scoped_lock<std::shared_mutex> r_lock{context->lock};
-	return context->table[fd].mapped;
+	file_t& f = get_file(fd);
+	assert(!f.pack && "vfs: pack entries are read only");
+	return f.mapped;
+}
+
+size_t vfs_size(vfs_fd fd)
+{
+	return get_file(fd).size;
+}
+
+bool vfs_read(vfs_fd fd, u8* dst, size_t offset, size_t size)
+{
+	file_t& f = get_file(fd);
+	if(offset > f.size || size > f.size - offset)
+		return false;
+
+	// compressed entries that were never mapped decode straight into dst
+	if(!f.mapped && f.owned)
+		return vfs_decode_range(f.pack->mapped + f.entry->offset, *f.entry, dst, offset, size);
+
+	std::memcpy(dst, f.mapped + offset, size);
+	return true;
 }
 
 }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <penumbra/vfs.hpp>
+#include <penumbra/vfs_pack.hpp>
+
+namespace penumbra
+{
+
+void vfs_async_init();
+void vfs_async_shutdown();
+
+void vfs_write_init();
+void vfs_write_shutdown();
+
+void vfs_trace_init();
+void vfs_trace_shutdown();
+void vfs_trace_record(const vfs_path& p, u64 offset, u64 length);
+
+// native path new files are created at
+vfs_path vfs_resolve_write_path(const vfs_path& p);
+
+// decodes [offset, offset + size) of a compressed pack entry into dst, blocks are spread over the job workers
+bool vfs_decode_range(const u8* entry_data, const PackFileFormat::Entry& entry, u8* dst, size_t offset, size_t size);
+
+// native location of a virtual path, packed entries are read straight out of the archive by the async reader
+struct vfs_location
+{
+	vfs_path native_path;
+	u64 offset;
+	u64 size;
+	bool packed;
+	bool compressed;
+};
+
+bool vfs_resolve(const vfs_path& p, vfs_location& out);
+
+// vfs_open without recording to the trace, for reads whoever queued them already recorded
+vfs_fd vfs_open_untraced(const vfs_path& p, vfs_access_t mode);
+
+}
@@ -0,0 +1,865 @@
+#include <core/vfs.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/job.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#endif
+
+namespace penumbra
+{
+
+constexpr u32 VFS_ASYNC_QUEUE_DEPTH = 256u;
+constexpr size_t VFS_ASYNC_MAX_CHUNK = 1ull << 30;
+constexpr size_t VFS_ASYNC_ALIGNMENT = 4096ull;
+
+struct read_op
+{
+	#if defined __linux__
+	int fd{-1};
+	#elif defined _WIN32
+	HANDLE fd{INVALID_HANDLE_VALUE};
+	#endif
+	u8* dst{nullptr};
+	size_t offset{0};
+	size_t size{0};
+	size_t done{0};
+	u64 user_data{0};
+	vfs_read_queue queue{VFS_READ_QUEUE_SHARED};
+	bool owned{false};
+	bool decode{false};
+};
+
+// compressed pack entries have no byte range to read, a job decodes them into the op's buffer
+struct decode_task
+{
+	vfs_path path;
+	u32 slot;
+	u8* dst;
+	size_t offset;
+	size_t size;
+};
+
+// completions wait here until the submitter of the read collects them
+struct read_queue_t
+{
+	std::vector<vfs_read_completion> completed;
+	size_t pending{0};
+	size_t decoding{0};
+	bool live{false};
+};
+
+#if defined __linux__
+struct uring_t
+{
+	int fd{-1};
+	u32 sq_entries{0};
+	u32 to_submit{0};
+	u32 inflight{0};
+
+	u32* sq_tail{nullptr};
+	u32* sq_array{nullptr};
+	u32 sq_mask{0};
+	io_uring_sqe* sqes{nullptr};
+
+	u32* cq_head{nullptr};
+	u32* cq_tail{nullptr};
+	u32 cq_mask{0};
+	io_uring_cqe* cqes{nullptr};
+
+	void* sq_ring{nullptr};
+	size_t sq_ring_size{0};
+	void* cq_ring{nullptr};
+	size_t cq_ring_size{0};
+	size_t sqes_size{0};
+};
+#endif
+
+struct vfs_async_context
+{
+	std::mutex lock;
+	std::condition_variable work_cv;
+	std::condition_variable done_cv;
+
+	std::vector<read_op> ops;
+	std::vector<u32> free_slots;
+	std::deque<u32> backlog;
+	std::vector<read_queue_t> queues;
+	std::vector<vfs_read_queue> free_queues;
+
+	std::vector<std::thread> workers;
+	job_counter decodes;
+	bool shutdown{false};
+	// one thread at a time sleeps in io_uring_enter without the lock, the others wait on done_cv for it to reap
+	bool ring_waiting{false};
+
+	#if defined __linux__
+	uring_t ring;
+	#endif
+};
+static vfs_async_context* context = nullptr;
+
+static u8* buffer_alloc(size_t size)
+{
+	size = (size + VFS_ASYNC_ALIGNMENT - 1) & ~(VFS_ASYNC_ALIGNMENT - 1);
+	#if defined _WIN32
+	return reinterpret_cast<u8*>(_aligned_malloc(size, VFS_ASYNC_ALIGNMENT));
+	#else
+	return reinterpret_cast<u8*>(std::aligned_alloc(VFS_ASYNC_ALIGNMENT, size));
+	#endif
+}
+
+static void buffer_free(u8* ptr)
+{
+	#if defined _WIN32
+	_aligned_free(ptr);
+	#else
+	std::free(ptr);
+	#endif
+}
+
+static s32 read_op_decode(read_op& op, const vfs_location& packed)
+{
+	#if defined __linux__
+	op.fd = -1;
+	#elif defined _WIN32
+	op.fd = INVALID_HANDLE_VALUE;
+	#endif
+
+	if(op.offset >= packed.size)
+		op.size = 0;
+	else if(!op.size || op.offset + op.size > packed.size)
+		op.size = packed.size - op.offset;
+
+	if(!op.size)
+		return 0;
+
+	if(!op.dst)
+	{
+		op.dst = buffer_alloc(op.size);
+		op.owned = true;
+	}
+
+	op.decode = true;
+	return 0;
+}
+
+static s32 read_op_open(const vfs_read_request& req, read_op& op)
+{
+	op.offset = req.offset;
+	op.size = req.size;
+	op.dst = req.dst;
+	op.done = 0;
+	op.user_data = req.user_data;
+	op.owned = false;
+	op.decode = false;
+
+	// relative paths go through the mount table, packed entries are read straight out of the archive
+	vfs_location location;
+	const bool resolved = vfs_resolve(req.path, location);
+	const bool in_pack = resolved && location.packed;
+	const vfs_path& native_path = resolved ? location.native_path : req.path;
+
+	// compressed entries are already mapped with the pack, they are decoded by a job instead of queueing io
+	if(in_pack && location.compressed)
+		return read_op_decode(op, location);
+
+	size_t file_size = 0;
+
+	#if defined __linux__
+	op.fd = open(native_path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(op.fd < 0)
+		return -errno;
+
+	struct stat file_info;
+	if(fstat(op.fd, &file_info) < 0)
+		return -errno;
+
+	if(!S_ISREG(file_info.st_mode))
+		return -EISDIR;
+
+	file_size = static_cast<size_t>(file_info.st_size);
+	#elif defined _WIN32
+	op.fd = CreateFileW
+	(
+		native_path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		0
+	);
+
+	if(op.fd == INVALID_HANDLE_VALUE)
+		return -static_cast<s32>(GetLastError());
+
+	LARGE_INTEGER fsize;
+	if(!GetFileSizeEx(op.fd, &fsize))
+		return -static_cast<s32>(GetLastError());
+
+	file_size = static_cast<size_t>(fsize.QuadPart);
+	#else
+	static_assert(false, "vfs_read_submit not implemented");
+	#endif
+
+	if(in_pack)
+		file_size = location.size;
+
+	if(op.offset >= file_size)
+		op.size = 0;
+	else if(!op.size || op.offset + op.size > file_size)
+		op.size = file_size - op.offset;
+
+	if(in_pack)
+		op.offset += location.offset;
+
+	if(!op.dst && op.size)
+	{
+		op.dst = buffer_alloc(op.size);
+		op.owned = true;
+	}
+
+	return 0;
+}
+
+static s32 read_op_execute(read_op& op)
+{
+	while(op.done < op.size)
+	{
+		const size_t chunk = std::min(op.size - op.done, VFS_ASYNC_MAX_CHUNK);
+
+		#if defined __linux__
+		ssize_t res = pread(op.fd, op.dst + op.done, chunk, static_cast<off_t>(op.offset + op.done));
+		if(res < 0)
+		{
+			if(errno == EINTR)
+				continue;
+
+			return -errno;
+		}
+		#elif defined _WIN32
+		const u64 pos = op.offset + op.done;
+		OVERLAPPED ov{};
+		ov.Offset = static_cast<DWORD>(pos & 0xFFFFFFFFull);
+		ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+
+		DWORD res = 0;
+		if(!ReadFile(op.fd, op.dst + op.done, static_cast<DWORD>(chunk), &res, &ov))
+			return -static_cast<s32>(GetLastError());
+		#endif
+
+		if(res == 0)
+			break;
+
+		op.done += static_cast<size_t>(res);
+	}
+
+	return 0;
+}
+
+static vfs_read_completion read_op_finish(read_op& op, s32 result)
+{
+	#if defined __linux__
+	if(op.fd >= 0)
+		close(op.fd);
+	op.fd = -1;
+	#elif defined _WIN32
+	if(op.fd != INVALID_HANDLE_VALUE)
+		CloseHandle(op.fd);
+	op.fd = INVALID_HANDLE_VALUE;
+	#endif
+
+	// a read that ends early means the file shrank under it, the caller must not parse a partial buffer
+	if(result == 0 && op.done < op.size)
+	{
+		#if defined _WIN32
+		result = -static_cast<s32>(ERROR_HANDLE_EOF);
+		#else
+		result = -EIO;
+		#endif
+	}
+
+	if(result < 0 && op.owned)
+	{
+		buffer_free(op.dst);
+		op.dst = nullptr;
+	}
+
+	return {op.user_data, op.dst, op.done, result};
+}
+
+static u32 read_op_alloc()
+{
+	if(context->free_slots.empty())
+	{
+		context->ops.emplace_back();
+		return static_cast<u32>(context->ops.size() - 1);
+	}
+
+	u32 slot = context->free_slots.back();
+	context->free_slots.pop_back();
+	return slot;
+}
+
+static void read_op_complete(u32 slot, s32 result)
+{
+	read_op& op = context->ops[slot];
+	context->queues[op.queue].completed.push_back(read_op_finish(op, result));
+	context->free_slots.push_back(slot);
+}
+
+#if defined __linux__
+static bool uring_init(uring_t& ring, u32 entries)
+{
+	io_uring_params params{};
+	ring.fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+	if(ring.fd < 0)
+		return false;
+
+	// IORING_OP_READ is 5.6+, older kernels only have the readv variant
+	constexpr u32 probe_ops = 256u;
+	std::vector<u8> probe_storage(sizeof(io_uring_probe) + probe_ops * sizeof(io_uring_probe_op));
+	auto* probe = reinterpret_cast<io_uring_probe*>(probe_storage.data());
+	if(syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, probe_ops) < 0 ||
+	   probe->last_op < IORING_OP_READ ||
+	   !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+	{
+		close(ring.fd);
+		ring.fd = -1;
+		return false;
+	}
+
+	ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+	ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if(single_mmap)
+	{
+		ring.sq_ring_size = std::max(ring.sq_ring_size, ring.cq_ring_size);
+		ring.cq_ring_size = ring.sq_ring_size;
+	}
+
+	ring.sq_ring = mmap(nullptr, ring.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+	if(ring.sq_ring == MAP_FAILED)
+	{
+		close(ring.fd);
+		ring.fd = -1;
+		return false;
+	}
+
+	if(single_mmap)
+	{
+		ring.cq_ring = ring.sq_ring;
+	}
+	else
+	{
+		ring.cq_ring = mmap(nullptr, ring.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+		if(ring.cq_ring == MAP_FAILED)
+		{
+			munmap(ring.sq_ring, ring.sq_ring_size);
+			close(ring.fd);
+			ring.fd = -1;
+			return false;
+		}
+	}
+
+	ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	ring.sqes = reinterpret_cast<io_uring_sqe*>(mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES));
+	if(ring.sqes == MAP_FAILED)
+	{
+		if(!single_mmap)
+			munmap(ring.cq_ring, ring.cq_ring_size);
+		munmap(ring.sq_ring, ring.sq_ring_size);
+		close(ring.fd);
+		ring.fd = -1;
+		return false;
+	}
+
+	auto* sq_base = reinterpret_cast<u8*>(ring.sq_ring);
+	ring.sq_tail = reinterpret_cast<u32*>(sq_base + params.sq_off.tail);
+	ring.sq_mask = *reinterpret_cast<u32*>(sq_base + params.sq_off.ring_mask);
+	ring.sq_array = reinterpret_cast<u32*>(sq_base + params.sq_off.array);
+	ring.sq_entries = params.sq_entries;
+
+	auto* cq_base = reinterpret_cast<u8*>(ring.cq_ring);
+	ring.cq_head = reinterpret_cast<u32*>(cq_base + params.cq_off.head);
+	ring.cq_tail = reinterpret_cast<u32*>(cq_base + params.cq_off.tail);
+	ring.cq_mask = *reinterpret_cast<u32*>(cq_base + params.cq_off.ring_mask);
+	ring.cqes = reinterpret_cast<io_uring_cqe*>(cq_base + params.cq_off.cqes);
+
+	return true;
+}
+
+static void uring_shutdown(uring_t& ring)
+{
+	munmap(ring.sqes, ring.sqes_size);
+	if(ring.cq_ring != ring.sq_ring)
+		munmap(ring.cq_ring, ring.cq_ring_size);
+	munmap(ring.sq_ring, ring.sq_ring_size);
+	close(ring.fd);
+	ring.fd = -1;
+}
+
+static void uring_queue_read(uring_t& ring, u32 slot)
+{
+	read_op& op = context->ops[slot];
+
+	const u32 tail = *ring.sq_tail;
+	const u32 index = tail & ring.sq_mask;
+
+	io_uring_sqe& sqe = ring.sqes[index];
+	sqe = {};
+	sqe.opcode = IORING_OP_READ;
+	sqe.fd = op.fd;
+	sqe.addr = reinterpret_cast<u64>(op.dst + op.done);
+	sqe.len = static_cast<u32>(std::min(op.size - op.done, VFS_ASYNC_MAX_CHUNK));
+	sqe.off = op.offset + op.done;
+	sqe.user_data = slot;
+
+	ring.sq_array[index] = index;
+	std::atomic_ref<u32>(*ring.sq_tail).store(tail + 1, std::memory_order_release);
+
+	ring.to_submit++;
+	ring.inflight++;
+}
+
+static void uring_enter(uring_t& ring, u32 min_complete)
+{
+	const u32 flags = min_complete ? IORING_ENTER_GETEVENTS : 0u;
+
+	int res = 0;
+	do
+	{
+		res = static_cast<int>(syscall(__NR_io_uring_enter, ring.fd, ring.to_submit, min_complete, flags, nullptr, 0));
+	}
+	while(res < 0 && errno == EINTR);
+
+	if(res < 0)
+	{
+		if(errno != EAGAIN && errno != EBUSY)
+			log::error("vfs: io_uring_enter failed: {}", errno);
+
+		return;
+	}
+
+	ring.to_submit -= std::min(ring.to_submit, static_cast<u32>(res));
+}
+
+// blocks until the ring has a completion, submits nothing so it can run without the lock
+static void uring_wait(uring_t& ring)
+{
+	int res = 0;
+	do
+	{
+		res = static_cast<int>(syscall(__NR_io_uring_enter, ring.fd, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0));
+	}
+	while(res < 0 && errno == EINTR);
+
+	if(res < 0 && errno != EAGAIN && errno != EBUSY)
+		log::error("vfs: io_uring_enter failed: {}", errno);
+}
+
+static void uring_fill(uring_t& ring)
+{
+	while(!context->backlog.empty() && ring.inflight < ring.sq_entries)
+	{
+		uring_queue_read(ring, context->backlog.front());
+		context->backlog.pop_front();
+	}
+}
+
+static void uring_reap(uring_t& ring)
+{
+	u32 head = *ring.cq_head;
+	const u32 tail = std::atomic_ref<u32>(*ring.cq_tail).load(std::memory_order_acquire);
+
+	for(; head != tail; head++)
+	{
+		const io_uring_cqe& cqe = ring.cqes[head & ring.cq_mask];
+		const auto slot = static_cast<u32>(cqe.user_data);
+		read_op& op = context->ops[slot];
+		ring.inflight--;
+
+		if(cqe.res < 0)
+		{
+			read_op_complete(slot, cqe.res);
+			continue;
+		}
+
+		op.done += static_cast<size_t>(cqe.res);
+		if(cqe.res == 0 || op.done >= op.size)
+			read_op_complete(slot, 0);
+		else
+			context->backlog.push_front(slot);
+	}
+
+	std::atomic_ref<u32>(*ring.cq_head).store(head, std::memory_order_release);
+
+	uring_fill(ring);
+}
+
+static bool uring_active()
+{
+	return context->ring.fd >= 0;
+}
+#else
+static bool uring_active()
+{
+	return false;
+}
+#endif
+
+static void worker_main()
+{
+	std::unique_lock<std::mutex> lock{context->lock};
+
+	for(;;)
+	{
+		context->work_cv.wait(lock, []{ return context->shutdown || !context->backlog.empty(); });
+		if(context->shutdown)
+			return;
+
+		u32 slot = context->backlog.front();
+		context->backlog.pop_front();
+
+		read_op op = context->ops[slot];
+		lock.unlock();
+		s32 result = read_op_execute(op);
+		lock.lock();
+
+		context->ops[slot] = op;
+		read_op_complete(slot, result);
+		context->done_cv.notify_all();
+	}
+}
+
+static void decode_main(void* data)
+{
+	auto* task = reinterpret_cast<decode_task*>(data);
+
+	// the read was traced when it was submitted
+	vfs_fd file = vfs_open_untraced(task->path, VFS_ACCESS_READ);
+	const bool decoded = file >= 0 && vfs_read(file, task->dst, task->offset, task->size);
+	if(file >= 0)
+		vfs_close(file);
+
+	{
+		std::unique_lock<std::mutex> lock{context->lock};
+		read_op& op = context->ops[task->slot];
+		if(decoded)
+			op.done = op.size;
+
+		context->queues[op.queue].decoding--;
+		read_op_complete(task->slot, decoded ? 0 : -1);
+	}
+
+	context->done_cv.notify_all();
+	delete task;
+}
+
+void vfs_async_init()
+{
+	context = new vfs_async_context();
+	context->queues.resize(1);
+	context->queues[VFS_READ_QUEUE_SHARED].live = true;
+
+	#if defined __linux__
+	if(uring_init(context->ring, VFS_ASYNC_QUEUE_DEPTH))
+	{
+		PENUMBRA_LOG_INFO("vfs: async reads using io_uring, queue depth {}", context->ring.sq_entries);
+		return;
+	}
+	#endif
+
+	const u32 worker_count = std::clamp(std::thread::hardware_concurrency() / 2u, 2u, 8u);
+	for(u32 i = 0; i < worker_count; i++)
+		context->workers.emplace_back(worker_main);
+
+	PENUMBRA_LOG_INFO("vfs: async reads using {} worker threads", worker_count);
+}
+
+void vfs_async_shutdown()
+{
+	job_wait(&context->decodes);
+
+	{
+		std::unique_lock<std::mutex> lock{context->lock};
+		context->shutdown = true;
+
+		#if defined __linux__
+		if(uring_active())
+		{
+			while(context->ring.inflight)
+			{
+				uring_enter(context->ring, 1u);
+				uring_reap(context->ring);
+			}
+		}
+		#endif
+	}
+
+	context->work_cv.notify_all();
+	for(auto& worker : context->workers)
+		worker.join();
+
+	for(u32 slot : context->backlog)
+		read_op_complete(slot, -1);
+
+	size_t uncollected = 0;
+	for(const auto& queue : context->queues)
+		uncollected += queue.completed.size();
+
+	if(uncollected)
+		log::warn("vfs: {} async reads were never collected", uncollected);
+
+	#if defined __linux__
+	if(uring_active())
+		uring_shutdown(context->ring);
+	#endif
+
+	delete context;
+	context = nullptr;
+}
+
+vfs_read_queue vfs_read_queue_create()
+{
+	std::unique_lock<std::mutex> lock{context->lock};
+
+	vfs_read_queue queue;
+	if(context->free_queues.empty())
+	{
+		queue = static_cast<vfs_read_queue>(context->queues.size());
+		context->queues.emplace_back();
+	}
+	else
+	{
+		queue = context->free_queues.back();
+		context->free_queues.pop_back();
+	}
+
+	context->queues[queue].live = true;
+	return queue;
+}
+
+static size_t wait_completions(std::unique_lock<std::mutex>& lock, vfs_read_queue queue, size_t min_count);
+
+void vfs_read_queue_destroy(vfs_read_queue queue)
+{
+	assert(queue != VFS_READ_QUEUE_SHARED);
+
+	std::unique_lock<std::mutex> lock{context->lock};
+	assert(context->queues[queue].live);
+
+	// reads still in flight write into the queue, let them land before the slot is reused
+	wait_completions(lock, queue, context->queues[queue].pending);
+
+	read_queue_t& q = context->queues[queue];
+	if(!q.completed.empty())
+		log::warn("vfs: {} async reads were never collected", q.completed.size());
+
+	q.completed.clear();
+	q.pending = 0;
+	q.live = false;
+	context->free_queues.push_back(queue);
+}
+
+size_t vfs_read_submit(array_proxy<vfs_read_request> requests, vfs_read_queue queue)
+{
+	// resolving, opening and sizing the files are syscalls, none of it needs the lock
+	std::vector<read_op> opened(requests.size());
+	std::vector<s32> results(requests.size());
+	for(size_t i = 0; i < requests.size(); i++)
+	{
+		vfs_trace_record(requests[i].path, requests[i].offset, requests[i].size);
+		opened[i].queue = queue;
+		results[i] = read_op_open(requests[i], opened[i]);
+	}
+
+	std::vector<job_decl> decodes;
+	std::unique_lock<std::mutex> lock{context->lock};
+	assert(context->queues[queue].live);
+
+	for(size_t i = 0; i < requests.size(); i++)
+	{
+		u32 slot = read_op_alloc();
+		context->ops[slot] = opened[i];
+		context->queues[queue].pending++;
+
+		if(results[i] < 0 || opened[i].done >= opened[i].size)
+		{
+			read_op_complete(slot, results[i]);
+			continue;
+		}
+
+		if(opened[i].decode)
+		{
+			context->queues[queue].decoding++;
+			auto* task = new decode_task{requests[i].path, slot, opened[i].dst, opened[i].offset, opened[i].size};
+			decodes.push_back({decode_main, task});
+			continue;
+		}
+
+		context->backlog.push_back(slot);
+	}
+
+	#if defined __linux__
+	if(uring_active())
+	{
+		uring_fill(context->ring);
+		uring_enter(context->ring, 0u);
+	}
+	#endif
+
+	context->work_cv.notify_all();
+
+	// decode jobs take the lock when they finish, and run inline without job_init
+	lock.unlock();
+	job_run(decodes, &context->decodes);
+	return requests.size();
+}
+
+static size_t drain_completions(vfs_read_queue queue, std::span<vfs_read_completion> out)
+{
+	read_queue_t& q = context->queues[queue];
+	size_t count = std::min(out.size(), q.completed.size());
+	std::copy_n(q.completed.begin(), count, out.begin());
+	q.completed.erase(q.completed.begin(), q.completed.begin() + static_cast<std::ptrdiff_t>(count));
+	q.pending -= count;
+	return count;
+}
+
+// the queue is only waiting on decode jobs, help run them rather than sleep in case every worker is busy
+static bool help_decode(std::unique_lock<std::mutex>& lock, vfs_read_queue queue)
+{
+	const read_queue_t& q = context->queues[queue];
+	if(!q.decoding || q.pending - q.completed.size() != q.decoding)
+		return false;
+
+	// the submitter hasn't queued them yet, every decode notifies when it lands
+	if(!context->decodes.value.load(std::memory_order_acquire))
+	{
+		context->done_cv.wait(lock);
+		return true;
+	}
+
+	lock.unlock();
+	job_wait(&context->decodes);
+	lock.lock();
+	return true;
+}
+
+// blocks until the queue holds min_count completions, whoever waits on the ring reaps for every queue
+static size_t wait_completions(std::unique_lock<std::mutex>& lock, vfs_read_queue queue, size_t min_count)
+{
+	#if defined __linux__
+	if(uring_active())
+	{
+		if(!context->ring_waiting)
+			uring_reap(context->ring);
+
+		while(context->queues[queue].completed.size() < min_count)
+		{
+			if(help_decode(lock, queue))
+				continue;
+
+			if(context->ring_waiting)
+			{
+				context->done_cv.wait(lock);
+				continue;
+			}
+
+			if(context->ring.to_submit)
+				uring_enter(context->ring, 0u);
+
+			// submitters and pollers keep going while this thread sleeps in the kernel
+			context->ring_waiting = true;
+			lock.unlock();
+			uring_wait(context->ring);
+			lock.lock();
+			context->ring_waiting = false;
+
+			// reaping refills the ring from the backlog, submit it before leaving in case nobody else waits
+			uring_reap(context->ring);
+			if(context->ring.to_submit)
+				uring_enter(context->ring, 0u);
+
+			context->done_cv.notify_all();
+		}
+
+		return context->queues[queue].completed.size();
+	}
+	#endif
+
+	while(context->queues[queue].completed.size() < min_count)
+	{
+		if(!help_decode(lock, queue))
+			context->done_cv.wait(lock);
+	}
+
+	return context->queues[queue].completed.size();
+}
+
+size_t vfs_read_poll(std::span<vfs_read_completion> completions, vfs_read_queue queue)
+{
+	std::unique_lock<std::mutex> lock{context->lock};
+
+	#if defined __linux__
+	if(uring_active())
+	{
+		// the sleeping waiter needs the completion it wakes up for, reaping is left to it
+		if(!context->ring_waiting)
+			uring_reap(context->ring);
+
+		if(context->ring.to_submit)
+			uring_enter(context->ring, 0u);
+	}
+	#endif
+
+	return drain_completions(queue, completions);
+}
+
+size_t vfs_read_wait(std::span<vfs_read_completion> completions, size_t min_count, vfs_read_queue queue)
+{
+	std::unique_lock<std::mutex> lock{context->lock};
+
+	min_count = std::min({min_count, completions.size(), context->queues[queue].pending});
+	wait_completions(lock, queue, min_count);
+	return drain_completions(queue, completions);
+}
+
+size_t vfs_read_pending(vfs_read_queue queue)
+{
+	std::unique_lock<std::mutex> lock{context->lock};
+	return context->queues[queue].pending;
+}
+
+void vfs_read_free(u8* data)
+{
+	buffer_free(data);
+}
+
+}
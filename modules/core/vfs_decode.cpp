@@ -0,0 +1,120 @@
+#include <core/vfs.hpp>
+#include <penumbra/compress.hpp>
+#include <penumbra/job.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace penumbra
+{
+
+struct block_job
+{
+	const u8* src;
+	size_t src_size;
+	size_t raw_size;
+	u8* dst;
+
+	// partial blocks at the edges of a range are decoded to scratch and then copied
+	size_t skip;
+	size_t copy;
+};
+
+static bool decode_block(const block_job& job)
+{
+	const bool stored_raw = job.src_size == job.raw_size;
+
+	if(stored_raw)
+	{
+		std::memcpy(job.dst, job.src + job.skip, job.copy);
+		return true;
+	}
+
+	if(!job.skip && job.copy == job.raw_size)
+		return lz_decompress(job.src, job.src_size, job.dst, job.raw_size);
+
+	thread_local std::vector<u8> scratch;
+	scratch.resize(PackFileFormat::block_size);
+
+	if(!lz_decompress(job.src, job.src_size, scratch.data(), job.raw_size))
+		return false;
+
+	std::memcpy(job.dst, scratch.data() + job.skip, job.copy);
+	return true;
+}
+
+bool vfs_decode_range(const u8* entry_data, const PackFileFormat::Entry& entry, u8* dst, size_t offset, size_t size)
+{
+	if(offset > entry.size || size > entry.size - offset)
+		return false;
+
+	if(!size)
+		return true;
+
+	const size_t table_size = (entry.num_blocks + 1ull) * sizeof(u64);
+	if(entry.num_blocks != PackFileFormat::block_count(entry.size) || table_size > entry.stored_size)
+		return false;
+
+	u64 block_offsets[2];
+	auto read_block_offsets = [entry_data, &block_offsets](u32 block)
+	{
+		std::memcpy(block_offsets, entry_data + block * sizeof(u64), sizeof(block_offsets));
+	};
+
+	const u32 first_block = static_cast<u32>(offset / PackFileFormat::block_size);
+	const u32 last_block = static_cast<u32>((offset + size - 1) / PackFileFormat::block_size);
+
+	std::vector<block_job> jobs;
+	jobs.reserve(last_block - first_block + 1u);
+
+	for(u32 b = first_block; b <= last_block; b++)
+	{
+		read_block_offsets(b);
+
+		const size_t block_start = b * PackFileFormat::block_size;
+		const size_t raw_size = std::min(PackFileFormat::block_size, entry.size - block_start);
+		if(block_offsets[0] < table_size || block_offsets[1] < block_offsets[0] || block_offsets[1] > entry.stored_size || block_offsets[1] - block_offsets[0] > raw_size)
+		{
+			log::error("vfs: corrupt block table in compressed pack entry {:#x}", entry.path_hash);
+			return false;
+		}
+
+		const size_t range_start = std::max(offset, block_start);
+		const size_t range_end = std::min(offset + size, block_start + raw_size);
+
+		jobs.push_back
+		({
+			.src = entry_data + block_offsets[0],
+			.src_size = block_offsets[1] - block_offsets[0],
+			.raw_size = raw_size,
+			.dst = dst + (range_start - offset),
+			.skip = range_start - block_start,
+			.copy = range_end - range_start
+		});
+	}
+
+	// blocks are independent, spread them over the job workers
+	std::atomic<bool> failed{false};
+	job_parallel_for(static_cast<u32>(jobs.size()), 1u, [&jobs, &failed](u32 begin, u32 end)
+	{
+		for(u32 i = begin; i < end; i++)
+		{
+			if(!decode_block(jobs[i]))
+				failed.store(true, std::memory_order_relaxed);
+		}
+	});
+
+	if(failed.load(std::memory_order_relaxed))
+	{
+		log::error("vfs: failed to decode compressed pack entry {:#x}", entry.path_hash);
+		return false;
+	}
+
+	return true;
+}
+
+}
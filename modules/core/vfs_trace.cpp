@@ -0,0 +1,304 @@
+#include <core/vfs.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/hash.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#if defined __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace penumbra
+{
+
+// manifest of file accesses in the order they happened, paths are stored in a string table after the entries
+struct TraceFileFormat
+{
+	constexpr static u32 fmt_magic = 0x4352544c;
+	constexpr static u32 fmt_major = 1u;
+	constexpr static u32 fmt_minor = 0u;
+
+	struct Header
+	{
+		u32 magic{fmt_magic};
+		u32 vmajor{fmt_major};
+		u32 vminor{fmt_minor};
+		u32 num_entries;
+		u64 string_table_offset;
+	};
+
+	struct Entry
+	{
+		u32 path_offset;
+		u32 path_length;
+		u64 offset;
+		u64 length;
+		u64 timestamp_us;
+	};
+};
+
+constexpr size_t VFS_TRACE_MAX_ENTRIES = 16384;
+
+struct vfs_trace_context
+{
+	std::atomic<bool> recording{false};
+	std::mutex lock;
+	std::chrono::steady_clock::time_point start;
+	std::vector<TraceFileFormat::Entry> entries;
+	std::string strings;
+	std::unordered_set<u64> seen;
+
+	std::thread readahead;
+	std::atomic<bool> stop{false};
+};
+static vfs_trace_context* context = nullptr;
+
+// keeps the readahead thread's own reads out of the trace
+static thread_local bool trace_suppressed = false;
+
+void vfs_trace_init()
+{
+	context = new vfs_trace_context();
+}
+
+void vfs_trace_shutdown()
+{
+	context->stop.store(true, std::memory_order_relaxed);
+	if(context->readahead.joinable())
+		context->readahead.join();
+
+	delete context;
+	context = nullptr;
+}
+
+void vfs_trace_begin()
+{
+	std::scoped_lock<std::mutex> lock{context->lock};
+	context->entries.clear();
+	context->strings.clear();
+	context->seen.clear();
+	context->start = std::chrono::steady_clock::now();
+	context->recording.store(true, std::memory_order_release);
+}
+
+void vfs_trace_record(const vfs_path& p, u64 offset, u64 length)
+{
+	if(!context->recording.load(std::memory_order_acquire) || trace_suppressed)
+		return;
+
+	const auto now = std::chrono::steady_clock::now();
+	const std::string path = p.generic_string();
+
+	std::scoped_lock<std::mutex> lock{context->lock};
+	if(context->entries.size() >= VFS_TRACE_MAX_ENTRIES)
+		return;
+
+	// only the first access matters for warming the page cache
+	if(!context->seen.insert(xxh3::hash64(path) ^ (offset * 0x9e3779b97f4a7c15ull)).second)
+		return;
+
+	context->entries.push_back
+	({
+		.path_offset = static_cast<u32>(context->strings.size()),
+		.path_length = static_cast<u32>(path.size()),
+		.offset = offset,
+		.length = length,
+		.timestamp_us = static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(now - context->start).count())
+	});
+	context->strings += path;
+}
+
+bool vfs_trace_end(const vfs_path& manifest)
+{
+	context->recording.store(false, std::memory_order_release);
+
+	std::scoped_lock<std::mutex> lock{context->lock};
+
+	TraceFileFormat::Header header;
+	header.num_entries = static_cast<u32>(context->entries.size());
+	header.string_table_offset = sizeof(TraceFileFormat::Header) + context->entries.size() * sizeof(TraceFileFormat::Entry);
+
+	const u64 size = header.string_table_offset + context->strings.size();
+	vfs_wfd out = vfs_create(manifest, size);
+	if(out < 0)
+		return false;
+
+	vfs_write(out, &header, sizeof(TraceFileFormat::Header));
+	vfs_write(out, context->entries.data(), context->entries.size() * sizeof(TraceFileFormat::Entry));
+	vfs_write(out, context->strings.data(), context->strings.size());
+	if(!vfs_commit(out))
+		return false;
+
+	PENUMBRA_LOG_INFO("vfs: wrote access trace {} ({} entries)", manifest.string(), header.num_entries);
+	return true;
+}
+
+struct readahead_range
+{
+	vfs_path path;
+	u64 offset;
+	u64 length;
+};
+
+static void readahead_main(std::vector<readahead_range> ranges)
+{
+	trace_suppressed = true;
+
+	const auto start = std::chrono::steady_clock::now();
+	size_t count = 0;
+
+	#if defined __linux__
+	// packed entries share one file, keep it open across consecutive ranges
+	vfs_path open_path;
+	int fd = -1;
+
+	for(const auto& range : ranges)
+	{
+		if(context->stop.load(std::memory_order_relaxed))
+			break;
+
+		if(range.path != open_path)
+		{
+			if(fd >= 0)
+				close(fd);
+
+			open_path = range.path;
+			fd = open(open_path.c_str(), O_RDONLY | O_CLOEXEC);
+		}
+
+		if(fd < 0)
+			continue;
+
+		u64 length = range.length;
+		if(!length)
+		{
+			const off_t file_size = lseek(fd, 0, SEEK_END);
+			length = file_size > static_cast<off_t>(range.offset) ? static_cast<u64>(file_size) - range.offset : 0;
+		}
+
+		readahead(fd, static_cast<off64_t>(range.offset), static_cast<size_t>(length));
+		count++;
+	}
+
+	if(fd >= 0)
+		close(fd);
+	#else
+	// no readahead syscall, push the ranges through the async reader in small batches and drop the data
+	// on a queue of its own, the main thread's loads must not see these completions or take ours
+	constexpr size_t batch_size = 32;
+	std::vector<vfs_read_request> requests;
+	std::array<vfs_read_completion, batch_size> completions;
+	const vfs_read_queue queue = vfs_read_queue_create();
+
+	for(size_t i = 0; i < ranges.size() && !context->stop.load(std::memory_order_relaxed); i += batch_size)
+	{
+		requests.clear();
+		for(size_t j = i; j < std::min(i + batch_size, ranges.size()); j++)
+			requests.push_back({.path = ranges[j].path, .offset = ranges[j].offset, .size = ranges[j].length});
+
+		vfs_read_submit(requests, queue);
+
+		size_t remaining = requests.size();
+		while(remaining)
+		{
+			size_t done = vfs_read_wait(completions, remaining, queue);
+			for(size_t c = 0; c < done; c++)
+			{
+				if(completions[c].data)
+					vfs_read_free(completions[c].data);
+			}
+
+			remaining -= done;
+		}
+
+		count += requests.size();
+	}
+
+	vfs_read_queue_destroy(queue);
+	#endif
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	PENUMBRA_LOG_DEBUG("vfs: readahead of {} ranges finished in {} ms", count, elapsed.count());
+}
+
+void vfs_readahead_start(const vfs_path& manifest)
+{
+	vfs_fd file = vfs_open(manifest, VFS_ACCESS_READ);
+	if(file < 0)
+	{
+		PENUMBRA_LOG_DEBUG("vfs: no access trace at {}, skipping readahead", manifest.string());
+		return;
+	}
+
+	const u8* data = vfs_map(file);
+	const size_t size = vfs_size(file);
+	const auto* header = reinterpret_cast<const TraceFileFormat::Header*>(data);
+
+	if
+	(
+		size < sizeof(TraceFileFormat::Header) ||
+		header->magic != TraceFileFormat::fmt_magic ||
+		header->vmajor != TraceFileFormat::fmt_major ||
+		header->string_table_offset > size ||
+		header->string_table_offset < sizeof(TraceFileFormat::Header) ||
+		(header->string_table_offset - sizeof(TraceFileFormat::Header)) / sizeof(TraceFileFormat::Entry) < header->num_entries
+	)
+	{
+		log::warn("vfs: {} is not a valid access trace", manifest.string());
+		vfs_close(file);
+		return;
+	}
+
+	const auto* entries = reinterpret_cast<const TraceFileFormat::Entry*>(data + sizeof(TraceFileFormat::Header));
+	const char* strings = reinterpret_cast<const char*>(data + header->string_table_offset);
+	const size_t strings_size = size - header->string_table_offset;
+
+	// resolve on the calling thread so the worker only touches native files
+	std::vector<readahead_range> ranges;
+	ranges.reserve(header->num_entries);
+
+	for(u32 i = 0; i < header->num_entries; i++)
+	{
+		const auto& entry = entries[i];
+		if(entry.path_offset > strings_size || entry.path_length > strings_size - entry.path_offset)
+			break;
+
+		const vfs_path path{std::string_view{strings + entry.path_offset, entry.path_length}};
+
+		vfs_location location;
+		if(!vfs_resolve(path, location))
+		{
+			if(path.is_absolute())
+				ranges.push_back({path, entry.offset, entry.length});
+
+			continue;
+		}
+
+		u64 length = entry.length;
+		if(location.packed && !length)
+			length = location.size > entry.offset ? location.size - entry.offset : 0;
+
+		ranges.push_back({std::move(location.native_path), location.offset + entry.offset, length});
+	}
+
+	vfs_close(file);
+
+	if(context->readahead.joinable())
+		context->readahead.join();
+
+	PENUMBRA_LOG_INFO("vfs: reading ahead {} files from {}", ranges.size(), manifest.string());
+	context->readahead = std::thread{readahead_main, std::move(ranges)};
+}
+
+}
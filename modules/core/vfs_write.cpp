@@ -0,0 +1,384 @@
+#include <core/vfs.hpp>
+#include <penumbra/vfs.hpp>
+#include <penumbra/log.hpp>
+#include <penumbra/types.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#endif
+
+namespace penumbra
+{
+
+constexpr size_t VFS_WRITE_BUFFER_SIZE = 4ull * 1024ull * 1024ull;
+constexpr size_t VFS_WRITE_ALIGNMENT = 4096ull;
+
+struct writer_t
+{
+	#if defined __linux__
+	int fd{-1};
+	#elif defined _WIN32
+	HANDLE fd{INVALID_HANDLE_VALUE};
+	#endif
+
+	vfs_path target;
+	vfs_path temp;
+	bool direct{false};
+	bool failed{false};
+
+	u8* buffer{nullptr};
+	size_t buffer_used{0};
+	u64 written{0};
+};
+
+struct vfs_write_context
+{
+	std::mutex lock;
+	std::vector<std::unique_ptr<writer_t>> writers;
+	std::vector<vfs_wfd> free_slots;
+};
+static vfs_write_context* context = nullptr;
+
+static u8* buffer_alloc()
+{
+	#if defined _WIN32
+	return reinterpret_cast<u8*>(_aligned_malloc(VFS_WRITE_BUFFER_SIZE, VFS_WRITE_ALIGNMENT));
+	#else
+	return reinterpret_cast<u8*>(std::aligned_alloc(VFS_WRITE_ALIGNMENT, VFS_WRITE_BUFFER_SIZE));
+	#endif
+}
+
+static void buffer_free(u8* ptr)
+{
+	#if defined _WIN32
+	_aligned_free(ptr);
+	#else
+	std::free(ptr);
+	#endif
+}
+
+static writer_t* get_writer(vfs_wfd fd)
+{
+	std::scoped_lock<std::mutex> lock{context->lock};
+	if(fd < 0 || static_cast<size_t>(fd) >= context->writers.size() || !context->writers[fd])
+	{
+		log::error("vfs: invalid writer handle {}", fd);
+		return nullptr;
+	}
+
+	return context->writers[fd].get();
+}
+
+static void writer_release(vfs_wfd fd)
+{
+	std::scoped_lock<std::mutex> lock{context->lock};
+	buffer_free(context->writers[fd]->buffer);
+	context->writers[fd].reset();
+	context->free_slots.push_back(fd);
+}
+
+// writes whole buffers, with O_DIRECT the tail is padded to the alignment and trimmed again on commit
+static bool writer_flush(writer_t& w)
+{
+	if(!w.buffer_used || w.failed)
+		return !w.failed;
+
+	size_t size = w.buffer_used;
+	if(w.direct)
+	{
+		const size_t aligned = (size + VFS_WRITE_ALIGNMENT - 1) & ~(VFS_WRITE_ALIGNMENT - 1);
+		std::memset(w.buffer + size, 0, aligned - size);
+		size = aligned;
+	}
+
+	size_t done = 0;
+	while(done < size)
+	{
+		#if defined __linux__
+		ssize_t res = pwrite(w.fd, w.buffer + done, size - done, static_cast<off_t>(w.written + done));
+		if(res < 0)
+		{
+			if(errno == EINTR)
+				continue;
+
+			log::error("vfs: write to {} failed: {}", w.temp.string(), errno);
+			w.failed = true;
+			return false;
+		}
+		#elif defined _WIN32
+		const u64 pos = w.written + done;
+		OVERLAPPED ov{};
+		ov.Offset = static_cast<DWORD>(pos & 0xFFFFFFFFull);
+		ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+
+		DWORD res = 0;
+		if(!WriteFile(w.fd, w.buffer + done, static_cast<DWORD>(size - done), &res, &ov))
+		{
+			log::error("vfs: write to {} failed: {}", w.temp.string(), GetLastError());
+			w.failed = true;
+			return false;
+		}
+		#endif
+
+		done += static_cast<size_t>(res);
+	}
+
+	w.written += w.buffer_used;
+	w.buffer_used = 0;
+	return true;
+}
+
+static void writer_close(writer_t& w, bool remove_temp)
+{
+	#if defined __linux__
+	if(w.fd >= 0)
+		close(w.fd);
+	w.fd = -1;
+
+	if(remove_temp)
+		unlink(w.temp.c_str());
+	#elif defined _WIN32
+	if(w.fd != INVALID_HANDLE_VALUE)
+		CloseHandle(w.fd);
+	w.fd = INVALID_HANDLE_VALUE;
+
+	if(remove_temp)
+		DeleteFileW(w.temp.c_str());
+	#endif
+}
+
+void vfs_write_init()
+{
+	context = new vfs_write_context();
+}
+
+void vfs_write_shutdown()
+{
+	for(auto& w : context->writers)
+	{
+		if(!w)
+			continue;
+
+		log::warn("vfs: discarding uncommitted write to {}", w->target.string());
+		writer_close(*w, true);
+		buffer_free(w->buffer);
+	}
+
+	delete context;
+	context = nullptr;
+}
+
+vfs_wfd vfs_create(const vfs_path& p, u64 size_hint, u32 flags)
+{
+	auto w = std::make_unique<writer_t>();
+	w->target = vfs_resolve_write_path(p);
+	w->direct = flags & VFS_CREATE_DIRECT;
+
+	vfs_wfd handle;
+	{
+		std::scoped_lock<std::mutex> lock{context->lock};
+		if(context->free_slots.empty())
+		{
+			handle = static_cast<vfs_wfd>(context->writers.size());
+			context->writers.emplace_back();
+		}
+		else
+		{
+			handle = context->free_slots.back();
+			context->free_slots.pop_back();
+		}
+	}
+
+	// the temporary sits next to the target so the final rename never crosses filesystems,
+	// the pid keeps processes writing the same target apart, a leftover with this name is from a dead process that had it
+	w->temp = w->target;
+	#if defined _WIN32
+	w->temp += std::format(".{}.{}.tmp", GetCurrentProcessId(), handle);
+	DeleteFileW(w->temp.c_str());
+	#else
+	w->temp += std::format(".{}.{}.tmp", getpid(), handle);
+	unlink(w->temp.c_str());
+	#endif
+
+	#if defined __linux__
+	const int native_flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+	if(w->direct)
+	{
+		w->fd = open(w->temp.c_str(), native_flags | O_DIRECT, 0644);
+
+		// not every filesystem supports O_DIRECT, tmpfs for one
+		if(w->fd < 0 && errno == EINVAL)
+			w->direct = false;
+	}
+
+	if(w->fd < 0)
+		w->fd = open(w->temp.c_str(), native_flags, 0644);
+
+	if(w->fd < 0)
+	{
+		log::error("vfs_create: failed to create {}: {}", w->temp.string(), errno);
+		std::scoped_lock<std::mutex> lock{context->lock};
+		context->free_slots.push_back(handle);
+		return -1;
+	}
+
+	if(size_hint && fallocate(w->fd, 0, 0, static_cast<off_t>(size_hint)) < 0 && errno != EOPNOTSUPP)
+		log::warn("vfs_create: preallocating {} bytes for {} failed: {}", size_hint, w->temp.string(), errno);
+	#elif defined _WIN32
+	w->fd = CreateFileW
+	(
+		w->temp.c_str(),
+		GENERIC_WRITE,
+		0,
+		nullptr,
+		CREATE_NEW,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN | (w->direct ? FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH : 0),
+		0
+	);
+
+	if(w->fd == INVALID_HANDLE_VALUE)
+	{
+		log::error("vfs_create: failed to create {}: {}", w->temp.string(), GetLastError());
+		std::scoped_lock<std::mutex> lock{context->lock};
+		context->free_slots.push_back(handle);
+		return -1;
+	}
+
+	if(size_hint)
+	{
+		FILE_ALLOCATION_INFO alloc_info;
+		alloc_info.AllocationSize.QuadPart = static_cast<LONGLONG>(size_hint);
+		SetFileInformationByHandle(w->fd, FileAllocationInfo, &alloc_info, sizeof(alloc_info));
+	}
+	#else
+	static_assert(false, "vfs_create not implemented");
+	#endif
+
+	w->buffer = buffer_alloc();
+
+	std::scoped_lock<std::mutex> lock{context->lock};
+	context->writers[handle] = std::move(w);
+	return handle;
+}
+
+bool vfs_write(vfs_wfd fd, const void* data, size_t size)
+{
+	writer_t* w = get_writer(fd);
+	if(!w || w->failed)
+		return false;
+
+	const auto* src = reinterpret_cast<const u8*>(data);
+	while(size)
+	{
+		const size_t count = std::min(size, VFS_WRITE_BUFFER_SIZE - w->buffer_used);
+		std::memcpy(w->buffer + w->buffer_used, src, count);
+		w->buffer_used += count;
+		src += count;
+		size -= count;
+
+		if(w->buffer_used == VFS_WRITE_BUFFER_SIZE && !writer_flush(*w))
+			return false;
+	}
+
+	return true;
+}
+
+bool vfs_commit(vfs_wfd fd)
+{
+	writer_t* w = get_writer(fd);
+	if(!w)
+		return false;
+
+	bool ok = writer_flush(*w);
+
+	#if defined __linux__
+	// drops padding from the last direct write and any preallocated tail
+	if(ok && ftruncate(w->fd, static_cast<off_t>(w->written)) < 0)
+	{
+		log::error("vfs_commit: truncating {} failed: {}", w->temp.string(), errno);
+		ok = false;
+	}
+
+	if(ok && fdatasync(w->fd) < 0)
+	{
+		log::error("vfs_commit: syncing {} failed: {}", w->temp.string(), errno);
+		ok = false;
+	}
+
+	writer_close(*w, !ok);
+
+	if(ok && rename(w->temp.c_str(), w->target.c_str()) < 0)
+	{
+		log::error("vfs_commit: renaming {} to {} failed: {}", w->temp.string(), w->target.string(), errno);
+		unlink(w->temp.c_str());
+		ok = false;
+	}
+
+	// make the rename itself durable
+	if(ok)
+	{
+		int dir = open(w->target.has_parent_path() ? w->target.parent_path().c_str() : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(dir >= 0)
+		{
+			fsync(dir);
+			close(dir);
+		}
+	}
+	#elif defined _WIN32
+	if(ok)
+	{
+		FILE_END_OF_FILE_INFO eof_info;
+		eof_info.EndOfFile.QuadPart = static_cast<LONGLONG>(w->written);
+		if(!SetFileInformationByHandle(w->fd, FileEndOfFileInfo, &eof_info, sizeof(eof_info)) || !FlushFileBuffers(w->fd))
+		{
+			log::error("vfs_commit: finishing {} failed: {}", w->temp.string(), GetLastError());
+			ok = false;
+		}
+	}
+
+	writer_close(*w, !ok);
+
+	if(ok && !MoveFileExW(w->temp.c_str(), w->target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		log::error("vfs_commit: renaming {} to {} failed: {}", w->temp.string(), w->target.string(), GetLastError());
+		DeleteFileW(w->temp.c_str());
+		ok = false;
+	}
+	#endif
+
+	writer_release(fd);
+
+	// the new file shadows whatever the path resolved to before, packed copies included
+	if(ok)
+		vfs_flush_path_cache();
+
+	return ok;
+}
+
+void vfs_discard(vfs_wfd fd)
+{
+	writer_t* w = get_writer(fd);
+	if(!w)
+		return;
+
+	writer_close(*w, true);
+	writer_release(fd);
+}
+
+}
@@ -76,7 +76,7 @@ void wm_poll_events()
 			break;
 		}
 		default:
-			input_dispatch_event(event);
+			input_queue_event(event);
 			break;
 		}
 	}
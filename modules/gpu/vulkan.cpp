@@ -1,5 +1,6 @@
 #include <penumbra/gpu.hpp>
 #include <penumbra/shader.hpp>
+#include <penumbra/profile.hpp>
 #include <penumbra/types.hpp>
 #include <penumbra/panic.hpp>
 #include <penumbra/log.hpp>
@@ -10,7 +11,6 @@
 #include <vulkan/vk_enum_string_helper.h>
 #include <SDL3/SDL_vulkan.h>
 #include <SDL3/SDL_error.h>
-#include <tracy/Tracy.hpp>
 
 #include <algorithm>
 #include <array>
@@ -20,6 +20,7 @@
 #include <optional>
 #include <queue>
 #include <span>
+#include <thread>
 #include <vector>
 
 namespace penumbra
@@ -125,6 +126,8 @@ struct GPUBuffer
 	VkDeviceMemory allocation;
 	void* mapped;
 	size_t size;
+	GPUMemoryHeap heap;
+	VkDeviceSize allocation_size;
 };
 
 struct ImageViewInfo
@@ -140,6 +143,7 @@ struct GPUTextureData
 	uvec3 size;
 	GPUFormat format;
 	std::vector<ImageViewInfo> views;
+	VkDeviceSize allocation_size;
 };
 
 struct gpu_context_t
@@ -176,10 +180,26 @@ struct gpu_context_t
 	bool swapchain_dirty;
 
 	GPUProperties props;
+	std::array<GPUMemoryStats, 4> heap_stats;
 };
 
 static gpu_context_t* gpu_context = nullptr;
 
+static void heap_track_alloc(GPUMemoryHeap heap, VkDeviceSize size)
+{
+	auto& stats = gpu_context->heap_stats[heap];
+	stats.current += size;
+	stats.peak = std::max(stats.peak, stats.current);
+	stats.allocations++;
+}
+
+static void heap_track_free(GPUMemoryHeap heap, VkDeviceSize size)
+{
+	auto& stats = gpu_context->heap_stats[heap];
+	stats.current -= size;
+	stats.frees++;
+}
+
 static std::vector<VkDeviceQueueCreateInfo> vulkan_device_create_queues()
 {
 	u32 qf_count{0};
@@ -346,7 +366,7 @@ static bool vulkan_create_device(std::span<VkPhysicalDevice> phys_devices, int i
 
 	vkGetPhysicalDeviceProperties2(gpu_context->phys_device, &props);
 
-	log::info("gpu_vulkan: selected render device: {}", std::string_view{props.properties.deviceName});
+	PENUMBRA_LOG_INFO("gpu_vulkan: selected render device: {}", std::string_view{props.properties.deviceName});
 	gpu_context->props.device_name = std::string{props.properties.deviceName};
 	auto queue_ci = vulkan_device_create_queues();
 
@@ -480,7 +500,7 @@ static bool vulkan_create_device(std::span<VkPhysicalDevice> phys_devices, int i
 	for(u32 i = 0; i < device_ci.enabledExtensionCount; i++)
 		ext_msg += std::format("\n\t{}", device_ci.ppEnabledExtensionNames[i]);
 
-	log::info("gpu_vulkan: device extensions: {}", ext_msg);
+	PENUMBRA_LOG_INFO("gpu_vulkan: device extensions: {}", ext_msg);
 
 	auto status = vkCreateDevice(gpu_context->phys_device, &device_ci, nullptr, &gpu_context->device);
 	if(status != VK_SUCCESS)
@@ -540,7 +560,7 @@ static bool vulkan_context_init()
 	for(u32 i = 0; i < instance_info.enabledExtensionCount; i++)
 		ext_msg += std::format("\n\t{}", instance_info.ppEnabledExtensionNames[i]);
 
-	log::info("gpu_vulkan: instance extensions: {}", ext_msg);
+	PENUMBRA_LOG_INFO("gpu_vulkan: instance extensions: {}", ext_msg);
 
 	if(vkCreateInstance(&instance_info, nullptr, &gpu_context->instance) != VK_SUCCESS)
 	{
@@ -573,7 +593,7 @@ static bool vulkan_context_init()
 		vkGetPhysicalDeviceProperties2(phys_devices[i], &props);
 		devlist_msg += std::format("\n\t{}: {}", i, std::string_view{props.properties.deviceName});
 	}
-	log::info("gpu_vulkan: enumerated render devices: {}", devlist_msg);
+	PENUMBRA_LOG_INFO("gpu_vulkan: enumerated render devices: {}", devlist_msg);
 
 	if(vulkan_create_device(phys_devices))
 		return true;
@@ -790,14 +810,6 @@ static std::optional<u32> get_memory_type(u32 type, VkMemoryPropertyFlags flags)
 
 GPUPointer gpu_allocate_memory(size_t size, GPUMemoryHeap heap, GPUBufferUsage usage)
 {
-	constexpr const char* heap_names[] = 
-	{
-		"HOST",
-		"PRIVATE",
-		"MAPPED",
-		"READBACK"
-	};
-
 	std::array<u32, 3> indices;
 	indices[0] = gpu_context->queue_data[0].family;
 	indices[1] = gpu_context->queue_data[1].family;
@@ -885,7 +897,8 @@ GPUPointer gpu_allocate_memory(size_t size, GPUMemoryHeap heap, GPUBufferUsage u
 	if(heap != GPU_MEMORY_PRIVATE)
 		vkMapMemory(gpu_context->device, mem, 0, size, 0, &ptr);
 
-	gpu_context->buffers.emplace_back(buf, mem, ptr, size);
+	gpu_context->buffers.emplace_back(buf, mem, ptr, size, heap, mem_req.memoryRequirements.size);
+	heap_track_alloc(heap, mem_req.memoryRequirements.size);
 	auto handle = gpu_context->buffers.size();
 
 	return {handle, 0};
@@ -898,6 +911,7 @@ void gpu_free_memory(GPUPointer& ptr)
 
 	vkDestroyBuffer(gpu_context->device, buffer.handle, nullptr);
 	vkFreeMemory(gpu_context->device, buffer.allocation, nullptr);
+	heap_track_free(buffer.heap, buffer.allocation_size);
 }
 
 GPUDevicePointer gpu_host_to_device_pointer(const GPUPointer& ptr)
@@ -1014,7 +1028,8 @@ GPUTexture gpu_create_texture(const GPUTextureDesc& desc)
 		return GPUTexture{0u};
 	}
 
-	gpu_context->textures.push_back(GPUTextureData{handle, memory, desc.dim, desc.format});
+	gpu_context->textures.push_back(GPUTextureData{handle, memory, desc.dim, desc.format, {}, mem_req.size});
+	heap_track_alloc(GPU_MEMORY_PRIVATE, mem_req.size);
 	return GPUTexture{static_cast<u32>(gpu_context->textures.size() - 1)};
 }
 
@@ -1028,6 +1043,7 @@ void gpu_destroy_texture(GPUTexture tex)
 
 	vkDestroyImage(gpu_context->device, tex_info.handle, nullptr);
 	vkFreeMemory(gpu_context->device, tex_info.allocation, nullptr);
+	heap_track_free(GPU_MEMORY_PRIVATE, tex_info.allocation_size);
 }
 
 static VkImageView get_or_create_image_view(GPUTextureData& tex, const GPUViewDesc& desc)
@@ -1203,7 +1219,7 @@ void gpu_free_descriptor(GPUTextureDescriptor descriptor)
 
 GPUCommandBuffer gpu_record_commands(GPUQueue queue)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 	assert(queue > GPU_QUEUE_INVALID);
 	auto& qd = gpu_context->queue_data[queue - 1];
 	auto thread = 0u; //FIXME 
@@ -1252,7 +1268,7 @@ GPUCommandBuffer gpu_record_commands(GPUQueue queue)
 
 u64 gpu_submit(GPUQueue queue, GPUCommandBuffer& cmd)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 	assert(queue > GPU_QUEUE_INVALID);
 
 	cmd.bound_pipe = nullptr;
@@ -1337,7 +1353,7 @@ u64 gpu_submit(GPUQueue queue, GPUCommandBuffer& cmd)
 
 bool gpu_wait_queue(GPUQueue queue, u64 timeline)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 	assert(queue > GPU_QUEUE_INVALID);
 
 	const VkSemaphoreWaitInfo wait
@@ -1364,7 +1380,7 @@ bool gpu_wait_queue(GPUQueue queue, u64 timeline)
 
 void gpu_wait_idle()
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 	vkDeviceWaitIdle(gpu_context->device);
 }
 
@@ -2349,7 +2365,7 @@ void gpu_swapchain_init(window_t wnd)
 GPUTexture gpu_swapchain_acquire_next(GPUSemaphore sem)
 {
 	assert(sem);
-	ZoneScoped;
+	PROFILE_ZONE;
 	u32 image_index{0};
 	
 	do
@@ -2380,7 +2396,7 @@ GPUTexture gpu_swapchain_acquire_next(GPUSemaphore sem)
 
 void gpu_swapchain_present(GPUQueue queue, GPUSemaphore sem)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 	assert(queue > GPU_QUEUE_INVALID);
 	assert(sem);
 	VkSemaphore present_sem = gpu_context->semaphores[sem - 1];
@@ -2428,4 +2444,9 @@ const GPUProperties& gpu_get_properties()
 	return gpu_context->props;
 }
 
+GPUMemoryStats gpu_get_memory_stats(GPUMemoryHeap heap)
+{
+	return gpu_context->heap_stats[heap];
+}
+
 }
@@ -4,6 +4,7 @@
 #include <penumbra/math/transform.hpp>
 #include <penumbra/types.hpp>
 #include <cassert>
+#include <mutex>
 #include <vector>
 
 namespace penumbra
@@ -12,6 +13,7 @@ namespace penumbra
 physicsBodyID physics_create_body(const physicsBodyDesc& desc)
 {
 	auto& world = physics_world_get();
+	std::scoped_lock<std::mutex> lock{world.lock};
 	u32 bodyid;
 
 	if(world.body_id_freelist.empty())
@@ -33,6 +35,10 @@ physicsBodyID physics_create_body(const physicsBodyDesc& desc)
 	body.motion_type = desc.motion_type;
 	body.mass = 0.0f;
 	body.inertia = mat3::identity();
+	body.transform = desc.initial_transform;
+	body.moved = false;
+	body.snapshot_ticks = 0;
+	body.alive = true;
 	body.userdata = desc.userdata;
 
 	return physics_bodyid_new(bodyid, body.generation);
@@ -40,13 +46,26 @@ physicsBodyID physics_create_body(const physicsBodyDesc& desc)
 
 void physics_destroy_body(physicsBodyID id)
 {
+	auto& world = physics_world_get();
+	std::scoped_lock<std::mutex> lock{world.lock};
+
 	auto& body = physics_body_get(id);
 	u32 handle = physics_bodyid_handle(id);
-	auto& world = physics_world_get();
+	body.alive = false;
 
 	world.body_id_freelist.push_back(handle);
 }
 
+void physics_body_set_transform(physicsBodyID id, const Transform& transform)
+{
+	auto& world = physics_world_get();
+	std::scoped_lock<std::mutex> lock{world.lock};
+
+	auto& body = physics_body_get(id);
+	body.transform = transform;
+	body.moved = true;
+}
+
 physicsBody& physics_body_get(physicsBodyID id)
 {
 	u32 handle = physics_bodyid_handle(id);
@@ -18,6 +18,12 @@ struct physicsBody
 
 	physicsShapeID shape;
 
+	Transform transform;
+	// set whenever the transform changes, the body then goes into the next two snapshots so both ticks interpolated between have it
+	bool moved{false};
+	u8 snapshot_ticks{0};
+	bool alive{false};
+
 	u64 userdata;
 };
 
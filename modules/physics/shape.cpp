@@ -3,6 +3,7 @@
 #include <physics/world.hpp>
 #include <penumbra/physics.hpp>
 #include <penumbra/types.hpp>
+#include <mutex>
 #include <vector>
 
 namespace penumbra
@@ -54,6 +55,7 @@ physicsShape& physics_shape_get(physicsShapeID id)
 
 physicsShapeID physics_create_sphere(physicsBodyID body, const physicsShapeDesc& desc, const physicsSphere& sphere)
 {
+	std::scoped_lock<std::mutex> lock{physics_world_get().lock};
 	auto& shape = physics_shape_new(body, desc);
 	shape.type = PHYSICS_SHAPE_SPHERE;
 	shape.sphere = sphere;
@@ -64,6 +66,7 @@ physicsShapeID physics_create_sphere(physicsBodyID body, const physicsShapeDesc&
 
 physicsShapeID physics_create_capsule(physicsBodyID body, const physicsShapeDesc& desc, const physicsCapsule& capsule)
 {
+	std::scoped_lock<std::mutex> lock{physics_world_get().lock};
 	auto& shape = physics_shape_new(body, desc);
 	shape.type = PHYSICS_SHAPE_CAPSULE;
 	shape.capsule = capsule;
@@ -74,6 +77,7 @@ physicsShapeID physics_create_capsule(physicsBodyID body, const physicsShapeDesc
 
 physicsShapeID physics_create_hull(physicsBodyID body, const physicsShapeDesc& desc, const physicsHull& hull)
 {
+	std::scoped_lock<std::mutex> lock{physics_world_get().lock};
 	auto& shape = physics_shape_new(body, desc);
 	shape.type = PHYSICS_SHAPE_HULL;
 	shape.hull = &hull;
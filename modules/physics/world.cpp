@@ -2,8 +2,12 @@
 #include <physics/shape.hpp>
 #include <physics/world.hpp>
 #include <penumbra/physics.hpp>
+#include <penumbra/sim.hpp>
 #include <penumbra/types.hpp>
+#include <algorithm>
 #include <cassert>
+#include <mutex>
+#include <vector>
 
 namespace penumbra
 {
@@ -22,6 +26,39 @@ void physics_destroy_world()
 
 void physics_world_simulate(float dt, int substeps)
 {
+	std::scoped_lock<std::mutex> lock{world->lock};
+
+	// nothing tracks rest yet, every body the step owns counts as moved so the snapshot carries it
+	for(auto& body : world->bodies)
+	{
+		if(body.alive && body.body_type == PHYSICS_BODY_DYNAMIC)
+			body.moved = true;
+	}
+}
+
+void physics_world_write_transforms(std::vector<sim_transform>& out)
+{
+	std::scoped_lock<std::mutex> lock{world->lock};
+
+	for(auto& body : world->bodies)
+	{
+		if(!body.alive || body.body_type == PHYSICS_BODY_STATIC)
+			continue;
+
+		if(body.moved)
+		{
+			body.moved = false;
+			body.snapshot_ticks = 2u;
+		}
+
+		if(!body.snapshot_ticks)
+			continue;
+
+		body.snapshot_ticks--;
+		out.push_back({body.userdata, body.transform});
+	}
+
+	std::sort(out.begin(), out.end(), [](const sim_transform& a, const sim_transform& b){ return a.id < b.id; });
 }
 
 physicsWorld& physics_world_get()
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <penumbra/allocator.hpp>
 #include <penumbra/physics.hpp>
 #include <penumbra/types.hpp>
+#include <mutex>
 #include <vector>
 
 struct physicsBody;
@@ -12,12 +14,15 @@ namespace penumbra
 
 struct physicsWorld
 {
-	std::vector<physicsBody> bodies;
-	std::vector<u32> body_id_freelist;
+	// held by simulate and everything that adds or removes bodies and shapes, so the editor can do that while the sim thread ticks
+	std::mutex lock;
+
+	tagged_vector<physicsBody, MEMORY_TAG_PHYSICS> bodies;
+	tagged_vector<u32, MEMORY_TAG_PHYSICS> body_id_freelist;
 	u32 next_body_id = 1u;
 
-	std::vector<physicsShape> shapes;
-	std::vector<u32> shape_id_freelist;
+	tagged_vector<physicsShape, MEMORY_TAG_PHYSICS> shapes;
+	tagged_vector<u32, MEMORY_TAG_PHYSICS> shape_id_freelist;
 	u32 next_shape_id = 1u;
 };
 
@@ -17,7 +17,7 @@ GPUTextureDescriptor renderer_brdf_init()
 		.color_targets = {GPU_FORMAT_RG16_SFLOAT}
 	});
 
-	log::info("renderer: generating BRDF lookup table: 512x512 1024 integration steps");
+	PENUMBRA_LOG_INFO("renderer: generating BRDF lookup table: 512x512 1024 integration steps");
 	brdflut_tex = gpu_create_texture
 	({
 		.dim = {512u, 512u, 1u},
@@ -7,6 +7,7 @@
 #include <penumbra/ui.hpp>
 #include <penumbra/cvar.hpp>
 #include <penumbra/config.hpp>
+#include <penumbra/profile.hpp>
 #include <penumbra/types.hpp>
 #include <renderer/bloom.hpp>
 #include <renderer/brdf.hpp>
@@ -16,8 +17,6 @@
 #include <renderer/world.hpp>
 #include <renderer/visbuffer.hpp>
 
-#include <tracy/Tracy.hpp>
-
 #include <cassert>
 #include <cmath>
 
@@ -34,6 +33,9 @@ struct renderer_context_t
 	int frame_index;
 	u32 frame_counter{0};
 
+	frame_arena_t frame_arena;
+	frame_arena_resource frame_resource{&frame_arena};
+
 	GPUSemaphore swapchain_acquire[config::renderer_frames_in_flight];
 	GPUSemaphore swapchain_present[config::renderer_frames_in_flight];
 
@@ -90,7 +92,8 @@ static cvar_t pr_mode
 	.type = CVAR_TYPE_INT,
 	.int_defv = 2,
 	.int_v = 2,
-	.callback = set_pmode_cvar
+	.callback = set_pmode_cvar,
+	.flags = CVAR_FLAG_DEFERRED
 };
 
 static cvar_t wnd_mode
@@ -99,7 +102,8 @@ static cvar_t wnd_mode
 	.type = CVAR_TYPE_INT,
 	.int_defv = 0,
 	.int_v = 0,
-	.callback = set_wndmode_cvar
+	.callback = set_wndmode_cvar,
+	.flags = CVAR_FLAG_DEFERRED
 };
 
 static void renderer_init_rendertargets()
@@ -189,6 +193,7 @@ void renderer_init(window_t wnd)
 {
 	renderer = new renderer_context_t();
 	renderer->window = wnd;
+	frame_arena_create(renderer->frame_arena, config::renderer_frames_in_flight, 4ull * 1024ull * 1024ull, "renderer_frame", MEMORY_TAG_RENDERER);
 	
 	cvar_register(&vb_debug);
 	cvar_register(&pr_mode);
@@ -257,6 +262,7 @@ void renderer_shutdown()
 		gpu_destroy_semaphore(renderer->swapchain_present[i]);
 	}
 
+	frame_arena_destroy(renderer->frame_arena);
 	delete renderer;
 
 	gpu_shutdown();
@@ -264,7 +270,7 @@ void renderer_shutdown()
 
 void renderer_next_frame()
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	if(renderer->render_resolution != renderer->last_render_resolution)
 	{
@@ -281,6 +287,11 @@ void renderer_next_frame()
 		panic("renderer: gfx queue stuck");
 
 	gpu_wait_queue(GPU_QUEUE_COMPUTE, renderer->compute_queue_frames[renderer->frame_index]);
+	frame_arena_next(renderer->frame_arena);
+
+	// nothing of the previous frames is being recorded anymore, swapchain and window changes are safe here
+	cvar_flush();
+
 	renderer->cur_swapchain = gpu_swapchain_acquire_next(renderer->swapchain_acquire[renderer->frame_index]);
 	renderer->frame_counter++;
 }
@@ -389,7 +400,7 @@ static void renderer_try_compose_swapchain(GPUCommandBuffer& cmd)
 
 void renderer_process_frame(double dt)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	renderer_resource_copy_async();
 
@@ -465,6 +476,16 @@ u32 renderer_gfx_frame_index()
 	return renderer->frame_index;
 }
 
+arena_t& renderer_frame_arena()
+{
+	return frame_arena_current(renderer->frame_arena);
+}
+
+std::pmr::memory_resource* renderer_frame_resource()
+{
+	return &renderer->frame_resource;
+}
+
 uvec2 renderer_get_render_resolution()
 {
 	return renderer->render_resolution;
@@ -486,7 +507,7 @@ void renderer_update_camera(const render_camera_data& data)
 	vbconst->camera = data.view * data.proj;
 	vbconst->view = data.view;
 	vbconst->inv_proj = mat4::inverse(data.proj);
-	vbconst->inv_view = mat4::inverse(data.view);
+	vbconst->inv_view = mat4::inverse_affine(data.view);
 	vbconst->cam_pos = vec4{data.position, 1.0f};
 	vbconst->exposure = data.exposure;
 	vbconst->cluster_scale = 24.0f / std::log2f(data.zfar / data.znear);
@@ -1,9 +1,11 @@
 #include <renderer/resource.hpp>
 #include <penumbra/types.hpp>
 #include <penumbra/gpu.hpp>
+#include <penumbra/renderer.hpp>
 #include <penumbra/log.hpp>
 #include <penumbra/panic.hpp>
 
+#include <algorithm>
 #include <format>
 #include <vector>
 
@@ -39,8 +41,9 @@ struct renderer_resource_state
 	u64 transfer_sync{0u};
 
 	std::vector<streambuffer_chunk> streambuffer;
-	std::vector<buffer_write_request> bufwrites;
-	std::vector<texture_write_request> texwrites;
+	// frame arena backed, both are rebuilt once the copies are recorded
+	std::pmr::vector<buffer_write_request> bufwrites{renderer_frame_resource()};
+	std::pmr::vector<texture_write_request> texwrites{renderer_frame_resource()};
 
 	GPUPointer geometry_vertex_pos;
 	GPUPointer geometry_vertex_uv;
@@ -83,7 +86,7 @@ void renderer_resource_state_init()
 		0u, 0u
 	});
 	
-	log::info("renderer: streambuffer size {} KB", state->streambuffer.size() * streambuffer_chunk::size / 1024);
+	PENUMBRA_LOG_INFO("renderer: streambuffer size {} KB", state->streambuffer.size() * streambuffer_chunk::size / 1024);
 
 	state->geometry_vertex_pos = gpu_allocate_memory(state->geom_vertex_capacity * sizeof(geom_position_format));
 	state->geometry_vertex_uv = gpu_allocate_memory(state->geom_vertex_capacity * sizeof(geom_uv_format));
@@ -143,14 +146,14 @@ void renderer_resource_copy_async()
 	for(auto& write : state->bufwrites)
 		gpu_mem_copy(cmd, write.src, write.dst, write.size);
 
-	state->bufwrites.clear();
+	state->bufwrites = std::pmr::vector<buffer_write_request>{renderer_frame_resource()};
 
 	for(auto& write : state->texwrites)
 	{
 		gpu_texture_layout_transition(cmd, write.texture, GPU_STAGE_NONE, GPU_STAGE_TRANSFER, GPU_TEXTURE_LAYOUT_UNDEFINED, GPU_TEXTURE_LAYOUT_GENERAL);
 		gpu_copy_to_texture(cmd, write.data, write.texture, write.num_mips, write.num_layers);
 	}
-	state->texwrites.clear();
+	state->texwrites = std::pmr::vector<texture_write_request>{renderer_frame_resource()};
 
 	state->transfer_sync++;
 	gpu_barrier(cmd, GPU_STAGE_TRANSFER, GPU_STAGE_ALL);
@@ -179,7 +182,7 @@ static streambuffer_chunk& stream_buffer_acquire(size_t size)
 		0u, 0u
 	});
 
-	log::info("renderer: streambuffer size {} KB", state->streambuffer.size() * streambuffer_chunk::size / 1024);
+	PENUMBRA_LOG_INFO("renderer: streambuffer size {} KB", state->streambuffer.size() * streambuffer_chunk::size / 1024);
 
 	return state->streambuffer.back();
 }
@@ -329,13 +332,44 @@ renderer_geometry_storage renderer_geometry_get_storage()
 	};
 }
 
-void renderer_write_texture(GPUTexture texture, std::span<const u8> data, u32 num_mips, u32 num_layers)
+std::span<u8> renderer_stage_texture(GPUTexture texture, size_t size, u32 num_mips, u32 num_layers)
 {
-	auto& stream_block = stream_buffer_acquire(data.size());
-	memcpy(gpu_map_memory(stream_block.data + stream_block.head), data.data(), data.size());
+	auto& stream_block = stream_buffer_acquire(size);
+	u8* staging = gpu_map_memory(stream_block.data + stream_block.head);
 	state->texwrites.push_back({stream_block.data + stream_block.head, texture, num_mips, num_layers});
-	stream_block.head += data.size();
+	stream_block.head += size;
 	stream_block.syncval = state->transfer_sync + 1;
+	return {staging, size};
+}
+
+void renderer_unstage_texture(GPUTexture texture, size_t size)
+{
+	// batched loads stage every texture before any data lands, the failed one is usually not the last
+	auto it = std::find_if(state->texwrites.rbegin(), state->texwrites.rend(), [texture](const texture_write_request& w){ return w.texture == texture; });
+	if(it == state->texwrites.rend())
+	{
+		log::warn("renderer_unstage_texture: texture [{}] has no staged write", texture);
+		return;
+	}
+
+	const GPUPointer data = it->data;
+	state->texwrites.erase(std::next(it).base());
+
+	// the chunk head only moves back if nothing was staged after it, otherwise the space is reclaimed with the chunk
+	for(auto& chunk : state->streambuffer)
+	{
+		if(chunk.data.handle == data.handle && chunk.data.offset + chunk.head == data.offset + size)
+		{
+			chunk.head -= static_cast<u32>(size);
+			break;
+		}
+	}
+}
+
+void renderer_write_texture(GPUTexture texture, std::span<const u8> data, u32 num_mips, u32 num_layers)
+{
+	auto staging = renderer_stage_texture(texture, data.size(), num_mips, num_layers);
+	memcpy(staging.data(), data.data(), data.size());
 }
 
 void renderer_write_material(u32 offset, const render_material_data& data)
@@ -54,6 +54,10 @@ u32 renderer_geometry_write_indices(const geom_index_format* data, u32 count);
 u32 renderer_geometry_write_clusters(const geom_cluster_format* data, u32 count);
 u32 renderer_geometry_write_lods(const geom_lod_format* data, u32 count);
 void renderer_write_texture(GPUTexture texture, std::span<const u8> data, u32 num_mips, u32 num_layers);
+// reserves upload memory for a texture write, it must be filled before the next renderer_resource_copy_async
+std::span<u8> renderer_stage_texture(GPUTexture texture, size_t size, u32 num_mips, u32 num_layers);
+// drops the staged copy of a texture for writes that could not be filled, upload memory is returned if it was staged last
+void renderer_unstage_texture(GPUTexture texture, size_t size);
 void renderer_write_material(u32 offset, const render_material_data& data);
 void renderer_write_bones(u32 offset, const mat4* data, u16 count);
 
@@ -92,7 +92,7 @@ void renderer_shadow_init(render_shadow_data& data)
 	data.max_cascades = CSM_CASCADES; 
 	data.cascades.resize(data.max_cascades);
 	
-	log::info("renderer_csm_init: {} cascades, {}x{} unorm16 shadowmap", data.max_cascades, CSM_DIM, CSM_DIM);	
+	PENUMBRA_LOG_INFO("renderer_csm_init: {} cascades, {}x{} unorm16 shadowmap", data.max_cascades, CSM_DIM, CSM_DIM);	
 
 	auto cmd = gpu_record_commands(GPU_QUEUE_GRAPHICS);
 	for(int i = 0; i < data.max_cascades; i++)
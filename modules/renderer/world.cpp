@@ -6,15 +6,14 @@
 #include <penumbra/resource.hpp>
 #include <penumbra/config.hpp>
 #include <penumbra/log.hpp>
+#include <penumbra/profile.hpp>
+#include <penumbra/sparse_set.hpp>
 #include <penumbra/types.hpp>
 #include <penumbra/math/plane.hpp>
 #include <penumbra/math/transform.hpp>
 
-#include <tracy/Tracy.hpp>
-
 #include <algorithm>
 #include <cassert>
-#include <map>
 #include <vector>
 
 namespace penumbra
@@ -91,11 +90,11 @@ struct render_world
 	GPUPointer host_objects;
 	GPUPointer objects;
 
-	std::vector<renderObjectID> dirty_objects;
+	// rebuilt after every upload so it never outlives its frame arena slot
+	std::pmr::vector<renderObjectID> dirty_objects{renderer_frame_resource()};
 	std::vector<render_view> views;
 
-	//FIXME: sparse set might be better?
-	std::map<renderObjectID, renderer_skinned_geometry_instance> sg_instances;
+	sparse_set<renderer_skinned_geometry_instance, renderObjectID> sg_instances;
 };
 
 static render_world* world = nullptr;;
@@ -146,6 +145,8 @@ void renderer_world_cleanup()
 
 	gpu_free_memory(world->objects);
 	gpu_free_memory(world->host_objects);
+
+	world->sg_instances.clear();
 	
 	delete world;
 	
@@ -192,7 +193,7 @@ renderViewID renderer_create_view(const render_view_desc& desc)
 
 void renderer_update_view(renderViewID id, const render_camera_data& cam)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	assert(id);
 
@@ -251,7 +252,7 @@ render_bucket determine_bucket(u32 mtl_flags)
 
 renderObjectID renderer_world_insert_object_internal(const render_object_desc& desc, array_proxy<renderViewID> views)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	if(world->object_count >= world->object_capacity)
 	{
@@ -279,7 +280,7 @@ renderObjectID renderer_world_insert_object_internal(const render_object_desc& d
 	{
 		auto sg_instance = renderer_geometry_instantiate_skin(vtx_offset, geom_data.vertex_count, resource_manager_get_skeleton(desc.skeleton).bone_count);
 		vtx_offset = sg_instance.vertex_offset;
-		world->sg_instances[handle] = sg_instance;
+		world->sg_instances.emplace(handle, sg_instance);
 	}
 
 	obj->sphere = geom_data.sphere;
@@ -315,7 +316,7 @@ renderObjectID renderer_world_insert_object_internal(const render_object_desc& d
 
 void renderer_world_update_object(renderObjectID object, const mat4& transform)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	assert(object);
 
@@ -329,7 +330,7 @@ void renderer_world_update_object(renderObjectID object, const mat4& transform)
 
 void renderer_world_update_skin(renderObjectID object, const mat4* bones, u16 count)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	assert(object);
 
@@ -360,7 +361,7 @@ static void renderer_world_skinning(GPUCommandBuffer& cmd)
 	} shader_data;
 
 	gpu_set_pipeline(cmd, skinning_cs);
-	for(auto& [obj, sm] : world->sg_instances)
+	for(auto& sm : world->sg_instances)
 	{
 		shader_data.vertex_skinned = skv + (sm.vertex_skinned_offset * sizeof(geom_skinned_format));
 		shader_data.vertex_pos = vpos + (sm.vertex_offset * sizeof(geom_position_format));
@@ -375,7 +376,7 @@ static void renderer_world_skinning(GPUCommandBuffer& cmd)
 
 void renderer_world_update(GPUCommandBuffer& cmd)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	renderer_world_skinning(cmd);
 
@@ -385,7 +386,7 @@ void renderer_world_update(GPUCommandBuffer& cmd)
 	if(world->dirty_objects.size() == world->object_count)
 	{
 		gpu_mem_copy(cmd, world->host_objects, world->objects, world->object_count * sizeof(render_object_data));
-		world->dirty_objects.clear();
+		world->dirty_objects = std::pmr::vector<renderObjectID>{renderer_frame_resource()};
 		return;
 	}
 
@@ -394,7 +395,7 @@ void renderer_world_update(GPUCommandBuffer& cmd)
 		auto offset = (handle - 1) * sizeof(render_object_data);
 		gpu_mem_copy(cmd, world->host_objects + offset, world->objects + offset, sizeof(render_object_data));
 	}
-	world->dirty_objects.clear();
+	world->dirty_objects = std::pmr::vector<renderObjectID>{renderer_frame_resource()};
 
 	gpu_barrier(cmd, GPU_STAGE_TRANSFER, GPU_STAGE_COMPUTE | GPU_STAGE_VERTEX_SHADER);
 }
@@ -597,7 +598,7 @@ static void renderer_world_generate_drawcalls(GPUCommandBuffer& cmd)
 
 void renderer_world_determine_visibility(GPUCommandBuffer& cmd)
 {
-	ZoneScopedN("r_viscull");
+	PROFILE_ZONE_N("r_viscull");
 
 	renderer_world_vis_prepare(cmd);
 	renderer_world_viscull_instances(cmd);
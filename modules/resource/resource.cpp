@@ -1,4 +1,6 @@
 #include <penumbra/resource.hpp>
+#include <penumbra/allocator.hpp>
+#include <penumbra/flat_map.hpp>
 #include <penumbra/gpu.hpp>
 #include <penumbra/hash.hpp>
 #include <penumbra/log.hpp>
@@ -8,10 +10,10 @@
 #include <renderer/resource.hpp>
 
 #include <algorithm>
+#include <array>
 #include <limits>
 #include <string>
 #include <utility>
-#include <unordered_map>
 #include <vector>
 
 using std::memcpy;
@@ -21,16 +23,16 @@ namespace penumbra
 
 struct resource_context
 {
-	std::vector<geometry_resource> geometry;
-	std::vector<texture_resource> texture;
-	std::vector<material_resource> material;
-	std::vector<animation_resource> animation;
-	std::vector<skeleton_resource> skeleton;
-
-	std::unordered_map<u32, ResourceID> geometry_cache;
-	std::unordered_map<u32, ResourceID> texture_cache;
-	std::unordered_map<u32, ResourceID> animation_cache;
-	std::unordered_map<u32, ResourceID> skeleton_cache;
+	tagged_vector<geometry_resource, MEMORY_TAG_RESOURCE> geometry;
+	tagged_vector<texture_resource, MEMORY_TAG_RESOURCE> texture;
+	tagged_vector<material_resource, MEMORY_TAG_RESOURCE> material;
+	tagged_vector<animation_resource, MEMORY_TAG_RESOURCE> animation;
+	tagged_vector<skeleton_resource, MEMORY_TAG_RESOURCE> skeleton;
+
+	flat_map<hashed_string, ResourceID> geometry_cache;
+	flat_map<hashed_string, ResourceID> texture_cache;
+	flat_map<hashed_string, ResourceID> animation_cache;
+	flat_map<hashed_string, ResourceID> skeleton_cache;
 };
 
 static resource_context* context = nullptr;
@@ -147,25 +149,12 @@ ResourceID resource_manager_import_skeleton(const skeleton_resource& data)
 	return resource_id_new(RESOURCE_TYPE_SKELETON, static_cast<u32>(context->skeleton.size()));
 }
 
-ResourceID resource_manager_load_geometry(const vfs_path& path)
+static ResourceID parse_geometry(const vfs_path& path, const u8* data)
 {
-	auto phash = fnv::hash(path.c_str());
-	if(context->geometry_cache.contains(phash))
-		return context->geometry_cache[phash];
-
-	auto file = vfs_open(path, VFS_ACCESS_READ);
-	if(file < 0)
-	{
-		log::error("resource_manager: loading geometry [{}] failed: could not open file", path.string());
-		return ResourceID{0};
-	}
-
-	const auto* data = vfs_map(file);
 	const auto* header = reinterpret_cast<const GeometryFileFormat::Header*>(data);
 	if(header->magic != GeometryFileFormat::fmt_magic || header->vmajor != GeometryFileFormat::fmt_major)
 	{
 		log::error("resource_manager: loading geometry [{}] failed: invalid file", path.string());
-		vfs_close(file);
 		return ResourceID{0};
 	}
 
@@ -212,93 +201,117 @@ ResourceID resource_manager_load_geometry(const vfs_path& path)
 	import_desc.cluster = reinterpret_cast<const geom_cluster_format*>(data + header->cluster_offset);
 	import_desc.lod = reinterpret_cast<const geom_lod_format*>(data + header->lod_offset);
 
-	auto rid = resource_manager_import_geometry(import_desc);
-	context->geometry_cache[phash] = rid;
-	vfs_close(file);
-	return rid;
+	return resource_manager_import_geometry(import_desc);
 }
 
-ResourceID resource_manager_load_texture(const vfs_path& path)
+// a created texture with upload memory reserved for its data, committed once the data has landed in staging
+struct texture_staging
 {
-	auto phash = fnv::hash(path.c_str());
-	if(context->texture_cache.contains(phash))
-		return context->texture_cache[phash];
-
-	auto file = vfs_open(path, VFS_ACCESS_READ);
-	if(file < 0)
-	{
-		log::error("resource_manager: loading texture [{}] failed: could not open file", path.string());
-		return ResourceID{0};
-	}
+	GPUTexture texture;
+	GPUViewDesc view;
+	std::span<u8> staging;
+	u32 data_offset;
+};
 
-	const auto* ptr = vfs_map(file);
-	const auto* header = reinterpret_cast<const TextureFileFormat::Header*>(ptr);
-	if(header->magic != TextureFileFormat::fmt_magic || header->vmajor != TextureFileFormat::fmt_major)
+static bool stage_texture(const vfs_path& path, const TextureFileFormat::Header& header, const TextureFileFormat::SubresourceDescription* res_table, texture_staging& out)
+{
+	if(header.magic != TextureFileFormat::fmt_magic || header.vmajor != TextureFileFormat::fmt_major)
 	{
 		log::error("resource_manager: loading texture [{}] failed: invalid file", path.string());
-		vfs_close(file);
-		return ResourceID{0};
+		return false;
 	}
 
-	const auto* res_table = reinterpret_cast<const TextureFileFormat::SubresourceDescription*>(ptr + header->subres_desc_offset);
 	u32 tex_size = 0u;
 	u32 num_mips = 0u;
 	u32 num_layers = 0u;
-	for(u32 l = 0; l < header->num_subres; l++)
+	for(u32 l = 0; l < header.num_subres; l++)
 	{
 		tex_size += res_table[l].data_size_bytes;
 		num_mips = std::max(num_mips, res_table[l].level + 1);
 		num_layers = std::max(num_layers, res_table[l].layer + 1);
 	}
 
-	GPUTexture tex = gpu_create_texture
+	out.view = {.type = num_layers == 6 ? GPU_TEXTURE_CUBE : GPU_TEXTURE_2D, .format = TextureFileFormat::parse_format(header.texformat)};
+	out.texture = gpu_create_texture
 	({
-		.type = num_layers == 6 ? GPU_TEXTURE_CUBE : GPU_TEXTURE_2D,
+		.type = out.view.type,
 		.dim = {res_table[0].width, res_table[0].height, 1u},
 		.mip_count = num_mips,
 		.layer_count = num_layers,
-		.format = TextureFileFormat::parse_format(header->texformat),
+		.format = out.view.format,
 		.usage = GPU_TEXTURE_SAMPLED
 	});
 
-	renderer_write_texture(tex, {ptr + res_table[0].data_offset, tex_size}, num_mips, num_layers);
+	out.staging = renderer_stage_texture(out.texture, tex_size, num_mips, num_layers);
+	out.data_offset = res_table[0].data_offset;
+	return true;
+}
 
-	GPUTextureDescriptor descriptor = gpu_texture_view_descriptor(tex, {.type = num_layers == 6 ? GPU_TEXTURE_CUBE : GPU_TEXTURE_2D, .format = TextureFileFormat::parse_format(header->texformat)});
+static ResourceID commit_texture(const vfs_path& path, const texture_staging& staged)
+{
+	GPUTextureDescriptor descriptor = gpu_texture_view_descriptor(staged.texture, staged.view);
 
 	context->texture.push_back
 	({
 		path.filename().string(),
-		tex,
+		staged.texture,
 		descriptor,
 		renderer_resource_transfer_syncval() + 1
 	});
 
-	auto rid = resource_id_new(RESOURCE_TYPE_TEXTURE, static_cast<u32>(context->texture.size()));
-	context->texture_cache[phash] = rid;
-	vfs_close(file);
-	return rid;
+	return resource_id_new(RESOURCE_TYPE_TEXTURE, static_cast<u32>(context->texture.size()));
 }
 
-ResourceID resource_manager_load_animation(const vfs_path& path)
+static void discard_texture(const vfs_path& path, const texture_staging& staged)
 {
-	auto phash = fnv::hash(path.c_str());
-	if(context->animation_cache.contains(phash))
-		return context->animation_cache[phash];
+	log::error("resource_manager: loading texture [{}] failed: could not read texture data", path.string());
+	renderer_unstage_texture(staged.texture, staged.staging.size());
+	gpu_destroy_texture(staged.texture);
+}
 
-	auto file = vfs_open(path, VFS_ACCESS_READ);
-	if(file < 0)
+static bool read_texture_header(const vfs_path& path, vfs_fd file, TextureFileFormat::Header& header, std::vector<TextureFileFormat::SubresourceDescription>& res_table)
+{
+	if(!vfs_read(file, reinterpret_cast<u8*>(&header), 0, sizeof(TextureFileFormat::Header)))
 	{
-		log::error("resource_manager: loading animation [{}] failed: could not open file", path.string());
-		return ResourceID{};
+		log::error("resource_manager: loading texture [{}] failed: invalid file", path.string());
+		return false;
+	}
+
+	res_table.resize(header.num_subres);
+	if(!header.num_subres || !vfs_read(file, reinterpret_cast<u8*>(res_table.data()), header.subres_desc_offset, res_table.size() * sizeof(TextureFileFormat::SubresourceDescription)))
+	{
+		log::error("resource_manager: loading texture [{}] failed: invalid file", path.string());
+		return false;
 	}
 
-	const auto* pdata = vfs_map(file);
+	return true;
+}
+
+// reads the texture data straight into upload memory, for compressed pack entries this skips decoding to a temporary
+static ResourceID stream_texture(const vfs_path& path, vfs_fd file)
+{
+	TextureFileFormat::Header header;
+	std::vector<TextureFileFormat::SubresourceDescription> res_table;
+	texture_staging staged;
+	if(!read_texture_header(path, file, header, res_table) || !stage_texture(path, header, res_table.data(), staged))
+		return ResourceID{0};
+
+	if(!vfs_read(file, staged.staging.data(), staged.data_offset, staged.staging.size()))
+	{
+		discard_texture(path, staged);
+		return ResourceID{0};
+	}
+
+	return commit_texture(path, staged);
+}
+
+static ResourceID parse_animation(const vfs_path& path, const u8* pdata)
+{
 	const auto* header = reinterpret_cast<const AnimationFileFormat::Header*>(pdata);
 
 	if(header->magic != AnimationFileFormat::fmt_magic || header->vmajor != AnimationFileFormat::fmt_major)
 	{
 		log::error("resource_manager: loading animation [{}] failed: invalid file", path.string());
-		vfs_close(file);
 		return ResourceID{};
 	}
 
@@ -341,32 +354,16 @@ ResourceID resource_manager_load_animation(const vfs_path& path)
 		memcpy(chn.values.data(), pdata + chan_table[i].value_offset, esize_for_path(chn.path) * chan_table[i].keyframe_count * sizeof(float));
 	}
 
-	auto rid = resource_manager_import_animation(anim);
-	context->animation_cache[phash] = rid;
-	vfs_close(file);
-	return rid;
+	return resource_manager_import_animation(anim);
 }
 
-ResourceID resource_manager_load_skeleton(const vfs_path& path)
+static ResourceID parse_skeleton(const vfs_path& path, const u8* pdata)
 {
-	auto phash = fnv::hash(path.c_str());
-	if(context->skeleton_cache.contains(phash))
-		return context->skeleton_cache[phash];
-
-	auto file = vfs_open(path, VFS_ACCESS_READ);
-	if(file < 0)
-	{
-		log::error("resource_manager: loading skeleton [{}] failed: could not open file", path.string());
-		return ResourceID{};
-	}
-
-	const auto* pdata = vfs_map(file);
 	const auto* header = reinterpret_cast<const SkeletonFileFormat::Header*>(pdata);
 
 	if(header->magic != SkeletonFileFormat::fmt_magic || header->vmajor != SkeletonFileFormat::fmt_major)
 	{
 		log::error("resource_manager: loading skeleton [{}] failed: invalid file", path.string());
-		vfs_close(file);
 		return ResourceID{};
 	}
 
@@ -393,12 +390,225 @@ ResourceID resource_manager_load_skeleton(const vfs_path& path)
 		skel.bone_inv_bind_matrices[i] = matrix_table[i];
 	}
 
-	auto rid = resource_manager_import_skeleton(skel);
-	context->skeleton_cache[phash] = rid;
+	return resource_manager_import_skeleton(skel);
+}
+
+struct resource_loader
+{
+	const char* name;
+	flat_map<hashed_string, ResourceID>& cache;
+	ResourceID (*parse)(const vfs_path& path, const u8* data);
+	ResourceID (*stream)(const vfs_path& path, vfs_fd file);
+};
+
+static resource_loader get_loader(resource_type type)
+{
+	switch(type)
+	{
+	case RESOURCE_TYPE_GEOMETRY:
+		return {"geometry", context->geometry_cache, parse_geometry, nullptr};
+	case RESOURCE_TYPE_TEXTURE:
+		return {"texture", context->texture_cache, nullptr, stream_texture};
+	case RESOURCE_TYPE_ANIMATION:
+		return {"animation", context->animation_cache, parse_animation, nullptr};
+	case RESOURCE_TYPE_SKELETON:
+		return {"skeleton", context->skeleton_cache, parse_skeleton, nullptr};
+	default:
+		std::unreachable();
+	}
+}
+
+// generic form so the same file reached with different separators shares one cache entry
+static hashed_string path_id(const vfs_path& path)
+{
+	return hashed_string{path.generic_string()};
+}
+
+static ResourceID load_resource(resource_type type, const vfs_path& path)
+{
+	auto loader = get_loader(type);
+
+	auto phash = path_id(path);
+	if(auto it = loader.cache.find(phash); it != loader.cache.end())
+		return it->second;
+
+	// resources are consumed front to back right after opening, prefault instead of taking a page fault every 4 KB
+	auto file = vfs_open(path, VFS_ACCESS_READ, VFS_HINT_SEQUENTIAL | VFS_HINT_POPULATE);
+	if(file < 0)
+	{
+		log::error("resource_manager: loading {} [{}] failed: could not open file", loader.name, path.string());
+		return ResourceID{0};
+	}
+
+	ResourceID rid{0};
+	if(loader.stream)
+	{
+		rid = loader.stream(path, file);
+	}
+	else if(const u8* data = vfs_map(file); data)
+	{
+		rid = loader.parse(path, data);
+	}
+	else
+	{
+		log::error("resource_manager: loading {} [{}] failed: could not read file", loader.name, path.string());
+	}
+
+	if(resource_get_handle(rid))
+		loader.cache[phash] = rid;
+
 	vfs_close(file);
 	return rid;
 }
 
+ResourceID resource_manager_load_geometry(const vfs_path& path)
+{
+	return load_resource(RESOURCE_TYPE_GEOMETRY, path);
+}
+
+ResourceID resource_manager_load_texture(const vfs_path& path)
+{
+	return load_resource(RESOURCE_TYPE_TEXTURE, path);
+}
+
+ResourceID resource_manager_load_animation(const vfs_path& path)
+{
+	return load_resource(RESOURCE_TYPE_ANIMATION, path);
+}
+
+ResourceID resource_manager_load_skeleton(const vfs_path& path)
+{
+	return load_resource(RESOURCE_TYPE_SKELETON, path);
+}
+
+// only the headers are read up front, the async reader then lands the texture data straight in upload memory
+static void load_texture_batch(array_proxy<vfs_path> paths)
+{
+	std::vector<vfs_read_request> requests;
+	std::vector<texture_staging> staged;
+	std::vector<hashed_string> hashes;
+	requests.reserve(paths.size());
+	staged.reserve(paths.size());
+
+	for(u32 i = 0; i < paths.size(); i++)
+	{
+		auto phash = path_id(paths[i]);
+		if(context->texture_cache.contains(phash) || std::ranges::find(hashes, phash) != hashes.end())
+			continue;
+
+		hashes.push_back(phash);
+
+		auto file = vfs_open(paths[i], VFS_ACCESS_READ);
+		if(file < 0)
+		{
+			log::error("resource_manager: loading texture [{}] failed: could not open file", paths[i].string());
+			continue;
+		}
+
+		TextureFileFormat::Header header;
+		std::vector<TextureFileFormat::SubresourceDescription> res_table;
+		texture_staging texture;
+		const bool valid = read_texture_header(paths[i], file, header, res_table) && stage_texture(paths[i], header, res_table.data(), texture);
+		vfs_close(file);
+
+		if(!valid)
+			continue;
+
+		// a zero size request reads the whole file, there is nothing to land in staging
+		if(texture.staging.empty())
+		{
+			context->texture_cache[phash] = commit_texture(paths[i], texture);
+			continue;
+		}
+
+		requests.push_back({.path = paths[i], .dst = texture.staging.data(), .offset = texture.data_offset, .size = texture.staging.size(), .user_data = staged.size()});
+		staged.push_back(texture);
+	}
+
+	const vfs_read_queue queue = vfs_read_queue_create();
+	vfs_read_submit(requests, queue);
+
+	std::array<vfs_read_completion, 32> completions;
+	size_t remaining = requests.size();
+	while(remaining)
+	{
+		size_t count = vfs_read_wait(completions, 1, queue);
+		for(size_t i = 0; i < count; i++)
+		{
+			const auto& path = requests[completions[i].user_data].path;
+			const auto& texture = staged[completions[i].user_data];
+			// reads are clamped to the file, a file cut short completes with less than the texture needs
+			if(completions[i].result < 0 || completions[i].size != texture.staging.size())
+			{
+				discard_texture(path, texture);
+				continue;
+			}
+
+			context->texture_cache[path_id(path)] = commit_texture(path, texture);
+		}
+
+		remaining -= count;
+	}
+
+	vfs_read_queue_destroy(queue);
+}
+
+void resource_manager_load_batch(resource_type type, array_proxy<vfs_path> paths)
+{
+	if(type == RESOURCE_TYPE_TEXTURE)
+	{
+		load_texture_batch(paths);
+		return;
+	}
+
+	auto loader = get_loader(type);
+
+	std::vector<vfs_read_request> requests;
+	std::vector<hashed_string> hashes;
+	requests.reserve(paths.size());
+
+	for(u32 i = 0; i < paths.size(); i++)
+	{
+		auto phash = path_id(paths[i]);
+		if(loader.cache.contains(phash) || std::ranges::find(hashes, phash) != hashes.end())
+			continue;
+
+		hashes.push_back(phash);
+		requests.push_back({.path = paths[i], .user_data = i});
+	}
+
+	// a private queue, other submitters' completions never show up here and ours never show up there
+	const vfs_read_queue queue = vfs_read_queue_create();
+	vfs_read_submit(requests, queue);
+
+	std::array<vfs_read_completion, 32> completions;
+	size_t remaining = requests.size();
+	while(remaining)
+	{
+		size_t count = vfs_read_wait(completions, 1, queue);
+		for(size_t i = 0; i < count; i++)
+		{
+			const auto& path = paths[completions[i].user_data];
+			// short reads complete with an error, a file cut off under the read is never parsed
+			if(completions[i].result < 0 || !completions[i].data)
+			{
+				log::error("resource_manager: loading {} [{}] failed: could not open file", loader.name, path.string());
+				continue;
+			}
+
+			auto rid = loader.parse(path, completions[i].data);
+			if(resource_get_handle(rid))
+				loader.cache[path_id(path)] = rid;
+
+			vfs_read_free(completions[i].data);
+		}
+
+		remaining -= count;
+	}
+
+	vfs_read_queue_destroy(queue);
+}
+
 geometry_resource& resource_manager_get_geometry(ResourceID rid)
 {
 	assert(resource_get_type(rid) == RESOURCE_TYPE_GEOMETRY);
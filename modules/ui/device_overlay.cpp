@@ -1,4 +1,5 @@
 #include <penumbra/ui.hpp>
+#include <penumbra/allocator.hpp>
 #include <penumbra/gpu.hpp>
 #include <penumbra/config.hpp>
 #include <penumbra/types.hpp>
@@ -6,7 +7,60 @@
 namespace penumbra::ui
 {
 
-void draw_device_overlay(uvec2 root)
+constexpr double memory_rate_interval = 0.5;
+constexpr float mb = 1.0f / (1024.0f * 1024.0f);
+
+// allocation rates are averaged over an interval, per frame they jump around too much to read
+struct memory_rate_state
+{
+	double last_sample{0.0};
+	u64 allocations[MEMORY_TAG_COUNT]{};
+	u64 allocated_bytes[MEMORY_TAG_COUNT]{};
+	float allocs_per_sec[MEMORY_TAG_COUNT]{};
+	float mb_per_sec[MEMORY_TAG_COUNT]{};
+};
+static memory_rate_state memory_rates;
+
+static void update_memory_rates()
+{
+	const double now = ImGui::GetTime();
+	const double elapsed = now - memory_rates.last_sample;
+	if(elapsed < memory_rate_interval)
+		return;
+
+	for(u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+	{
+		const memory_stats_t stats = memory_get_stats(static_cast<memory_tag>(tag));
+		memory_rates.allocs_per_sec[tag] = static_cast<float>(static_cast<double>(stats.allocations - memory_rates.allocations[tag]) / elapsed);
+		memory_rates.mb_per_sec[tag] = static_cast<float>(static_cast<double>(stats.allocated_bytes - memory_rates.allocated_bytes[tag]) / elapsed) * mb;
+		memory_rates.allocations[tag] = stats.allocations;
+		memory_rates.allocated_bytes[tag] = stats.allocated_bytes;
+	}
+
+	memory_rates.last_sample = now;
+}
+
+static void draw_memory_stats()
+{
+	update_memory_rates();
+
+	for(u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+	{
+		const memory_stats_t stats = memory_get_stats(static_cast<memory_tag>(tag));
+		const ImColor color = stats.budget && stats.current > stats.budget ? ImColor(220, 20, 20, 255) : ImColor(220, 220, 220, 255);
+		ImGui::TextColored(color, "%-8s %8.1f MB (peak %.1f) %6.0f allocs/s %6.1f MB/s", memory_tag_names[tag],
+			static_cast<float>(stats.current) * mb, static_cast<float>(stats.peak) * mb, memory_rates.allocs_per_sec[tag], memory_rates.mb_per_sec[tag]);
+	}
+
+	for(u32 heap = GPU_MEMORY_HOST; heap <= GPU_MEMORY_READBACK; heap++)
+	{
+		const GPUMemoryStats stats = gpu_get_memory_stats(static_cast<GPUMemoryHeap>(heap));
+		ImGui::Text("gpu %-8s %8.1f MB (peak %.1f) %llu live", gpu_memory_heap_names[heap],
+			static_cast<float>(stats.current) * mb, static_cast<float>(stats.peak) * mb, static_cast<unsigned long long>(stats.allocations - stats.frees));
+	}
+}
+
+void draw_device_overlay(uvec2 root, bool show_memory)
 {
 	const float fps = ImGui::GetIO().Framerate;
 	static bool p_open = true;
@@ -28,7 +82,10 @@ void draw_device_overlay(uvec2 root)
 		fps_color = ImColor(180, 220, 20, 255);
 
 	ImGui::TextColored(fps_color, "%.0f FPS (%.2f mspf)", fps, 1000.0f / fps);
-	
+
+	if(show_memory)
+		draw_memory_stats();
+
 	ImGui::End();
 	ImGui::PopStyleVar(2);
 }
@@ -6,10 +6,9 @@
 #include <penumbra/math/vector.hpp>
 #include <penumbra/gpu.hpp>
 #include <penumbra/shader.hpp>
+#include <penumbra/profile.hpp>
 #include <penumbra/types.hpp>
 
-#include <tracy/Tracy.hpp>
-
 #include <array>
 #include <cstring>
 #include <functional>
@@ -239,7 +238,7 @@ void imgui_backend_shutdown()
 
 void imgui_backend_render(GPUCommandBuffer& cmd, double dt)
 {
-	ZoneScoped;
+	PROFILE_ZONE;
 
 	ImGuiIO& io = ImGui::GetIO();
 	auto* bd = reinterpret_cast<imgui_backend_penumbra*>(io.BackendPlatformUserData);
@@ -259,7 +258,7 @@ void imgui_backend_render(GPUCommandBuffer& cmd, double dt)
 	platform_update_ime();
 
 	{
-		ZoneScopedN("user_hooks");
+		PROFILE_ZONE_N("user_hooks");
 		for(auto& hook : bd->hooks)
 			hook();
 	}
@@ -0,0 +1,16 @@
+#include <penumbra/log.hpp>
+
+#include <print>
+
+using namespace penumbra;
+
+int main(int argc, const char** argv)
+{
+	if(argc < 2)
+	{
+		std::println("Usage: log_decode [INPUT] [OUTPUT]");
+		return 0;
+	}
+
+	return log_decode_binary(argv[1], argc > 2 ? argv[2] : nullptr) ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include <penumbra/compress.hpp>
+#include <penumbra/types.hpp>
+#include <penumbra/vfs_pack.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace penumbra;
+using namespace std::literals::string_view_literals;
+
+struct PackInput
+{
+	std::filesystem::path source;
+	std::string name;
+	PackFileFormat::Entry entry;
+};
+
+// compresses every block independently, returns false if the result would not save enough space to be worth decoding
+static bool compress_entry(const std::vector<char>& data, std::vector<u8>& out)
+{
+	const auto* src = reinterpret_cast<const u8*>(data.data());
+	const u32 num_blocks = PackFileFormat::block_count(data.size());
+
+	std::vector<u64> block_offsets(num_blocks + 1);
+	out.resize(block_offsets.size() * sizeof(u64));
+	block_offsets[0] = out.size();
+
+	std::vector<u8> block(lz_compress_bound(PackFileFormat::block_size));
+	for(u32 b = 0; b < num_blocks; b++)
+	{
+		const size_t block_start = b * PackFileFormat::block_size;
+		const size_t raw_size = std::min<size_t>(PackFileFormat::block_size, data.size() - block_start);
+
+		size_t stored = lz_compress(src + block_start, raw_size, block.data(), block.size());
+		if(!stored || stored >= raw_size)
+			out.insert(out.end(), src + block_start, src + block_start + raw_size);
+		else
+			out.insert(out.end(), block.data(), block.data() + stored);
+
+		block_offsets[b + 1] = out.size();
+	}
+
+	std::memcpy(out.data(), block_offsets.data(), block_offsets.size() * sizeof(u64));
+
+	return out.size() + out.size() / 8 < data.size();
+}
+
+int main(int argc, const char** argv)
+{
+	bool compress = false;
+	if(argc > 1 && argv[1] == "-c"sv)
+	{
+		compress = true;
+		argc--;
+		argv++;
+	}
+
+	if(argc < 3)
+	{
+		std::println("Usage: pack_builder [-c] [INPUT_DIR] [OUTPUT]");
+		return 0;
+	}
+
+	std::filesystem::path input_dir{argv[1]};
+	std::filesystem::path output_path{argv[2]};
+
+	std::error_code ec;
+	if(!std::filesystem::is_directory(input_dir, ec))
+	{
+		std::println("{} is not a directory", argv[1]);
+		return 1;
+	}
+
+	std::vector<PackInput> inputs;
+	for(const auto& dirent : std::filesystem::recursive_directory_iterator{input_dir, ec})
+	{
+		if(!dirent.is_regular_file(ec))
+			continue;
+
+		PackInput input;
+		input.source = dirent.path();
+		input.name = dirent.path().lexically_relative(input_dir).generic_string();
+		input.entry.path_hash = PackFileFormat::hash_path(input.name);
+		input.entry.size = dirent.file_size(ec);
+		inputs.push_back(std::move(input));
+	}
+
+	if(ec)
+	{
+		std::println("failed to walk {}: {}", argv[1], ec.message());
+		return 1;
+	}
+
+	std::sort(inputs.begin(), inputs.end(), [](const PackInput& a, const PackInput& b)
+	{
+		return a.entry.path_hash < b.entry.path_hash;
+	});
+
+	for(size_t i = 1; i < inputs.size(); i++)
+	{
+		if(inputs[i].entry.path_hash == inputs[i - 1].entry.path_hash)
+		{
+			std::println("hash collision between {} and {}", inputs[i - 1].name, inputs[i].name);
+			return 1;
+		}
+	}
+
+	std::ofstream out{output_path, std::ios::binary};
+	if(!out)
+	{
+		std::println("failed to open {}", argv[2]);
+		return 1;
+	}
+
+	auto align_output = [&out]()
+	{
+		u64 pos = static_cast<u64>(out.tellp());
+		u64 aligned = (pos + PackFileFormat::entry_alignment - 1) & ~(PackFileFormat::entry_alignment - 1);
+		for(; pos < aligned; pos++)
+			out.put('\0');
+
+		return aligned;
+	};
+
+	PackFileFormat::Header header;
+	header.num_entries = static_cast<u32>(inputs.size());
+	out.seekp(sizeof(PackFileFormat::Header));
+
+	std::vector<char> buffer;
+	std::vector<u8> compressed;
+	u64 total_size = 0;
+	u64 total_stored = 0;
+
+	for(auto& input : inputs)
+	{
+		input.entry.offset = align_output();
+
+		std::ifstream in{input.source, std::ios::binary};
+		buffer.resize(input.entry.size);
+		if(!in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())))
+		{
+			std::println("failed to read {}", input.source.string());
+			return 1;
+		}
+
+		input.entry.stored_size = input.entry.size;
+		input.entry.flags = 0u;
+		input.entry.num_blocks = 0u;
+
+		if(compress && compress_entry(buffer, compressed))
+		{
+			input.entry.stored_size = compressed.size();
+			input.entry.flags = PackFileFormat::entry_compressed;
+			input.entry.num_blocks = PackFileFormat::block_count(input.entry.size);
+			out.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+		}
+		else
+		{
+			out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		}
+
+		total_size += input.entry.size;
+		total_stored += input.entry.stored_size;
+	}
+
+	header.toc_offset = align_output();
+	for(const auto& input : inputs)
+		out.write(reinterpret_cast<const char*>(&input.entry), sizeof(PackFileFormat::Entry));
+
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(PackFileFormat::Header));
+
+	if(!out)
+	{
+		std::println("failed to write {}", argv[2]);
+		return 1;
+	}
+
+	std::println("packed {} files into {}, {} KB stored as {} KB", inputs.size(), argv[2], total_size / 1024, total_stored / 1024);
+
+	return 0;
+}
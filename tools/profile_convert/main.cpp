@@ -0,0 +1,22 @@
+#include <penumbra/profile.hpp>
+#include <penumbra/vfs.hpp>
+
+#include <print>
+
+using namespace penumbra;
+
+int main(int argc, const char** argv)
+{
+	if(argc < 3)
+	{
+		std::println("Usage: profile_convert [INPUT] [OUTPUT]");
+		return 0;
+	}
+
+	vfs_init();
+
+	const bool ok = profile_convert_binary(argv[1], argv[2]);
+
+	vfs_shutdown();
+	return ok ? 0 : 1;
+}
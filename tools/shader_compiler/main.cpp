@@ -4,9 +4,9 @@
 #include <penumbra/gpu.hpp>
 #include <penumbra/shader.hpp>
 #include <penumbra/types.hpp>
+#include <penumbra/vfs.hpp>
 
 #include <array>
-#include <fstream>
 #include <filesystem>
 #include <print>
 #include <string>
@@ -311,27 +311,18 @@ int main(int argc, const char** argv)
 	{
 	using namespace penumbra;
 
-	std::ofstream out{argv[2], std::ios::binary};
-	std::array<u32, 5> code_offsets;
-
 	ShaderFileFormat::Header header;
 	header.cbuffer_stages = ctx.cbuffer_stages;
 	header.cbuffer_size = ctx.cbuffer_size;
 	header.pcb_size = ctx.pconst_size;
 	header.pcb_stages = ctx.pconst_stages;
 	header.num_stages = ctx.ep_count;
-	out.seekp(sizeof(ShaderFileFormat::Header) + sizeof(ShaderFileFormat::Stage) * ctx.ep_count);
-	
-	for(u32 i = 0; i < ctx.ep_count; i++)
-	{
-		code_offsets[i] = static_cast<u32>(out.tellp());
-		out.write(reinterpret_cast<const char*>(ctx.stage_code[i]->getBufferPointer()), ctx.stage_code[i]->getBufferSize());
-	}
 
-	out.seekp(sizeof(ShaderFileFormat::Header));
+	std::array<ShaderFileFormat::Stage, 3> stages;
+	size_t file_size = sizeof(ShaderFileFormat::Header) + sizeof(ShaderFileFormat::Stage) * ctx.ep_count;
 	for(u32 i = 0; i < ctx.ep_count; i++)
 	{
-		ShaderFileFormat::Stage stg;
+		auto& stg = stages[i];
 		if(ctx.ep_types[i] == 0)
 			stg.stage = GPU_STAGE_VERTEX_SHADER;
 		else if(ctx.ep_types[i] == 1)
@@ -340,12 +331,32 @@ int main(int argc, const char** argv)
 			stg.stage = GPU_STAGE_COMPUTE;
 
 		stg.code_size = ctx.stage_code[i]->getBufferSize();
-		stg.code_offset = code_offsets[i];
+		stg.code_offset = static_cast<u32>(file_size);
+		file_size += stg.code_size;
+	}
+
+	vfs_init();
+
+	vfs_wfd out = vfs_create(output_path, file_size);
+	if(out < 0)
+	{
+		vfs_shutdown();
+		return 1;
+	}
+
+	vfs_write(out, &header, sizeof(ShaderFileFormat::Header));
+	vfs_write(out, stages.data(), sizeof(ShaderFileFormat::Stage) * ctx.ep_count);
+	for(u32 i = 0; i < ctx.ep_count; i++)
+		vfs_write(out, ctx.stage_code[i]->getBufferPointer(), ctx.stage_code[i]->getBufferSize());
+
+	bool written = vfs_commit(out);
+	vfs_shutdown();
 
-		out.write(reinterpret_cast<const char*>(&stg), sizeof(ShaderFileFormat::Stage));
+	if(!written)
+	{
+		std::println("failed to write {}", argv[2]);
+		return 1;
 	}
-	out.seekp(0);
-	out.write(reinterpret_cast<const char*>(&header), sizeof(ShaderFileFormat::Header));
 
 	}	
 	